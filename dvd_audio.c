@@ -195,6 +195,49 @@ uint8_t dvd_audio_channels(const ifo_handle_t *vts_ifo, const uint8_t audio_trac
 
 }
 
+/**
+ * Get the sample rate of an audio track, 48 or 96 kHz
+ *
+ * @param vts_ifo dvdread track IFO handler
+ * @param audio_track audio track number
+ * @return sample rate, in Hz
+ */
+uint32_t dvd_audio_sample_rate(const ifo_handle_t *vts_ifo, const uint8_t audio_track) {
+
+	if(vts_ifo->vtsi_mat == NULL)
+		return 0;
+
+	audio_attr_t *audio_attr = &vts_ifo->vtsi_mat->vts_audio_attr[audio_track];
+
+	if(audio_attr->sample_frequency == 1)
+		return 96000;
+
+	return 48000;
+
+}
+
+/**
+ * Get the bits per sample of an LPCM audio track.  The same field is the
+ * dynamic range control flag for MPEG audio, and isn't used for the others.
+ *
+ * @param vts_ifo dvdread track IFO handler
+ * @param audio_track audio track number
+ * @return 16, 20 or 24, or 0 if it isn't LPCM
+ */
+uint8_t dvd_audio_quantization(const ifo_handle_t *vts_ifo, const uint8_t audio_track) {
+
+	if(vts_ifo->vtsi_mat == NULL)
+		return 0;
+
+	audio_attr_t *audio_attr = &vts_ifo->vtsi_mat->vts_audio_attr[audio_track];
+
+	if(audio_attr->audio_format != 4 || audio_attr->quantization > 2)
+		return 0;
+
+	return (uint8_t)(16 + audio_attr->quantization * 4);
+
+}
+
 /**
  * Get the stream ID for an audio track
  *
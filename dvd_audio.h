@@ -26,6 +26,10 @@ bool dvd_audio_codec(char *dest_str, const ifo_handle_t *vts_ifo, const uint8_t
 
 uint8_t dvd_audio_channels(const ifo_handle_t *vts_ifo, const uint8_t audio_track);
 
+uint32_t dvd_audio_sample_rate(const ifo_handle_t *vts_ifo, const uint8_t audio_track);
+
+uint8_t dvd_audio_quantization(const ifo_handle_t *vts_ifo, const uint8_t audio_track);
+
 bool dvd_audio_stream_id(char *dest_str, const ifo_handle_t *vts_ifo, const uint8_t audio_track);
 
 bool dvd_audio_lang_code(char *dest_str, const ifo_handle_t *vts_ifo, const uint8_t audio_stream);
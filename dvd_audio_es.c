@@ -0,0 +1,362 @@
+#include "dvd_audio_es.h"
+
+// AC3 bit rates (kbit/s), by frmsizecod / 2
+static const uint16_t dvd_audio_es_ac3_rates[19] = {
+	32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384, 448, 512, 576, 640
+};
+
+/**
+ * What kind of stream a substream id is
+ */
+uint8_t dvd_audio_es_format(const uint8_t stream_id) {
+
+	if(stream_id >= 0x80 && stream_id <= 0x87)
+		return DVD_AUDIO_ES_AC3;
+	if(stream_id >= 0x88 && stream_id <= 0x8f)
+		return DVD_AUDIO_ES_DTS;
+	if(stream_id >= 0xa0 && stream_id <= 0xa7)
+		return DVD_AUDIO_ES_LPCM;
+
+	return DVD_AUDIO_ES_RAW;
+
+}
+
+/**
+ * Length of the frame that starts at buf, from its sync info
+ *
+ * @param buf DVD_AUDIO_ES_SYNC bytes
+ * @return bytes, or 0 if it isn't the start of a frame
+ */
+size_t dvd_audio_es_frame_length(const uint8_t format, const uint8_t *buf) {
+
+	uint8_t fscod = 0;
+	uint8_t frmsizecod = 0;
+	uint16_t rate = 0;
+	size_t length = 0;
+
+	if(format == DVD_AUDIO_ES_AC3) {
+
+		if(buf[0] != 0x0b || buf[1] != 0x77)
+			return 0;
+
+		fscod = buf[4] >> 6;
+		frmsizecod = buf[4] & 0x3f;
+
+		if(fscod == 3 || frmsizecod > 37)
+			return 0;
+
+		rate = dvd_audio_es_ac3_rates[frmsizecod >> 1];
+
+		// Two byte words: 48, 44.1 and 32 kHz
+		if(fscod == 0)
+			return (size_t)rate * 4;
+		if(fscod == 1)
+			return ((size_t)rate * 320 / 147 + (frmsizecod & 0x01)) * 2;
+		return (size_t)rate * 6;
+
+	}
+
+	if(format == DVD_AUDIO_ES_DTS) {
+
+		if(buf[0] != 0x7f || buf[1] != 0xfe || buf[2] != 0x80 || buf[3] != 0x01)
+			return 0;
+
+		// FSIZE, 14 bits after the sync word, frame type, deficit sample count, CRC flag and number of blocks
+		length = (size_t)((((buf[5] & 0x03) << 12) | (buf[6] << 4) | (buf[7] >> 4)) + 1);
+
+		return length < 96 ? 0 : length;
+
+	}
+
+	return 0;
+
+}
+
+static void dvd_audio_es_le16(uint8_t *p, const uint16_t value) {
+
+	p[0] = value & 0xff;
+	p[1] = (uint8_t)(value >> 8);
+
+}
+
+static void dvd_audio_es_le32(uint8_t *p, const uint32_t value) {
+
+	p[0] = value & 0xff;
+	p[1] = (value >> 8) & 0xff;
+	p[2] = (value >> 16) & 0xff;
+	p[3] = (uint8_t)(value >> 24);
+
+}
+
+/**
+ * Canonical 44 byte WAV header, for PCM samples
+ *
+ * @param bits bits per sample written, 16 or 24
+ * @param data_bytes bytes of samples
+ */
+void dvd_audio_es_wav_header(uint8_t *header, const uint8_t channels, const uint32_t sample_rate, const uint8_t bits, const uint32_t data_bytes) {
+
+	uint16_t block_align = (uint16_t)(channels * (bits / 8));
+
+	memcpy(header, "RIFF", 4);
+	dvd_audio_es_le32(header + 4, data_bytes > UINT32_MAX - 36 ? UINT32_MAX : data_bytes + 36);
+	memcpy(header + 8, "WAVEfmt ", 8);
+	dvd_audio_es_le32(header + 16, 16);
+	dvd_audio_es_le16(header + 20, 1);
+	dvd_audio_es_le16(header + 22, channels);
+	dvd_audio_es_le32(header + 24, sample_rate);
+	dvd_audio_es_le32(header + 28, sample_rate * block_align);
+	dvd_audio_es_le16(header + 32, block_align);
+	dvd_audio_es_le16(header + 34, bits);
+	memcpy(header + 36, "data", 4);
+	dvd_audio_es_le32(header + 40, data_bytes);
+
+}
+
+/**
+ * Start writing a stream
+ *
+ * @param stream_id substream id for private stream 1, or the stream id
+ * @param channels, sample_rate, bits LPCM attributes, from the IFO
+ * @return false if the header couldn't be written, or the LPCM attributes
+ *   are out of range
+ */
+bool dvd_audio_es_open(struct dvd_audio_es *dvd_audio_es, FILE *file, const uint8_t stream_id, const uint8_t channels, const uint32_t sample_rate, const uint8_t bits) {
+
+	uint8_t header[DVD_AUDIO_ES_WAV_HEADER];
+
+	memset(dvd_audio_es, 0, sizeof(*dvd_audio_es));
+
+	dvd_audio_es->file = file;
+	dvd_audio_es->format = dvd_audio_es_format(stream_id);
+	dvd_audio_es->channels = channels;
+	dvd_audio_es->sample_rate = sample_rate;
+	dvd_audio_es->bits = bits;
+
+	if(dvd_audio_es->format != DVD_AUDIO_ES_LPCM)
+		return true;
+
+	if(channels < 1 || channels > 8 || (bits != 16 && bits != 20 && bits != 24))
+		return false;
+
+	dvd_audio_es->group_length = bits == 16 ? channels * 2u : channels * (bits == 20 ? 5u : 6u);
+
+	// Unknown sizes, until it is closed
+	dvd_audio_es_wav_header(header, channels, sample_rate, bits == 16 ? 16 : 24, UINT32_MAX);
+
+	return fwrite(header, DVD_AUDIO_ES_WAV_HEADER, 1, file) == 1;
+
+}
+
+/**
+ * AC3 and DTS: copy the stream into the frame buffer, and write each frame
+ * once it is whole
+ */
+static bool dvd_audio_es_frames(struct dvd_audio_es *dvd_audio_es, const uint8_t *buf, const uint8_t *end) {
+
+	size_t bytes = 0;
+
+	while(buf < end) {
+
+		if(dvd_audio_es->frame_length == 0) {
+
+			bytes = DVD_AUDIO_ES_SYNC - dvd_audio_es->frame_bytes;
+			if(bytes > (size_t)(end - buf))
+				bytes = (size_t)(end - buf);
+			memcpy(dvd_audio_es->frame + dvd_audio_es->frame_bytes, buf, bytes);
+			dvd_audio_es->frame_bytes += bytes;
+			buf += bytes;
+
+			if(dvd_audio_es->frame_bytes < DVD_AUDIO_ES_SYNC)
+				return true;
+
+			dvd_audio_es->frame_length = dvd_audio_es_frame_length(dvd_audio_es->format, dvd_audio_es->frame);
+
+			// Lost the sync, wait for the next frame a packet points to
+			if(dvd_audio_es->frame_length < DVD_AUDIO_ES_SYNC || dvd_audio_es->frame_length > DVD_AUDIO_ES_FRAME) {
+				dvd_audio_es->dropped += dvd_audio_es->frame_bytes + (size_t)(end - buf);
+				dvd_audio_es->frame_bytes = 0;
+				dvd_audio_es->frame_length = 0;
+				dvd_audio_es->aligned = false;
+				return true;
+			}
+
+			continue;
+
+		}
+
+		bytes = dvd_audio_es->frame_length - dvd_audio_es->frame_bytes;
+		if(bytes > (size_t)(end - buf))
+			bytes = (size_t)(end - buf);
+		memcpy(dvd_audio_es->frame + dvd_audio_es->frame_bytes, buf, bytes);
+		dvd_audio_es->frame_bytes += bytes;
+		buf += bytes;
+
+		if(dvd_audio_es->frame_bytes < dvd_audio_es->frame_length)
+			return true;
+
+		if(fwrite(dvd_audio_es->frame, dvd_audio_es->frame_length, 1, dvd_audio_es->file) != 1)
+			return false;
+
+		dvd_audio_es->frames++;
+		dvd_audio_es->data_bytes += dvd_audio_es->frame_length;
+		dvd_audio_es->frame_bytes = 0;
+		dvd_audio_es->frame_length = 0;
+
+	}
+
+	return true;
+
+}
+
+/**
+ * Put one LPCM sample group back together as little-endian samples
+ *
+ * 16 bit: one big-endian sample for each channel.  20 and 24 bit: two
+ * samples for each channel, the top 16 bits of all of them first, then the
+ * rest, a nibble (20 bit) or a byte (24 bit) each.  20 bit is written as 24.
+ *
+ * @return bytes written to out
+ */
+static size_t dvd_audio_es_group(const struct dvd_audio_es *dvd_audio_es, const uint8_t *group, uint8_t *out) {
+
+	const uint8_t *low = NULL;
+	uint8_t samples = 0;
+	uint8_t ix = 0;
+	uint8_t nibble = 0;
+
+	if(dvd_audio_es->bits == 16) {
+		for(ix = 0; ix < dvd_audio_es->channels; ix++) {
+			out[ix * 2] = group[ix * 2 + 1];
+			out[ix * 2 + 1] = group[ix * 2];
+		}
+		return dvd_audio_es->channels * 2u;
+	}
+
+	samples = (uint8_t)(dvd_audio_es->channels * 2);
+	low = group + samples * 2;
+
+	for(ix = 0; ix < samples; ix++) {
+		if(dvd_audio_es->bits == 24) {
+			out[ix * 3] = low[ix];
+		} else {
+			nibble = (ix & 0x01) ? (low[ix / 2] & 0x0f) : (low[ix / 2] >> 4);
+			out[ix * 3] = (uint8_t)(nibble << 4);
+		}
+		out[ix * 3 + 1] = group[ix * 2 + 1];
+		out[ix * 3 + 2] = group[ix * 2];
+	}
+
+	return samples * 3u;
+
+}
+
+static bool dvd_audio_es_lpcm(struct dvd_audio_es *dvd_audio_es, const uint8_t *buf, const uint8_t *end) {
+
+	uint8_t out[4096];
+	size_t out_bytes = 0;
+	size_t bytes = 0;
+
+	while(buf < end) {
+
+		bytes = dvd_audio_es->group_length - dvd_audio_es->group_bytes;
+		if(bytes > (size_t)(end - buf))
+			bytes = (size_t)(end - buf);
+		memcpy(dvd_audio_es->group + dvd_audio_es->group_bytes, buf, bytes);
+		dvd_audio_es->group_bytes += bytes;
+		buf += bytes;
+
+		if(dvd_audio_es->group_bytes < dvd_audio_es->group_length)
+			break;
+
+		out_bytes += dvd_audio_es_group(dvd_audio_es, dvd_audio_es->group, out + out_bytes);
+		dvd_audio_es->group_bytes = 0;
+
+		if(out_bytes + DVD_AUDIO_ES_GROUP > sizeof(out)) {
+			if(fwrite(out, out_bytes, 1, dvd_audio_es->file) != 1)
+				return false;
+			dvd_audio_es->data_bytes += out_bytes;
+			out_bytes = 0;
+		}
+
+	}
+
+	if(out_bytes) {
+		if(fwrite(out, out_bytes, 1, dvd_audio_es->file) != 1)
+			return false;
+		dvd_audio_es->data_bytes += out_bytes;
+	}
+
+	return true;
+
+}
+
+/**
+ * Write a piece of the stream, from the demuxer
+ *
+ * @return false if it couldn't be written
+ */
+bool dvd_audio_es_write(struct dvd_audio_es *dvd_audio_es, const struct dvd_demux_packet *dvd_demux_packet) {
+
+	const uint8_t *buf = dvd_demux_packet->buffer;
+	const uint8_t *end = buf + dvd_demux_packet->length;
+
+	if(dvd_audio_es->format == DVD_AUDIO_ES_RAW) {
+		if(fwrite(buf, dvd_demux_packet->length, 1, dvd_audio_es->file) != 1)
+			return false;
+		dvd_audio_es->data_bytes += dvd_demux_packet->length;
+		return true;
+	}
+
+	// Start at the first frame that a packet points to
+	if(!dvd_audio_es->aligned) {
+
+		if(dvd_demux_packet->frames == 0 || dvd_demux_packet->access_unit >= dvd_demux_packet->length) {
+			dvd_audio_es->dropped += dvd_demux_packet->length;
+			return true;
+		}
+
+		dvd_audio_es->dropped += dvd_demux_packet->access_unit;
+		buf += dvd_demux_packet->access_unit;
+		dvd_audio_es->aligned = true;
+
+	}
+
+	if(dvd_audio_es->format == DVD_AUDIO_ES_LPCM)
+		return dvd_audio_es_lpcm(dvd_audio_es, buf, end);
+
+	return dvd_audio_es_frames(dvd_audio_es, buf, end);
+
+}
+
+/**
+ * Drop anything that isn't a whole frame or sample group, and fill in the
+ * WAV header's sizes.  The file is left open.
+ *
+ * @return false if the header couldn't be written
+ */
+bool dvd_audio_es_close(struct dvd_audio_es *dvd_audio_es) {
+
+	uint8_t header[DVD_AUDIO_ES_WAV_HEADER];
+	long position = 0;
+
+	dvd_audio_es->dropped += dvd_audio_es->frame_bytes + dvd_audio_es->group_bytes;
+	dvd_audio_es->frame_bytes = 0;
+	dvd_audio_es->group_bytes = 0;
+
+	if(dvd_audio_es->format != DVD_AUDIO_ES_LPCM)
+		return true;
+
+	// A pipe keeps the unknown sizes
+	position = ftell(dvd_audio_es->file);
+	if(position < 0 || fseek(dvd_audio_es->file, 0, SEEK_SET) != 0)
+		return true;
+
+	dvd_audio_es_wav_header(header, dvd_audio_es->channels, dvd_audio_es->sample_rate, dvd_audio_es->bits == 16 ? 16 : 24, dvd_audio_es->data_bytes > UINT32_MAX ? UINT32_MAX : (uint32_t)dvd_audio_es->data_bytes);
+
+	if(fwrite(header, DVD_AUDIO_ES_WAV_HEADER, 1, dvd_audio_es->file) != 1)
+		return false;
+
+	return fseek(dvd_audio_es->file, position, SEEK_SET) == 0;
+
+}
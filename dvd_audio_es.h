@@ -0,0 +1,85 @@
+#ifndef DVD_INFO_AUDIO_ES_H
+#define DVD_INFO_AUDIO_ES_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "dvd_demux.h"
+
+/**
+ * Audio elementary streams
+ *
+ * Writes one audio stream from the demuxer as a file that other programs can
+ * read on their own.  AC3 and DTS start at the first frame that starts in a
+ * packet (the first access unit pointer in the substream header), and only
+ * whole frames are written, so a stream cut at a chapter doesn't start or end
+ * with part of one.  If the sync is lost, it picks up again at the next
+ * packet with a frame in it.
+ *
+ * LPCM on a DVD is big-endian, with 20 and 24 bit samples split up in groups
+ * of two per channel.  It is put back together as little-endian samples in a
+ * WAV file, with the header made from the IFO's audio attributes.  The sizes
+ * in the header are filled in when it is closed, if the file can be seeked.
+ *
+ * Anything else (MPEG audio) is written as it is.
+ *
+ * struct dvd_audio_es dvd_audio_es;
+ * dvd_audio_es_open(&dvd_audio_es, file, 0xa0, 2, 48000, 16);
+ * dvd_audio_es_write(&dvd_audio_es, dvd_demux_packet);
+ * dvd_audio_es_close(&dvd_audio_es);
+ */
+
+#define DVD_AUDIO_ES_RAW 0
+#define DVD_AUDIO_ES_AC3 1
+#define DVD_AUDIO_ES_DTS 2
+#define DVD_AUDIO_ES_LPCM 3
+
+// Longest frame: DTS can be up to 16 KB
+#define DVD_AUDIO_ES_FRAME 16384
+
+// Bytes at the start of a frame that are needed to get its length
+#define DVD_AUDIO_ES_SYNC 8
+
+#define DVD_AUDIO_ES_WAV_HEADER 44
+
+// One sample group: two 24 bit samples for each of 8 channels
+#define DVD_AUDIO_ES_GROUP 48
+
+/**
+ * frames: whole frames written (AC3 and DTS)
+ * dropped: bytes left out, before the first frame or where the sync was lost
+ * data_bytes: bytes of audio written
+ */
+struct dvd_audio_es {
+	FILE *file;
+	uint8_t format;
+	bool aligned;
+	uint8_t frame[DVD_AUDIO_ES_FRAME];
+	size_t frame_bytes;
+	size_t frame_length;
+	uint8_t channels;
+	uint32_t sample_rate;
+	uint8_t bits;
+	uint8_t group[DVD_AUDIO_ES_GROUP];
+	size_t group_bytes;
+	size_t group_length;
+	uint32_t frames;
+	uint64_t dropped;
+	uint64_t data_bytes;
+};
+
+uint8_t dvd_audio_es_format(const uint8_t stream_id);
+
+size_t dvd_audio_es_frame_length(const uint8_t format, const uint8_t *buf);
+
+void dvd_audio_es_wav_header(uint8_t *header, const uint8_t channels, const uint32_t sample_rate, const uint8_t bits, const uint32_t data_bytes);
+
+bool dvd_audio_es_open(struct dvd_audio_es *dvd_audio_es, FILE *file, const uint8_t stream_id, const uint8_t channels, const uint32_t sample_rate, const uint8_t bits);
+
+bool dvd_audio_es_write(struct dvd_audio_es *dvd_audio_es, const struct dvd_demux_packet *dvd_demux_packet);
+
+bool dvd_audio_es_close(struct dvd_audio_es *dvd_audio_es);
+
+#endif
@@ -0,0 +1,562 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <string.h>
+#include <ctype.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <getopt.h>
+#include "dvd_info.h"
+#include "dvd_device.h"
+#include "dvd_track.h"
+#include "dvd_json.h"
+#include "dvd_cbor.h"
+#include "dvd_ogm.h"
+#include "dvd_session.h"
+#include "dvd_track_copy.h"
+#ifdef DVD_INFO_MPEG2
+#include "dvd_thumbnail.h"
+#endif
+#ifdef __linux__
+#include <linux/cdrom.h>
+#include "dvd_drive.h"
+#endif
+#ifndef VERSION
+#define VERSION "1.2"
+#endif
+
+/**
+ * dvd_batch - run a list of jobs against a DVD, opening it only once
+ *
+ * Getting everything off a disc normally means running dvd_info a couple of
+ * times and then dvd_copy, and each of those opens the drive, waits for it,
+ * authenticates, and reads all the IFOs again.  dvd_batch reads a manifest of
+ * jobs and runs all of them on the same session.
+ *
+ * The manifest is one job per line.  Blank lines and lines starting with '#'
+ * are ignored.  Track can be a number or "longest", chapters can be "all", a
+ * single chapter, or a range.  A filename of "-" writes to stdout.
+ *
+ * json <filename>
+ * cbor <filename>
+ * chapters <track> <filename>
+ * copy <track> <chapters> <filename>
+ * thumbnails <track> <count> <directory>
+ *
+ * Thumbnails are only there when it's built with libmpeg2.  The whole
+ * manifest is checked before the DVD is opened.  If a job fails, the rest of
+ * them are still run.
+ */
+
+#define DVD_BATCH_MAX_JOBS 256
+#define DVD_BATCH_LINE 1024
+
+#define DVD_BATCH_JSON 1
+#define DVD_BATCH_CBOR 2
+#define DVD_BATCH_CHAPTERS 3
+#define DVD_BATCH_COPY 4
+#define DVD_BATCH_THUMBNAILS 5
+
+// Most thumbnails for one job, the same as dvd_ppm
+#define DVD_BATCH_MAX_THUMBNAILS 999
+
+// Track number for "longest"
+#define DVD_BATCH_LONGEST_TRACK 0
+
+struct dvd_batch_job {
+	uint8_t operation;
+	uint16_t track;
+	uint8_t first_chapter;
+	uint8_t last_chapter;
+	uint16_t thumbnails;
+	char filename[PATH_MAX];
+	unsigned int line;
+};
+
+int main(int argc, char **argv);
+void print_usage(char *binary);
+void print_version(char *binary);
+
+static bool dvd_batch_track(uint16_t *track_number, const char *str) {
+
+	char *end = NULL;
+	uintmax_t number = 0;
+
+	if(strcmp(str, "longest") == 0) {
+		*track_number = DVD_BATCH_LONGEST_TRACK;
+		return true;
+	}
+
+	number = strtoumax(str, &end, 10);
+
+	if(end == str || *end != '\0' || number < 1 || number > DVD_MAX_TRACKS)
+		return false;
+
+	*track_number = (uint16_t)number;
+
+	return true;
+
+}
+
+/**
+ * Parse a chapter range: "all", "3", or "3-7".  "all" is 1 to 99, and gets
+ * cut down to the number of chapters in the track when the job is run.
+ */
+static bool dvd_batch_chapters(uint8_t *first_chapter, uint8_t *last_chapter, const char *str) {
+
+	char *end = NULL;
+	uintmax_t first = 0;
+	uintmax_t last = 0;
+
+	if(strcmp(str, "all") == 0) {
+		*first_chapter = 1;
+		*last_chapter = 99;
+		return true;
+	}
+
+	first = strtoumax(str, &end, 10);
+	last = first;
+
+	if(end != str && *end == '-') {
+		str = end + 1;
+		last = strtoumax(str, &end, 10);
+	}
+
+	if(end == str || *end != '\0' || first < 1 || first > 99 || last < first || last > 99)
+		return false;
+
+	*first_chapter = (uint8_t)first;
+	*last_chapter = (uint8_t)last;
+
+	return true;
+
+}
+
+static bool dvd_batch_thumbnails(uint16_t *thumbnails, const char *str) {
+
+	char *end = NULL;
+	uintmax_t number = 0;
+
+	number = strtoumax(str, &end, 10);
+
+	if(end == str || *end != '\0' || number < 1 || number > DVD_BATCH_MAX_THUMBNAILS)
+		return false;
+
+	*thumbnails = (uint16_t)number;
+
+	return true;
+
+}
+
+/**
+ * Parse one line of the manifest
+ *
+ * @return false if it's not a valid job, true otherwise; a blank line or a
+ * comment is valid and has no operation
+ */
+static bool dvd_batch_parse(struct dvd_batch_job *job, char *line) {
+
+	char *args[5];
+	char *token = NULL;
+	uint8_t num_args = 0;
+	char *filename = NULL;
+
+	memset(job, 0, sizeof(*job));
+
+	for(token = strtok(line, " \t\r\n"); token != NULL && num_args < 5; token = strtok(NULL, " \t\r\n")) {
+		args[num_args] = token;
+		num_args++;
+	}
+
+	if(num_args == 0 || args[0][0] == '#')
+		return true;
+
+	if(strcmp(args[0], "json") == 0 && num_args == 2) {
+		job->operation = DVD_BATCH_JSON;
+		filename = args[1];
+	} else if(strcmp(args[0], "cbor") == 0 && num_args == 2) {
+		job->operation = DVD_BATCH_CBOR;
+		filename = args[1];
+	} else if(strcmp(args[0], "chapters") == 0 && num_args == 3) {
+		job->operation = DVD_BATCH_CHAPTERS;
+		if(!dvd_batch_track(&job->track, args[1]))
+			return false;
+		filename = args[2];
+	} else if(strcmp(args[0], "copy") == 0 && num_args == 4) {
+		job->operation = DVD_BATCH_COPY;
+		if(!dvd_batch_track(&job->track, args[1]))
+			return false;
+		if(!dvd_batch_chapters(&job->first_chapter, &job->last_chapter, args[2]))
+			return false;
+		filename = args[3];
+	} else if(strcmp(args[0], "thumbnails") == 0 && num_args == 4) {
+		job->operation = DVD_BATCH_THUMBNAILS;
+		if(!dvd_batch_track(&job->track, args[1]))
+			return false;
+		if(!dvd_batch_thumbnails(&job->thumbnails, args[2]))
+			return false;
+		filename = args[3];
+	} else {
+		return false;
+	}
+
+	if(strlen(filename) >= PATH_MAX)
+		return false;
+
+	strncpy(job->filename, filename, PATH_MAX - 1);
+
+	return true;
+
+}
+
+/**
+ * Point stdout at a file, so that the display functions can write to it.
+ * Returns the old stdout to give back to dvd_batch_restore_stdout(), or -1
+ * if the file couldn't be opened.
+ */
+static int dvd_batch_redirect_stdout(const char *filename) {
+
+	int fd = -1;
+	int stdout_fd = -1;
+
+	fflush(stdout);
+
+	fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if(fd == -1)
+		return -1;
+
+	stdout_fd = dup(STDOUT_FILENO);
+	if(stdout_fd == -1 || dup2(fd, STDOUT_FILENO) == -1) {
+		close(fd);
+		if(stdout_fd != -1)
+			close(stdout_fd);
+		return -1;
+	}
+
+	close(fd);
+
+	return stdout_fd;
+
+}
+
+static void dvd_batch_restore_stdout(int stdout_fd) {
+
+	fflush(stdout);
+	dup2(stdout_fd, STDOUT_FILENO);
+	close(stdout_fd);
+
+}
+
+int main(int argc, char **argv) {
+
+	char program_name[] = "dvd_batch";
+	const char *device_filename = DEFAULT_DVD_DEVICE;
+	const char *manifest_filename = "-";
+	FILE *manifest = NULL;
+	char line[DVD_BATCH_LINE];
+	unsigned int line_number = 0;
+	struct dvd_batch_job *jobs = NULL;
+	struct dvd_batch_job job;
+	uint16_t num_jobs = 0;
+	uint16_t ix = 0;
+	bool valid_manifest = true;
+	int retval = 0;
+
+	// libdvdinfo
+	struct dvd_session *dvd_session = NULL;
+	int session_error = DVD_SESSION_OK;
+	struct dvd_info dvd_info;
+	struct dvd_track dvd_tracks[DVD_MAX_TRACKS];
+	bool load_tracks = false;
+	uint16_t track_number = 1;
+	uint8_t first_chapter = 1;
+	uint8_t last_chapter = 1;
+	int stdout_fd = -1;
+	int fd = -1;
+	bool success = false;
+
+	memset(dvd_tracks, 0, sizeof(dvd_tracks));
+
+	// getopt_long
+	int long_ix = 0;
+	int opt = 0;
+	opterr = 1;
+	const char p_short_opts[] = "hm:V";
+
+	struct option p_long_opts[] = {
+
+		{ "manifest", required_argument, NULL, 'm' },
+		{ "help", no_argument, NULL, 'h' },
+		{ "version", no_argument, NULL, 'V' },
+		{ 0, 0, 0, 0 }
+
+	};
+
+	while((opt = getopt_long(argc, argv, p_short_opts, p_long_opts, &long_ix)) != -1) {
+
+		switch(opt) {
+
+			case 'h':
+				print_usage(program_name);
+				return 0;
+
+			case 'V':
+				print_version(program_name);
+				return 0;
+
+			case 'm':
+				manifest_filename = optarg;
+				break;
+
+			case '?':
+				print_usage(program_name);
+				return 1;
+
+			case 0:
+			default:
+				break;
+
+		}
+
+	}
+
+	if (argv[optind])
+		device_filename = argv[optind];
+
+	/** Read the manifest **/
+
+	if(strcmp(manifest_filename, "-") == 0)
+		manifest = stdin;
+	else
+		manifest = fopen(manifest_filename, "r");
+
+	if(manifest == NULL) {
+		fprintf(stderr, "%s: cannot open manifest %s\n", program_name, manifest_filename);
+		return 1;
+	}
+
+	jobs = calloc(DVD_BATCH_MAX_JOBS, sizeof(*jobs));
+	if(jobs == NULL) {
+		fprintf(stderr, "%s: could not allocate memory\n", program_name);
+		return 1;
+	}
+
+	while(fgets(line, DVD_BATCH_LINE, manifest) != NULL) {
+
+		line_number++;
+
+		if(!dvd_batch_parse(&job, line)) {
+			fprintf(stderr, "%s: invalid job on line %u of %s\n", program_name, line_number, manifest_filename);
+			valid_manifest = false;
+			continue;
+		}
+
+		if(job.operation == 0)
+			continue;
+
+#ifndef DVD_INFO_MPEG2
+		if(job.operation == DVD_BATCH_THUMBNAILS) {
+			fprintf(stderr, "%s: thumbnails on line %u need libmpeg2, and this was built without it\n", program_name, line_number);
+			valid_manifest = false;
+			continue;
+		}
+#endif
+
+		if(num_jobs == DVD_BATCH_MAX_JOBS) {
+			fprintf(stderr, "%s: too many jobs, the limit is %u\n", program_name, DVD_BATCH_MAX_JOBS);
+			valid_manifest = false;
+			break;
+		}
+
+		job.line = line_number;
+		jobs[num_jobs] = job;
+		num_jobs++;
+
+	}
+
+	if(manifest != stdin)
+		fclose(manifest);
+
+	if(!valid_manifest) {
+		free(jobs);
+		return 1;
+	}
+
+	if(num_jobs == 0) {
+		fprintf(stderr, "%s: no jobs to run\n", program_name);
+		free(jobs);
+		return 0;
+	}
+
+	/** Open the DVD, once **/
+
+	dvd_session = dvd_session_open(device_filename, &session_error);
+
+	if(dvd_session == NULL) {
+
+#ifdef __linux__
+		if(session_error == DVD_SESSION_ERR_NO_MEDIA) {
+			fprintf(stderr, "drive status: ");
+			dvd_drive_display_status(device_filename);
+			free(jobs);
+			return 1;
+		}
+#endif
+
+		fprintf(stderr, "%s: %s: %s\n", program_name, device_filename, dvd_session_strerror(session_error));
+		free(jobs);
+		return 1;
+
+	}
+
+	dvd_session_info(dvd_session, &dvd_info);
+
+	// All the track information is only looked up once, and only if
+	// something other than copying needs it
+	for(ix = 0; ix < num_jobs; ix++) {
+		if(jobs[ix].operation != DVD_BATCH_COPY && jobs[ix].operation != DVD_BATCH_THUMBNAILS)
+			load_tracks = true;
+	}
+
+	if(load_tracks) {
+		for(track_number = 1; track_number <= dvd_info.tracks; track_number++)
+			dvd_session_track(dvd_session, track_number, &dvd_tracks[track_number - 1]);
+	}
+
+	for(ix = 0; ix < num_jobs; ix++) {
+
+		job = jobs[ix];
+		success = false;
+
+		if(job.track == DVD_BATCH_LONGEST_TRACK)
+			track_number = dvd_info.longest_track;
+		else
+			track_number = job.track;
+
+		if(track_number > dvd_info.tracks) {
+			fprintf(stderr, "%s: line %u: invalid track number %u, valid track numbers: 1 to %u\n", program_name, job.line, track_number, dvd_info.tracks);
+			retval = 1;
+			continue;
+		}
+
+		switch(job.operation) {
+
+			case DVD_BATCH_JSON:
+			case DVD_BATCH_CBOR:
+			case DVD_BATCH_CHAPTERS:
+
+				fprintf(stderr, "%s: %s to %s\n", program_name, job.operation == DVD_BATCH_JSON ? "json" : (job.operation == DVD_BATCH_CBOR ? "cbor" : "chapters"), job.filename);
+
+				stdout_fd = -1;
+				if(strcmp(job.filename, "-")) {
+					stdout_fd = dvd_batch_redirect_stdout(job.filename);
+					if(stdout_fd == -1) {
+						fprintf(stderr, "%s: line %u: couldn't create file %s\n", program_name, job.line, job.filename);
+						break;
+					}
+				}
+
+				if(job.operation == DVD_BATCH_JSON)
+					dvd_json(dvd_info, dvd_tracks, 1, 1, dvd_info.tracks);
+				else if(job.operation == DVD_BATCH_CBOR)
+					dvd_cbor(dvd_info, dvd_tracks, 1, 1, dvd_info.tracks);
+				else
+					dvd_ogm(dvd_tracks[track_number - 1]);
+
+				if(stdout_fd != -1)
+					dvd_batch_restore_stdout(stdout_fd);
+
+				success = true;
+				break;
+
+			case DVD_BATCH_COPY:
+
+				if(dvd_session_track_ifo(dvd_session, track_number) == NULL) {
+					fprintf(stderr, "%s: line %u: could not open VTS_IFO for track %u\n", program_name, job.line, track_number);
+					break;
+				}
+
+				last_chapter = dvd_track_chapters(dvd_session_vmg_ifo(dvd_session), dvd_session_track_ifo(dvd_session, track_number), track_number);
+				first_chapter = job.first_chapter > last_chapter ? last_chapter : job.first_chapter;
+				if(job.last_chapter < last_chapter)
+					last_chapter = job.last_chapter;
+
+				fprintf(stderr, "%s: copy track %02u, chapters %02u to %02u, to %s\n", program_name, track_number, first_chapter, last_chapter, job.filename);
+
+				fflush(stdout);
+
+				if(strcmp(job.filename, "-") == 0) {
+					fd = STDOUT_FILENO;
+				} else {
+					fd = open(job.filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+					if(fd == -1) {
+						fprintf(stderr, "%s: line %u: couldn't create file %s\n", program_name, job.line, job.filename);
+						break;
+					}
+				}
+
+				success = dvd_track_copy(dvd_session, track_number, first_chapter, last_chapter, fd, DVD_COPY_BLOCK_LIMIT, false);
+
+				if(fd != STDOUT_FILENO)
+					close(fd);
+
+				break;
+
+#ifdef DVD_INFO_MPEG2
+			case DVD_BATCH_THUMBNAILS:
+
+				fprintf(stderr, "%s: %u thumbnails of track %02u to %s\n", program_name, job.thumbnails, track_number, job.filename);
+
+				success = dvd_thumbnails(dvd_session, track_number, job.thumbnails, DVD_THUMBNAIL_WIDTH, job.filename) == job.thumbnails;
+
+				break;
+#endif
+
+		}
+
+		if(!success)
+			retval = 1;
+
+	}
+
+	for(track_number = 1; track_number <= dvd_info.tracks; track_number++)
+		dvd_session_track_free(&dvd_tracks[track_number - 1]);
+
+	dvd_session_close(dvd_session);
+
+	free(jobs);
+
+	return retval;
+
+}
+
+void print_usage(char *binary) {
+
+	printf("%s %s - run a list of jobs against a DVD, opening it once\n", binary, VERSION);
+	printf("\n");
+	printf("Usage: %s [-m manifest] [dvd path]\n", binary);
+	printf("\n");
+	printf("Options:\n");
+	printf("  -m, --manifest <filename>	Read jobs from file (default: stdin)\n");
+	printf("  -h, --help			Display these help options\n");
+	printf("  -V, --version			Version information\n");
+	printf("\n");
+	printf("Manifest, one job per line, filename can be - for stdout:\n");
+	printf("  json <filename>				dvd_info JSON output\n");
+	printf("  cbor <filename>				dvd_info CBOR output\n");
+	printf("  chapters <track|longest> <filename>		OGM chapters\n");
+	printf("  copy <track|longest> <all|#|#-#> <filename>	Copy a track's chapters\n");
+	printf("  thumbnails <track|longest> <#> <directory>	Thumbnails spread across a track\n");
+	printf("\n");
+	printf("DVD path can be a device name, a single file, or directory.\n");
+
+}
+
+void print_version(char *binary) {
+
+	printf("%s %s - http://dvds.beandog.org/ - (c) 2018 Steve Dibb <steve.dibb@gmail.com>, licensed under GPL-2\n", binary, VERSION);
+
+}
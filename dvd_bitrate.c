@@ -0,0 +1,258 @@
+#include "dvd_bitrate.h"
+#include "dvd_pipeline.h"
+
+/**
+ * Where each cell starts, from the first one of a chapter
+ *
+ * @return false if the track's IFO can't be opened
+ */
+bool dvd_bitrate_init(struct dvd_bitrate *dvd_bitrate, struct dvd_session *dvd_session, const struct dvd_track *dvd_track, const uint8_t first_chapter) {
+
+	ifo_handle_t *vmg_ifo = dvd_session_vmg_ifo(dvd_session);
+	ifo_handle_t *vts_ifo = dvd_session_track_ifo(dvd_session, dvd_track->track);
+	uint8_t first_cell = 0;
+
+	memset(dvd_bitrate, 0, sizeof(*dvd_bitrate));
+
+	if(vts_ifo == NULL)
+		return false;
+
+	first_cell = dvd_chapter_first_cell(vmg_ifo, vts_ifo, dvd_track->track, first_chapter);
+	dvd_cell_starts(vmg_ifo, vts_ifo, dvd_track->track, first_cell, dvd_bitrate->cell_start);
+
+	return true;
+
+}
+
+/**
+ * Add up the PES packets of one pack, by stream.  Only the pack header and
+ * the packet lengths are read.
+ *
+ * @param block one block (2048 bytes)
+ */
+void dvd_bitrate_pack(struct dvd_bitrate_streams *dvd_bitrate_streams, const uint8_t *block) {
+
+	const uint8_t *end = block + DVD_VIDEO_LB_LEN;
+	const uint8_t *p = block;
+	uint8_t stream_id = 0;
+	uint8_t substream_id = 0;
+	size_t length = 0;
+
+	dvd_bitrate_streams->total += DVD_VIDEO_LB_LEN;
+
+	// MPEG-2 pack header, and its stuffing
+	if(p[0] != 0x00 || p[1] != 0x00 || p[2] != 0x01 || p[3] != 0xba || (p[4] & 0xc0) != 0x40)
+		return;
+
+	p += 14 + (p[13] & 0x07);
+
+	while(p + 6 <= end && p[0] == 0x00 && p[1] == 0x00 && p[2] == 0x01) {
+
+		stream_id = p[3];
+		length = 6 + (size_t)((p[4] << 8) | p[5]);
+
+		if(p + length > end)
+			length = (size_t)(end - p);
+
+		if(stream_id == 0xe0) {
+			dvd_bitrate_streams->video += length;
+		} else if(stream_id >= 0xc0 && stream_id <= 0xc7) {
+			dvd_bitrate_streams->audio[stream_id & 0x07] += length;
+		} else if(stream_id == 0xbe) {
+			dvd_bitrate_streams->padding += length;
+		} else if(stream_id == 0xbd && length > 9 && (size_t)p[8] + 9 < length) {
+
+			substream_id = p[9 + p[8]];
+
+			if(substream_id >= 0x20 && substream_id <= 0x3f)
+				dvd_bitrate_streams->subtitles += length;
+			else if((substream_id >= 0x80 && substream_id <= 0x8f) || (substream_id >= 0xa0 && substream_id <= 0xa7))
+				dvd_bitrate_streams->audio[substream_id & 0x07] += length;
+
+		}
+
+		p += length;
+
+	}
+
+}
+
+/**
+ * Bits a second, 0 if it has no length
+ */
+uint32_t dvd_bitrate_rate(const uint64_t bytes, const uint64_t ticks) {
+
+	if(ticks == 0)
+		return 0;
+
+	return (uint32_t)(bytes * 8 * 90000 / ticks);
+
+}
+
+/**
+ * Share of the bytes that are padding, in thousandths
+ */
+uint16_t dvd_bitrate_padding(const struct dvd_bitrate_streams *bytes) {
+
+	if(bytes->total == 0)
+		return 0;
+
+	return (uint16_t)(bytes->padding * 1000 / bytes->total);
+
+}
+
+static void dvd_bitrate_peak(uint64_t *peak, const uint64_t bytes, const uint32_t ticks) {
+
+	uint32_t rate = dvd_bitrate_rate(bytes, ticks);
+
+	if(rate > *peak)
+		*peak = rate;
+
+}
+
+/**
+ * Add a VOBU that is done to its cell and the track
+ */
+static void dvd_bitrate_add(struct dvd_bitrate_stats *dvd_bitrate_stats, const struct dvd_bitrate_vobu *dvd_bitrate_vobu) {
+
+	const struct dvd_bitrate_streams *bytes = &dvd_bitrate_vobu->bytes;
+	struct dvd_bitrate_streams *total = &dvd_bitrate_stats->bytes;
+	struct dvd_bitrate_streams *peak = &dvd_bitrate_stats->peak;
+	uint32_t ticks = dvd_bitrate_vobu->ticks;
+	uint8_t ix = 0;
+
+	dvd_bitrate_stats->vobus++;
+	dvd_bitrate_stats->ticks += ticks;
+
+	total->total += bytes->total;
+	total->video += bytes->video;
+	total->subtitles += bytes->subtitles;
+	total->padding += bytes->padding;
+
+	dvd_bitrate_peak(&peak->total, bytes->total, ticks);
+	dvd_bitrate_peak(&peak->video, bytes->video, ticks);
+	dvd_bitrate_peak(&peak->subtitles, bytes->subtitles, ticks);
+	dvd_bitrate_peak(&peak->padding, bytes->padding, ticks);
+
+	for(ix = 0; ix < DVD_BITRATE_AUDIO; ix++) {
+		total->audio[ix] += bytes->audio[ix];
+		dvd_bitrate_peak(&peak->audio[ix], bytes->audio[ix], ticks);
+	}
+
+}
+
+/**
+ * Profile a batch of blocks read from a cell.  Each NAV pack starts a new
+ * VOBU, and anything before the first one is left out.
+ *
+ * @return false if there isn't the memory for another VOBU
+ */
+bool dvd_bitrate_blocks(struct dvd_bitrate *dvd_bitrate, const uint8_t *buffer, const ssize_t blocks, const uint8_t cell) {
+
+	struct dvd_bitrate_vobu *dvd_bitrate_vobu = NULL;
+	struct dvd_vobu dvd_vobu;
+	const uint8_t *block = NULL;
+	uint32_t size = 0;
+	ssize_t ix = 0;
+
+	for(ix = 0; ix < blocks; ix++) {
+
+		block = buffer + ix * DVD_VIDEO_LB_LEN;
+
+		if(dvd_vobu_parse(&dvd_vobu, block)) {
+
+			dvd_bitrate_finish(dvd_bitrate);
+
+			if(dvd_bitrate->vobus == dvd_bitrate->size) {
+				size = dvd_bitrate->size ? dvd_bitrate->size * 2 : 4096;
+				dvd_bitrate_vobu = realloc(dvd_bitrate->vobu, size * sizeof(struct dvd_bitrate_vobu));
+				if(dvd_bitrate_vobu == NULL) {
+					dvd_bitrate->error = true;
+					return false;
+				}
+				dvd_bitrate->vobu = dvd_bitrate_vobu;
+				dvd_bitrate->size = size;
+			}
+
+			dvd_bitrate_vobu = &dvd_bitrate->vobu[dvd_bitrate->vobus];
+			memset(dvd_bitrate_vobu, 0, sizeof(*dvd_bitrate_vobu));
+
+			dvd_bitrate_vobu->msecs = dvd_bitrate->cell_start[cell] + dvd_vobu.cell_msecs;
+			dvd_bitrate_vobu->ticks = dvd_vobu.end_pts > dvd_vobu.start_pts ? dvd_vobu.end_pts - dvd_vobu.start_pts : 0;
+			dvd_bitrate_vobu->cell = cell;
+
+			dvd_bitrate->vobus++;
+
+		}
+
+		if(dvd_bitrate->vobus == 0)
+			continue;
+
+		dvd_bitrate_vobu = &dvd_bitrate->vobu[dvd_bitrate->vobus - 1];
+		dvd_bitrate_vobu->blocks++;
+
+		dvd_bitrate_pack(&dvd_bitrate_vobu->bytes, block);
+
+	}
+
+	return true;
+
+}
+
+/**
+ * Add the last VOBU to the cell and track stats.  It is only done once for
+ * each one, so it can be called again.
+ */
+void dvd_bitrate_finish(struct dvd_bitrate *dvd_bitrate) {
+
+	const struct dvd_bitrate_vobu *dvd_bitrate_vobu = NULL;
+
+	if(dvd_bitrate->vobus == 0 || dvd_bitrate->track.vobus == dvd_bitrate->vobus)
+		return;
+
+	dvd_bitrate_vobu = &dvd_bitrate->vobu[dvd_bitrate->vobus - 1];
+
+	dvd_bitrate_add(&dvd_bitrate->track, dvd_bitrate_vobu);
+	dvd_bitrate_add(&dvd_bitrate->cells[dvd_bitrate_vobu->cell], dvd_bitrate_vobu);
+
+}
+
+void dvd_bitrate_free(struct dvd_bitrate *dvd_bitrate) {
+
+	free(dvd_bitrate->vobu);
+
+	dvd_bitrate->vobu = NULL;
+	dvd_bitrate->vobus = 0;
+	dvd_bitrate->size = 0;
+
+}
+
+static bool dvd_bitrate_pipeline_write(void *data, const struct dvd_pipeline_blocks *dvd_pipeline_blocks) {
+
+	if(!dvd_bitrate_blocks((struct dvd_bitrate *)data, dvd_pipeline_blocks->buffer, dvd_pipeline_blocks->blocks, dvd_pipeline_blocks->cell)) {
+		fprintf(stderr, "Couldn't allocate memory\n");
+		return false;
+	}
+
+	return true;
+
+}
+
+static bool dvd_bitrate_pipeline_close(void *data) {
+
+	dvd_bitrate_finish((struct dvd_bitrate *)data);
+
+	return true;
+
+}
+
+/**
+ * Profile every VOBU a pipeline reads.  dvd_bitrate has to be set up with
+ * dvd_bitrate_init() first, and has the totals once dvd_pipeline_run()
+ * returns.
+ */
+bool dvd_bitrate_pipeline(struct dvd_pipeline *dvd_pipeline, struct dvd_bitrate *dvd_bitrate) {
+
+	return dvd_pipeline_add(dvd_pipeline, "bitrate", dvd_bitrate_pipeline_write, dvd_bitrate_pipeline_close, dvd_bitrate);
+
+}
@@ -0,0 +1,110 @@
+#ifndef DVD_INFO_BITRATE_H
+#define DVD_INFO_BITRATE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dvdread/dvd_reader.h>
+#include <dvdread/ifo_read.h>
+#include "dvd_session.h"
+#include "dvd_track.h"
+#include "dvd_chapter.h"
+#include "dvd_cell.h"
+#include "dvd_vobu.h"
+
+#ifndef DVD_VIDEO_LB_LEN
+#define DVD_VIDEO_LB_LEN 2048
+#endif
+
+/**
+ * Bitrate profile of a track
+ *
+ * Adds up the bytes of each stream in every VOBU, from the pack headers and
+ * the PES packet lengths only, so nothing is demuxed and it runs as fast as
+ * the track can be read.  The length of each VOBU is from its NAV pack.
+ *
+ * Bytes are whole PES packets, headers and all.  The total is every block of
+ * the VOBU, so it also has the pack headers and the NAV pack.  Audio streams
+ * are by their number (0xc0, 0x80, 0x88 and 0xa0 are all the first one), and
+ * the subtitle streams are added up together.  Padding is the padding stream
+ * (0xbe), which fills out packs that aren't full, and whole blocks that are
+ * there to take up space.
+ *
+ * struct dvd_bitrate dvd_bitrate;
+ * dvd_bitrate_init(&dvd_bitrate, dvd_session, &dvd_track, 1);
+ * dvd_bitrate_blocks(&dvd_bitrate, buffer, blocks, cell);
+ * dvd_bitrate_finish(&dvd_bitrate);
+ * dvd_bitrate_free(&dvd_bitrate);
+ */
+
+#define DVD_BITRATE_AUDIO 8
+
+// Padding, in thousandths of the track, that is more than a real one has
+#define DVD_BITRATE_PADDING_WARNING 250
+
+struct dvd_bitrate_streams {
+	uint64_t total;
+	uint64_t video;
+	uint64_t audio[DVD_BITRATE_AUDIO];
+	uint64_t subtitles;
+	uint64_t padding;
+};
+
+/**
+ * msecs: time the VOBU starts at, from the start of the first cell read
+ * ticks: length (90 kHz), 0 for a still
+ * bytes: bytes of each stream
+ */
+struct dvd_bitrate_vobu {
+	uint32_t msecs;
+	uint32_t ticks;
+	uint32_t blocks;
+	uint8_t cell;
+	struct dvd_bitrate_streams bytes;
+};
+
+/**
+ * A track, or one cell of it
+ *
+ * ticks: length of the VOBUs (90 kHz)
+ * bytes: bytes of each stream
+ * peak: highest bitrate of each stream in any one VOBU (bits a second)
+ */
+struct dvd_bitrate_stats {
+	uint32_t vobus;
+	uint64_t ticks;
+	struct dvd_bitrate_streams bytes;
+	struct dvd_bitrate_streams peak;
+};
+
+struct dvd_bitrate {
+	uint32_t cell_start[256];
+	struct dvd_bitrate_stats track;
+	struct dvd_bitrate_stats cells[256];
+	uint32_t vobus;
+	uint32_t size;
+	struct dvd_bitrate_vobu *vobu;
+	bool error;
+};
+
+bool dvd_bitrate_init(struct dvd_bitrate *dvd_bitrate, struct dvd_session *dvd_session, const struct dvd_track *dvd_track, const uint8_t first_chapter);
+
+void dvd_bitrate_pack(struct dvd_bitrate_streams *dvd_bitrate_streams, const uint8_t *block);
+
+bool dvd_bitrate_blocks(struct dvd_bitrate *dvd_bitrate, const uint8_t *buffer, const ssize_t blocks, const uint8_t cell);
+
+void dvd_bitrate_finish(struct dvd_bitrate *dvd_bitrate);
+
+uint32_t dvd_bitrate_rate(const uint64_t bytes, const uint64_t ticks);
+
+uint16_t dvd_bitrate_padding(const struct dvd_bitrate_streams *bytes);
+
+void dvd_bitrate_free(struct dvd_bitrate *dvd_bitrate);
+
+struct dvd_pipeline;
+
+bool dvd_bitrate_pipeline(struct dvd_pipeline *dvd_pipeline, struct dvd_bitrate *dvd_bitrate);
+
+#endif
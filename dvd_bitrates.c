@@ -0,0 +1,510 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdbool.h>
+#include <getopt.h>
+#include <limits.h>
+#include <inttypes.h>
+#ifdef __linux__
+#include <linux/cdrom.h>
+#include "dvd_drive.h"
+#endif
+#include <dvdread/dvd_reader.h>
+#include <dvdread/ifo_read.h>
+#include "dvd_info.h"
+#include "dvd_device.h"
+#include "dvd_track.h"
+#include "dvd_chapter.h"
+#include "dvd_cell.h"
+#include "dvd_time.h"
+#include "dvd_session.h"
+#include "dvd_pipeline.h"
+#include "dvd_bitrate.h"
+#ifndef VERSION
+#define VERSION "1.2"
+#endif
+
+#define DVD_INFO_PROGRAM "dvd_bitrates"
+
+#define DVD_BITRATE_JSON 0
+#define DVD_BITRATE_CSV 1
+
+int main(int, char **);
+void print_usage(char *binary);
+void print_version(char *binary);
+
+/**
+ * Bitrates of each stream, as JSON members
+ */
+static void dvd_bitrate_json_streams(FILE *output, const struct dvd_bitrate_streams *rates, const uint8_t audio_tracks, const char *indent) {
+
+	uint8_t ix = 0;
+
+	fprintf(output, "%s\"total\": %" PRIu64 ",\n", indent, rates->total);
+	fprintf(output, "%s\"video\": %" PRIu64 ",\n", indent, rates->video);
+	fprintf(output, "%s\"audio\": [", indent);
+	for(ix = 0; ix < audio_tracks; ix++)
+		fprintf(output, "%s%" PRIu64, ix ? ", " : "", rates->audio[ix]);
+	fprintf(output, "],\n");
+	fprintf(output, "%s\"subtitles\": %" PRIu64 ",\n", indent, rates->subtitles);
+	fprintf(output, "%s\"padding\": %" PRIu64 "\n", indent, rates->padding);
+
+}
+
+static void dvd_bitrate_csv_streams(FILE *output, const struct dvd_bitrate_streams *rates, const uint8_t audio_tracks) {
+
+	uint8_t ix = 0;
+
+	fprintf(output, "%" PRIu64 ",%" PRIu64, rates->total, rates->video);
+	for(ix = 0; ix < audio_tracks; ix++)
+		fprintf(output, ",%" PRIu64, rates->audio[ix]);
+	fprintf(output, ",%" PRIu64 ",%" PRIu64, rates->subtitles, rates->padding);
+
+}
+
+static void dvd_bitrate_csv_header(FILE *output, const char *prefix, const uint8_t audio_tracks) {
+
+	uint8_t ix = 0;
+
+	fprintf(output, "%stotal,%svideo", prefix, prefix);
+	for(ix = 0; ix < audio_tracks; ix++)
+		fprintf(output, ",%saudio %u", prefix, ix + 1);
+	fprintf(output, ",%ssubtitles,%spadding", prefix, prefix);
+
+}
+
+/**
+ * Bytes of each stream as bits a second
+ */
+static void dvd_bitrate_rates(struct dvd_bitrate_streams *rates, const struct dvd_bitrate_streams *bytes, const uint64_t ticks) {
+
+	uint8_t ix = 0;
+
+	rates->total = dvd_bitrate_rate(bytes->total, ticks);
+	rates->video = dvd_bitrate_rate(bytes->video, ticks);
+	rates->subtitles = dvd_bitrate_rate(bytes->subtitles, ticks);
+	rates->padding = dvd_bitrate_rate(bytes->padding, ticks);
+
+	for(ix = 0; ix < DVD_BITRATE_AUDIO; ix++)
+		rates->audio[ix] = dvd_bitrate_rate(bytes->audio[ix], ticks);
+
+}
+
+/**
+ * Averages, peaks and padding of the track or a cell
+ */
+static void dvd_bitrate_json_stats(FILE *output, const struct dvd_bitrate_stats *dvd_bitrate_stats, const uint8_t audio_tracks, const char *indent) {
+
+	struct dvd_bitrate_streams average;
+	char member_indent[16];
+	uint16_t padding = dvd_bitrate_padding(&dvd_bitrate_stats->bytes);
+
+	dvd_bitrate_rates(&average, &dvd_bitrate_stats->bytes, dvd_bitrate_stats->ticks);
+	snprintf(member_indent, sizeof(member_indent), "%s ", indent);
+
+	fprintf(output, "%s\"vobus\": %u,\n", indent, dvd_bitrate_stats->vobus);
+	fprintf(output, "%s\"msecs\": %" PRIu64 ",\n", indent, dvd_bitrate_stats->ticks / 90);
+	fprintf(output, "%s\"bytes\": %" PRIu64 ",\n", indent, dvd_bitrate_stats->bytes.total);
+	fprintf(output, "%s\"padding share\": %u.%03u,\n", indent, padding / 1000, padding % 1000);
+	fprintf(output, "%s\"average\": {\n", indent);
+	dvd_bitrate_json_streams(output, &average, audio_tracks, member_indent);
+	fprintf(output, "%s},\n", indent);
+	fprintf(output, "%s\"peak\": {\n", indent);
+	dvd_bitrate_json_streams(output, &dvd_bitrate_stats->peak, audio_tracks, member_indent);
+	fprintf(output, "%s}", indent);
+
+}
+
+static void dvd_bitrate_json(FILE *output, const struct dvd_bitrate *dvd_bitrate, const struct dvd_track *dvd_track, const uint8_t first_chapter, const uint8_t last_chapter, const uint8_t audio_tracks) {
+
+	const struct dvd_bitrate_vobu *dvd_bitrate_vobu = NULL;
+	struct dvd_bitrate_streams rates;
+	uint32_t ix = 0;
+	uint16_t cell = 0;
+	bool first = true;
+
+	fprintf(output, "{\n");
+	fprintf(output, " \"track\": %u,\n", dvd_track->track);
+	fprintf(output, " \"first chapter\": %u,\n", first_chapter);
+	fprintf(output, " \"last chapter\": %u,\n", last_chapter);
+	dvd_bitrate_json_stats(output, &dvd_bitrate->track, audio_tracks, " ");
+	fprintf(output, ",\n");
+	fprintf(output, " \"cells\": [\n");
+
+	for(cell = 1; cell < 256; cell++) {
+
+		if(dvd_bitrate->cells[cell].vobus == 0)
+			continue;
+
+		fprintf(output, "%s  {\n", first ? "" : ",\n");
+		fprintf(output, "   \"cell\": %u,\n", cell);
+		fprintf(output, "   \"start msecs\": %u,\n", dvd_bitrate->cell_start[cell]);
+		dvd_bitrate_json_stats(output, &dvd_bitrate->cells[cell], audio_tracks, "   ");
+		fprintf(output, "\n  }");
+
+		first = false;
+
+	}
+
+	fprintf(output, "\n ],\n");
+
+	// Bits a second of each VOBU
+	fprintf(output, " \"profile\": [\n");
+
+	for(ix = 0; ix < dvd_bitrate->vobus; ix++) {
+
+		dvd_bitrate_vobu = &dvd_bitrate->vobu[ix];
+		dvd_bitrate_rates(&rates, &dvd_bitrate_vobu->bytes, dvd_bitrate_vobu->ticks);
+
+		fprintf(output, "  {\n");
+		fprintf(output, "   \"msecs\": %u,\n", dvd_bitrate_vobu->msecs);
+		fprintf(output, "   \"length msecs\": %u,\n", dvd_bitrate_vobu->ticks / 90);
+		fprintf(output, "   \"cell\": %u,\n", dvd_bitrate_vobu->cell);
+		fprintf(output, "   \"blocks\": %u,\n", dvd_bitrate_vobu->blocks);
+		dvd_bitrate_json_streams(output, &rates, audio_tracks, "   ");
+		fprintf(output, "  }%s\n", ix + 1 < dvd_bitrate->vobus ? "," : "");
+
+	}
+
+	fprintf(output, " ]\n");
+	fprintf(output, "}\n");
+
+}
+
+/**
+ * One line for each VOBU, with the bitrate of each stream
+ */
+static void dvd_bitrate_csv(FILE *output, const struct dvd_bitrate *dvd_bitrate, const uint8_t audio_tracks) {
+
+	const struct dvd_bitrate_vobu *dvd_bitrate_vobu = NULL;
+	struct dvd_bitrate_streams rates;
+	uint32_t ix = 0;
+
+	fprintf(output, "msecs,length msecs,cell,blocks,");
+	dvd_bitrate_csv_header(output, "", audio_tracks);
+	fprintf(output, "\n");
+
+	for(ix = 0; ix < dvd_bitrate->vobus; ix++) {
+
+		dvd_bitrate_vobu = &dvd_bitrate->vobu[ix];
+		dvd_bitrate_rates(&rates, &dvd_bitrate_vobu->bytes, dvd_bitrate_vobu->ticks);
+
+		fprintf(output, "%u,%u,%u,%u,", dvd_bitrate_vobu->msecs, dvd_bitrate_vobu->ticks / 90, dvd_bitrate_vobu->cell, dvd_bitrate_vobu->blocks);
+		dvd_bitrate_csv_streams(output, &rates, audio_tracks);
+		fprintf(output, "\n");
+
+	}
+
+}
+
+/**
+ * One line for each cell, with the averages and peaks
+ */
+static void dvd_bitrate_csv_cells(FILE *output, const struct dvd_bitrate *dvd_bitrate, const uint8_t audio_tracks) {
+
+	const struct dvd_bitrate_stats *dvd_bitrate_stats = NULL;
+	struct dvd_bitrate_streams average;
+	uint16_t padding = 0;
+	uint16_t cell = 0;
+
+	fprintf(output, "cell,start msecs,msecs,vobus,padding share,");
+	dvd_bitrate_csv_header(output, "average ", audio_tracks);
+	fprintf(output, ",");
+	dvd_bitrate_csv_header(output, "peak ", audio_tracks);
+	fprintf(output, "\n");
+
+	for(cell = 1; cell < 256; cell++) {
+
+		dvd_bitrate_stats = &dvd_bitrate->cells[cell];
+
+		if(dvd_bitrate_stats->vobus == 0)
+			continue;
+
+		dvd_bitrate_rates(&average, &dvd_bitrate_stats->bytes, dvd_bitrate_stats->ticks);
+		padding = dvd_bitrate_padding(&dvd_bitrate_stats->bytes);
+
+		fprintf(output, "%u,%u,%" PRIu64 ",%u,%u.%03u,", cell, dvd_bitrate->cell_start[cell], dvd_bitrate_stats->ticks / 90, dvd_bitrate_stats->vobus, padding / 1000, padding % 1000);
+		dvd_bitrate_csv_streams(output, &average, audio_tracks);
+		fprintf(output, ",");
+		dvd_bitrate_csv_streams(output, &dvd_bitrate_stats->peak, audio_tracks);
+		fprintf(output, "\n");
+
+	}
+
+}
+
+int main(int argc, char **argv) {
+
+	/**
+	 * Parse options
+	 */
+
+	bool opt_track_number = false;
+	bool opt_chapter_number = false;
+	bool opt_cells = false;
+	uint16_t arg_track_number = 0;
+	uint8_t arg_first_chapter = 1;
+	uint8_t arg_last_chapter = 99;
+	uint8_t arg_format = DVD_BITRATE_JSON;
+	char *arg_output = NULL;
+	char *token = NULL;
+	int long_index = 0;
+	int opt = 0;
+	opterr = 1;
+	const char *str_options;
+	str_options = "c:Cf:ho:t:V";
+
+	struct option long_options[] = {
+
+		{ "chapters", required_argument, 0, 'c' },
+		{ "cells", no_argument, 0, 'C' },
+		{ "format", required_argument, 0, 'f' },
+		{ "output", required_argument, 0, 'o' },
+		{ "track", required_argument, 0, 't' },
+		{ "help", no_argument, 0, 'h' },
+		{ "version", no_argument, 0, 'V' },
+		{ 0, 0, 0, 0 }
+
+	};
+
+	while((opt = getopt_long(argc, argv, str_options, long_options, &long_index )) != -1) {
+
+		switch(opt) {
+
+			case 'c':
+				opt_chapter_number = true;
+				token = strtok(optarg, "-"); {
+					if(strlen(token) > 2) {
+						fprintf(stderr, "Chapter range must be between 1 and 99\n");
+						return 1;
+					}
+					arg_first_chapter = (uint8_t)strtoumax(token, NULL, 0);
+				}
+
+				token = strtok(NULL, "-");
+				if(token != NULL) {
+					if(strlen(token) > 2) {
+						fprintf(stderr, "Chapter range must be between 1 and 99\n");
+						return 1;
+					}
+					arg_last_chapter = (uint8_t)strtoumax(token, NULL, 0);
+				}
+
+				if(arg_first_chapter == 0)
+					arg_first_chapter = 1;
+				if(arg_last_chapter < arg_first_chapter)
+					arg_last_chapter = arg_first_chapter;
+
+				break;
+
+			case 'C':
+				opt_cells = true;
+				break;
+
+			case 'f':
+				if(strcmp(optarg, "json") == 0)
+					arg_format = DVD_BITRATE_JSON;
+				else if(strcmp(optarg, "csv") == 0)
+					arg_format = DVD_BITRATE_CSV;
+				else {
+					fprintf(stderr, "Format must be json or csv\n");
+					return 1;
+				}
+				break;
+
+			case 'h':
+				print_usage(DVD_INFO_PROGRAM);
+				return 0;
+
+			case 'o':
+				arg_output = optarg;
+				break;
+
+			case 't':
+				opt_track_number = true;
+				arg_track_number = (uint16_t)strtoumax(optarg, NULL, 0);
+				break;
+
+			case 'V':
+				print_version(DVD_INFO_PROGRAM);
+				return 0;
+
+			// ignore unknown arguments
+			case '?':
+				print_usage(DVD_INFO_PROGRAM);
+				return 1;
+
+			// let getopt_long set the variable
+			case 0:
+			default:
+				break;
+
+		}
+
+	}
+
+	// The JSON has the cells and the VOBUs both
+	if(opt_cells && arg_format != DVD_BITRATE_CSV) {
+		fprintf(stderr, "%s: Cell summaries on their own are only for CSV\n", DVD_INFO_PROGRAM);
+		return 1;
+	}
+
+	const char *device_filename = DEFAULT_DVD_DEVICE;
+
+	if (argv[optind])
+		device_filename = argv[optind];
+
+	// Open the DVD, the VMG IFO and check the drive status
+	struct dvd_session *dvd_session = NULL;
+	int session_error = DVD_SESSION_OK;
+
+	dvd_session = dvd_session_open(device_filename, &session_error);
+
+	if(dvd_session == NULL) {
+
+#ifdef __linux__
+		if(session_error == DVD_SESSION_ERR_NO_MEDIA) {
+			fprintf(stderr, "drive status: ");
+			dvd_drive_display_status(device_filename);
+			return 1;
+		}
+#endif
+
+		fprintf(stderr, "%s: %s: %s\n", DVD_INFO_PROGRAM, device_filename, dvd_session_strerror(session_error));
+		return 1;
+
+	}
+
+	struct dvd_info dvd_info;
+	dvd_session_info(dvd_session, &dvd_info);
+
+	uint16_t track_number = dvd_info.longest_track;
+
+	if(opt_track_number && (arg_track_number > dvd_info.tracks || arg_track_number < 1)) {
+		fprintf(stderr, "%s: Invalid track number %d\n", DVD_INFO_PROGRAM, arg_track_number);
+		fprintf(stderr, "%s: Valid track numbers: 1 to %u\n", DVD_INFO_PROGRAM, dvd_info.tracks);
+		dvd_session_close(dvd_session);
+		return 1;
+	} else if(opt_track_number) {
+		track_number = arg_track_number;
+	}
+
+	struct dvd_track dvd_track;
+	dvd_session_track(dvd_session, track_number, &dvd_track);
+
+	if(!dvd_track.valid) {
+		fprintf(stderr, "* Could not open VTS_IFO for track %u\n", track_number);
+		dvd_session_close(dvd_session);
+		return 1;
+	}
+
+	uint8_t first_chapter = 1;
+	uint8_t last_chapter = dvd_track.chapters;
+
+	if(opt_chapter_number) {
+		first_chapter = arg_first_chapter > dvd_track.chapters ? dvd_track.chapters : arg_first_chapter;
+		last_chapter = arg_last_chapter > dvd_track.chapters ? dvd_track.chapters : arg_last_chapter;
+	}
+
+	uint8_t audio_tracks = dvd_track.audio_tracks > DVD_BITRATE_AUDIO ? DVD_BITRATE_AUDIO : dvd_track.audio_tracks;
+
+	fprintf(stderr, "Track: %02u, Length: %s, Chapters: %02u-%02u, Cells: %02u, Audio streams: %02u\n", dvd_track.track, dvd_track.length, first_chapter, last_chapter, dvd_track.cells, audio_tracks);
+
+	FILE *output = stdout;
+
+	if(arg_output != NULL) {
+		output = fopen(arg_output, "w");
+		if(output == NULL) {
+			fprintf(stderr, "%s: Could not open file %s\n", DVD_INFO_PROGRAM, arg_output);
+			dvd_session_track_free(&dvd_track);
+			dvd_session_close(dvd_session);
+			return 1;
+		}
+	}
+
+	// Only the pack headers are read, so this goes as fast as the disc does
+	struct dvd_pipeline *dvd_pipeline = NULL;
+	struct dvd_bitrate dvd_bitrate;
+	struct dvd_bitrate_streams average;
+	bool initialized = false;
+	bool profiled = false;
+	uint16_t padding = 0;
+
+	initialized = dvd_bitrate_init(&dvd_bitrate, dvd_session, &dvd_track, first_chapter);
+	dvd_pipeline = dvd_pipeline_open(dvd_session, track_number, first_chapter, last_chapter);
+
+	if(initialized && dvd_pipeline != NULL && dvd_bitrate_pipeline(dvd_pipeline, &dvd_bitrate))
+		profiled = dvd_pipeline_run(dvd_pipeline);
+
+	dvd_pipeline_close(dvd_pipeline);
+
+	if(profiled && arg_format == DVD_BITRATE_JSON)
+		dvd_bitrate_json(output, &dvd_bitrate, &dvd_track, first_chapter, last_chapter, audio_tracks);
+	else if(profiled && opt_cells)
+		dvd_bitrate_csv_cells(output, &dvd_bitrate, audio_tracks);
+	else if(profiled)
+		dvd_bitrate_csv(output, &dvd_bitrate, audio_tracks);
+
+	if(arg_output != NULL && fclose(output) != 0) {
+		fprintf(stderr, "%s: Could not write file %s\n", DVD_INFO_PROGRAM, arg_output);
+		profiled = false;
+	}
+
+	if(profiled) {
+
+		dvd_bitrate_rates(&average, &dvd_bitrate.track.bytes, dvd_bitrate.track.ticks);
+		padding = dvd_bitrate_padding(&dvd_bitrate.track.bytes);
+
+		fprintf(stderr, "VOBUs: %u, Average: %" PRIu64 " kbps, Peak: %" PRIu64 " kbps, Video: %" PRIu64 " kbps, Padding: %u.%u%%\n", dvd_bitrate.track.vobus, average.total / 1000, dvd_bitrate.track.peak.total / 1000, average.video / 1000, padding / 10, padding % 10);
+
+		if(padding >= DVD_BITRATE_PADDING_WARNING)
+			fprintf(stderr, "%s: Track is mostly padding, it may not be the real one\n", DVD_INFO_PROGRAM);
+
+	}
+
+	dvd_bitrate_free(&dvd_bitrate);
+
+	dvd_session_track_free(&dvd_track);
+
+	dvd_session_close(dvd_session);
+
+	return profiled ? 0 : 1;
+
+}
+
+void print_usage(char *binary) {
+
+	printf("%s %s - profile the bitrates of a DVD track\n", binary, VERSION);
+	printf("\n");
+	printf("Usage: %s [-t track] [-c chapter[-chapter]] [-f json|csv] [-C] [-o filename] [dvd path]\n", binary);
+	printf("\n");
+	printf("Options:\n");
+	printf("  -t, --track <#>		Track to read (default: longest)\n");
+	printf("  -c, --chapters <#>[-#]	Chapters to read (default: all)\n");
+	printf("  -f, --format <json|csv>	Write the track, cells and each VOBU as JSON, or\n");
+	printf("				a line for each VOBU as CSV (default: json)\n");
+	printf("  -C, --cells			Write a line for each cell instead (CSV)\n");
+	printf("  -o, --output <filename>	Save to a file (default: standard output)\n");
+	printf("\n");
+	printf("Bitrates are in bits a second, for the whole of the stream and for the\n");
+	printf("video, each audio stream, the subtitles and the padding.  Only the pack\n");
+	printf("and packet headers are read.  Times are from the start of the first\n");
+	printf("chapter that is read.\n");
+	printf("\n");
+	printf("DVD path can be a directory, a device filename, or a local file.\n");
+	printf("\n");
+	printf("Examples:\n");
+	printf("  %s movie.iso > movie.json\n", binary);
+	printf("  %s -t 2 -f csv -C -o cells.csv " DEFAULT_DVD_DEVICE "\n", binary);
+	printf("\n");
+	printf("If no DVD path is given, %s is used in its place.\n", DEFAULT_DVD_DEVICE);
+
+}
+
+void print_version(char *binary) {
+
+	printf("%s %s - http://dvds.beandog.org/ - (c) 2018 Steve Dibb <steve.dibb@gmail.com>, licensed under GPL-2\n", binary, VERSION);
+
+}
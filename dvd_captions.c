@@ -0,0 +1,569 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdbool.h>
+#include <getopt.h>
+#include <limits.h>
+#include <inttypes.h>
+#ifdef __linux__
+#include <linux/cdrom.h>
+#include "dvd_drive.h"
+#endif
+#include <dvdread/dvd_reader.h>
+#include <dvdread/ifo_read.h>
+#include "dvd_info.h"
+#include "dvd_device.h"
+#include "dvd_track.h"
+#include "dvd_chapter.h"
+#include "dvd_cell.h"
+#include "dvd_time.h"
+#include "dvd_session.h"
+#include "dvd_pipeline.h"
+#include "dvd_demux.h"
+#include "dvd_vobu.h"
+#include "dvd_es.h"
+#include "dvd_cc.h"
+#ifndef VERSION
+#define VERSION "1.2"
+#endif
+
+#ifndef DVD_VIDEO_LB_LEN
+#define DVD_VIDEO_LB_LEN 2048
+#endif
+
+#define DVD_INFO_PROGRAM "dvd_captions"
+
+#define DVD_CAPTIONS_SRT 0
+#define DVD_CAPTIONS_SCC 1
+
+int main(int, char **);
+void print_usage(char *binary);
+void print_version(char *binary);
+
+/**
+ * Times are from the start of the first cell that is read.  A PTS is turned
+ * into one using the NAV pack of the VOBU it is in, which has the time into
+ * the cell and the PTS the VOBU starts at.
+ *
+ * Captions in the DVD format come before the first picture of a GOP, and are
+ * held until its header says how far into the GOP it is displayed.  ATSC
+ * captions come after the header of the picture they go with, in the order
+ * the pictures are coded.  A B picture is displayed before the I or P
+ * picture coded ahead of it, so the words of an I or P picture are held
+ * until the next one comes, and those of a B picture are written right
+ * away.
+ */
+struct dvd_captions {
+	uint32_t cell_start[256];
+	uint8_t cell;
+	struct dvd_vobu dvd_vobu;
+	bool has_vobu;
+	struct dvd_demux *dvd_demux;
+	struct dvd_es dvd_es;
+	struct dvd_es_stats dvd_es_stats;
+	struct dvd_cc *dvd_cc;
+	FILE *output;
+	uint8_t format;
+	uint8_t field;
+	uint64_t ticks;
+	uint64_t gop_ticks;
+	uint64_t end_ticks;
+	struct dvd_cc_word pending[DVD_CC_MAX_WORDS];
+	uint16_t pending_words;
+	struct dvd_cc_word anchor[DVD_CC_MAX_WORDS];
+	uint16_t anchor_words;
+	uint64_t anchor_ticks;
+	uint8_t picture_type;
+	uint32_t words;
+};
+
+/**
+ * Length of a frame, in 90 kHz ticks
+ */
+static uint32_t dvd_captions_frame(const struct dvd_captions *dvd_captions) {
+
+	if(dvd_captions->dvd_es.frame_rate_code == 3)
+		return 3600;
+
+	return 3003;
+
+}
+
+/**
+ * Time of a PTS from the start of the first cell, in 90 kHz ticks
+ */
+static uint64_t dvd_captions_pts_ticks(const struct dvd_captions *dvd_captions, const uint64_t pts) {
+
+	int64_t ticks = 0;
+
+	if(!dvd_captions->has_vobu)
+		return pts;
+
+	ticks = ((int64_t)dvd_captions->cell_start[dvd_captions->cell] + dvd_captions->dvd_vobu.cell_msecs) * 90 + (int64_t)pts - (int64_t)dvd_captions->dvd_vobu.start_pts;
+
+	return ticks > 0 ? (uint64_t)ticks : 0;
+
+}
+
+/**
+ * Decode or write the words of one block
+ *
+ * @param base time of the first frame of the block (90 kHz)
+ */
+static void dvd_captions_words(struct dvd_captions *dvd_captions, const struct dvd_cc_word *cc_words, const uint16_t words, const uint64_t base) {
+
+	uint32_t frame = dvd_captions_frame(dvd_captions);
+	uint8_t data[DVD_CC_MAX_WORDS * 2];
+	uint32_t first_msecs = 0;
+	uint16_t scc_words = 0;
+	uint16_t last = 0;
+	uint16_t ix = 0;
+
+	for(ix = 0; ix < words; ix++) {
+
+		if(cc_words[ix].field != dvd_captions->field)
+			continue;
+
+		if(!dvd_cc_padding(cc_words[ix].data))
+			dvd_captions->words++;
+
+		if(dvd_captions->format == DVD_CAPTIONS_SRT) {
+			dvd_cc_decode(dvd_captions->dvd_cc, cc_words[ix].data, (uint32_t)((base + (uint64_t)cc_words[ix].frame * frame) / 90));
+			continue;
+		}
+
+		// SCC has one word a frame from the time on the line, so only the padding at either end is left out
+		if(scc_words == 0 && dvd_cc_padding(cc_words[ix].data))
+			continue;
+
+		if(scc_words == 0)
+			first_msecs = (uint32_t)((base + (uint64_t)cc_words[ix].frame * frame) / 90);
+
+		data[scc_words * 2] = cc_words[ix].data[0];
+		data[scc_words * 2 + 1] = cc_words[ix].data[1];
+		scc_words++;
+
+		if(!dvd_cc_padding(cc_words[ix].data))
+			last = scc_words;
+
+	}
+
+	if(dvd_captions->format == DVD_CAPTIONS_SCC)
+		dvd_cc_scc_line(dvd_captions->output, first_msecs, data, last);
+
+}
+
+static void dvd_captions_user_data(void *data, const uint8_t *buf, const size_t length) {
+
+	struct dvd_captions *dvd_captions = (struct dvd_captions *)data;
+	struct dvd_cc_word cc_words[DVD_CC_MAX_WORDS];
+	uint16_t words = 0;
+	uint8_t format = 0;
+
+	words = dvd_cc_words(buf, length, cc_words, &format);
+
+	if(words == 0)
+		return;
+
+	// ATSC captions are for the picture they come after
+	if(format == DVD_CC_ATSC && dvd_captions->picture_type == 3) {
+		dvd_captions_words(dvd_captions, cc_words, words, dvd_captions->ticks);
+		return;
+	}
+
+	if(format == DVD_CC_ATSC) {
+		memcpy(dvd_captions->anchor, cc_words, words * sizeof(struct dvd_cc_word));
+		dvd_captions->anchor_words = words;
+		dvd_captions->anchor_ticks = dvd_captions->ticks;
+		return;
+	}
+
+	memcpy(dvd_captions->pending, cc_words, words * sizeof(struct dvd_cc_word));
+	dvd_captions->pending_words = words;
+
+}
+
+/**
+ * Write the ATSC words held for the last I or P picture
+ */
+static void dvd_captions_anchor(struct dvd_captions *dvd_captions) {
+
+	if(dvd_captions->anchor_words == 0)
+		return;
+
+	dvd_captions_words(dvd_captions, dvd_captions->anchor, dvd_captions->anchor_words, dvd_captions->anchor_ticks);
+
+	dvd_captions->anchor_words = 0;
+
+}
+
+static void dvd_captions_picture(void *data, const struct dvd_es_picture *dvd_es_picture) {
+
+	struct dvd_captions *dvd_captions = (struct dvd_captions *)data;
+	uint32_t frame = dvd_captions_frame(dvd_captions);
+	uint64_t offset = (uint64_t)dvd_es_picture->temporal_reference * frame;
+
+	// A picture is displayed at its PTS, or the temporal reference into its
+	// GOP.  An I picture with no PTS starts a GOP after the last frame so far.
+	if(dvd_es_picture->has_pts) {
+		dvd_captions->ticks = dvd_captions_pts_ticks(dvd_captions, dvd_es_picture->pts);
+		dvd_captions->gop_ticks = dvd_captions->ticks > offset ? dvd_captions->ticks - offset : 0;
+	} else {
+		if(dvd_es_picture->type == 1)
+			dvd_captions->gop_ticks = dvd_captions->end_ticks;
+		dvd_captions->ticks = dvd_captions->gop_ticks + offset;
+	}
+
+	if(dvd_captions->ticks + frame > dvd_captions->end_ticks)
+		dvd_captions->end_ticks = dvd_captions->ticks + frame;
+
+	dvd_captions->picture_type = dvd_es_picture->type;
+
+	if(dvd_es_picture->type != 3)
+		dvd_captions_anchor(dvd_captions);
+
+	if(dvd_captions->pending_words == 0)
+		return;
+
+	// The block starts with the first frame displayed in the GOP
+	dvd_captions_words(dvd_captions, dvd_captions->pending, dvd_captions->pending_words, dvd_captions->gop_ticks);
+
+	dvd_captions->pending_words = 0;
+
+}
+
+static bool dvd_captions_output(void *data, const struct dvd_demux_packet *dvd_demux_packet) {
+
+	struct dvd_captions *dvd_captions = (struct dvd_captions *)data;
+
+	if(dvd_demux_packet->pes_start && dvd_demux_packet->has_pts)
+		dvd_es_pts(&dvd_captions->dvd_es, dvd_demux_packet->pts);
+
+	dvd_es_parse(&dvd_captions->dvd_es, dvd_demux_packet->buffer, dvd_demux_packet->buffer + dvd_demux_packet->length);
+
+	return true;
+
+}
+
+/**
+ * Go through the blocks one at a time, so each NAV pack is read before the
+ * video of its VOBU
+ */
+static bool dvd_captions_write(void *data, const struct dvd_pipeline_blocks *dvd_pipeline_blocks) {
+
+	struct dvd_captions *dvd_captions = (struct dvd_captions *)data;
+	uint8_t *block = NULL;
+	ssize_t ix = 0;
+
+	dvd_captions->cell = dvd_pipeline_blocks->cell;
+
+	for(ix = 0; ix < dvd_pipeline_blocks->blocks; ix++) {
+
+		block = (uint8_t *)dvd_pipeline_blocks->buffer + ix * DVD_VIDEO_LB_LEN;
+
+		if(dvd_vobu_parse(&dvd_captions->dvd_vobu, block)) {
+			dvd_captions->has_vobu = true;
+			continue;
+		}
+
+		if(dvd_demux(dvd_captions->dvd_demux, block, block + DVD_VIDEO_LB_LEN, 0) == DVD_DEMUX_ERROR)
+			return false;
+
+	}
+
+	return true;
+
+}
+
+int main(int argc, char **argv) {
+
+	/**
+	 * Parse options
+	 */
+
+	bool opt_track_number = false;
+	bool opt_chapter_number = false;
+	uint16_t arg_track_number = 0;
+	uint8_t arg_first_chapter = 1;
+	uint8_t arg_last_chapter = 99;
+	uint8_t arg_channel = 1;
+	uint8_t arg_format = DVD_CAPTIONS_SRT;
+	char *arg_output = NULL;
+	char *token = NULL;
+	int long_index = 0;
+	int opt = 0;
+	opterr = 1;
+	const char *str_options;
+	str_options = "c:C:f:ho:t:V";
+
+	struct option long_options[] = {
+
+		{ "chapters", required_argument, 0, 'c' },
+		{ "channel", required_argument, 0, 'C' },
+		{ "format", required_argument, 0, 'f' },
+		{ "output", required_argument, 0, 'o' },
+		{ "track", required_argument, 0, 't' },
+		{ "help", no_argument, 0, 'h' },
+		{ "version", no_argument, 0, 'V' },
+		{ 0, 0, 0, 0 }
+
+	};
+
+	while((opt = getopt_long(argc, argv, str_options, long_options, &long_index )) != -1) {
+
+		switch(opt) {
+
+			case 'c':
+				opt_chapter_number = true;
+				token = strtok(optarg, "-"); {
+					if(strlen(token) > 2) {
+						fprintf(stderr, "Chapter range must be between 1 and 99\n");
+						return 1;
+					}
+					arg_first_chapter = (uint8_t)strtoumax(token, NULL, 0);
+				}
+
+				token = strtok(NULL, "-");
+				if(token != NULL) {
+					if(strlen(token) > 2) {
+						fprintf(stderr, "Chapter range must be between 1 and 99\n");
+						return 1;
+					}
+					arg_last_chapter = (uint8_t)strtoumax(token, NULL, 0);
+				}
+
+				if(arg_first_chapter == 0)
+					arg_first_chapter = 1;
+				if(arg_last_chapter < arg_first_chapter)
+					arg_last_chapter = arg_first_chapter;
+
+				break;
+
+			case 'C':
+				arg_channel = (uint8_t)strtoumax(optarg, NULL, 0);
+				if(arg_channel < 1 || arg_channel > 4) {
+					fprintf(stderr, "Channel must be between 1 and 4\n");
+					return 1;
+				}
+				break;
+
+			case 'f':
+				if(strcmp(optarg, "srt") == 0)
+					arg_format = DVD_CAPTIONS_SRT;
+				else if(strcmp(optarg, "scc") == 0)
+					arg_format = DVD_CAPTIONS_SCC;
+				else {
+					fprintf(stderr, "Format must be srt or scc\n");
+					return 1;
+				}
+				break;
+
+			case 'h':
+				print_usage(DVD_INFO_PROGRAM);
+				return 0;
+
+			case 'o':
+				arg_output = optarg;
+				break;
+
+			case 't':
+				opt_track_number = true;
+				arg_track_number = (uint16_t)strtoumax(optarg, NULL, 0);
+				break;
+
+			case 'V':
+				print_version(DVD_INFO_PROGRAM);
+				return 0;
+
+			// ignore unknown arguments
+			case '?':
+				print_usage(DVD_INFO_PROGRAM);
+				return 1;
+
+			// let getopt_long set the variable
+			case 0:
+			default:
+				break;
+
+		}
+
+	}
+
+	// SCC only has field 1
+	if(arg_format == DVD_CAPTIONS_SCC && arg_channel > 2) {
+		fprintf(stderr, "%s: SCC files only have channels 1 and 2\n", DVD_INFO_PROGRAM);
+		return 1;
+	}
+
+	const char *device_filename = DEFAULT_DVD_DEVICE;
+
+	if (argv[optind])
+		device_filename = argv[optind];
+
+	// Open the DVD, the VMG IFO and check the drive status
+	struct dvd_session *dvd_session = NULL;
+	int session_error = DVD_SESSION_OK;
+
+	dvd_session = dvd_session_open(device_filename, &session_error);
+
+	if(dvd_session == NULL) {
+
+#ifdef __linux__
+		if(session_error == DVD_SESSION_ERR_NO_MEDIA) {
+			fprintf(stderr, "drive status: ");
+			dvd_drive_display_status(device_filename);
+			return 1;
+		}
+#endif
+
+		fprintf(stderr, "%s: %s: %s\n", DVD_INFO_PROGRAM, device_filename, dvd_session_strerror(session_error));
+		return 1;
+
+	}
+
+	struct dvd_info dvd_info;
+	dvd_session_info(dvd_session, &dvd_info);
+
+	uint16_t track_number = dvd_info.longest_track;
+
+	if(opt_track_number && (arg_track_number > dvd_info.tracks || arg_track_number < 1)) {
+		fprintf(stderr, "%s: Invalid track number %d\n", DVD_INFO_PROGRAM, arg_track_number);
+		fprintf(stderr, "%s: Valid track numbers: 1 to %u\n", DVD_INFO_PROGRAM, dvd_info.tracks);
+		dvd_session_close(dvd_session);
+		return 1;
+	} else if(opt_track_number) {
+		track_number = arg_track_number;
+	}
+
+	struct dvd_track dvd_track;
+	dvd_session_track(dvd_session, track_number, &dvd_track);
+
+	if(!dvd_track.valid) {
+		fprintf(stderr, "* Could not open VTS_IFO for track %u\n", track_number);
+		dvd_session_close(dvd_session);
+		return 1;
+	}
+
+	uint8_t first_chapter = 1;
+	uint8_t last_chapter = dvd_track.chapters;
+
+	if(opt_chapter_number) {
+		first_chapter = arg_first_chapter > dvd_track.chapters ? dvd_track.chapters : arg_first_chapter;
+		last_chapter = arg_last_chapter > dvd_track.chapters ? dvd_track.chapters : arg_last_chapter;
+	}
+
+	fprintf(stderr, "Track: %02u, Length: %s, Chapters: %02u-%02u, Cells: %02u\n", dvd_track.track, dvd_track.length, first_chapter, last_chapter, dvd_track.cells);
+
+	// Where each cell starts, from the first one that is read
+	ifo_handle_t *vmg_ifo = dvd_session_vmg_ifo(dvd_session);
+	ifo_handle_t *vts_ifo = dvd_session_track_ifo(dvd_session, track_number);
+	struct dvd_captions dvd_captions;
+	uint8_t first_cell = dvd_chapter_first_cell(vmg_ifo, vts_ifo, track_number, first_chapter);
+
+	memset(&dvd_captions, 0, sizeof(dvd_captions));
+
+	dvd_cell_starts(vmg_ifo, vts_ifo, track_number, first_cell, dvd_captions.cell_start);
+
+	dvd_captions.format = arg_format;
+	dvd_captions.field = arg_channel <= 2 ? 1 : 2;
+	dvd_captions.output = stdout;
+
+	if(arg_output != NULL) {
+		dvd_captions.output = fopen(arg_output, "w");
+		if(dvd_captions.output == NULL) {
+			fprintf(stderr, "%s: Could not open file %s\n", DVD_INFO_PROGRAM, arg_output);
+			dvd_session_track_free(&dvd_track);
+			dvd_session_close(dvd_session);
+			return 1;
+		}
+	}
+
+	struct dvd_pipeline *dvd_pipeline = NULL;
+	bool extracted = false;
+	uint32_t cues = 0;
+
+	dvd_es_init(&dvd_captions.dvd_es, &dvd_captions.dvd_es_stats);
+	dvd_es_callbacks(&dvd_captions.dvd_es, dvd_captions_user_data, dvd_captions_picture, &dvd_captions);
+
+	if(arg_format == DVD_CAPTIONS_SRT)
+		dvd_captions.dvd_cc = dvd_cc_open(arg_channel, dvd_captions.output);
+	else
+		dvd_cc_scc_header(dvd_captions.output);
+
+	dvd_captions.dvd_demux = dvd_demux_open(DVD_DEMUX_VIDEO, dvd_captions_output, &dvd_captions);
+	dvd_pipeline = dvd_pipeline_open(dvd_session, track_number, first_chapter, last_chapter);
+
+	if(dvd_captions.dvd_demux != NULL && dvd_pipeline != NULL && (arg_format == DVD_CAPTIONS_SCC || dvd_captions.dvd_cc != NULL)) {
+
+		if(dvd_pipeline_add(dvd_pipeline, "captions", dvd_captions_write, NULL, &dvd_captions))
+			extracted = dvd_pipeline_run(dvd_pipeline);
+
+	}
+
+	dvd_pipeline_close(dvd_pipeline);
+
+	dvd_es_flush(&dvd_captions.dvd_es);
+
+	dvd_captions_anchor(&dvd_captions);
+
+	cues = dvd_cc_close(dvd_captions.dvd_cc, (uint32_t)(dvd_captions.end_ticks / 90));
+
+	dvd_demux_close(dvd_captions.dvd_demux);
+
+	if(arg_output != NULL && fclose(dvd_captions.output) != 0) {
+		fprintf(stderr, "%s: Could not write file %s\n", DVD_INFO_PROGRAM, arg_output);
+		extracted = false;
+	}
+
+	if(extracted) {
+		fprintf(stderr, "Frames: %u, Caption words: %u", dvd_captions.dvd_es_stats.frames, dvd_captions.words);
+		if(arg_format == DVD_CAPTIONS_SRT)
+			fprintf(stderr, ", Cues: %u", cues);
+		fprintf(stderr, "\n");
+	}
+
+	if(extracted && dvd_captions.words == 0)
+		fprintf(stderr, "%s: No closed captions found\n", DVD_INFO_PROGRAM);
+
+	dvd_session_track_free(&dvd_track);
+
+	dvd_session_close(dvd_session);
+
+	return extracted ? 0 : 1;
+
+}
+
+void print_usage(char *binary) {
+
+	printf("%s %s - extract the closed captions of a DVD track\n", binary, VERSION);
+	printf("\n");
+	printf("Usage: %s [-t track] [-c chapter[-chapter]] [-C channel] [-f srt|scc] [-o filename] [dvd path]\n", binary);
+	printf("\n");
+	printf("Options:\n");
+	printf("  -t, --track <#>		Track to read (default: longest)\n");
+	printf("  -c, --chapters <#>[-#]	Chapters to read (default: all)\n");
+	printf("  -C, --channel <#>		Caption channel, 1 to 4 (default: 1)\n");
+	printf("  -f, --format <srt|scc>	Write SubRip cues, or the caption data as it is\n");
+	printf("				in a Scenarist file (default: srt)\n");
+	printf("  -o, --output <filename>	Save to a file (default: standard output)\n");
+	printf("\n");
+	printf("The captions are read from the user data of the video, nothing is decoded.\n");
+	printf("Times are from the start of the first chapter that is read.\n");
+	printf("\n");
+	printf("DVD path can be a directory, a device filename, or a local file.\n");
+	printf("\n");
+	printf("Examples:\n");
+	printf("  %s movie.iso > movie.srt\n", binary);
+	printf("  %s -t 2 -f scc -o episode.scc " DEFAULT_DVD_DEVICE "\n", binary);
+	printf("\n");
+	printf("If no DVD path is given, %s is used in its place.\n", DEFAULT_DVD_DEVICE);
+
+}
+
+void print_version(char *binary) {
+
+	printf("%s %s - http://dvds.beandog.org/ - (c) 2018 Steve Dibb <steve.dibb@gmail.com>, licensed under GPL-2\n", binary, VERSION);
+
+}
@@ -0,0 +1,428 @@
+#include "dvd_cbor.h"
+
+/**
+ * Binary output of the same data that dvd_json() displays, encoded as CBOR
+ * (RFC 7049).  CBOR is self-describing, so any generic decoder can read it,
+ * and it is much cheaper to parse (and smaller to store) than the JSON.
+ *
+ * The values are written straight from the structs to stdout, there is no
+ * text representation built in between.
+ *
+ * The schema is the same as the JSON output, with the same key names, so that
+ * anything reading one can read the other.  The only difference is that JSON
+ * has "cells" twice on a track (the number of cells, and then the array of
+ * them), and CBOR maps can't have duplicate keys, so only the array is kept.
+ * The number of cells is the length of the array.
+ *
+ * "valid" and "active" are unsigned integers, 0 or 1, as they are in the
+ * JSON.  "letterbox" and "closed captions" are booleans.
+ *
+ * The stream starts with the self-describe CBOR tag (0xd9d9f7) so that the
+ * file can be identified by its magic bytes.
+ *
+ * {
+ *  "dvd": { "title", "side", "tracks", "longest track", ["provider id"], ["vmg id"], "video title sets", "dvdread id" },
+ *  "tracks": [
+ *   { "track", "valid" } if the track is invalid, otherwise:
+ *   { "track", "valid", "length", "msecs", "vts", "ttn",
+ *     "video": { ["codec"], ["format"], ["aspect ratio"], "width", "height", "angles", ["fps"], "letterbox", ["crop": { "top", "bottom", "left", "right", "width", "height" }], ["closed captions"], ["scan"] },
+ *     ["audio"]: [ { "track", "active", ["lang code"], "codec", "channels", "stream id" } ],
+ *     ["subtitles"]: [ { "track", "active", ["lang code"], "stream id" } ],
+ *     ["chapters"]: [ { "chapter", "length", "msecs", "first cell", "last cell" } ],
+ *     ["cells"]: [ { "cell", "length", "msecs", "first sector", "last sector", ["scan"] } ]
+ *
+ * "scan" is { "type", "frames", "progressive frames", "repeat first field", "top field first", "3:2 cadence", "fields" }
+ *   }
+ *  ]
+ * }
+ */
+
+#define CBOR_UINT 0
+#define CBOR_TEXT 3
+#define CBOR_ARRAY 4
+#define CBOR_MAP 5
+#define CBOR_TAG 6
+#define CBOR_SIMPLE 7
+
+#define CBOR_FALSE 20
+#define CBOR_TRUE 21
+#define CBOR_SELF_DESCRIBE 55799
+
+/**
+ * Write the initial byte of a data item, followed by the argument in the
+ * shortest form possible.
+ */
+static void cbor_head(const uint8_t major_type, const uint64_t value) {
+
+	uint8_t head[9];
+	size_t len = 0;
+	uint8_t major = (uint8_t)(major_type << 5);
+
+	if(value < 24) {
+		head[0] = major | (uint8_t)value;
+		len = 1;
+	} else if(value <= UINT8_MAX) {
+		head[0] = major | 24;
+		head[1] = (uint8_t)value;
+		len = 2;
+	} else if(value <= UINT16_MAX) {
+		head[0] = major | 25;
+		head[1] = (uint8_t)(value >> 8);
+		head[2] = (uint8_t)value;
+		len = 3;
+	} else if(value <= UINT32_MAX) {
+		head[0] = major | 26;
+		head[1] = (uint8_t)(value >> 24);
+		head[2] = (uint8_t)(value >> 16);
+		head[3] = (uint8_t)(value >> 8);
+		head[4] = (uint8_t)value;
+		len = 5;
+	} else {
+		head[0] = major | 27;
+		head[1] = (uint8_t)(value >> 56);
+		head[2] = (uint8_t)(value >> 48);
+		head[3] = (uint8_t)(value >> 40);
+		head[4] = (uint8_t)(value >> 32);
+		head[5] = (uint8_t)(value >> 24);
+		head[6] = (uint8_t)(value >> 16);
+		head[7] = (uint8_t)(value >> 8);
+		head[8] = (uint8_t)value;
+		len = 9;
+	}
+
+	fwrite(head, 1, len, stdout);
+
+}
+
+static void cbor_uint(const uint64_t value) {
+
+	cbor_head(CBOR_UINT, value);
+
+}
+
+static void cbor_bool(const bool value) {
+
+	cbor_head(CBOR_SIMPLE, value ? CBOR_TRUE : CBOR_FALSE);
+
+}
+
+static void cbor_text(const char *str) {
+
+	size_t len = strlen(str);
+
+	cbor_head(CBOR_TEXT, len);
+	fwrite(str, 1, len, stdout);
+
+}
+
+static void cbor_map(const uint64_t pairs) {
+
+	cbor_head(CBOR_MAP, pairs);
+
+}
+
+static void cbor_array(const uint64_t items) {
+
+	cbor_head(CBOR_ARRAY, items);
+
+}
+
+/**
+ * "scan", the frame flags from the video headers
+ */
+static void cbor_scan(const struct dvd_es_stats *dvd_es_stats) {
+
+	cbor_text("scan");
+	cbor_map(7);
+	cbor_text("type");
+	cbor_text(dvd_es_scan_name(dvd_es_stats->scan));
+	cbor_text("frames");
+	cbor_uint(dvd_es_stats->frames);
+	cbor_text("progressive frames");
+	cbor_uint(dvd_es_stats->progressive);
+	cbor_text("repeat first field");
+	cbor_uint(dvd_es_stats->repeat_first_field);
+	cbor_text("top field first");
+	cbor_uint(dvd_es_stats->top_field_first);
+	cbor_text("3:2 cadence");
+	cbor_uint(dvd_es_stats->cadence);
+	cbor_text("fields");
+	cbor_uint(dvd_es_stats->fields);
+
+}
+
+void dvd_cbor(struct dvd_info dvd_info, struct dvd_track dvd_tracks[], uint16_t track_number, uint16_t d_first_track, uint16_t d_last_track) {
+
+	struct dvd_track dvd_track;
+	struct dvd_video dvd_video;
+	struct dvd_audio dvd_audio;
+	struct dvd_subtitle dvd_subtitle;
+	struct dvd_chapter dvd_chapter;
+	struct dvd_cell dvd_cell;
+	uint8_t c = 0;
+	uint8_t pairs = 0;
+
+	cbor_head(CBOR_TAG, CBOR_SELF_DESCRIBE);
+
+	cbor_map(2);
+
+	// DVD
+	pairs = 6;
+	if(strlen(dvd_info.provider_id))
+		pairs++;
+	if(strlen(dvd_info.vmg_id))
+		pairs++;
+
+	cbor_text("dvd");
+	cbor_map(pairs);
+	cbor_text("title");
+	cbor_text(dvd_info.title);
+	cbor_text("side");
+	cbor_uint(dvd_info.side);
+	cbor_text("tracks");
+	cbor_uint(dvd_info.tracks);
+	cbor_text("longest track");
+	cbor_uint(dvd_info.longest_track);
+	if(strlen(dvd_info.provider_id)) {
+		cbor_text("provider id");
+		cbor_text(dvd_info.provider_id);
+	}
+	if(strlen(dvd_info.vmg_id)) {
+		cbor_text("vmg id");
+		cbor_text(dvd_info.vmg_id);
+	}
+	cbor_text("video title sets");
+	cbor_uint(dvd_info.video_title_sets);
+	cbor_text("dvdread id");
+	cbor_text(dvd_info.dvdread_id);
+
+	// DVD title tracks
+	cbor_text("tracks");
+	cbor_array(d_last_track - d_first_track + 1);
+
+	for(track_number = d_first_track; track_number <= d_last_track; track_number++) {
+
+		dvd_track = dvd_tracks[track_number - 1];
+
+		// If the title track is invalid, there's nothing else to display
+		if(dvd_track.valid == false) {
+			cbor_map(2);
+			cbor_text("track");
+			cbor_uint(dvd_track.track);
+			cbor_text("valid");
+			cbor_uint(0);
+			continue;
+		}
+
+		pairs = 7;
+		if(dvd_track.audio_tracks)
+			pairs++;
+		if(dvd_track.subtitles)
+			pairs++;
+		if(dvd_track.chapters)
+			pairs++;
+		if(dvd_track.cells)
+			pairs++;
+
+		cbor_map(pairs);
+		cbor_text("track");
+		cbor_uint(dvd_track.track);
+		cbor_text("valid");
+		cbor_uint(1);
+		cbor_text("length");
+		cbor_text(dvd_track.length);
+		cbor_text("msecs");
+		cbor_uint(dvd_track.msecs);
+		cbor_text("vts");
+		cbor_uint(dvd_track.vts);
+		cbor_text("ttn");
+		cbor_uint(dvd_track.ttn);
+
+		// Video
+		dvd_video = dvd_track.dvd_video;
+
+		pairs = 4;
+		if(strlen(dvd_video.codec))
+			pairs++;
+		if(strlen(dvd_video.format))
+			pairs++;
+		if(strlen(dvd_video.aspect_ratio))
+			pairs++;
+		if(strlen(dvd_video.fps))
+			pairs++;
+		if(dvd_video.crop)
+			pairs++;
+		if(dvd_video.dvd_es_stats.frames)
+			pairs += 2;
+
+		cbor_text("video");
+		cbor_map(pairs);
+		if(strlen(dvd_video.codec)) {
+			cbor_text("codec");
+			cbor_text(dvd_video.codec);
+		}
+		if(strlen(dvd_video.format)) {
+			cbor_text("format");
+			cbor_text(dvd_video.format);
+		}
+		if(strlen(dvd_video.aspect_ratio)) {
+			cbor_text("aspect ratio");
+			cbor_text(dvd_video.aspect_ratio);
+		}
+		cbor_text("width");
+		cbor_uint(dvd_video.width);
+		cbor_text("height");
+		cbor_uint(dvd_video.height);
+		cbor_text("angles");
+		cbor_uint(dvd_video.angles);
+		cbor_text("letterbox");
+		cbor_bool(dvd_video.letterbox);
+		if(strlen(dvd_video.fps)) {
+			cbor_text("fps");
+			cbor_text(dvd_video.fps);
+		}
+		if(dvd_video.crop) {
+			cbor_text("crop");
+			cbor_map(6);
+			cbor_text("top");
+			cbor_uint(dvd_video.crop_top);
+			cbor_text("bottom");
+			cbor_uint(dvd_video.crop_bottom);
+			cbor_text("left");
+			cbor_uint(dvd_video.crop_left);
+			cbor_text("right");
+			cbor_uint(dvd_video.crop_right);
+			cbor_text("width");
+			cbor_uint(dvd_video.width - dvd_video.crop_left - dvd_video.crop_right);
+			cbor_text("height");
+			cbor_uint(dvd_video.height - dvd_video.crop_top - dvd_video.crop_bottom);
+		}
+		if(dvd_video.dvd_es_stats.frames) {
+			cbor_text("closed captions");
+			cbor_bool(dvd_video.dvd_es_stats.captions);
+			cbor_scan(&dvd_video.dvd_es_stats);
+		}
+
+		// Audio tracks
+		if(dvd_track.audio_tracks) {
+
+			cbor_text("audio");
+			cbor_array(dvd_track.audio_tracks);
+
+			for(c = 0; c < dvd_track.audio_tracks; c++) {
+
+				dvd_audio = dvd_track.dvd_audio_tracks[c];
+
+				pairs = 5;
+				if(strlen(dvd_audio.lang_code) == DVD_AUDIO_LANG_CODE)
+					pairs++;
+
+				cbor_map(pairs);
+				cbor_text("track");
+				cbor_uint(dvd_audio.track);
+				cbor_text("active");
+				cbor_uint(dvd_audio.active);
+				if(strlen(dvd_audio.lang_code) == DVD_AUDIO_LANG_CODE) {
+					cbor_text("lang code");
+					cbor_text(dvd_audio.lang_code);
+				}
+				cbor_text("codec");
+				cbor_text(dvd_audio.codec);
+				cbor_text("channels");
+				cbor_uint(dvd_audio.channels);
+				cbor_text("stream id");
+				cbor_text(dvd_audio.stream_id);
+
+			}
+
+		}
+
+		// Subtitles
+		if(dvd_track.subtitles) {
+
+			cbor_text("subtitles");
+			cbor_array(dvd_track.subtitles);
+
+			for(c = 0; c < dvd_track.subtitles; c++) {
+
+				dvd_subtitle = dvd_track.dvd_subtitles[c];
+
+				pairs = 3;
+				if(strlen(dvd_subtitle.lang_code) == DVD_SUBTITLE_LANG_CODE)
+					pairs++;
+
+				cbor_map(pairs);
+				cbor_text("track");
+				cbor_uint(dvd_subtitle.track);
+				cbor_text("active");
+				cbor_uint(dvd_subtitle.active);
+				if(strlen(dvd_subtitle.lang_code) == DVD_SUBTITLE_LANG_CODE) {
+					cbor_text("lang code");
+					cbor_text(dvd_subtitle.lang_code);
+				}
+				cbor_text("stream id");
+				cbor_text(dvd_subtitle.stream_id);
+
+			}
+
+		}
+
+		// Chapters
+		if(dvd_track.chapters) {
+
+			cbor_text("chapters");
+			cbor_array(dvd_track.chapters);
+
+			for(c = 0; c < dvd_track.chapters; c++) {
+
+				dvd_chapter = dvd_track.dvd_chapters[c];
+
+				cbor_map(5);
+				cbor_text("chapter");
+				cbor_uint(dvd_chapter.chapter);
+				cbor_text("length");
+				cbor_text(dvd_chapter.length);
+				cbor_text("msecs");
+				cbor_uint(dvd_chapter.msecs);
+				cbor_text("first cell");
+				cbor_uint(dvd_chapter.first_cell);
+				cbor_text("last cell");
+				cbor_uint(dvd_chapter.last_cell);
+
+			}
+
+		}
+
+		// Cells
+		if(dvd_track.cells) {
+
+			cbor_text("cells");
+			cbor_array(dvd_track.cells);
+
+			for(c = 0; c < dvd_track.cells; c++) {
+
+				dvd_cell = dvd_track.dvd_cells[c];
+
+				cbor_map(dvd_video.dvd_es_stats.frames ? 6 : 5);
+				cbor_text("cell");
+				cbor_uint(dvd_cell.cell);
+				cbor_text("length");
+				cbor_text(dvd_cell.length);
+				cbor_text("msecs");
+				cbor_uint(dvd_cell.msecs);
+				cbor_text("first sector");
+				cbor_uint(dvd_cell.first_sector);
+				cbor_text("last sector");
+				cbor_uint(dvd_cell.last_sector);
+				if(dvd_video.dvd_es_stats.frames)
+					cbor_scan(&dvd_cell.dvd_es_stats);
+
+			}
+
+		}
+
+	}
+
+	fflush(stdout);
+
+}
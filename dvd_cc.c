@@ -0,0 +1,588 @@
+#include "dvd_cc.h"
+
+#define DVD_CC_ROWS 15
+#define DVD_CC_COLUMNS 32
+
+#define DVD_CC_POP_ON 0
+#define DVD_CC_ROLL_UP 1
+#define DVD_CC_PAINT_ON 2
+#define DVD_CC_TEXT 3
+
+/**
+ * Decoder state for one channel
+ *
+ * There are two memories of 15 rows of 32 characters, the one on the screen
+ * and the one that pop-on captions are built in.  Characters are stored as
+ * Unicode code points, 0 is an empty cell.
+ */
+struct dvd_cc {
+	uint8_t field;
+	uint8_t data_channel;
+	uint8_t channel;
+	bool xds;
+	FILE *srt;
+	uint8_t mode;
+	uint8_t roll_up_rows;
+	uint8_t row;
+	uint8_t column;
+	uint8_t visible;
+	uint16_t memory[2][DVD_CC_ROWS][DVD_CC_COLUMNS];
+	bool shown;
+	uint32_t shown_msecs;
+	uint8_t last_control[2];
+	bool repeated;
+	uint32_t cues;
+};
+
+/**
+ * Characters that are different from ASCII in the standard set
+ */
+static uint16_t dvd_cc_standard(const uint8_t c) {
+
+	switch(c) {
+		case 0x2a: return 0xe1;
+		case 0x5c: return 0xe9;
+		case 0x5e: return 0xed;
+		case 0x5f: return 0xf3;
+		case 0x60: return 0xfa;
+		case 0x7b: return 0xe7;
+		case 0x7c: return 0xf7;
+		case 0x7d: return 0xd1;
+		case 0x7e: return 0xf1;
+		case 0x7f: return 0x2588;
+		default: return c;
+	}
+
+}
+
+// Special characters, 0x11 0x30 to 0x3f
+static const uint16_t dvd_cc_special[16] = {
+	0xae, 0xb0, 0xbd, 0xbf, 0x2122, 0xa2, 0xa3, 0x266a,
+	0xe0, 0x20, 0xe8, 0xe2, 0xea, 0xee, 0xf4, 0xfb,
+};
+
+// Extended characters, 0x12 and 0x13 0x20 to 0x3f
+static const uint16_t dvd_cc_extended[2][32] = {
+	{
+		0xc1, 0xc9, 0xd3, 0xda, 0xdc, 0xfc, 0x2018, 0xa1,
+		0x2a, 0x27, 0x2014, 0xa9, 0x2120, 0x2022, 0x201c, 0x201d,
+		0xc0, 0xc2, 0xc7, 0xc8, 0xca, 0xcb, 0xeb, 0xce,
+		0xcf, 0xef, 0xd4, 0xd9, 0xf9, 0xdb, 0xab, 0xbb,
+	},
+	{
+		0xc3, 0xe3, 0xcd, 0xcc, 0xec, 0xd2, 0xf2, 0xd5,
+		0xf5, 0x7b, 0x7d, 0x5c, 0x5e, 0x5f, 0x7c, 0x7e,
+		0xc4, 0xe4, 0xd6, 0xf6, 0xdf, 0xa5, 0xa4, 0x2502,
+		0xc5, 0xe5, 0xd8, 0xf8, 0x250c, 0x2510, 0x2514, 0x2518,
+	},
+};
+
+// Row of each preamble address code, by the first byte, then bit 5 of the second
+static const uint8_t dvd_cc_pac_rows[8][2] = {
+	{ 11, 11 }, { 1, 2 }, { 3, 4 }, { 12, 13 },
+	{ 14, 15 }, { 5, 6 }, { 7, 8 }, { 9, 10 },
+};
+
+/**
+ * Get the caption words out of a block of user data
+ *
+ * @param buf user data, after the start code
+ * @param length bytes of user data
+ * @param cc_words words, room for DVD_CC_MAX_WORDS
+ * @param format set to DVD_CC_DVD or DVD_CC_ATSC, or 0 if it has no captions
+ * @return number of words
+ */
+uint16_t dvd_cc_words(const uint8_t *buf, const size_t length, struct dvd_cc_word *cc_words, uint8_t *format) {
+
+	const uint8_t *end = buf + length;
+	const uint8_t *p = NULL;
+	uint16_t words = 0;
+	uint8_t count = 0;
+	uint8_t ix = 0;
+
+	*format = 0;
+
+	// DVD: each frame has a field 1 and a field 2 word, and there can be one more field after them
+	if(length >= 5 && buf[0] == 'C' && buf[1] == 'C' && buf[2] == 0x01 && buf[3] == 0xf8) {
+
+		*format = DVD_CC_DVD;
+		count = (uint8_t)(((buf[4] & 0x3e) >> 1) * 2 + (buf[4] & 0x01));
+
+		for(ix = 0, p = buf + 5; ix < count && p + 3 <= end && words < DVD_CC_MAX_WORDS; ix++, p += 3) {
+			if(p[0] != 0xff && p[0] != 0xfe)
+				continue;
+			cc_words[words].field = p[0] == 0xff ? 1 : 2;
+			cc_words[words].frame = ix / 2;
+			cc_words[words].data[0] = p[1];
+			cc_words[words].data[1] = p[2];
+			words++;
+		}
+
+		return words;
+
+	}
+
+	// ATSC: cc_count triplets, only the valid ones of type 0 and 1 are line 21
+	if(length >= 7 && memcmp(buf, "GA94", 4) == 0 && buf[4] == 0x03 && (buf[5] & 0x40)) {
+
+		*format = DVD_CC_ATSC;
+		count = buf[5] & 0x1f;
+
+		for(ix = 0, p = buf + 7; ix < count && p + 3 <= end && words < DVD_CC_MAX_WORDS; ix++, p += 3) {
+			if(!(p[0] & 0x04) || (p[0] & 0x03) > 1)
+				continue;
+			cc_words[words].field = (p[0] & 0x03) + 1;
+			cc_words[words].frame = 0;
+			cc_words[words].data[0] = p[1];
+			cc_words[words].data[1] = p[2];
+			words++;
+		}
+
+	}
+
+	return words;
+
+}
+
+/**
+ * A word with nothing in it, once the parity bits are taken off
+ */
+bool dvd_cc_padding(const uint8_t *data) {
+
+	return (data[0] & 0x7f) == 0 && (data[1] & 0x7f) == 0;
+
+}
+
+/**
+ * Start decoding one channel
+ *
+ * @param channel 1 to 4 (CC1 to CC4)
+ * @param srt file to write the cues to
+ * @return decoder, or NULL
+ */
+struct dvd_cc *dvd_cc_open(const uint8_t channel, FILE *srt) {
+
+	struct dvd_cc *dvd_cc = NULL;
+
+	if(channel < 1 || channel > 4)
+		return NULL;
+
+	dvd_cc = calloc(1, sizeof(struct dvd_cc));
+	if(dvd_cc == NULL)
+		return NULL;
+
+	dvd_cc->field = channel <= 2 ? 1 : 2;
+	dvd_cc->data_channel = (channel - 1) % 2;
+	dvd_cc->srt = srt;
+	dvd_cc->mode = DVD_CC_POP_ON;
+	dvd_cc->roll_up_rows = 2;
+	dvd_cc->row = DVD_CC_ROWS - 1;
+
+	return dvd_cc;
+
+}
+
+static bool dvd_cc_empty(uint16_t memory[DVD_CC_ROWS][DVD_CC_COLUMNS]) {
+
+	uint8_t row = 0;
+	uint8_t column = 0;
+
+	for(row = 0; row < DVD_CC_ROWS; row++) {
+		for(column = 0; column < DVD_CC_COLUMNS; column++) {
+			if(memory[row][column] > 0x20)
+				return false;
+		}
+	}
+
+	return true;
+
+}
+
+static void dvd_cc_utf8(FILE *srt, const uint16_t c) {
+
+	if(c < 0x80)
+		fputc(c, srt);
+	else if(c < 0x800)
+		fprintf(srt, "%c%c", 0xc0 | (c >> 6), 0x80 | (c & 0x3f));
+	else
+		fprintf(srt, "%c%c%c", 0xe0 | (c >> 12), 0x80 | ((c >> 6) & 0x3f), 0x80 | (c & 0x3f));
+
+}
+
+static void dvd_cc_timestamp(FILE *srt, const uint32_t msecs) {
+
+	fprintf(srt, "%02u:%02u:%02u,%03u", msecs / 3600000, (msecs / 60000) % 60, (msecs / 1000) % 60, msecs % 1000);
+
+}
+
+/**
+ * Write what is on the screen as a cue, from when it was shown until now.
+ * Each row with text in it is a line, without the spaces around it.
+ */
+static void dvd_cc_cue(struct dvd_cc *dvd_cc, const uint32_t msecs) {
+
+	uint16_t (*memory)[DVD_CC_COLUMNS] = dvd_cc->memory[dvd_cc->visible];
+	uint8_t row = 0;
+	uint8_t first = 0;
+	uint8_t last = 0;
+	bool lines = false;
+
+	if(!dvd_cc->shown)
+		return;
+
+	dvd_cc->shown = false;
+
+	if(dvd_cc_empty(memory) || dvd_cc->srt == NULL)
+		return;
+
+	dvd_cc->cues++;
+
+	fprintf(dvd_cc->srt, "%u\n", dvd_cc->cues);
+	dvd_cc_timestamp(dvd_cc->srt, dvd_cc->shown_msecs);
+	fprintf(dvd_cc->srt, " --> ");
+	dvd_cc_timestamp(dvd_cc->srt, msecs > dvd_cc->shown_msecs ? msecs : dvd_cc->shown_msecs + 1);
+	fprintf(dvd_cc->srt, "\n");
+
+	for(row = 0; row < DVD_CC_ROWS; row++) {
+
+		for(first = 0; first < DVD_CC_COLUMNS && memory[row][first] <= 0x20; first++)
+			;
+
+		if(first == DVD_CC_COLUMNS)
+			continue;
+
+		for(last = DVD_CC_COLUMNS - 1; memory[row][last] <= 0x20; last--)
+			;
+
+		if(lines)
+			fprintf(dvd_cc->srt, "\n");
+		lines = true;
+
+		for(; first <= last; first++)
+			dvd_cc_utf8(dvd_cc->srt, memory[row][first] ? memory[row][first] : 0x20);
+
+	}
+
+	fprintf(dvd_cc->srt, "\n\n");
+
+}
+
+/**
+ * The screen is shown from now, if there is anything on it
+ */
+static void dvd_cc_show(struct dvd_cc *dvd_cc, const uint32_t msecs) {
+
+	if(!dvd_cc->shown && !dvd_cc_empty(dvd_cc->memory[dvd_cc->visible])) {
+		dvd_cc->shown = true;
+		dvd_cc->shown_msecs = msecs;
+	}
+
+}
+
+/**
+ * Put a character where the cursor is, in the memory that is being written
+ * to for the mode, and move the cursor on
+ */
+static void dvd_cc_put(struct dvd_cc *dvd_cc, const uint16_t c, const uint32_t msecs) {
+
+	uint8_t memory = dvd_cc->visible;
+
+	if(dvd_cc->mode == DVD_CC_TEXT)
+		return;
+
+	if(dvd_cc->mode == DVD_CC_POP_ON)
+		memory = !dvd_cc->visible;
+
+	dvd_cc->memory[memory][dvd_cc->row][dvd_cc->column] = c;
+
+	if(dvd_cc->column < DVD_CC_COLUMNS - 1)
+		dvd_cc->column++;
+
+	if(dvd_cc->mode != DVD_CC_POP_ON)
+		dvd_cc_show(dvd_cc, msecs);
+
+}
+
+static void dvd_cc_backspace(struct dvd_cc *dvd_cc) {
+
+	uint8_t memory = dvd_cc->mode == DVD_CC_POP_ON ? !dvd_cc->visible : dvd_cc->visible;
+
+	if(dvd_cc->column > 0)
+		dvd_cc->column--;
+
+	dvd_cc->memory[memory][dvd_cc->row][dvd_cc->column] = 0;
+
+}
+
+/**
+ * Roll-up captions: the rows above the base row move up one, the top one is
+ * dropped, and the base row starts over empty
+ */
+static void dvd_cc_carriage_return(struct dvd_cc *dvd_cc, const uint32_t msecs) {
+
+	uint16_t (*memory)[DVD_CC_COLUMNS] = dvd_cc->memory[dvd_cc->visible];
+	uint8_t top = 0;
+	uint8_t row = 0;
+
+	if(dvd_cc->mode != DVD_CC_ROLL_UP)
+		return;
+
+	dvd_cc_cue(dvd_cc, msecs);
+
+	top = dvd_cc->row + 1 >= dvd_cc->roll_up_rows ? (uint8_t)(dvd_cc->row + 1 - dvd_cc->roll_up_rows) : 0;
+
+	for(row = 0; row < DVD_CC_ROWS; row++) {
+		if(row < top || row > dvd_cc->row)
+			memset(memory[row], 0, sizeof(memory[row]));
+		else if(row < dvd_cc->row)
+			memcpy(memory[row], memory[row + 1], sizeof(memory[row]));
+	}
+
+	memset(memory[dvd_cc->row], 0, sizeof(memory[dvd_cc->row]));
+	dvd_cc->column = 0;
+
+	dvd_cc_show(dvd_cc, msecs);
+
+}
+
+/**
+ * Preamble address code: move the cursor to the start of a row, and
+ * possibly indent it.  In roll-up mode the rows on the screen move with the
+ * base row.
+ */
+static void dvd_cc_preamble(struct dvd_cc *dvd_cc, const uint8_t b1, const uint8_t b2) {
+
+	uint16_t (*memory)[DVD_CC_COLUMNS] = dvd_cc->memory[dvd_cc->visible];
+	uint16_t rows[DVD_CC_ROWS][DVD_CC_COLUMNS];
+	uint8_t row = (uint8_t)(dvd_cc_pac_rows[b1 & 0x07][(b2 & 0x20) ? 1 : 0] - 1);
+	uint8_t ix = 0;
+	int offset = 0;
+
+	if(dvd_cc->mode == DVD_CC_ROLL_UP && row != dvd_cc->row) {
+		offset = (int)row - (int)dvd_cc->row;
+		memcpy(rows, memory, sizeof(rows));
+		memset(memory, 0, sizeof(rows));
+		for(ix = 0; ix < DVD_CC_ROWS; ix++) {
+			if((int)ix + offset >= 0 && (int)ix + offset < DVD_CC_ROWS)
+				memcpy(memory[ix + offset], rows[ix], sizeof(rows[ix]));
+		}
+	}
+
+	dvd_cc->row = row;
+	dvd_cc->column = (b2 & 0x10) ? (uint8_t)(((b2 & 0x0e) >> 1) * 4) : 0;
+
+}
+
+/**
+ * Miscellaneous control codes, 0x14 (0x15 in field 2) 0x20 to 0x2f
+ */
+static void dvd_cc_control(struct dvd_cc *dvd_cc, const uint8_t b2, const uint32_t msecs) {
+
+	switch(b2) {
+
+		// Resume caption loading
+		case 0x20:
+			dvd_cc->mode = DVD_CC_POP_ON;
+			break;
+
+		// Backspace
+		case 0x21:
+			dvd_cc_backspace(dvd_cc);
+			break;
+
+		// Delete to end of row
+		case 0x24:
+			memset(&dvd_cc->memory[dvd_cc->mode == DVD_CC_POP_ON ? !dvd_cc->visible : dvd_cc->visible][dvd_cc->row][dvd_cc->column], 0, (size_t)(DVD_CC_COLUMNS - dvd_cc->column) * sizeof(uint16_t));
+			break;
+
+		// Roll-up, 2 to 4 rows
+		case 0x25:
+		case 0x26:
+		case 0x27:
+			if(dvd_cc->mode != DVD_CC_ROLL_UP) {
+				dvd_cc_cue(dvd_cc, msecs);
+				memset(dvd_cc->memory, 0, sizeof(dvd_cc->memory));
+				dvd_cc->row = DVD_CC_ROWS - 1;
+				dvd_cc->column = 0;
+			}
+			dvd_cc->mode = DVD_CC_ROLL_UP;
+			dvd_cc->roll_up_rows = (uint8_t)(b2 - 0x23);
+			break;
+
+		// Resume direct captioning
+		case 0x29:
+			dvd_cc->mode = DVD_CC_PAINT_ON;
+			break;
+
+		// Text restart, resume text display
+		case 0x2a:
+		case 0x2b:
+			dvd_cc->mode = DVD_CC_TEXT;
+			break;
+
+		// Erase displayed memory
+		case 0x2c:
+			dvd_cc_cue(dvd_cc, msecs);
+			memset(dvd_cc->memory[dvd_cc->visible], 0, sizeof(dvd_cc->memory[dvd_cc->visible]));
+			break;
+
+		// Carriage return
+		case 0x2d:
+			dvd_cc_carriage_return(dvd_cc, msecs);
+			break;
+
+		// Erase non-displayed memory
+		case 0x2e:
+			memset(dvd_cc->memory[!dvd_cc->visible], 0, sizeof(dvd_cc->memory[!dvd_cc->visible]));
+			break;
+
+		// End of caption: the pop-on caption that was built goes on the screen
+		case 0x2f:
+			dvd_cc_cue(dvd_cc, msecs);
+			dvd_cc->visible = !dvd_cc->visible;
+			dvd_cc->mode = DVD_CC_POP_ON;
+			dvd_cc_show(dvd_cc, msecs);
+			break;
+
+	}
+
+}
+
+/**
+ * Decode one word of the decoder's field
+ *
+ * Control codes are sent twice in a row, in case one is lost, so the second
+ * one is skipped.  Everything after a control code for the other channel in
+ * the field is for that channel, until one comes for this one.
+ *
+ * @param data the two bytes, with their parity bits
+ * @param msecs time of the frame it is in
+ */
+void dvd_cc_decode(struct dvd_cc *dvd_cc, const uint8_t *data, const uint32_t msecs) {
+
+	uint8_t b1 = data[0] & 0x7f;
+	uint8_t b2 = data[1] & 0x7f;
+	uint8_t code = 0;
+
+	if(b1 == 0 && b2 == 0)
+		return;
+
+	// Extended data services, only in field 2
+	if(b1 < 0x10) {
+		dvd_cc->xds = b1 != 0x0f;
+		dvd_cc->repeated = false;
+		return;
+	}
+
+	if(b1 >= 0x20) {
+		dvd_cc->repeated = false;
+		if(dvd_cc->xds || dvd_cc->channel != dvd_cc->data_channel)
+			return;
+		dvd_cc_put(dvd_cc, dvd_cc_standard(b1), msecs);
+		if(b2 >= 0x20)
+			dvd_cc_put(dvd_cc, dvd_cc_standard(b2), msecs);
+		return;
+	}
+
+	dvd_cc->xds = false;
+
+	if(dvd_cc->repeated && dvd_cc->last_control[0] == b1 && dvd_cc->last_control[1] == b2) {
+		dvd_cc->repeated = false;
+		return;
+	}
+
+	dvd_cc->repeated = true;
+	dvd_cc->last_control[0] = b1;
+	dvd_cc->last_control[1] = b2;
+
+	dvd_cc->channel = (b1 & 0x08) ? 1 : 0;
+	if(dvd_cc->channel != dvd_cc->data_channel)
+		return;
+
+	code = b1 & 0x07;
+
+	if(b2 >= 0x40) {
+		dvd_cc_preamble(dvd_cc, code, b2);
+		return;
+	}
+
+	if(code == 0x01 && b2 >= 0x30) {
+		dvd_cc_put(dvd_cc, dvd_cc_special[b2 - 0x30], msecs);
+	} else if(code == 0x01 && b2 >= 0x20) {
+		// Mid-row codes change the style, and take up a space
+		dvd_cc_put(dvd_cc, 0x20, msecs);
+	} else if((code == 0x02 || code == 0x03) && b2 >= 0x20) {
+		// An extended character replaces the standard one sent before it
+		dvd_cc_backspace(dvd_cc);
+		dvd_cc_put(dvd_cc, dvd_cc_extended[code - 0x02][b2 - 0x20], msecs);
+	} else if((code == 0x04 || code == 0x05) && b2 >= 0x20 && b2 <= 0x2f) {
+		dvd_cc_control(dvd_cc, b2, msecs);
+	} else if(code == 0x07 && b2 >= 0x21 && b2 <= 0x23) {
+		// Tab offsets
+		dvd_cc->column = (uint8_t)(dvd_cc->column + b2 - 0x20 < DVD_CC_COLUMNS ? dvd_cc->column + b2 - 0x20 : DVD_CC_COLUMNS - 1);
+	}
+
+}
+
+/**
+ * Write anything still on the screen, and free the decoder
+ *
+ * @param msecs end of the stream
+ * @return number of cues written
+ */
+uint32_t dvd_cc_close(struct dvd_cc *dvd_cc, const uint32_t msecs) {
+
+	uint32_t cues = 0;
+
+	if(dvd_cc == NULL)
+		return 0;
+
+	dvd_cc_cue(dvd_cc, msecs);
+
+	cues = dvd_cc->cues;
+
+	free(dvd_cc);
+
+	return cues;
+
+}
+
+/**
+ * Scenarist closed captions
+ */
+void dvd_cc_scc_header(FILE *scc) {
+
+	fprintf(scc, "Scenarist_SCC V1.0\n\n");
+
+}
+
+/**
+ * Write words that are on consecutive frames as one line, starting with the
+ * SMPTE drop frame timecode (29.97 fps) of the first one
+ *
+ * @param data two bytes for each word, with their parity bits
+ * @param words number of words
+ */
+void dvd_cc_scc_line(FILE *scc, const uint32_t msecs, const uint8_t *data, const uint16_t words) {
+
+	uint64_t frames = (uint64_t)msecs * 30 / 1001;
+	uint64_t minutes = 0;
+	uint16_t ix = 0;
+
+	if(words == 0)
+		return;
+
+	// Two frame numbers are dropped every minute, except every tenth one
+	minutes = frames % 17982;
+	frames += 18 * (frames / 17982);
+	if(minutes > 1)
+		frames += 2 * ((minutes - 2) / 1798);
+
+	fprintf(scc, "%02u:%02u:%02u;%02u\t", (uint32_t)(frames / 108000), (uint32_t)(frames / 1800 % 60), (uint32_t)(frames / 30 % 60), (uint32_t)(frames % 30));
+
+	for(ix = 0; ix < words; ix++)
+		fprintf(scc, "%s%02x%02x", ix ? " " : "", data[ix * 2], data[ix * 2 + 1]);
+
+	fprintf(scc, "\n\n");
+
+}
@@ -0,0 +1,68 @@
+#ifndef DVD_INFO_CC_H
+#define DVD_INFO_CC_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Closed captions (CEA-608, line 21)
+ *
+ * NTSC DVDs carry the line 21 captions in the video's user data, as two
+ * bytes per field.  Most use the DVD format, one block in front of each GOP
+ * with the bytes for every frame in it:
+ *
+ *   "CC" 0x01 0xf8, then a byte with the number of frames (bits 5 to 1),
+ *   then for each frame a field 1 and a field 2 word: 0xff (field 1) or
+ *   0xfe (field 2) and the two bytes
+ *
+ * Some use the ATSC format instead, "GA94" 0x03, with the words for one
+ * picture after its picture header.
+ *
+ * dvd_cc_words() pulls the words out of either one.  A decoder for one
+ * channel (CC1 and CC2 are in field 1, CC3 and CC4 in field 2) turns them
+ * into text, and writes a SubRip (.srt) cue each time what is on the screen
+ * changes.  The words can also be written as they are to a Scenarist (.scc)
+ * file, which is field 1 only.
+ *
+ * struct dvd_cc *dvd_cc = dvd_cc_open(1, srt_file);
+ * dvd_cc_decode(dvd_cc, word.data, msecs);
+ * dvd_cc_close(dvd_cc, last_msecs);
+ */
+
+#define DVD_CC_DVD 1
+#define DVD_CC_ATSC 2
+
+// The most words in one block: 31 frames of two fields, or 31 ATSC words
+#define DVD_CC_MAX_WORDS 64
+
+/**
+ * field: 1 or 2
+ * frame: frame in the block, from the first one displayed
+ * data: the two bytes, with their parity bits
+ */
+struct dvd_cc_word {
+	uint8_t field;
+	uint8_t frame;
+	uint8_t data[2];
+};
+
+struct dvd_cc;
+
+uint16_t dvd_cc_words(const uint8_t *buf, const size_t length, struct dvd_cc_word *cc_words, uint8_t *format);
+
+bool dvd_cc_padding(const uint8_t *data);
+
+struct dvd_cc *dvd_cc_open(const uint8_t channel, FILE *srt);
+
+void dvd_cc_decode(struct dvd_cc *dvd_cc, const uint8_t *data, const uint32_t msecs);
+
+uint32_t dvd_cc_close(struct dvd_cc *dvd_cc, const uint32_t msecs);
+
+void dvd_cc_scc_header(FILE *scc);
+
+void dvd_cc_scc_line(FILE *scc, const uint32_t msecs, const uint8_t *data, const uint16_t words);
+
+#endif
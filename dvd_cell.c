@@ -1,4 +1,5 @@
 #include "dvd_cell.h"
+#include "dvd_time.h"
 
 /**
  * Functions used to get information about a DVD cell
@@ -72,3 +73,22 @@ ssize_t dvd_cell_filesize(const ifo_handle_t *vmg_ifo, const ifo_handle_t *vts_i
 	return filesize;
 
 }
+
+/**
+ * Time each cell of a track starts at, from the start of one of them.  The
+ * cells before it are left at 0.
+ *
+ * @param first_cell cell the times are from, such as the first one of a chapter
+ * @param cell_start msecs for each cell, by cell number
+ */
+void dvd_cell_starts(const ifo_handle_t *vmg_ifo, const ifo_handle_t *vts_ifo, const uint16_t track_number, const uint8_t first_cell, uint32_t cell_start[256]) {
+
+	uint8_t cells = dvd_track_cells(vmg_ifo, vts_ifo, track_number);
+	uint16_t cell = 0;
+
+	memset(cell_start, 0, 256 * sizeof(uint32_t));
+
+	for(cell = (uint16_t)(first_cell + 1); cell < cells + 1; cell++)
+		cell_start[cell] = cell_start[cell - 1] + dvd_cell_msecs(vmg_ifo, vts_ifo, track_number, (uint8_t)(cell - 1));
+
+}
@@ -3,6 +3,7 @@
 
 #include "dvd_track.h"
 #include "dvd_vmg_ifo.h"
+#include "dvd_es.h"
 
 struct dvd_cell {
 	uint8_t cell;
@@ -12,6 +13,7 @@ struct dvd_cell {
 	uint32_t last_sector;
 	ssize_t blocks;
 	ssize_t filesize;
+	struct dvd_es_stats dvd_es_stats;
 };
 
 uint32_t dvd_cell_first_sector(const ifo_handle_t *vmg_ifo, const ifo_handle_t *vts_ifo, const uint16_t track_number, const uint8_t cell_number);
@@ -33,4 +35,6 @@ ssize_t dvd_cell_blocks(const ifo_handle_t *vmg_ifo, const ifo_handle_t *vts_ifo
 
 ssize_t dvd_cell_filesize(const ifo_handle_t *vmg_ifo, const ifo_handle_t *vts_ifo, const uint16_t track_number, const uint8_t cell_number);
 
+void dvd_cell_starts(const ifo_handle_t *vmg_ifo, const ifo_handle_t *vts_ifo, const uint16_t track_number, const uint8_t first_cell, uint32_t cell_start[256]);
+
 #endif
@@ -10,6 +10,7 @@
 #include <fcntl.h>
 #include <stdbool.h>
 #include <getopt.h>
+#include <limits.h>
 #ifdef __linux__
 #include <linux/cdrom.h>
 #include "dvd_drive.h"
@@ -27,26 +28,22 @@
 #include "dvd_audio.h"
 #include "dvd_subtitles.h"
 #include "dvd_time.h"
+#include "dvd_session.h"
+#include "dvd_track_copy.h"
+#include "dvd_pipeline.h"
+#include "dvd_md5.h"
+#include "dvd_vobu.h"
+#include "dvd_mkv.h"
+#include "dvd_ts.h"
 #ifndef VERSION
 #define VERSION "1.2"
 #endif
 
 #define DVD_INFO_PROGRAM "dvd_copy"
-#define DVD_COPY_FILENAME 16
-
-#ifndef DVD_VIDEO_LB_LEN
-#define DVD_VIDEO_LB_LEN 2048
-#endif
-
-#define DVD_COPY_BLOCK_LIMIT 512
-#define DVD_CAT_BLOCK_LIMIT 1
-
-// 2048 * 512 = 1 MB
-#define DVD_COPY_BYTES_LIMIT ( DVD_COPY_BLOCK_LIMIT * DVD_VIDEO_LB_LEN )
-#define DVD_CAT_BYTES_LIMIT ( DVD_CAT_BLOCK_LIMIT * DVD_VIDEO_LB_LEN )
+// dvd_track_65535.m3u8
+#define DVD_COPY_FILENAME 20
 
 int main(int, char **);
-void dvd_track_info(struct dvd_track *dvd_track, const uint16_t track_number, const ifo_handle_t *vmg_ifo, const ifo_handle_t *vts_ifo);
 void print_usage(char *binary);
 void print_version(char *binary);
 
@@ -59,6 +56,7 @@ struct dvd_copy {
 	ssize_t blocks;
 	ssize_t filesize;
 	char *filename;
+	char vobu_filename[PATH_MAX];
 	int fd;
 };
 
@@ -73,12 +71,21 @@ int main(int argc, char **argv) {
 	bool p_dvd_copy = true;
 	bool p_dvd_cat = false;
 	bool opt_filename = false;
+	bool opt_md5 = false;
+	bool opt_vobu = false;
+	bool opt_mkv = false;
+	bool opt_hls = false;
+	bool opt_start = false;
+	bool opt_end = false;
+	uint32_t arg_start = 0;
+	uint32_t arg_end = 0;
 	uint16_t arg_track_number = 0;
+	uint8_t arg_hls_seconds = DVD_TS_SEGMENT_SECONDS;
 	int long_index = 0;
 	int opt = 0;
 	opterr = 1;
 	const char *str_options;
-	str_options = "c:ho:t:V";
+	str_options = "c:e:hH:ikmo:s:t:V";
 	uint8_t arg_first_chapter = 1;
 	uint8_t arg_last_chapter = 99;
 	char *token = NULL;
@@ -88,6 +95,12 @@ int main(int argc, char **argv) {
 
 		{ "chapters", required_argument, 0, 'c' },
 		{ "dvd_copy.filename", required_argument, 0, 'o' },
+		{ "end", required_argument, 0, 'e' },
+		{ "index", no_argument, 0, 'i' },
+		{ "mkv", no_argument, 0, 'k' },
+		{ "hls", required_argument, 0, 'H' },
+		{ "md5", no_argument, 0, 'm' },
+		{ "start", required_argument, 0, 's' },
 		{ "track", required_argument, 0, 't' },
 		{ "help", no_argument, 0, 'h' },
 		{ "version", no_argument, 0, 'V' },
@@ -134,10 +147,39 @@ int main(int argc, char **argv) {
 
 				break;
 
+			case 'e':
+				opt_end = true;
+				if(!milliseconds_length_parse(&arg_end, optarg)) {
+					fprintf(stderr, "End time must be in the format [[hh:]mm:]ss[.ms]\n");
+					return 1;
+				}
+				break;
+
 			case 'h':
 				print_usage(DVD_INFO_PROGRAM);
 				return 0;
 
+			case 'H':
+				opt_hls = true;
+				arg_hls_seconds = (uint8_t)strtoumax(optarg, NULL, 0);
+				if(strlen(optarg) > 2 || arg_hls_seconds == 0 || arg_hls_seconds > 60) {
+					fprintf(stderr, "Segment length must be between 1 and 60 seconds\n");
+					return 1;
+				}
+				break;
+
+			case 'i':
+				opt_vobu = true;
+				break;
+
+			case 'k':
+				opt_mkv = true;
+				break;
+
+			case 'm':
+				opt_md5 = true;
+				break;
+
 			case 'o':
 				if(strlen(optarg) == 1 && strncmp("-", optarg, 1) == 0) {
 					p_dvd_copy = false;
@@ -151,6 +193,14 @@ int main(int argc, char **argv) {
 				}
 				break;
 
+			case 's':
+				opt_start = true;
+				if(!milliseconds_length_parse(&arg_start, optarg)) {
+					fprintf(stderr, "Start time must be in the format [[hh:]mm:]ss[.ms]\n");
+					return 1;
+				}
+				break;
+
 			case 't':
 				opt_track_number = true;
 				arg_track_number = (uint16_t)strtoumax(optarg, NULL, 0);
@@ -174,166 +224,125 @@ int main(int argc, char **argv) {
 
 	}
 
-	const char *device_filename = DEFAULT_DVD_DEVICE;
-
-	if (argv[optind])
-		device_filename = argv[optind];
-
-	if(access(device_filename, F_OK) != 0) {
-		fprintf(stderr, "cannot access %s\n", device_filename);
+	if(opt_chapter_number && (opt_start || opt_end)) {
+		fprintf(stderr, "[%s] Copy either a range of chapters, or a start and end time, not both\n", DVD_INFO_PROGRAM);
 		return 1;
 	}
 
-	// Check to see if device can be opened
-	int dvd_fd = 0;
-	dvd_fd = dvd_device_open(device_filename);
-	if(dvd_fd < 0) {
-		fprintf(stderr, "dvd_copy: error opening %s\n", device_filename);
+	if(opt_mkv && (opt_start || opt_end)) {
+		fprintf(stderr, "[%s] Matroska output is by chapters, not a start and end time\n", DVD_INFO_PROGRAM);
 		return 1;
 	}
-	dvd_device_close(dvd_fd);
-
-
-#ifdef __linux__
-
-	// Poll drive status if it is hardware
-	if(dvd_device_is_hardware(device_filename)) {
-
-		// Wait for the drive to become ready
-		if(!dvd_drive_has_media(device_filename)) {
-
-			fprintf(stderr, "drive status: ");
-			dvd_drive_display_status(device_filename);
-
-			return 1;
-
-		}
 
+	if(opt_hls && (opt_start || opt_end)) {
+		fprintf(stderr, "[%s] HLS output is by chapters, not a start and end time\n", DVD_INFO_PROGRAM);
+		return 1;
 	}
 
-#endif
-
-	dvd_reader_t *dvdread_dvd = NULL;
-	dvdread_dvd = DVDOpen(device_filename);
+	if(opt_hls && opt_mkv) {
+		fprintf(stderr, "[%s] Remux to either Matroska or HLS, not both\n", DVD_INFO_PROGRAM);
+		return 1;
+	}
 
-	if(!dvdread_dvd) {
-		fprintf(stderr, "* dvdread could not open %s\n", device_filename);
+	// Segments are files next to the playlist
+	if(opt_hls && p_dvd_cat) {
+		fprintf(stderr, "[%s] HLS output can't be streamed to stdout\n", DVD_INFO_PROGRAM);
 		return 1;
 	}
 
-	ifo_handle_t *vmg_ifo = NULL;
-	vmg_ifo = ifoOpen(dvdread_dvd, 0);
+	if(opt_end && arg_end == 0) {
+		fprintf(stderr, "[%s] End time must be after the start of the track\n", DVD_INFO_PROGRAM);
+		return 1;
+	}
 
-	if(vmg_ifo == NULL) {
-		fprintf(stderr, "* Could not open IFO zero\n");
-		DVDClose(dvdread_dvd);
+	if(opt_start && opt_end && arg_end <= arg_start) {
+		fprintf(stderr, "[%s] End time must be after the start time\n", DVD_INFO_PROGRAM);
 		return 1;
 	}
 
-	// DVD
-	struct dvd_info dvd_info;
-	memset(dvd_info.dvdread_id, '\0', sizeof(dvd_info.dvdread_id));
-	dvd_info.video_title_sets = dvd_video_title_sets(vmg_ifo);
-	dvd_info.side = 1;
-	memset(dvd_info.title, '\0', sizeof(dvd_info.title));
-	memset(dvd_info.provider_id, '\0', sizeof(dvd_info.provider_id));
-	memset(dvd_info.vmg_id, '\0', sizeof(dvd_info.vmg_id));
-	dvd_info.tracks = dvd_tracks(vmg_ifo);
-	dvd_info.longest_track = 1;
-
-	dvd_title(dvd_info.title, device_filename);
-	if(p_dvd_copy)
-		printf("Disc title: %s\n", dvd_info.title);
+	const char *device_filename = DEFAULT_DVD_DEVICE;
 
-	uint16_t num_ifos = 1;
-	num_ifos = vmg_ifo->vts_atrt->nr_of_vtss;
+	if (argv[optind])
+		device_filename = argv[optind];
 
-	if(num_ifos < 1) {
-		fprintf(stderr, "* DVD has no title IFOs?!\n");
-		fprintf(stderr, "* Most likely a bug in libdvdread or a bad master or problems reading the disc\n");
-		ifoClose(vmg_ifo);
-		DVDClose(dvdread_dvd);
-		return 1;
-	}
+	// Open the DVD, the VMG IFO and check the drive status
+	struct dvd_session *dvd_session = NULL;
+	int session_error = DVD_SESSION_OK;
 
+	dvd_session = dvd_session_open(device_filename, &session_error);
 
-	// Track
-	struct dvd_track dvd_track;
-	memset(&dvd_track, 0, sizeof(dvd_track));
+	if(dvd_session == NULL) {
 
-	struct dvd_track dvd_tracks[DVD_MAX_TRACKS];
-	memset(&dvd_tracks, 0, sizeof(dvd_track) * dvd_info.tracks);
+		switch(session_error) {
 
-	// Cells
-	struct dvd_cell dvd_cell;
-	dvd_cell.cell = 1;
-	memset(dvd_cell.length, '\0', sizeof(dvd_cell.length));
-	snprintf(dvd_cell.length, DVD_CELL_LENGTH + 1, "00:00:00.000");
-	dvd_cell.msecs = 0;
+			case DVD_SESSION_ERR_ACCESS:
+				fprintf(stderr, "cannot access %s\n", device_filename);
+				break;
 
-	// Open first IFO
-	uint16_t vts = 1;
-	ifo_handle_t *vts_ifo = NULL;
+			case DVD_SESSION_ERR_DEVICE:
+				fprintf(stderr, "dvd_copy: error opening %s\n", device_filename);
+				break;
 
-	vts_ifo = ifoOpen(dvdread_dvd, vts);
-	if(vts_ifo == NULL) {
-		fprintf(stderr, "* Could not open VTS_IFO for track %u\n", 1);
-		return 1;
-	}
-	ifoClose(vts_ifo);
-	vts_ifo = NULL;
+#ifdef __linux__
+			case DVD_SESSION_ERR_NO_MEDIA:
+				fprintf(stderr, "drive status: ");
+				dvd_drive_display_status(device_filename);
+				break;
+#endif
 
-	// Create an array of all the IFOs
-	ifo_handle_t *vts_ifos[DVD_MAX_VTS_IFOS];
-	vts_ifos[0] = NULL;
+			case DVD_SESSION_ERR_DVDREAD:
+				fprintf(stderr, "* dvdread could not open %s\n", device_filename);
+				break;
 
-	for(vts = 1; vts < dvd_info.video_title_sets + 1; vts++) {
+			case DVD_SESSION_ERR_VMG_IFO:
+				fprintf(stderr, "* Could not open IFO zero\n");
+				break;
+
+			case DVD_SESSION_ERR_NO_VTS:
+				fprintf(stderr, "* DVD has no title IFOs?!\n");
+				fprintf(stderr, "* Most likely a bug in libdvdread or a bad master or problems reading the disc\n");
+				break;
 
-		vts_ifos[vts] = ifoOpen(dvdread_dvd, vts);
+			default:
+				fprintf(stderr, "dvd_copy: %s\n", dvd_session_strerror(session_error));
+				break;
 
-		if(!vts_ifos[vts]) {
-			vts_ifos[vts] = NULL;
-		} else if(!ifo_is_vts(vts_ifos[vts])) {
-			ifoClose(vts_ifos[vts]);
-			vts_ifos[vts] = NULL;
 		}
 
+		return 1;
+
 	}
-	
+
+	// DVD
+	struct dvd_info dvd_info;
+	dvd_session_info(dvd_session, &dvd_info);
+
+	if(p_dvd_copy)
+		printf("Disc title: %s\n", dvd_info.title);
+
 	// Exit if track number requested does not exist
-	if(opt_track_number && (arg_track_number > dvd_info.tracks)) {
+	if(opt_track_number && (arg_track_number > dvd_info.tracks || arg_track_number < 1)) {
 		fprintf(stderr, "dvd_copy: Invalid track number %d\n", arg_track_number);
 		fprintf(stderr, "dvd_copy: Valid track numbers: 1 to %u\n", dvd_info.tracks);
-		ifoClose(vmg_ifo);
-		DVDClose(dvdread_dvd);
+		dvd_session_close(dvd_session);
 		return 1;
 	} else if(opt_track_number) {
 		dvd_copy.track = arg_track_number;
 	}
 
-	uint16_t ix = 0;
-	uint16_t track = 1;
-	
-	uint32_t longest_msecs = 0;
-	
-	for(ix = 0, track = 1; ix < dvd_info.tracks; ix++, track++) {
- 
-		vts = dvd_vts_ifo_number(vmg_ifo, ix + 1);
-		vts_ifo = vts_ifos[vts];
-		dvd_track_info(&dvd_tracks[ix], track, vmg_ifo, vts_ifo);
-
-		if(dvd_tracks[ix].msecs > longest_msecs) {
-			dvd_info.longest_track = track;
-			longest_msecs = dvd_tracks[ix].msecs;
-		}
-
-	}
-
 	// Set the track number to rip if none is passed as an argument
 	if(!opt_track_number)
 		dvd_copy.track = dvd_info.longest_track;
-	
-	dvd_track = dvd_tracks[dvd_copy.track - 1];
+
+	// Track
+	struct dvd_track dvd_track;
+	dvd_session_track(dvd_session, dvd_copy.track, &dvd_track);
+
+	if(!dvd_track.valid) {
+		fprintf(stderr, "* Could not open VTS_IFO for track %u\n", dvd_copy.track);
+		dvd_session_close(dvd_session);
+		return 1;
+	}
 
 	// Set the proper chapter range
 	if(opt_chapter_number) {
@@ -353,221 +362,202 @@ int main(int argc, char **argv) {
 		dvd_copy.last_chapter = dvd_track.chapters;
 	}
 	
-	// Set default filename
-	if(!opt_filename) {
-		dvd_copy.filename = calloc(DVD_COPY_FILENAME + 1, sizeof(unsigned char));
-		snprintf(dvd_copy.filename, DVD_COPY_FILENAME + 1, "dvd_track_%02u.vob", dvd_copy.track);
+	// Map a time range to the VOBUs it starts and ends in, looking only at the
+	// NAV packs of the cells those times are in
+	struct dvd_vobu start_vobu;
+	struct dvd_vobu end_vobu;
+	char start_length[DVD_CHAPTER_LENGTH + 1] = {'\0'};
+	char end_length[DVD_CHAPTER_LENGTH + 1] = {'\0'};
+
+	memset(&start_vobu, 0, sizeof(start_vobu));
+	start_vobu.cell = 1;
+	memset(&end_vobu, 0, sizeof(end_vobu));
+	end_vobu.cell = dvd_track.cells;
+	end_vobu.sector = UINT32_MAX;
+
+	if(opt_start && !dvd_vobu_find_msecs(dvd_session, dvd_copy.track, arg_start, &start_vobu)) {
+		fprintf(stderr, "[%s] Start time is past the end of track %u (%s)\n", DVD_INFO_PROGRAM, dvd_copy.track, dvd_track.length);
+		return 1;
 	}
 
-	/**
-	 * Integers for numbers of blocks read, copied, counters
-	 */
-	int offset = 0;
-	ssize_t dvdread_read_blocks = 0; // num blocks passed by dvdread function
-	ssize_t cell_blocks_written = 0;
-	ssize_t track_blocks_written = 0;
-	ssize_t bytes_written = 0;
-	uint32_t cell_sectors = 0;
-
-	// Copy size
-	// For p_dvd_copy, the amount is variable, regarding the code
-	// For p_dvd_cat, limit the blocks to one so it is reading the minimum that
-	// dvdread will provide.
-	ssize_t read_blocks = 1;
-	if(p_dvd_copy)
-		read_blocks = DVD_COPY_BLOCK_LIMIT; // this can be changed, if you want to to do testing on different block sizes (grab more / less data on each read)
-	else if(p_dvd_cat)
-		read_blocks = DVD_CAT_BLOCK_LIMIT;
-	else
-		read_blocks = 1;
-
-	unsigned char *dvd_read_buffer = NULL;
-	if(p_dvd_copy)
-		dvd_read_buffer = (unsigned char *)calloc(1, (uint64_t)DVD_COPY_BYTES_LIMIT * sizeof(unsigned char));
-	else if (p_dvd_cat)
-		dvd_read_buffer = (unsigned char *)calloc(1, (uint64_t)DVD_CAT_BYTES_LIMIT * sizeof(unsigned char));
-	else
-		dvd_read_buffer = (unsigned char *)calloc(1, 1 * sizeof(unsigned char));
-	if(dvd_read_buffer == NULL) {
-		fprintf(stderr, "Couldn't allocate memory\n");
+	// The end time is in the last VOBU copied, stopping where the next one starts
+	if(opt_end && !dvd_vobu_find_msecs(dvd_session, dvd_copy.track, arg_end - 1, &end_vobu)) {
+		fprintf(stderr, "[%s] End time is past the end of track %u (%s)\n", DVD_INFO_PROGRAM, dvd_copy.track, dvd_track.length);
 		return 1;
 	}
 
-	/**
-	 * File descriptors and filenames
-	 */
-	dvd_file_t *dvdread_vts_file = NULL;
+	if(opt_end)
+		end_vobu.sector += end_vobu.blocks - 1;
 
-	vts = dvd_vts_ifo_number(vmg_ifo, dvd_copy.track);
-	vts_ifo = vts_ifos[vts];
+	// Set default filename
+	if(!opt_filename) {
+		dvd_copy.filename = calloc(DVD_COPY_FILENAME + 1, sizeof(unsigned char));
+		snprintf(dvd_copy.filename, DVD_COPY_FILENAME + 1, "dvd_track_%02u.%s", dvd_copy.track, opt_mkv ? "mkv" : opt_hls ? "m3u8" : "vob");
+	}
 
-	// Open the VTS VOB
-	dvdread_vts_file = DVDOpenFile(dvdread_dvd, vts, DVD_READ_TITLE_VOBS);
+	// The VOBU index goes next to the copy, or in the current directory when
+	// streaming
+	char *extension = NULL;
+	if(opt_vobu && p_dvd_copy) {
+		snprintf(dvd_copy.vobu_filename, PATH_MAX, "%s", dvd_copy.filename);
+		extension = strrchr(dvd_copy.vobu_filename, '.');
+		if(extension != NULL && strchr(extension, '/') == NULL)
+			*extension = '\0';
+		if(strlen(dvd_copy.vobu_filename) + 5 < PATH_MAX)
+			strcat(dvd_copy.vobu_filename, ".vobu");
+	} else if(opt_vobu) {
+		snprintf(dvd_copy.vobu_filename, PATH_MAX, "dvd_track_%02u.vobu", dvd_copy.track);
+	}
 
 	if(p_dvd_copy)
 		printf("Track: %02u, Length: %s, Chapters: %02u, Cells: %02u, Audio streams: %02u, Subpictures: %02u, Filesize: %lu, Blocks: %lu\n", dvd_track.track, dvd_track.length, dvd_track.chapters, dvd_track.cells, dvd_track.audio_tracks, dvd_track.subtitles, dvd_track.filesize, dvd_track.blocks);
 
-	if(p_dvd_copy) {
+	// The HLS muxer writes its own files
+	if(p_dvd_copy && !opt_hls) {
 		dvd_copy.fd = open(dvd_copy.filename, O_WRONLY | O_CREAT | O_APPEND | O_TRUNC, 0644);
 		if(dvd_copy.fd == -1) {
 			fprintf(stderr, "Couldn't create file %s\n", dvd_copy.filename);
 			return 1;
 		}
+	} else if(p_dvd_cat) {
+		dvd_copy.fd = 1;
 	}
 
-	track_blocks_written = 0;
-
-	dvd_copy.first_cell = dvd_chapter_first_cell(vmg_ifo, vts_ifo, dvd_copy.track, dvd_copy.first_chapter);
-	dvd_copy.last_cell = dvd_chapter_last_cell(vmg_ifo, vts_ifo, dvd_copy.track, dvd_copy.last_chapter);
-
-	// Get limits of copy
-	for(dvd_cell.cell = dvd_copy.first_cell; dvd_cell.cell < dvd_copy.last_cell + 1; dvd_cell.cell++) {
-		
-		dvd_copy.blocks += dvd_cell_blocks(vmg_ifo, vts_ifo, dvd_track.track, dvd_cell.cell);
-		dvd_copy.filesize += dvd_cell_filesize(vmg_ifo, vts_ifo, dvd_track.track, dvd_cell.cell);
-
+	// Everything is read once, and the output, checksum and progress are all
+	// fed from the same read
+	struct dvd_pipeline *dvd_pipeline = NULL;
+	struct dvd_pipeline_stats dvd_pipeline_stats;
+	struct dvd_md5 dvd_md5;
+	char md5[DVD_MD5_HEX + 1] = {'\0'};
+	struct dvd_vobu_index dvd_vobu_index;
+	struct dvd_mkv *dvd_mkv = NULL;
+	struct dvd_ts *dvd_ts = NULL;
+	bool copied = false;
+
+	dvd_pipeline = dvd_pipeline_open(dvd_session, dvd_copy.track, dvd_copy.first_chapter, dvd_copy.last_chapter);
+	if(dvd_pipeline == NULL) {
+		fprintf(stderr, "* Could not open VTS_IFO for track %u\n", dvd_copy.track);
+		return 1;
 	}
 
-	struct dvd_chapter dvd_chapter;
-
-	for(dvd_chapter.chapter = dvd_copy.first_chapter; dvd_chapter.chapter < dvd_copy.last_chapter + 1; dvd_chapter.chapter++) {
-
-		dvd_chapter.first_cell = dvd_chapter_first_cell(vmg_ifo, vts_ifo, dvd_copy.track, dvd_chapter.chapter);
-		dvd_chapter.last_cell = dvd_chapter_last_cell(vmg_ifo, vts_ifo, dvd_copy.track, dvd_chapter.chapter);
-		dvd_chapter_length(dvd_chapter.length, vmg_ifo, vts_ifo, dvd_copy.track, dvd_chapter.chapter);
-
-		for(dvd_cell.cell = dvd_chapter.first_cell; dvd_cell.cell < dvd_chapter.last_cell + 1; dvd_cell.cell++) {
-
-			dvd_cell.blocks = dvd_cell_blocks(vmg_ifo, vts_ifo, dvd_track.track, dvd_cell.cell);
-			dvd_cell.filesize = dvd_cell_filesize(vmg_ifo, vts_ifo, dvd_track.track, dvd_cell.cell);
-			dvd_cell.first_sector = dvd_cell_first_sector(vmg_ifo, vts_ifo, dvd_track.track, dvd_cell.cell);
-			dvd_cell.last_sector = dvd_cell_last_sector(vmg_ifo, vts_ifo, dvd_track.track, dvd_cell.cell);
-			dvd_cell_length(dvd_cell.length, vmg_ifo, vts_ifo, dvd_track.track, dvd_cell.cell);
-			cell_sectors = dvd_cell.last_sector - dvd_cell.first_sector;
-
-			if(p_dvd_copy)
-				printf("        Chapter: %02u, Cell: %02u, VTS: %u, Filesize: %lu, Blocks: %lu, Sectors: %i to %i\n", dvd_chapter.chapter, dvd_cell.cell, vts, dvd_cell.filesize, dvd_cell.blocks, dvd_cell.first_sector, dvd_cell.last_sector);
-
-			cell_blocks_written = 0;
-
-			if(dvd_cell.last_sector > dvd_cell.first_sector)
-				cell_sectors++;
+	// Copy size
+	// For p_dvd_copy, the amount is variable, regarding the code
+	// For p_dvd_cat, limit the blocks to one so it is reading the minimum that
+	// dvdread will provide.
+	dvd_pipeline_block_limit(dvd_pipeline, p_dvd_copy ? DVD_COPY_BLOCK_LIMIT : DVD_CAT_BLOCK_LIMIT);
+
+	if(opt_start || opt_end) {
+		dvd_pipeline_sectors(dvd_pipeline, start_vobu.cell, start_vobu.sector, end_vobu.cell, end_vobu.sector);
+		milliseconds_length_format(start_length, arg_start);
+		if(opt_end)
+			milliseconds_length_format(end_length, arg_end);
+		else
+			snprintf(end_length, DVD_CHAPTER_LENGTH + 1, "%s", dvd_track.length);
+		if(p_dvd_copy)
+			printf("Copying %s to %s, Cells: %02u to %02u\n", start_length, end_length, start_vobu.cell, end_vobu.cell);
+	}
 
-			if(dvd_cell.last_sector < dvd_cell.first_sector) {
-				fprintf(stderr, "* DEBUG Someone doing something nasty? The last sector is listed before the first; skipping cell\n");
-				continue;
-			}
-			
-			offset = (int)dvd_cell.first_sector;
+	// Matroska is remuxed from the same read, in place of the VOBs
+	if(opt_mkv) {
+		dvd_mkv = dvd_mkv_open(dvd_session, &dvd_track, dvd_copy.first_chapter, dvd_copy.last_chapter, dvd_copy.fd);
+		if(dvd_mkv == NULL) {
+			fprintf(stderr, "[%s] Couldn't write Matroska header\n", DVD_INFO_PROGRAM);
+			dvd_pipeline_close(dvd_pipeline);
+			return 1;
+		}
+		if(p_dvd_copy)
+			printf("Remuxing to Matroska, Tracks: %02u, Chapters: %02u to %02u\n", dvd_mkv_tracks(dvd_mkv), dvd_copy.first_chapter, dvd_copy.last_chapter);
+		dvd_mkv_pipeline(dvd_pipeline, dvd_mkv);
+	} else if(opt_hls) {
+		dvd_ts = dvd_ts_open(dvd_session, &dvd_track, dvd_copy.first_chapter, dvd_copy.filename, arg_hls_seconds);
+		if(dvd_ts == NULL) {
+			fprintf(stderr, "[%s] Couldn't start HLS playlist %s\n", DVD_INFO_PROGRAM, dvd_copy.filename);
+			dvd_pipeline_close(dvd_pipeline);
+			return 1;
+		}
+		printf("Remuxing to HLS, Streams: %02u, Segments: %u seconds, Chapters: %02u to %02u\n", dvd_ts_streams(dvd_ts), arg_hls_seconds, dvd_copy.first_chapter, dvd_copy.last_chapter);
+		dvd_ts_pipeline(dvd_pipeline, dvd_ts);
+	} else {
+		dvd_pipeline_add_fd(dvd_pipeline, dvd_copy.fd);
+	}
 
-			// This is where you would change the boundaries -- are you dumping to a track file (no boundaries) or a VOB (boundaries)
-			while(cell_blocks_written < dvd_cell.blocks) {
+	if(p_dvd_copy) {
+		dvd_pipeline_add_progress(dvd_pipeline);
+		dvd_pipeline_add_stats(dvd_pipeline, &dvd_pipeline_stats);
+	}
 
-				// Reset to the defaults
-				if(p_dvd_copy)
-					read_blocks = DVD_COPY_BLOCK_LIMIT;
-				else if(p_dvd_cat)
-					read_blocks = DVD_CAT_BLOCK_LIMIT;
-				else
-					read_blocks = 1;
+	if(opt_md5)
+		dvd_pipeline_add_md5(dvd_pipeline, &dvd_md5);
 
-				if(read_blocks > (dvd_cell.blocks - cell_blocks_written)) {
-					read_blocks = dvd_cell.blocks - cell_blocks_written;
-				}
+	if(opt_vobu)
+		dvd_vobu_index_pipeline(dvd_pipeline, &dvd_vobu_index);
 
-				dvdread_read_blocks = DVDReadBlocks(dvdread_vts_file, offset, (uint64_t)read_blocks, dvd_read_buffer);
-				if(!dvdread_read_blocks) {
-					fprintf(stderr, "* Could not read data from cell %u\n", dvd_cell.cell);
-					return 1;
-				}
+	copied = dvd_pipeline_run(dvd_pipeline);
 
-				// Check to make sure the amount read was what we wanted
-				if(dvdread_read_blocks != read_blocks) {
-					fprintf(stderr, "*** Asked for %ld and only got %ld\n", read_blocks, dvdread_read_blocks);
-					return 1;
-				}
+	dvd_pipeline_close(dvd_pipeline);
 
-				// Increment the offsets
-				offset += dvdread_read_blocks;
+	if(opt_mkv && !dvd_mkv_close(dvd_mkv)) {
+		fprintf(stderr, "[%s] Couldn't finish Matroska file\n", DVD_INFO_PROGRAM);
+		copied = false;
+	}
 
-				// Write the buffer to the track file
-				if(p_dvd_copy)
-					bytes_written = write(dvd_copy.fd, dvd_read_buffer, (uint64_t)(read_blocks * DVD_VIDEO_LB_LEN));
-				else if(p_dvd_cat)
-					bytes_written = write(1, dvd_read_buffer, (uint64_t)(read_blocks * DVD_VIDEO_LB_LEN));
-				else
-					bytes_written = 0;
+	if(opt_hls && !dvd_ts_close(dvd_ts)) {
+		fprintf(stderr, "[%s] Couldn't finish HLS playlist %s\n", DVD_INFO_PROGRAM, dvd_copy.filename);
+		copied = false;
+	}
 
-				if(!bytes_written) {
-					fprintf(stderr, "* Could not write data from cell %u\n", dvd_cell.cell);
-					return 1;
-				}
+	if(!copied)
+		return 1;
 
-				// Check to make sure we wrote as much as we asked for
-				if(bytes_written != dvdread_read_blocks * DVD_VIDEO_LB_LEN) {
-					fprintf(stderr, "*** Tried to write %ld bytes and only wrote %ld instead\n", dvdread_read_blocks * DVD_VIDEO_LB_LEN, bytes_written);
-					return 1;
-				}
+	if(p_dvd_copy && !opt_hls)
+		close(dvd_copy.fd);
 
-				// Increment the amount of blocks written
-				cell_blocks_written += dvdread_read_blocks;
-				track_blocks_written += dvdread_read_blocks;
+	if(p_dvd_copy)
+		printf("\n");
 
-				if(p_dvd_copy) {
-					printf("Progress %lu%%\r", track_blocks_written * 100 / dvd_copy.blocks);
-					fflush(stdout);
-				}
+	if(p_dvd_copy && dvd_pipeline_stats.msecs)
+		printf("Copied %ld blocks in %u.%03u seconds\n", dvd_pipeline_stats.blocks, dvd_pipeline_stats.msecs / 1000, dvd_pipeline_stats.msecs % 1000);
 
-			}
+	if(opt_md5) {
+		dvd_md5_hex(md5, &dvd_md5);
+		if(p_dvd_copy)
+			printf("MD5: %s\n", md5);
+		else
+			fprintf(stderr, "[%s] MD5: %s\n", DVD_INFO_PROGRAM, md5);
+	}
 
+	if(opt_vobu) {
+		if(!dvd_vobu_index_save(&dvd_vobu_index, dvd_copy.vobu_filename)) {
+			fprintf(stderr, "[%s] Couldn't save VOBU index to %s\n", DVD_INFO_PROGRAM, dvd_copy.vobu_filename);
+			dvd_vobu_index_free(&dvd_vobu_index);
+			return 1;
 		}
-
+		if(p_dvd_copy)
+			printf("VOBU index: %u VOBUs, saved to %s\n", dvd_vobu_index.vobus, dvd_copy.vobu_filename);
+		dvd_vobu_index_free(&dvd_vobu_index);
 	}
 
-	close(dvd_copy.fd);
+	dvd_session_track_free(&dvd_track);
 
-	DVDCloseFile(dvdread_vts_file);
+	dvd_session_close(dvd_session);
 
-	if(p_dvd_copy)
-		printf("\n");
-	
-	if(vts_ifo)
-		ifoClose(vts_ifo);
-	
-	if(vmg_ifo)
-		ifoClose(vmg_ifo);
-
-	if(dvdread_dvd)
-		DVDClose(dvdread_dvd);
-	
 	return 0;
 
 }
 
-void dvd_track_info(struct dvd_track *dvd_track, const uint16_t track_number, const ifo_handle_t *vmg_ifo, const ifo_handle_t *vts_ifo) {
-
-	dvd_track->track = track_number;
-	dvd_track->valid = 1;
-	dvd_track->vts = dvd_vts_ifo_number(vmg_ifo, track_number);
-	dvd_track->ttn = dvd_track_ttn(vmg_ifo, track_number);
-	dvd_track_length(dvd_track->length, vmg_ifo, vts_ifo, track_number);
-	dvd_track->msecs = dvd_track_msecs(vmg_ifo, vts_ifo, track_number);
-	dvd_track->chapters = dvd_track_chapters(vmg_ifo, vts_ifo, track_number);
-	dvd_track->audio_tracks = dvd_track_audio_tracks(vts_ifo);
-	dvd_track->subtitles = dvd_track_subtitles(vts_ifo);
-	dvd_track->active_audio_streams = dvd_audio_active_tracks(vmg_ifo, vts_ifo, track_number);
-	dvd_track->active_subs = dvd_track_active_subtitles(vmg_ifo, vts_ifo, track_number);
-	dvd_track->cells = dvd_track_cells(vmg_ifo, vts_ifo, track_number);
-	dvd_track->blocks = dvd_track_blocks(vmg_ifo, vts_ifo, track_number);
-	dvd_track->filesize = dvd_track_filesize(vmg_ifo, vts_ifo, track_number);
-
-}
-
 void print_usage(char *binary) {
 
 	printf("%s %s - copy a single DVD track to the filesystem\n", binary, VERSION);
 	printf("\n");
-	printf("Usage: %s [-t track] [-c chapter[-chapter]] [-o filename] [dvd path]\n", binary);
+	printf("Usage: %s [-t track] [-c chapter[-chapter]] [-o filename] [-s start] [-e end] [-m] [-i] [-k] [-H seconds] [dvd path]\n", binary);
+	printf("\n");
+	printf("Options:\n");
+	printf("  -m, --md5		Display the MD5 checksum of the copy, computed while reading\n");
+	printf("  -s, --start <time>	Start copying at a time in the track ([[hh:]mm:]ss[.ms])\n");
+	printf("  -e, --end <time>	Stop copying at a time in the track\n");
+	printf("  -i, --index		Save an index of the VOBUs next to the copy (filename.vobu)\n");
+	printf("  -k, --mkv		Remux to Matroska instead: video, audio, subtitles and chapters\n");
+	printf("  -H, --hls <seconds>	Remux to HLS instead: MPEG-TS segments of about that length\n");
 	printf("\n");
 	printf("DVD path can be a device name, a single file, or directory.\n");
 	printf("\n");
@@ -582,6 +572,8 @@ void print_usage(char *binary) {
 	printf("  dvd_copy -o video.vob	# Save to \"video.vob\" (MPEG2 program stream)\n");
 	printf("  dvd_copy -o video.mpg	# Save to \"video.mpg\" (MPEG2 program stream)\n");
 	printf("  dvd_copy -o -		# Stream to console output (stdout)\n");
+	printf("  dvd_copy -k		# Save to \"dvd_track_##.mkv\" (Matroska)\n");
+	printf("  dvd_copy -H 6		# Save to \"dvd_track_##.m3u8\" and \"dvd_track_##_#####.ts\" (HLS)\n");
 
 }
 
@@ -0,0 +1,287 @@
+#include <pthread.h>
+#include "dvd_crop.h"
+#ifdef DVD_CROP_X86
+#include <immintrin.h>
+#endif
+
+/**
+ * Sum of one row
+ */
+uint32_t dvd_crop_row_scalar(const uint8_t *row, const uint16_t width) {
+
+	uint32_t sum = 0;
+	uint16_t x = 0;
+
+	for(x = 0; x < width; x++)
+		sum += row[x];
+
+	return sum;
+
+}
+
+/**
+ * Add each column of a number of rows to sums
+ */
+void dvd_crop_columns_scalar(const uint8_t *luma, const size_t stride, const uint16_t rows, const uint16_t width, uint32_t *sums) {
+
+	uint16_t row = 0;
+	uint16_t x = 0;
+
+	for(row = 0; row < rows; row++)
+		for(x = 0; x < width; x++)
+			sums[x] += luma[row * stride + x];
+
+}
+
+#ifdef DVD_CROP_X86
+
+/**
+ * psadbw against zero adds up 8 bytes at a time
+ */
+__attribute__((target("sse2")))
+uint32_t dvd_crop_row_sse2(const uint8_t *row, const uint16_t width) {
+
+	const __m128i zero = _mm_setzero_si128();
+	__m128i sum = zero;
+	uint16_t x = 0;
+
+	for(x = 0; x + 16 <= width; x += 16)
+		sum = _mm_add_epi64(sum, _mm_sad_epu8(_mm_loadu_si128((const __m128i *)(row + x)), zero));
+
+	sum = _mm_add_epi64(sum, _mm_srli_si128(sum, 8));
+
+	return (uint32_t)_mm_cvtsi128_si32(sum) + dvd_crop_row_scalar(row + x, width - x);
+
+}
+
+/**
+ * Add up 16 columns at a time, in 16 bits for up to 256 rows, and then into
+ * the 32 bit sums
+ */
+__attribute__((target("sse2")))
+void dvd_crop_columns_sse2(const uint8_t *luma, const size_t stride, const uint16_t rows, const uint16_t width, uint32_t *sums) {
+
+	const __m128i zero = _mm_setzero_si128();
+	__m128i b, lo, hi;
+	uint16_t x = 0;
+	uint16_t row = 0;
+	uint16_t block = 0;
+	uint16_t block_rows = 0;
+
+	for(x = 0; x + 16 <= width; x += 16) {
+
+		for(block = 0; block < rows; block += 256) {
+
+			block_rows = (uint16_t)(rows - block < 256 ? rows - block : 256);
+			lo = zero;
+			hi = zero;
+
+			for(row = block; row < block + block_rows; row++) {
+				b = _mm_loadu_si128((const __m128i *)(luma + row * stride + x));
+				lo = _mm_add_epi16(lo, _mm_unpacklo_epi8(b, zero));
+				hi = _mm_add_epi16(hi, _mm_unpackhi_epi8(b, zero));
+			}
+
+			_mm_storeu_si128((__m128i *)(sums + x), _mm_add_epi32(_mm_loadu_si128((const __m128i *)(sums + x)), _mm_unpacklo_epi16(lo, zero)));
+			_mm_storeu_si128((__m128i *)(sums + x + 4), _mm_add_epi32(_mm_loadu_si128((const __m128i *)(sums + x + 4)), _mm_unpackhi_epi16(lo, zero)));
+			_mm_storeu_si128((__m128i *)(sums + x + 8), _mm_add_epi32(_mm_loadu_si128((const __m128i *)(sums + x + 8)), _mm_unpacklo_epi16(hi, zero)));
+			_mm_storeu_si128((__m128i *)(sums + x + 12), _mm_add_epi32(_mm_loadu_si128((const __m128i *)(sums + x + 12)), _mm_unpackhi_epi16(hi, zero)));
+
+		}
+
+	}
+
+	if(x < width)
+		dvd_crop_columns_scalar(luma + x, stride, rows, width - x, sums + x);
+
+}
+
+#endif
+
+typedef uint32_t (*dvd_crop_row_t)(const uint8_t *row, const uint16_t width);
+typedef void (*dvd_crop_columns_t)(const uint8_t *luma, const size_t stride, const uint16_t rows, const uint16_t width, uint32_t *sums);
+
+static dvd_crop_row_t dvd_crop_row_function = dvd_crop_row_scalar;
+static dvd_crop_columns_t dvd_crop_columns_function = dvd_crop_columns_scalar;
+static const char *dvd_crop_function_name = "scalar";
+static pthread_once_t dvd_crop_once = PTHREAD_ONCE_INIT;
+
+static void dvd_crop_init(void) {
+
+#ifdef DVD_CROP_X86
+	__builtin_cpu_init();
+
+	if(__builtin_cpu_supports("sse2")) {
+		dvd_crop_row_function = dvd_crop_row_sse2;
+		dvd_crop_columns_function = dvd_crop_columns_sse2;
+		dvd_crop_function_name = "sse2";
+	}
+#endif
+
+}
+
+/**
+ * Which version is being used: "sse2" or "scalar"
+ */
+const char *dvd_crop_name(void) {
+
+	pthread_once(&dvd_crop_once, dvd_crop_init);
+
+	return dvd_crop_function_name;
+
+}
+
+/**
+ * Find the black borders of one frame
+ *
+ * The rows are checked first, and then only the columns of the rows that are
+ * left, so the letterbox bars don't hide a pillarbox.  A frame that is black
+ * all the way through is flagged as black, and tells nothing about the crop.
+ *
+ * @param luma luma plane, one row after another
+ * @param width frame width
+ * @param height frame height
+ * @param dvd_crop crop
+ */
+void dvd_crop_frame(const uint8_t *luma, const uint16_t width, const uint16_t height, struct dvd_crop *dvd_crop) {
+
+	uint32_t limit = 0;
+	uint32_t *sums = NULL;
+	uint16_t top = 0;
+	uint16_t bottom = 0;
+	uint16_t left = 0;
+	uint16_t right = 0;
+
+	memset(dvd_crop, 0, sizeof(struct dvd_crop));
+	dvd_crop->width = width;
+	dvd_crop->height = height;
+
+	pthread_once(&dvd_crop_once, dvd_crop_init);
+
+	// A row is black if its sum is at or under the limit for every pixel
+	limit = (uint32_t)width * DVD_CROP_LIMIT;
+
+	for(top = 0; top < height; top++)
+		if(dvd_crop_row_function(luma + (size_t)top * width, width) > limit)
+			break;
+
+	if(top == height) {
+		dvd_crop->black = true;
+		return;
+	}
+
+	for(bottom = 0; bottom < height - top; bottom++)
+		if(dvd_crop_row_function(luma + (size_t)(height - bottom - 1) * width, width) > limit)
+			break;
+
+	sums = calloc(width, sizeof(uint32_t));
+	if(sums == NULL) {
+		dvd_crop->black = true;
+		return;
+	}
+
+	dvd_crop_columns_function(luma + (size_t)top * width, width, height - top - bottom, width, sums);
+
+	limit = (uint32_t)(height - top - bottom) * DVD_CROP_LIMIT;
+
+	for(left = 0; left < width; left++)
+		if(sums[left] > limit)
+			break;
+
+	for(right = 0; right < width - left; right++)
+		if(sums[width - right - 1] > limit)
+			break;
+
+	free(sums);
+
+	// Round down to even, so what is left of the picture is never cut
+	dvd_crop->top = top & ~1;
+	dvd_crop->bottom = bottom & ~1;
+	dvd_crop->left = left & ~1;
+	dvd_crop->right = right & ~1;
+	dvd_crop->width = width - dvd_crop->left - dvd_crop->right;
+	dvd_crop->height = height - dvd_crop->top - dvd_crop->bottom;
+
+}
+
+static int dvd_crop_compare(const void *a, const void *b) {
+
+	return (int)*(const uint16_t *)a - (int)*(const uint16_t *)b;
+
+}
+
+/**
+ * One side of the crop, from all of the samples: close to the smallest, but
+ * ignoring the smallest tenth, so a logo or some noise in the border on one
+ * frame doesn't undo it.  Dark scenes make the crop look bigger, not smaller,
+ * so they are never picked.
+ */
+static uint16_t dvd_crop_side(uint16_t *values, const uint16_t count) {
+
+	qsort(values, count, sizeof(uint16_t), dvd_crop_compare);
+
+	return values[count / 10];
+
+}
+
+/**
+ * Pick one crop for a track from the frames sampled from it
+ *
+ * @param dvd_crop_samples crop of each frame
+ * @param samples number of frames
+ * @param dvd_crop crop for the track
+ * @return false if every frame was black
+ */
+bool dvd_crop_aggregate(const struct dvd_crop *dvd_crop_samples, const uint16_t samples, struct dvd_crop *dvd_crop) {
+
+	uint16_t *values[4] = { NULL, NULL, NULL, NULL };
+	uint16_t count = 0;
+	uint16_t ix = 0;
+	uint16_t width = 0;
+	uint16_t height = 0;
+	bool aggregated = true;
+
+	memset(dvd_crop, 0, sizeof(struct dvd_crop));
+
+	for(ix = 0; ix < 4; ix++) {
+		values[ix] = calloc(samples ? samples : 1, sizeof(uint16_t));
+		if(values[ix] == NULL)
+			aggregated = false;
+	}
+
+	for(ix = 0; ix < samples && aggregated; ix++) {
+
+		if(dvd_crop_samples[ix].black)
+			continue;
+
+		width = dvd_crop_samples[ix].left + dvd_crop_samples[ix].width + dvd_crop_samples[ix].right;
+		height = dvd_crop_samples[ix].top + dvd_crop_samples[ix].height + dvd_crop_samples[ix].bottom;
+
+		values[0][count] = dvd_crop_samples[ix].top;
+		values[1][count] = dvd_crop_samples[ix].bottom;
+		values[2][count] = dvd_crop_samples[ix].left;
+		values[3][count] = dvd_crop_samples[ix].right;
+		count++;
+
+	}
+
+	if(count == 0)
+		aggregated = false;
+
+	if(aggregated) {
+		dvd_crop->top = dvd_crop_side(values[0], count);
+		dvd_crop->bottom = dvd_crop_side(values[1], count);
+		dvd_crop->left = dvd_crop_side(values[2], count);
+		dvd_crop->right = dvd_crop_side(values[3], count);
+		dvd_crop->width = width - dvd_crop->left - dvd_crop->right;
+		dvd_crop->height = height - dvd_crop->top - dvd_crop->bottom;
+	} else {
+		dvd_crop->black = true;
+	}
+
+	for(ix = 0; ix < 4; ix++)
+		free(values[ix]);
+
+	return aggregated;
+
+}
@@ -0,0 +1,61 @@
+#ifndef DVD_INFO_CROP_H
+#define DVD_INFO_CROP_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Letterbox and pillarbox detection
+ *
+ * Finds the black borders around the picture in the luma plane of a decoded
+ * frame.  A row or a column is black if its average is no brighter than
+ * DVD_CROP_LIMIT, the same test ffmpeg's cropdetect uses.  Sums of the rows
+ * and columns use the widest version the CPU supports (SSE2, or plain C).
+ *
+ * One frame can be misleading (a dark scene looks like it is all border), so
+ * a track is sampled at a number of points and dvd_crop_aggregate() picks a
+ * crop that nearly all of them agree with.
+ *
+ * All the values are even, since the chroma planes are half the size.
+ */
+
+// Luma at or below this is black (16 is black in video range)
+#define DVD_CROP_LIMIT 24
+
+// Frames sampled across a track by default
+#define DVD_CROP_SAMPLES 16
+#define DVD_CROP_MAX_SAMPLES 256
+
+struct dvd_crop {
+	bool black;
+	uint16_t top;
+	uint16_t bottom;
+	uint16_t left;
+	uint16_t right;
+	uint16_t width;
+	uint16_t height;
+};
+
+void dvd_crop_frame(const uint8_t *luma, const uint16_t width, const uint16_t height, struct dvd_crop *dvd_crop);
+
+bool dvd_crop_aggregate(const struct dvd_crop *dvd_crop_samples, const uint16_t samples, struct dvd_crop *dvd_crop);
+
+const char *dvd_crop_name(void);
+
+// Each version of the kernels, for comparing them
+uint32_t dvd_crop_row_scalar(const uint8_t *row, const uint16_t width);
+
+void dvd_crop_columns_scalar(const uint8_t *luma, const size_t stride, const uint16_t rows, const uint16_t width, uint32_t *sums);
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define DVD_CROP_X86 1
+
+uint32_t dvd_crop_row_sse2(const uint8_t *row, const uint16_t width);
+
+void dvd_crop_columns_sse2(const uint8_t *luma, const size_t stride, const uint16_t rows, const uint16_t width, uint32_t *sums);
+#endif
+
+#endif
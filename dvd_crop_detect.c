@@ -0,0 +1,190 @@
+#include "dvd_crop_detect.h"
+
+#ifndef DVD_VIDEO_LB_LEN
+#define DVD_VIDEO_LB_LEN 2048
+#endif
+
+struct dvd_crop_detect {
+	mpeg2dec_t *mpeg2dec;
+	const mpeg2_info_t *mpeg2_info;
+	struct dvd_crop *dvd_crop;
+	bool decoded;
+};
+
+/**
+ * Run the decoder, and check the first picture that comes out of it
+ */
+static bool dvd_crop_detect_parse(struct dvd_crop_detect *dvd_crop_detect) {
+
+	mpeg2_state_t state;
+
+	while(true) {
+
+		state = mpeg2_parse(dvd_crop_detect->mpeg2dec);
+
+		switch(state) {
+
+			case STATE_BUFFER:
+				return true;
+
+			case STATE_SLICE:
+			case STATE_END:
+			case STATE_INVALID_END:
+				if(dvd_crop_detect->decoded || dvd_crop_detect->mpeg2_info->display_fbuf == NULL)
+					break;
+				dvd_crop_frame(dvd_crop_detect->mpeg2_info->display_fbuf->buf[0], (uint16_t)dvd_crop_detect->mpeg2_info->sequence->width, (uint16_t)dvd_crop_detect->mpeg2_info->sequence->height, dvd_crop_detect->dvd_crop);
+				dvd_crop_detect->decoded = true;
+				break;
+
+			default:
+				break;
+
+		}
+
+	}
+
+}
+
+static bool dvd_crop_detect_decode(void *data, const struct dvd_demux_packet *dvd_demux_packet) {
+
+	struct dvd_crop_detect *dvd_crop_detect = (struct dvd_crop_detect *)data;
+	uint8_t *buf = (uint8_t *)dvd_demux_packet->buffer;
+
+	if(dvd_crop_detect->decoded)
+		return true;
+
+	mpeg2_buffer(dvd_crop_detect->mpeg2dec, buf, buf + dvd_demux_packet->length);
+
+	return dvd_crop_detect_parse(dvd_crop_detect);
+
+}
+
+/**
+ * Decode the I frame of the VOBU a time is in, and find its borders
+ */
+static bool dvd_crop_detect_sample(struct dvd_session *dvd_session, const struct dvd_vobu_index *dvd_vobu_index, dvd_file_t *dvdread_vts_file, struct dvd_demux *dvd_crop_demux, struct dvd_crop_detect *dvd_crop_detect, const uint32_t msecs) {
+
+	struct dvd_vobu dvd_vobu;
+	unsigned char *buffer = NULL;
+	uint32_t blocks = 0;
+	uint8_t sequence_end[4] = { 0x00, 0x00, 0x01, 0xb7 };
+
+	if(!dvd_vobu_index_find_msecs(dvd_session, dvd_vobu_index, msecs, &dvd_vobu))
+		return false;
+
+	blocks = dvd_vobu_first_ref_blocks(&dvd_vobu);
+
+	buffer = malloc((size_t)blocks * DVD_VIDEO_LB_LEN);
+	if(buffer == NULL)
+		return false;
+
+	if(DVDReadBlocks(dvdread_vts_file, (int)dvd_vobu.sector, blocks, buffer) != (ssize_t)blocks) {
+		free(buffer);
+		return false;
+	}
+
+	mpeg2_reset(dvd_crop_detect->mpeg2dec, 1);
+	dvd_demux_reset(dvd_crop_demux);
+	dvd_crop_detect->decoded = false;
+
+	dvd_demux(dvd_crop_demux, buffer, buffer + blocks * DVD_VIDEO_LB_LEN, DVD_DEMUX_PAYLOAD_START);
+
+	if(!dvd_crop_detect->decoded) {
+		mpeg2_buffer(dvd_crop_detect->mpeg2dec, sequence_end, sequence_end + sizeof(sequence_end));
+		dvd_crop_detect_parse(dvd_crop_detect);
+	}
+
+	free(buffer);
+
+	return dvd_crop_detect->decoded;
+
+}
+
+/**
+ * Detect the crop of a track, and set it on its video
+ *
+ * @param dvd_session session
+ * @param track_number track number
+ * @param samples number of frames to check
+ * @param dvd_video video of the track, where the crop is set
+ * @return false if no crop could be found (nothing decoded, or every frame
+ * was black)
+ */
+bool dvd_crop_detect(struct dvd_session *dvd_session, const uint16_t track_number, const uint16_t samples, struct dvd_video *dvd_video) {
+
+	ifo_handle_t *vmg_ifo = dvd_session_vmg_ifo(dvd_session);
+	ifo_handle_t *vts_ifo = dvd_session_track_ifo(dvd_session, track_number);
+	uint16_t vts = 0;
+	uint32_t track_msecs = 0;
+	uint32_t msecs = 0;
+	dvd_file_t *dvdread_vts_file = NULL;
+	struct dvd_demux *dvd_crop_demux = NULL;
+	struct dvd_crop_detect dvd_crop_detect;
+	struct dvd_crop *dvd_crop_samples = NULL;
+	struct dvd_crop dvd_crop;
+	struct dvd_vobu_index dvd_vobu_index;
+	uint16_t decoded = 0;
+	uint16_t ix = 0;
+
+	dvd_video->crop = false;
+
+	if(vmg_ifo == NULL || vts_ifo == NULL || samples == 0)
+		return false;
+
+	vts = dvd_vts_ifo_number(vmg_ifo, track_number);
+	track_msecs = dvd_track_msecs(vmg_ifo, vts_ifo, track_number);
+
+	memset(&dvd_crop_detect, 0, sizeof(dvd_crop_detect));
+
+	// Only the NAV packs are read, once, to find every sample
+	if(!dvd_vobu_index_track(dvd_session, track_number, &dvd_vobu_index)) {
+		dvd_vobu_index_free(&dvd_vobu_index);
+		return false;
+	}
+
+	dvd_crop_samples = calloc(samples, sizeof(struct dvd_crop));
+	dvd_crop_detect.mpeg2dec = mpeg2_init();
+	dvdread_vts_file = DVDOpenFile(dvd_session_dvdread(dvd_session), vts, DVD_READ_TITLE_VOBS);
+
+	if(dvd_crop_samples != NULL && dvd_crop_detect.mpeg2dec != NULL && dvdread_vts_file != NULL) {
+
+		dvd_crop_detect.mpeg2_info = mpeg2_info(dvd_crop_detect.mpeg2dec);
+		dvd_crop_demux = dvd_demux_open(DVD_DEMUX_VIDEO, dvd_crop_detect_decode, &dvd_crop_detect);
+
+	}
+
+	// The middle of each of the equal parts of the track
+	for(ix = 0; ix < samples && dvd_crop_demux != NULL; ix++) {
+
+		msecs = (uint32_t)((uint64_t)track_msecs * (2 * ix + 1) / (2 * samples));
+
+		dvd_crop_detect.dvd_crop = &dvd_crop_samples[decoded];
+
+		if(dvd_crop_detect_sample(dvd_session, &dvd_vobu_index, dvdread_vts_file, dvd_crop_demux, &dvd_crop_detect, msecs))
+			decoded++;
+
+	}
+
+	if(decoded && dvd_crop_aggregate(dvd_crop_samples, decoded, &dvd_crop)) {
+		dvd_video->crop = true;
+		dvd_video->crop_top = dvd_crop.top;
+		dvd_video->crop_bottom = dvd_crop.bottom;
+		dvd_video->crop_left = dvd_crop.left;
+		dvd_video->crop_right = dvd_crop.right;
+	}
+
+	dvd_demux_close(dvd_crop_demux);
+
+	if(dvdread_vts_file != NULL)
+		DVDCloseFile(dvdread_vts_file);
+
+	if(dvd_crop_detect.mpeg2dec != NULL)
+		mpeg2_close(dvd_crop_detect.mpeg2dec);
+
+	free(dvd_crop_samples);
+
+	dvd_vobu_index_free(&dvd_vobu_index);
+
+	return dvd_video->crop;
+
+}
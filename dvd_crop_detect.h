@@ -0,0 +1,29 @@
+#ifndef DVD_INFO_CROP_DETECT_H
+#define DVD_INFO_CROP_DETECT_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dvdread/dvd_reader.h>
+#include <dvdread/ifo_read.h>
+#include <mpeg2dec/mpeg2.h>
+#include "dvd_session.h"
+#include "dvd_demux.h"
+#include "dvd_vobu.h"
+#include "dvd_crop.h"
+
+/**
+ * Crop detection for a whole track, by decoding a number of I frames spread
+ * evenly across it.  Each one is found through the VOBU at that time, and
+ * only the blocks up to the end of its first picture are read, so a track
+ * takes a few hundred blocks instead of all of them.
+ *
+ * This needs libmpeg2, so it is built into the programs that can use it, and
+ * not into libdvdinfo.
+ */
+
+bool dvd_crop_detect(struct dvd_session *dvd_session, const uint16_t track_number, const uint16_t samples, struct dvd_video *dvd_video);
+
+#endif
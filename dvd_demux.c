@@ -0,0 +1,540 @@
+#include "dvd_demux.h"
+#include "dvd_pipeline.h"
+
+/**
+ * Based on the demuxer in libmpeg2's mpeg2dec.c
+ *
+ * The demuxer keeps some state between calls:
+ *
+ * if "state" = DEMUX_HEADER, then "head_buf" contains the first
+ *     "state_bytes" bytes from some header.
+ * if "state" == DEMUX_DATA, then we need to copy "state_bytes" bytes
+ *     of ES data before the next header.
+ * if "state" == DEMUX_SKIP, then we need to skip "state_bytes" bytes
+ *     of data before the next header.
+ *
+ * NEEDBYTES makes sure we have the requested number of bytes for a
+ * header. If we don't, it copies what we have into head_buf and returns,
+ * so that when we come back with more data we finish decoding this header.
+ *
+ * DONEBYTES updates "buf" to point after the header we just parsed.
+ *
+ * The transport stream mode (demux_pid) is left out, DVDs are always
+ * program streams.
+ *
+ * A demuxer opened with dvd_demux_open_streams() looks at every PES packet
+ * instead of one stream id, and checks it against the streams selected.
+ * Private stream 1 packets are matched on their substream id, and the
+ * substream header (the id, plus the frame count and pointer for AC3 and
+ * DTS, and the LPCM header) is taken off, so only the audio or subpicture
+ * data is passed on.  The pointer is kept, as where the first frame starts
+ * in what is passed on.
+ */
+
+#define DEMUX_HEADER 0
+#define DEMUX_DATA 1
+#define DEMUX_SKIP 2
+
+// PES header (9 + 255) and the longest substream header (LPCM)
+#define DEMUX_HEAD_BUF (264 + 7)
+
+struct dvd_demux {
+	uint8_t stream_id;
+	bool streams;
+	bool selected[256];
+	dvd_demux_output_t output;
+	void *data;
+	int state;
+	int state_bytes;
+	uint8_t head_buf[DEMUX_HEAD_BUF];
+	uint8_t pes_stream_id;
+	uint8_t pes_substream_id;
+	uint8_t pes_frames;
+	uint16_t pes_access_unit;
+	bool pes_start;
+	bool has_pts;
+	bool has_dts;
+	uint64_t pts;
+	uint64_t dts;
+};
+
+static const int mpeg1_skip_table[16] = {
+	0, 0, 4, 9, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+};
+
+/**
+ * Create a demuxer for one stream
+ *
+ * @param stream_id stream id to extract (0xe0 for video, etc.)
+ * @param output function called with the extracted stream
+ * @param data passed to the output function
+ * @return demuxer, or NULL if memory couldn't be allocated
+ */
+struct dvd_demux *dvd_demux_open(const uint8_t stream_id, dvd_demux_output_t output, void *data) {
+
+	struct dvd_demux *dvd_demux = calloc(1, sizeof(*dvd_demux));
+
+	if(dvd_demux == NULL)
+		return NULL;
+
+	dvd_demux->stream_id = stream_id;
+	dvd_demux->output = output;
+	dvd_demux->data = data;
+
+	dvd_demux_reset(dvd_demux);
+
+	return dvd_demux;
+
+}
+
+/**
+ * Create a demuxer that passes on every stream that is selected, all in one
+ * pass.  Nothing is selected to begin with.
+ *
+ * @param output function called with the extracted streams
+ * @param data passed to the output function
+ * @return demuxer, or NULL if memory couldn't be allocated
+ */
+struct dvd_demux *dvd_demux_open_streams(dvd_demux_output_t output, void *data) {
+
+	struct dvd_demux *dvd_demux = dvd_demux_open(0, output, data);
+
+	if(dvd_demux == NULL)
+		return NULL;
+
+	dvd_demux->streams = true;
+
+	return dvd_demux;
+
+}
+
+/**
+ * Select a stream to keep, or drop
+ *
+ * Stream ids are the same ones that dvd_audio_stream_id() and
+ * dvd_subtitle_stream_id() display: the substream id for anything in private
+ * stream 1 (AC3, DTS, LPCM, subpictures), and the PES stream id for the rest
+ * (video, MPEG audio).
+ *
+ * @param stream_id stream id
+ * @param selected keep the stream or not
+ */
+void dvd_demux_select(struct dvd_demux *dvd_demux, const uint8_t stream_id, const bool selected) {
+
+	dvd_demux->selected[stream_id] = selected;
+
+}
+
+/**
+ * Check if a stream is selected, by its stream id
+ */
+bool dvd_demux_selected(const struct dvd_demux *dvd_demux, const uint8_t stream_id) {
+
+	if(dvd_demux->streams)
+		return dvd_demux->selected[stream_id];
+
+	return dvd_demux->stream_id == stream_id;
+
+}
+
+/**
+ * Throw away anything that is partially parsed, to start on a new stream
+ * or after a seek.
+ */
+void dvd_demux_reset(struct dvd_demux *dvd_demux) {
+
+	dvd_demux->state = DEMUX_SKIP;
+	dvd_demux->state_bytes = 0;
+	dvd_demux->pes_start = false;
+	dvd_demux->has_pts = false;
+	dvd_demux->has_dts = false;
+
+}
+
+void dvd_demux_close(struct dvd_demux *dvd_demux) {
+
+	free(dvd_demux);
+
+}
+
+/**
+ * Length of the header at the start of a private stream 1 packet, including
+ * the substream id
+ */
+static int dvd_demux_substream_header(const uint8_t substream_id) {
+
+	// AC3 and DTS: frame count, first access unit pointer
+	if(substream_id >= 0x80 && substream_id <= 0x8f)
+		return 4;
+
+	// LPCM: same, plus emphasis / quantization / sample rate / channels
+	if(substream_id >= 0xa0 && substream_id <= 0xa7)
+		return 7;
+
+	return 1;
+
+}
+
+static uint64_t dvd_demux_timestamp(const uint8_t *ts) {
+
+	return ((uint64_t)((ts[0] >> 1) & 0x07) << 30) | ((uint64_t)ts[1] << 22) | ((uint64_t)(ts[2] >> 1) << 15) | ((uint64_t)ts[3] << 7) | (uint64_t)(ts[4] >> 1);
+
+}
+
+/**
+ * Pass a piece of the stream to the output function.  The PES details go
+ * with the first piece that has any data in it.
+ */
+static bool dvd_demux_output(struct dvd_demux *dvd_demux, const uint8_t *buf, const size_t len) {
+
+	struct dvd_demux_packet dvd_demux_packet;
+
+	if(len == 0)
+		return true;
+
+	dvd_demux_packet.stream_id = dvd_demux->pes_stream_id;
+	dvd_demux_packet.substream_id = dvd_demux->pes_substream_id;
+	dvd_demux_packet.frames = dvd_demux->pes_start ? dvd_demux->pes_frames : 0;
+	dvd_demux_packet.access_unit = dvd_demux_packet.frames ? dvd_demux->pes_access_unit : 0;
+	dvd_demux_packet.buffer = buf;
+	dvd_demux_packet.length = len;
+	dvd_demux_packet.pes_start = dvd_demux->pes_start;
+	dvd_demux_packet.has_pts = dvd_demux->pes_start && dvd_demux->has_pts;
+	dvd_demux_packet.has_dts = dvd_demux->pes_start && dvd_demux->has_dts;
+	dvd_demux_packet.pts = dvd_demux->pts;
+	dvd_demux_packet.dts = dvd_demux->dts;
+
+	dvd_demux->pes_start = false;
+
+	return dvd_demux->output(dvd_demux->data, &dvd_demux_packet);
+
+}
+
+/**
+ * Demux a piece of a program stream
+ *
+ * @param dvd_demux demuxer
+ * @param buf start of data
+ * @param end end of data
+ * @param flags DVD_DEMUX_PAYLOAD_START if buf is the start of a pack
+ * @return DVD_DEMUX_CONTINUE when it's ready for more, DVD_DEMUX_ERROR if the
+ * output function failed
+ */
+int dvd_demux(struct dvd_demux *dvd_demux, uint8_t *buf, uint8_t *end, int flags) {
+
+	uint8_t *head_buf = dvd_demux->head_buf;
+	uint8_t *header = NULL;
+	int bytes = 0;
+	int len = 0;
+	int pes_len = 0;
+	int substream_len = 0;
+	int pointer = 0;
+	bool selected = false;
+
+#define NEEDBYTES(x)								\
+	do {									\
+		int missing = 0;						\
+		missing = (x) - bytes;						\
+		if(missing > 0) {						\
+			if (header == head_buf) {				\
+				if(missing <= end - buf) {			\
+					memcpy(header + bytes, buf, missing);	\
+					buf += missing;				\
+					bytes = (x);				\
+				} else {					\
+					memcpy(header + bytes, buf, end - buf);	\
+					dvd_demux->state_bytes = bytes + end - buf;	\
+					return DVD_DEMUX_CONTINUE;		\
+				}						\
+			} else {						\
+				memcpy (head_buf, header, bytes);		\
+				dvd_demux->state = DEMUX_HEADER;		\
+				dvd_demux->state_bytes = bytes;			\
+				return DVD_DEMUX_CONTINUE;			\
+			}							\
+		}								\
+	} while (0)
+
+#define DONEBYTES(x)				\
+	do {					\
+		if (header != head_buf)		\
+	    		buf = header + (x);	\
+	} while (0)
+
+	if(flags & DVD_DEMUX_PAYLOAD_START)
+		goto payload_start;
+
+	switch (dvd_demux->state) {
+		case DEMUX_HEADER:
+			if(dvd_demux->state_bytes > 0) {
+				header = head_buf;
+				bytes = dvd_demux->state_bytes;
+				goto continue_header;
+			}
+			break;
+		case DEMUX_DATA:
+			if(dvd_demux->state_bytes > end - buf) {
+				if(!dvd_demux_output(dvd_demux, buf, (size_t)(end - buf)))
+					return DVD_DEMUX_ERROR;
+				dvd_demux->state_bytes -= end - buf;
+				return DVD_DEMUX_CONTINUE;
+			}
+			if(!dvd_demux_output(dvd_demux, buf, (size_t)dvd_demux->state_bytes))
+				return DVD_DEMUX_ERROR;
+			buf += dvd_demux->state_bytes;
+			break;
+		case DEMUX_SKIP:
+			if(dvd_demux->state_bytes > end - buf) {
+				dvd_demux->state_bytes -= end - buf;
+				return DVD_DEMUX_CONTINUE;
+			}
+			buf += dvd_demux->state_bytes;
+			break;
+	}
+
+	while(true) {
+
+		payload_start:
+
+		header = buf;
+		bytes = end - buf;
+
+		continue_header:
+
+		NEEDBYTES (4);
+
+		if(header[0] || header[1] || (header[2] != 1)) {
+
+			if(header != head_buf) {
+
+				// Lost sync, skip ahead to the next start code
+				buf = (uint8_t *)dvd_startcode(buf + 1, end);
+				goto payload_start;
+
+			} else {
+
+				header[0] = header[1];
+				header[1] = header[2];
+				header[2] = header[3];
+				bytes = 3;
+
+				goto continue_header;
+
+			}
+
+		}
+
+		switch (header[3]) {
+
+			/* program end code */
+			case 0xb9:
+				// Cells can be joined one after another, so carry on with the next pack
+				DONEBYTES (4);
+				break;
+
+			/* pack header */
+			case 0xba:
+
+				NEEDBYTES (5);
+
+				if((header[4] & 0xc0) == 0x40) {	/* mpeg2 */
+
+					NEEDBYTES (14);
+					len = 14 + (header[13] & 7);
+					NEEDBYTES (len);
+					DONEBYTES (len);
+
+				/* header points to the mpeg2 pack header */
+				} else if((header[4] & 0xf0) == 0x20) {	/* mpeg1 */
+
+					NEEDBYTES (12);
+					DONEBYTES (12);
+
+				/* header points to the mpeg1 pack header */
+				} else {
+
+					DONEBYTES (5);
+
+				}
+
+				break;
+
+			default:
+
+				if((dvd_demux->streams && (header[3] == DVD_DEMUX_PRIVATE_STREAM_1 || dvd_demux->selected[header[3]])) || (!dvd_demux->streams && header[3] == dvd_demux->stream_id)) {
+
+					NEEDBYTES (7);
+
+					pes_len = 6 + (header[4] << 8) + header[5];
+
+					dvd_demux->has_pts = false;
+					dvd_demux->has_dts = false;
+
+					if((header[6] & 0xc0) == 0x80) {	/* mpeg2 */
+						NEEDBYTES (9);
+						len = 9 + header[8];
+						NEEDBYTES (len);
+
+						if((header[7] & 0x80) && len >= 14) {
+							dvd_demux->has_pts = true;
+							dvd_demux->pts = dvd_demux_timestamp(header + 9);
+						}
+
+						if((header[7] & 0xc0) == 0xc0 && len >= 19) {
+							dvd_demux->has_dts = true;
+							dvd_demux->dts = dvd_demux_timestamp(header + 14);
+						}
+
+					/* header points to the mpeg2 pes header */
+					} else {	/* mpeg1 */
+
+						len = 7;
+
+						while((header-1)[len] == 0xff) {
+
+							len++;
+							NEEDBYTES (len);
+
+							// too much stuffing
+							if(len > 23)
+								break;
+
+						}
+
+						if(((header-1)[len] & 0xc0) == 0x40) {
+
+							len += 2;
+							NEEDBYTES (len);
+
+						}
+
+						len += mpeg1_skip_table[(header - 1)[len] >> 4];
+
+						NEEDBYTES (len);
+
+						/* header points to the mpeg1 pes header */
+					}
+
+					selected = true;
+					dvd_demux->pes_stream_id = header[3];
+					dvd_demux->pes_substream_id = 0;
+					dvd_demux->pes_frames = 0;
+					dvd_demux->pes_access_unit = 0;
+
+					// Route private stream 1 on its substream, and drop its header
+					if(dvd_demux->streams && header[3] == DVD_DEMUX_PRIVATE_STREAM_1 && pes_len > len) {
+
+						NEEDBYTES (len + 1);
+
+						dvd_demux->pes_substream_id = header[len];
+						selected = dvd_demux->selected[header[len]];
+
+						substream_len = dvd_demux_substream_header(header[len]);
+						if(len + substream_len > pes_len)
+							substream_len = pes_len - len;
+
+						// The pointer counts from its own last byte, make it from the end of the header
+						if(substream_len >= 4) {
+							NEEDBYTES (len + 4);
+							dvd_demux->pes_frames = header[len + 1];
+							pointer = (header[len + 2] << 8) | header[len + 3];
+							if(dvd_demux->pes_frames && pointer + 3 >= substream_len)
+								dvd_demux->pes_access_unit = (uint16_t)(pointer + 3 - substream_len);
+							else
+								dvd_demux->pes_frames = 0;
+						}
+
+						len += substream_len;
+						NEEDBYTES (len);
+
+					} else if(dvd_demux->streams && header[3] == DVD_DEMUX_PRIVATE_STREAM_1) {
+						selected = false;
+					}
+
+					DONEBYTES (len);
+
+					bytes = pes_len - len;
+
+					if(!selected) {
+
+						if(bytes > end - buf) {
+							dvd_demux->state = DEMUX_SKIP;
+							dvd_demux->state_bytes = bytes - (end - buf);
+							return DVD_DEMUX_CONTINUE;
+						} else if(bytes > 0) {
+							buf += bytes;
+						}
+
+						continue;
+
+					}
+
+					dvd_demux->pes_start = true;
+
+					if(bytes > end - buf) {
+
+						if(!dvd_demux_output(dvd_demux, buf, (size_t)(end - buf)))
+							return DVD_DEMUX_ERROR;
+
+						dvd_demux->state = DEMUX_DATA;
+						dvd_demux->state_bytes = bytes - (end - buf);
+
+						return DVD_DEMUX_CONTINUE;
+
+					} else if(bytes <= 0) {
+						continue;
+					}
+
+					if(!dvd_demux_output(dvd_demux, buf, (size_t)bytes))
+						return DVD_DEMUX_ERROR;
+
+					buf += bytes;
+
+				} else if(header[3] < 0xb9) {
+					// looks like a video stream, not system stream
+					DONEBYTES (4);
+				} else {
+
+					NEEDBYTES (6);
+					DONEBYTES (6);
+
+					bytes = (header[4] << 8) + header[5];
+
+					if(bytes > end - buf) {
+						dvd_demux->state = DEMUX_SKIP;
+						dvd_demux->state_bytes = bytes - (end - buf);
+						return DVD_DEMUX_CONTINUE;
+					}
+
+					buf += bytes;
+
+				}
+		}
+	}
+
+#undef NEEDBYTES
+#undef DONEBYTES
+
+}
+
+static bool dvd_demux_pipeline_write(void *data, const struct dvd_pipeline_blocks *dvd_pipeline_blocks) {
+
+	uint8_t *buf = (uint8_t *)dvd_pipeline_blocks->buffer;
+	uint8_t *end = buf + dvd_pipeline_blocks->blocks * DVD_VIDEO_LB_LEN;
+
+	// The demuxer never writes to the buffer, it only reads it
+	if(dvd_demux((struct dvd_demux *)data, buf, end, 0) == DVD_DEMUX_ERROR)
+		return false;
+
+	return true;
+
+}
+
+/**
+ * Feed everything a pipeline reads to a demuxer.  The demuxer is not closed.
+ */
+bool dvd_demux_pipeline(struct dvd_pipeline *dvd_pipeline, struct dvd_demux *dvd_demux) {
+
+	return dvd_pipeline_add(dvd_pipeline, "demux", dvd_demux_pipeline_write, NULL, dvd_demux);
+
+}
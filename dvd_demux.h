@@ -0,0 +1,102 @@
+#ifndef DVD_INFO_DEMUX_H
+#define DVD_INFO_DEMUX_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "dvd_startcode.h"
+
+/**
+ * MPEG program stream demuxer
+ *
+ * Pulls the payload of one elementary stream out of a program stream (a VOB)
+ * and passes it to a callback.  Data can be fed in any size pieces, headers
+ * split across two calls are put back together.
+ *
+ * All the state is in the demuxer, so any number of them can run at the same
+ * time, on any number of threads (one thread per demuxer).
+ *
+ * struct dvd_demux *dvd_demux = dvd_demux_open(0xe0, write_video, file);
+ * while(...)
+ * 	dvd_demux(dvd_demux, buffer, buffer + len, 0);
+ * dvd_demux_close(dvd_demux);
+ *
+ * To get several streams out in one pass, open it with
+ * dvd_demux_open_streams() and select each one to keep (0xe0 for video, 0x80
+ * for the first AC3 track, 0x20 for the first subtitles, etc.).  The output
+ * function is passed the stream id and the substream id of each piece.
+ */
+
+// Stream ids
+#define DVD_DEMUX_VIDEO 0xe0
+#define DVD_DEMUX_MPEG_AUDIO 0xc0
+#define DVD_DEMUX_PRIVATE_STREAM_1 0xbd
+
+// Private stream 1 substream ids
+#define DVD_DEMUX_SUBPICTURE 0x20
+#define DVD_DEMUX_AC3 0x80
+#define DVD_DEMUX_DTS 0x88
+#define DVD_DEMUX_LPCM 0xa0
+
+// Flags
+#define DVD_DEMUX_PAYLOAD_START 1
+
+// Return values
+#define DVD_DEMUX_CONTINUE 0
+#define DVD_DEMUX_ERROR -1
+
+/**
+ * A piece of an elementary stream
+ *
+ * A PES packet can be handed over in more than one piece, if it is split
+ * across calls to dvd_demux().  The first piece has pes_start set, and the
+ * PTS and DTS from the PES header, if it had them (90 kHz).
+ *
+ * substream_id is only set for private stream 1, when demuxing all streams.
+ * For AC3, DTS and LPCM, frames is the number of audio frames that start in
+ * the packet, and access_unit is where the first one starts, in bytes from
+ * the start of the first piece.  Both are 0 if none do.
+ */
+struct dvd_demux_packet {
+	uint8_t stream_id;
+	uint8_t substream_id;
+	uint8_t frames;
+	uint16_t access_unit;
+	const uint8_t *buffer;
+	size_t length;
+	bool pes_start;
+	bool has_pts;
+	bool has_dts;
+	uint64_t pts;
+	uint64_t dts;
+};
+
+/**
+ * Called with every piece of the stream.  Returning false stops the demuxer
+ * with DVD_DEMUX_ERROR.
+ */
+typedef bool (*dvd_demux_output_t)(void *data, const struct dvd_demux_packet *dvd_demux_packet);
+
+struct dvd_demux;
+
+struct dvd_demux *dvd_demux_open(const uint8_t stream_id, dvd_demux_output_t output, void *data);
+
+struct dvd_demux *dvd_demux_open_streams(dvd_demux_output_t output, void *data);
+
+void dvd_demux_select(struct dvd_demux *dvd_demux, const uint8_t stream_id, const bool selected);
+
+bool dvd_demux_selected(const struct dvd_demux *dvd_demux, const uint8_t stream_id);
+
+void dvd_demux_reset(struct dvd_demux *dvd_demux);
+
+int dvd_demux(struct dvd_demux *dvd_demux, uint8_t *buf, uint8_t *end, int flags);
+
+void dvd_demux_close(struct dvd_demux *dvd_demux);
+
+struct dvd_pipeline;
+
+bool dvd_demux_pipeline(struct dvd_pipeline *dvd_pipeline, struct dvd_demux *dvd_demux);
+
+#endif
@@ -0,0 +1,591 @@
+#include "dvd_es.h"
+#include "dvd_pipeline.h"
+#include "dvd_startcode.h"
+#include "dvd_cc.h"
+
+/**
+ * Start codes, and how many bytes of each header are needed, counting the
+ * start code value
+ */
+#define DVD_ES_PICTURE 0x00
+#define DVD_ES_USER_DATA_START 0xb2
+#define DVD_ES_SEQUENCE 0xb3
+#define DVD_ES_EXTENSION 0xb5
+#define DVD_ES_GOP 0xb8
+
+#define DVD_ES_SEQUENCE_EXTENSION 1
+#define DVD_ES_PICTURE_CODING_EXTENSION 8
+
+#define DVD_ES_FRAME_PICTURE 3
+
+static uint8_t dvd_es_header_length(const uint8_t code) {
+
+	switch(code) {
+		case DVD_ES_PICTURE:
+			return 3;
+		case DVD_ES_SEQUENCE:
+			return 8;
+		case DVD_ES_EXTENSION:
+			return 6;
+		default:
+			return 0;
+	}
+
+}
+
+/**
+ * Start with empty stats
+ */
+void dvd_es_init(struct dvd_es *dvd_es, struct dvd_es_stats *dvd_es_stats) {
+
+	memset(dvd_es, 0, sizeof(*dvd_es));
+
+	dvd_es->dvd_es_stats = dvd_es_stats;
+
+}
+
+/**
+ * Pass user data and picture headers to callbacks, either can be NULL
+ */
+void dvd_es_callbacks(struct dvd_es *dvd_es, dvd_es_user_data_t user_data, dvd_es_picture_t picture, void *data) {
+
+	dvd_es->user_data_callback = user_data;
+	dvd_es->picture_callback = picture;
+	dvd_es->callback_data = data;
+
+}
+
+/**
+ * The PTS of a packet, for the first picture that starts in it
+ */
+void dvd_es_pts(struct dvd_es *dvd_es, const uint64_t pts) {
+
+	dvd_es->has_pts = true;
+	dvd_es->pts = pts;
+
+}
+
+/**
+ * Keep the user data in a piece of the stream
+ */
+static void dvd_es_user_data_copy(struct dvd_es *dvd_es, const uint8_t *buf, const uint8_t *end) {
+
+	size_t bytes = (size_t)(end - buf);
+
+	if(dvd_es->user_data_length < DVD_ES_USER_DATA)
+		memcpy(dvd_es->user_data_buffer + dvd_es->user_data_length, buf, bytes < DVD_ES_USER_DATA - dvd_es->user_data_length ? bytes : DVD_ES_USER_DATA - dvd_es->user_data_length);
+
+	dvd_es->user_data_length += (uint32_t)bytes;
+
+}
+
+/**
+ * The user data ends at the next start code.  Captions are counted here, so
+ * they are in the stats without a callback.
+ */
+static void dvd_es_user_data_end(struct dvd_es *dvd_es) {
+
+	struct dvd_cc_word cc_words[DVD_CC_MAX_WORDS];
+	size_t length = dvd_es->user_data_length < DVD_ES_USER_DATA ? dvd_es->user_data_length : DVD_ES_USER_DATA;
+	uint16_t words = 0;
+	uint16_t ix = 0;
+	uint8_t format = 0;
+
+	if(!dvd_es->user_data)
+		return;
+
+	dvd_es->user_data = false;
+
+	words = dvd_cc_words(dvd_es->user_data_buffer, length, cc_words, &format);
+	for(ix = 0; ix < words; ix++) {
+		if(cc_words[ix].field == 1 && !dvd_cc_padding(cc_words[ix].data))
+			dvd_es->dvd_es_stats->captions++;
+	}
+
+	if(dvd_es->user_data_callback != NULL)
+		dvd_es->user_data_callback(dvd_es->callback_data, dvd_es->user_data_buffer, length);
+
+}
+
+/**
+ * Add one frame to the stats
+ */
+static void dvd_es_frame(struct dvd_es *dvd_es, const bool progressive, const bool repeat_first_field, const bool top_field_first) {
+
+	struct dvd_es_stats *dvd_es_stats = dvd_es->dvd_es_stats;
+
+	dvd_es_stats->frames++;
+	dvd_es_stats->fields += repeat_first_field ? 3 : 2;
+
+	if(progressive)
+		dvd_es_stats->progressive++;
+	if(repeat_first_field)
+		dvd_es_stats->repeat_first_field++;
+	if(top_field_first)
+		dvd_es_stats->top_field_first++;
+
+	// Kept in display order, until the end of the GOP
+	if(dvd_es->picture.temporal_reference < 64) {
+		dvd_es->gop_frames |= (uint64_t)1 << dvd_es->picture.temporal_reference;
+		if(progressive)
+			dvd_es->gop_progressive |= (uint64_t)1 << dvd_es->picture.temporal_reference;
+	}
+
+	if(dvd_es->picture_type == 1)
+		dvd_es_stats->i_frames++;
+	else if(dvd_es->picture_type == 2)
+		dvd_es_stats->p_frames++;
+	else if(dvd_es->picture_type == 3)
+		dvd_es_stats->b_frames++;
+
+	dvd_es->picture_pending = false;
+
+}
+
+/**
+ * Check the progressive_frame flags of the frames of a GOP, in display order,
+ * for the 3:2 cadence.  It carries on from the last GOP.
+ */
+static void dvd_es_gop_end(struct dvd_es *dvd_es) {
+
+	uint8_t ix = 0;
+
+	for(ix = 0; ix < 64 && dvd_es->gop_frames; ix++) {
+
+		if(!(dvd_es->gop_frames & ((uint64_t)1 << ix)))
+			continue;
+
+		dvd_es->cadence = (uint8_t)(((dvd_es->cadence << 1) | ((dvd_es->gop_progressive >> ix) & 1)) & 0x1f);
+		if(dvd_es->cadence_frames < 5)
+			dvd_es->cadence_frames++;
+
+		// Three progressive frames and then two interlaced ones, from any of the five
+		if(dvd_es->cadence_frames == 5 && (dvd_es->cadence == 0x1c || dvd_es->cadence == 0x0e || dvd_es->cadence == 0x07 || dvd_es->cadence == 0x13 || dvd_es->cadence == 0x19))
+			dvd_es->dvd_es_stats->cadence++;
+
+	}
+
+	dvd_es->gop_frames = 0;
+	dvd_es->gop_progressive = 0;
+
+}
+
+/**
+ * A picture with no coding extension after it is MPEG-1, which is always
+ * progressive
+ */
+static void dvd_es_picture_end(struct dvd_es *dvd_es) {
+
+	if(dvd_es->picture_pending)
+		dvd_es_frame(dvd_es, true, false, false);
+
+}
+
+/**
+ * Picture coding extension: picture_structure is in the third byte,
+ * top_field_first and repeat_first_field in the fourth, and
+ * progressive_frame at the top of the fifth
+ */
+static void dvd_es_picture_coding_extension(struct dvd_es *dvd_es, const uint8_t *extension) {
+
+	uint8_t picture_structure = extension[2] & 0x03;
+	bool top_field_first = extension[3] & 0x80;
+	bool repeat_first_field = extension[3] & 0x02;
+	bool progressive = extension[4] & 0x80;
+
+	if(!dvd_es->picture_pending)
+		return;
+
+	// Two field pictures make one frame
+	if(picture_structure != DVD_ES_FRAME_PICTURE) {
+		dvd_es->dvd_es_stats->field_pictures++;
+		dvd_es->second_field = !dvd_es->second_field;
+		if(!dvd_es->second_field) {
+			dvd_es->picture_pending = false;
+			return;
+		}
+	} else {
+		dvd_es->second_field = false;
+	}
+
+	dvd_es_frame(dvd_es, progressive, repeat_first_field, top_field_first);
+
+}
+
+/**
+ * A whole header, starting with the start code value
+ */
+static void dvd_es_header(struct dvd_es *dvd_es) {
+
+	const uint8_t *header = dvd_es->header;
+
+	switch(header[0]) {
+
+		case DVD_ES_SEQUENCE:
+			dvd_es->width = (uint16_t)((header[1] << 4) | (header[2] >> 4));
+			dvd_es->height = (uint16_t)(((header[2] & 0x0f) << 8) | header[3]);
+			dvd_es->aspect_ratio_code = header[4] >> 4;
+			dvd_es->frame_rate_code = header[4] & 0x0f;
+			break;
+
+		case DVD_ES_PICTURE:
+			dvd_es->picture_type = (header[2] >> 3) & 0x07;
+			dvd_es->picture_pending = true;
+			dvd_es->picture.type = dvd_es->picture_type;
+			dvd_es->picture.temporal_reference = (uint16_t)((header[1] << 2) | (header[2] >> 6));
+			if(dvd_es->picture_callback != NULL)
+				dvd_es->picture_callback(dvd_es->callback_data, &dvd_es->picture);
+			break;
+
+		case DVD_ES_EXTENSION:
+			if((header[1] >> 4) == DVD_ES_SEQUENCE_EXTENSION) {
+				dvd_es->mpeg2 = true;
+				dvd_es->dvd_es_stats->progressive_sequence = header[2] & 0x08;
+			} else if((header[1] >> 4) == DVD_ES_PICTURE_CODING_EXTENSION) {
+				dvd_es_picture_coding_extension(dvd_es, header + 1);
+			}
+			break;
+
+	}
+
+}
+
+/**
+ * A start code was found, the value is the byte after the prefix
+ */
+static void dvd_es_start(struct dvd_es *dvd_es, const uint8_t code) {
+
+	dvd_es_user_data_end(dvd_es);
+
+	// Anything but an extension ends the picture before it
+	if(code != DVD_ES_EXTENSION && (code < 0x01 || code > 0xaf))
+		dvd_es_picture_end(dvd_es);
+
+	if(code == DVD_ES_GOP || code == DVD_ES_SEQUENCE)
+		dvd_es_gop_end(dvd_es);
+
+	if(code == DVD_ES_PICTURE) {
+		dvd_es->picture.has_pts = dvd_es->has_pts;
+		dvd_es->picture.pts = dvd_es->pts;
+		dvd_es->has_pts = false;
+	} else if(code == DVD_ES_USER_DATA_START) {
+		dvd_es->user_data = true;
+		dvd_es->user_data_length = 0;
+	}
+
+	dvd_es->header[0] = code;
+	dvd_es->header_bytes = 1;
+	dvd_es->header_length = dvd_es_header_length(code);
+
+}
+
+/**
+ * Read the headers in a piece of the stream
+ *
+ * A header or a start code prefix that is cut off at the end is finished
+ * with the next piece.
+ */
+void dvd_es_parse(struct dvd_es *dvd_es, const uint8_t *buf, const uint8_t *end) {
+
+	const uint8_t *start = NULL;
+	size_t bytes = 0;
+
+	while(buf < end) {
+
+		// The rest of a header from the last piece
+		if(dvd_es->header_length) {
+			bytes = (size_t)(dvd_es->header_length - dvd_es->header_bytes);
+			if(bytes > (size_t)(end - buf))
+				bytes = (size_t)(end - buf);
+			memcpy(dvd_es->header + dvd_es->header_bytes, buf, bytes);
+			dvd_es->header_bytes += (uint8_t)bytes;
+			buf += bytes;
+			if(dvd_es->header_bytes == dvd_es->header_length) {
+				dvd_es_header(dvd_es);
+				dvd_es->header_length = 0;
+			}
+			continue;
+		}
+
+		// The start code value, after a prefix at the end of the last piece
+		if(dvd_es->prefix) {
+			dvd_es->prefix = false;
+			dvd_es_start(dvd_es, *buf++);
+			continue;
+		}
+
+		// Zeros at the end of the last piece, that could be part of a prefix
+		if(dvd_es->zeros) {
+			if(*buf == 0x00) {
+				if(dvd_es->user_data)
+					dvd_es_user_data_copy(dvd_es, buf, buf + 1);
+				dvd_es->zeros = 2;
+				buf++;
+				continue;
+			}
+			if(*buf == 0x01 && dvd_es->zeros == 2) {
+				// The zeros were kept as user data, and aren't
+				if(dvd_es->user_data && dvd_es->user_data_length >= 2)
+					dvd_es->user_data_length -= 2;
+				dvd_es->prefix = true;
+				dvd_es->zeros = 0;
+				buf++;
+				continue;
+			}
+			dvd_es->zeros = 0;
+		}
+
+		start = dvd_startcode(buf, end);
+
+		if(end - start >= 3 && start[0] == 0x00 && start[1] == 0x00 && start[2] == 0x01) {
+			if(dvd_es->user_data)
+				dvd_es_user_data_copy(dvd_es, buf, start);
+			if(end - start == 3) {
+				dvd_es->prefix = true;
+				return;
+			}
+			dvd_es_start(dvd_es, start[3]);
+			buf = start + 4;
+			continue;
+		}
+
+		if(dvd_es->user_data)
+			dvd_es_user_data_copy(dvd_es, buf, end);
+
+		// No whole prefix, so keep count of any zeros at the end
+		for(; start < end; start++)
+			dvd_es->zeros = *start ? 0 : (dvd_es->zeros ? 2 : 1);
+
+		return;
+
+	}
+
+}
+
+/**
+ * Count the last picture, at the end of the stream
+ */
+void dvd_es_flush(struct dvd_es *dvd_es) {
+
+	dvd_es_user_data_end(dvd_es);
+	dvd_es_picture_end(dvd_es);
+	dvd_es_gop_end(dvd_es);
+
+}
+
+/**
+ * Add the stats of one section to a total
+ */
+void dvd_es_add(struct dvd_es_stats *dvd_es_stats, const struct dvd_es_stats *section) {
+
+	if(section->frames == 0)
+		return;
+
+	// The whole is only a progressive sequence if every part of it is
+	if(dvd_es_stats->frames == 0)
+		dvd_es_stats->progressive_sequence = section->progressive_sequence;
+	else
+		dvd_es_stats->progressive_sequence = dvd_es_stats->progressive_sequence && section->progressive_sequence;
+
+	dvd_es_stats->frames += section->frames;
+	dvd_es_stats->progressive += section->progressive;
+	dvd_es_stats->repeat_first_field += section->repeat_first_field;
+	dvd_es_stats->top_field_first += section->top_field_first;
+	dvd_es_stats->fields += section->fields;
+	dvd_es_stats->cadence += section->cadence;
+	dvd_es_stats->i_frames += section->i_frames;
+	dvd_es_stats->p_frames += section->p_frames;
+	dvd_es_stats->b_frames += section->b_frames;
+	dvd_es_stats->field_pictures += section->field_pictures;
+	dvd_es_stats->captions += section->captions;
+
+}
+
+/**
+ * Tell what kind of video a section is from its flags
+ *
+ * Soft telecine repeats a field on every other frame (2:3 pulldown), so it
+ * is close to half.  Hard telecine has no repeated fields, and most of the
+ * frames in the 3:2 cadence of progressive and interlaced ones (see
+ * dvd_es.h).
+ *
+ * @return DVD_ES_SCAN_*, which is also set in the stats
+ */
+uint8_t dvd_es_classify(struct dvd_es_stats *dvd_es_stats) {
+
+	uint32_t progressive = 0;
+	uint32_t repeat_first_field = 0;
+	uint32_t cadence = 0;
+
+	if(dvd_es_stats->frames == 0) {
+		dvd_es_stats->scan = DVD_ES_SCAN_UNKNOWN;
+		return dvd_es_stats->scan;
+	}
+
+	progressive = (uint32_t)((uint64_t)dvd_es_stats->progressive * 1000 / dvd_es_stats->frames);
+	repeat_first_field = (uint32_t)((uint64_t)dvd_es_stats->repeat_first_field * 1000 / dvd_es_stats->frames);
+	cadence = (uint32_t)((uint64_t)dvd_es_stats->cadence * 1000 / dvd_es_stats->frames);
+
+	if(progressive >= DVD_ES_SCAN_MAJORITY && repeat_first_field >= 300 && repeat_first_field <= 700)
+		dvd_es_stats->scan = DVD_ES_SCAN_SOFT_TELECINE;
+	else if(progressive >= DVD_ES_SCAN_MAJORITY && repeat_first_field < 1000 - DVD_ES_SCAN_MAJORITY)
+		dvd_es_stats->scan = DVD_ES_SCAN_PROGRESSIVE;
+	else if(progressive <= 1000 - DVD_ES_SCAN_MAJORITY)
+		dvd_es_stats->scan = DVD_ES_SCAN_INTERLACED;
+	else if(repeat_first_field < 1000 - DVD_ES_SCAN_MAJORITY && cadence >= DVD_ES_SCAN_CADENCE)
+		dvd_es_stats->scan = DVD_ES_SCAN_HARD_TELECINE;
+	else
+		dvd_es_stats->scan = DVD_ES_SCAN_MIXED;
+
+	return dvd_es_stats->scan;
+
+}
+
+/**
+ * Classify each section, and the whole from them: it is the same as its
+ * sections if nearly all of its frames are in ones of the same kind, and
+ * mixed if they aren't
+ *
+ * @param dvd_es_stats total, is set to the sum of the sections
+ * @param sections stats of each section, each is classified
+ * @param count number of sections
+ * @return DVD_ES_SCAN_*
+ */
+uint8_t dvd_es_classify_sections(struct dvd_es_stats *dvd_es_stats, struct dvd_es_stats *sections, const uint16_t count) {
+
+	uint32_t frames[DVD_ES_SCAN_MIXED + 1];
+	uint8_t scan = 0;
+	uint16_t ix = 0;
+
+	memset(dvd_es_stats, 0, sizeof(*dvd_es_stats));
+	memset(frames, 0, sizeof(frames));
+
+	for(ix = 0; ix < count; ix++) {
+		frames[dvd_es_classify(&sections[ix])] += sections[ix].frames;
+		dvd_es_add(dvd_es_stats, &sections[ix]);
+	}
+
+	dvd_es_stats->scan = DVD_ES_SCAN_UNKNOWN;
+
+	if(dvd_es_stats->frames == 0)
+		return dvd_es_stats->scan;
+
+	dvd_es_stats->scan = DVD_ES_SCAN_MIXED;
+
+	for(scan = DVD_ES_SCAN_PROGRESSIVE; scan < DVD_ES_SCAN_MIXED; scan++) {
+		if((uint64_t)frames[scan] * 1000 >= (uint64_t)dvd_es_stats->frames * DVD_ES_SCAN_MAJORITY)
+			dvd_es_stats->scan = scan;
+	}
+
+	return dvd_es_stats->scan;
+
+}
+
+/**
+ * Name of a kind of video, for display
+ */
+const char *dvd_es_scan_name(const uint8_t scan) {
+
+	switch(scan) {
+		case DVD_ES_SCAN_PROGRESSIVE:
+			return "progressive";
+		case DVD_ES_SCAN_INTERLACED:
+			return "interlaced";
+		case DVD_ES_SCAN_SOFT_TELECINE:
+			return "soft telecine";
+		case DVD_ES_SCAN_HARD_TELECINE:
+			return "hard telecine";
+		case DVD_ES_SCAN_MIXED:
+			return "mixed";
+		default:
+			return "unknown";
+	}
+
+}
+
+struct dvd_es_pipeline_data {
+	struct dvd_demux *dvd_demux;
+	struct dvd_es dvd_es;
+	struct dvd_es_stats *dvd_es_stats;
+	uint8_t cells;
+};
+
+static bool dvd_es_pipeline_output(void *data, const struct dvd_demux_packet *dvd_demux_packet) {
+
+	struct dvd_es_pipeline_data *es_data = (struct dvd_es_pipeline_data *)data;
+
+	dvd_es_parse(&es_data->dvd_es, dvd_demux_packet->buffer, dvd_demux_packet->buffer + dvd_demux_packet->length);
+
+	return true;
+
+}
+
+static bool dvd_es_pipeline_write(void *data, const struct dvd_pipeline_blocks *dvd_pipeline_blocks) {
+
+	struct dvd_es_pipeline_data *es_data = (struct dvd_es_pipeline_data *)data;
+	uint8_t *buf = (uint8_t *)dvd_pipeline_blocks->buffer;
+	uint8_t *end = buf + dvd_pipeline_blocks->blocks * DVD_VIDEO_LB_LEN;
+
+	// Frames go to the cell their blocks were read from
+	if(dvd_pipeline_blocks->cell >= 1 && dvd_pipeline_blocks->cell <= es_data->cells)
+		es_data->dvd_es.dvd_es_stats = &es_data->dvd_es_stats[dvd_pipeline_blocks->cell - 1];
+
+	if(dvd_demux(es_data->dvd_demux, buf, end, 0) == DVD_DEMUX_ERROR)
+		return false;
+
+	return true;
+
+}
+
+static bool dvd_es_pipeline_close(void *data) {
+
+	struct dvd_es_pipeline_data *es_data = (struct dvd_es_pipeline_data *)data;
+
+	dvd_es_flush(&es_data->dvd_es);
+	dvd_demux_close(es_data->dvd_demux);
+	free(es_data);
+
+	return true;
+
+}
+
+/**
+ * Read the headers of the video a pipeline reads, and add up the flags of
+ * its frames for each cell.  Nothing is decoded, so this keeps up with the
+ * reads.
+ *
+ * @param dvd_es_stats stats for each cell of the track, from cell 1
+ * @param cells number of cells in the track
+ */
+bool dvd_es_pipeline(struct dvd_pipeline *dvd_pipeline, struct dvd_es_stats *dvd_es_stats, const uint8_t cells) {
+
+	struct dvd_es_pipeline_data *data = NULL;
+
+	if(cells == 0)
+		return false;
+
+	data = calloc(1, sizeof(*data));
+	if(data == NULL)
+		return false;
+
+	memset(dvd_es_stats, 0, cells * sizeof(struct dvd_es_stats));
+
+	data->dvd_es_stats = dvd_es_stats;
+	data->cells = cells;
+	dvd_es_init(&data->dvd_es, &dvd_es_stats[0]);
+
+	data->dvd_demux = dvd_demux_open(DVD_DEMUX_VIDEO, dvd_es_pipeline_output, data);
+	if(data->dvd_demux == NULL) {
+		free(data);
+		return false;
+	}
+
+	if(!dvd_pipeline_add(dvd_pipeline, "es", dvd_es_pipeline_write, dvd_es_pipeline_close, data)) {
+		dvd_demux_close(data->dvd_demux);
+		free(data);
+		return false;
+	}
+
+	return true;
+
+}
@@ -0,0 +1,167 @@
+#ifndef DVD_INFO_ES_H
+#define DVD_INFO_ES_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "dvd_demux.h"
+
+/**
+ * MPEG-2 video elementary stream headers
+ *
+ * Reads the sequence, picture and picture coding extension headers, and
+ * nothing else, so a whole track can be checked at about the speed it can
+ * be read.  Start codes are found with dvd_startcode(), and data can be fed
+ * in any size pieces, the same as the demuxer.
+ *
+ * The flags of every frame are added up, and dvd_es_classify() uses them to
+ * tell how the video was made:
+ *
+ * progressive: every frame is progressive, and no fields are repeated
+ * interlaced: the frames are interlaced
+ * soft telecine: progressive frames (film), with repeat_first_field set on
+ *   every other one, so the player does the 3:2 pulldown
+ * hard telecine: the pulldown is already in the frames.  Encoders that set
+ *   progressive_frame on each frame by what's in it mark three of every five
+ *   as progressive, and the two with fields from different film frames as
+ *   interlaced, so in display order the flags repeat in that 3:2 cadence.
+ *   Only video encoded that way can be told from the flags, anything else
+ *   that is interlaced, whether it is telecined or not, needs the pictures
+ *   to be compared.
+ * mixed: none of them by a wide enough margin
+ *
+ * User data (0xb2) is collected up to the next start code, and can be passed
+ * to a callback along with each picture header, which is where closed
+ * captions are (see dvd_cc.h).  A PTS set with dvd_es_pts() goes with the
+ * next picture that starts.
+ */
+
+#define DVD_ES_SCAN_UNKNOWN 0
+#define DVD_ES_SCAN_PROGRESSIVE 1
+#define DVD_ES_SCAN_INTERLACED 2
+#define DVD_ES_SCAN_SOFT_TELECINE 3
+#define DVD_ES_SCAN_HARD_TELECINE 4
+#define DVD_ES_SCAN_MIXED 5
+
+#define DVD_ES_SCAN_NAME 13
+
+// Share of frames, in thousandths, for a section to be one kind of video
+#define DVD_ES_SCAN_MAJORITY 950
+
+// Share of frames, in thousandths, in the 3:2 cadence for hard telecine.  It
+// starts over at every edit, so it is lower.
+#define DVD_ES_SCAN_CADENCE 800
+
+// Bytes after the start code that are needed of each header
+#define DVD_ES_HEADER 8
+
+// User data kept of each block, anything past it is dropped
+#define DVD_ES_USER_DATA 256
+
+/**
+ * frames: coded frames (a pair of field pictures is one frame)
+ * progressive: frames with progressive_frame set
+ * repeat_first_field: frames with repeat_first_field set
+ * top_field_first: frames with top_field_first set
+ * fields: fields the frames are displayed as (2, or 3 with a repeated one)
+ * cadence: frames that end five in a row, in display order, that are three
+ *   progressive and two interlaced ones next to each other (3:2 cadence)
+ * i_frames, p_frames, b_frames: frames of each picture type
+ * field_pictures: pictures coded as a single field
+ * captions: closed caption words in field 1 that aren't padding
+ * progressive_sequence: the sequence extension says every frame is
+ * scan: DVD_ES_SCAN_*, once dvd_es_classify() has been run
+ */
+struct dvd_es_stats {
+	uint32_t frames;
+	uint32_t progressive;
+	uint32_t repeat_first_field;
+	uint32_t top_field_first;
+	uint32_t fields;
+	uint32_t cadence;
+	uint32_t i_frames;
+	uint32_t p_frames;
+	uint32_t b_frames;
+	uint32_t field_pictures;
+	uint32_t captions;
+	bool progressive_sequence;
+	uint8_t scan;
+};
+
+/**
+ * A picture header
+ *
+ * type: 1 (I), 2 (P) or 3 (B)
+ * temporal_reference: place in display order, from the start of the GOP
+ * has_pts, pts: PTS of the packet it started in (90 kHz)
+ */
+struct dvd_es_picture {
+	uint8_t type;
+	uint16_t temporal_reference;
+	bool has_pts;
+	uint64_t pts;
+};
+
+typedef void (*dvd_es_user_data_t)(void *data, const uint8_t *buf, const size_t length);
+
+typedef void (*dvd_es_picture_t)(void *data, const struct dvd_es_picture *dvd_es_picture);
+
+/**
+ * Parser state.  Frames are added to whichever stats dvd_es_stats points to
+ * at the time, so it can be moved from one section to the next.
+ */
+struct dvd_es {
+	struct dvd_es_stats *dvd_es_stats;
+	uint16_t width;
+	uint16_t height;
+	uint8_t aspect_ratio_code;
+	uint8_t frame_rate_code;
+	bool mpeg2;
+	uint8_t zeros;
+	bool prefix;
+	uint8_t header[DVD_ES_HEADER + 1];
+	uint8_t header_bytes;
+	uint8_t header_length;
+	uint8_t picture_type;
+	bool picture_pending;
+	bool second_field;
+	bool has_pts;
+	uint64_t pts;
+	uint64_t gop_frames;
+	uint64_t gop_progressive;
+	uint8_t cadence;
+	uint8_t cadence_frames;
+	struct dvd_es_picture picture;
+	bool user_data;
+	uint32_t user_data_length;
+	uint8_t user_data_buffer[DVD_ES_USER_DATA];
+	dvd_es_user_data_t user_data_callback;
+	dvd_es_picture_t picture_callback;
+	void *callback_data;
+};
+
+void dvd_es_init(struct dvd_es *dvd_es, struct dvd_es_stats *dvd_es_stats);
+
+void dvd_es_callbacks(struct dvd_es *dvd_es, dvd_es_user_data_t user_data, dvd_es_picture_t picture, void *data);
+
+void dvd_es_pts(struct dvd_es *dvd_es, const uint64_t pts);
+
+void dvd_es_parse(struct dvd_es *dvd_es, const uint8_t *buf, const uint8_t *end);
+
+void dvd_es_flush(struct dvd_es *dvd_es);
+
+void dvd_es_add(struct dvd_es_stats *dvd_es_stats, const struct dvd_es_stats *section);
+
+uint8_t dvd_es_classify(struct dvd_es_stats *dvd_es_stats);
+
+uint8_t dvd_es_classify_sections(struct dvd_es_stats *dvd_es_stats, struct dvd_es_stats *sections, const uint16_t count);
+
+const char *dvd_es_scan_name(const uint8_t scan);
+
+struct dvd_pipeline;
+
+bool dvd_es_pipeline(struct dvd_pipeline *dvd_pipeline, struct dvd_es_stats *dvd_es_stats, const uint8_t cells);
+
+#endif
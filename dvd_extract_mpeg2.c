@@ -4,90 +4,311 @@
 #include <unistd.h>
 #include <string.h>
 #include <ctype.h>
-#include <sys/ioctl.h>
-#include <sys/stat.h>
-#include <dirent.h>
 #include <fcntl.h>
 #include <stdbool.h>
 #include <getopt.h>
 #include <limits.h>
-#include <sys/mman.h>
 #include <inttypes.h>
 #include <errno.h>
-#include <inttypes.h>
 #ifdef __linux__
 #include <linux/cdrom.h>
 #include "dvd_drive.h"
 #endif
 #include <dvdread/dvd_reader.h>
 #include <dvdread/ifo_read.h>
-#include "mpeg2dec/mpeg2.h"
-#include "mpeg2dec/mpeg2convert.h"
 #include "dvd_info.h"
 #include "dvd_device.h"
-#include "dvd_drive.h"
-#include "dvd_vmg_ifo.h"
 #include "dvd_track.h"
 #include "dvd_chapter.h"
 #include "dvd_cell.h"
-#include "dvd_video.h"
-#include "dvd_audio.h"
-#include "dvd_subtitles.h"
+#include "dvd_session.h"
+#include "dvd_pipeline.h"
+#include "dvd_demux.h"
+#include "dvd_vobu.h"
 #include "dvd_time.h"
+#include "dvd_vobsub.h"
+#include "dvd_audio_es.h"
+#ifndef VERSION
+#define VERSION "1.2"
+#endif
 
 #ifndef DVD_VIDEO_LB_LEN
 #define DVD_VIDEO_LB_LEN 2048
 #endif
 
-// libmpeg2 reads 4096 bytes at a time, do the same here
-#define DVD_READ_BLOCKS 1
-#define DVD_BUFFER_SIZE ( DVD_VIDEO_LB_LEN * DVD_READ_BLOCKS )
-
-// libmpeg2
-static FILE *mpeg_file = NULL;
-static int demux_track = 0xe0;
-static int demux_pid = 0;
-
-static char mpeg_filename[] = "dvd_extract.mpg";
+#define DVD_INFO_PROGRAM "dvd_extract_mpeg2"
 
-#define DEMUX_PAYLOAD_START 1
-
-/*
- * libmpeg2:
- *
- * The demuxer keeps some state between calls:
- *
- * if "state" = DEMUX_HEADER, then "head_buf" contains the first
- *     "bytes" bytes from some header.
- * if "state" == DEMUX_DATA, then we need to copy "bytes" bytes
- *     of ES data before the next header.
- * if "state" == DEMUX_SKIP, then we need to skip "bytes" bytes
- *     of data before the next header.
- *
- * NEEDBYTES makes sure we have the requested number of bytes for a
- * header. If we don't, it copies what we have into head_buf and returns,
- * so that when we come back with more data we finish decoding this header.
- *
- * DONEBYTES updates "buf" to point after the header we just parsed.
-*/
-
-static int demux(uint8_t *buf, uint8_t *end, int flags);
 int main(int, char **);
-void dvd_track_info(struct dvd_track *dvd_track, const uint16_t track_number, const ifo_handle_t *vmg_ifo, const ifo_handle_t *vts_ifo);
 void print_usage(char *binary);
+void print_version(char *binary);
 
-struct dvd_copy {
+struct dvd_extract {
 	uint16_t track;
 	uint8_t first_chapter;
 	uint8_t last_chapter;
-	uint8_t first_cell;
-	uint8_t last_cell;
-	ssize_t blocks;
-	ssize_t filesize;
 	char filename[PATH_MAX];
-	int fd;
+	ssize_t block_limit;
+	bool selected[256];
+	FILE *files[256];
+	struct dvd_audio_es *audio_es[256];
+	bool vobsub;
+	char idx_filename[PATH_MAX + 4];
+	struct dvd_vobsub dvd_vobsub;
+	struct dvd_vobu dvd_vobu;
+	bool has_vobu;
+	uint32_t cell_start[256];
 };
 
+/**
+ * File extension for an elementary stream, by its stream id
+ */
+static const char *dvd_extract_extension(const uint8_t stream_id) {
+
+	if(stream_id >= 0x20 && stream_id <= 0x3f)
+		return "spu";
+	if(stream_id >= 0x80 && stream_id <= 0x87)
+		return "ac3";
+	if(stream_id >= 0x88 && stream_id <= 0x8f)
+		return "dts";
+	if(stream_id >= 0xa0 && stream_id <= 0xa7)
+		return "wav";
+	if(stream_id >= 0xc0 && stream_id <= 0xdf)
+		return "mpa";
+
+	return "m2v";
+
+}
+
+/**
+ * Select the streams to extract, from a comma separated list of stream ids
+ * (0xe0, 0x80, 0x20, ...), or "video", "audio", "subtitles" and "all" for
+ * the streams the track has.
+ */
+static bool dvd_extract_select(struct dvd_extract *dvd_extract, struct dvd_session *dvd_session, const struct dvd_track *dvd_track, char *streams) {
+
+	char *token = NULL;
+	char *end = NULL;
+	unsigned long stream_id = 0;
+	uint8_t ix = 0;
+	struct dvd_audio dvd_audio;
+	struct dvd_subtitle dvd_subtitle;
+	bool all = false;
+
+	for(token = strtok(streams, ","); token != NULL; token = strtok(NULL, ",")) {
+
+		all = (strcmp(token, "all") == 0);
+
+		if(all || strcmp(token, "video") == 0)
+			dvd_extract->selected[DVD_DEMUX_VIDEO] = true;
+
+		if(all || strcmp(token, "audio") == 0) {
+			for(ix = 1; ix <= dvd_track->audio_tracks; ix++) {
+				if(dvd_session_audio(dvd_session, dvd_extract->track, ix, &dvd_audio))
+					dvd_extract->selected[strtoul(dvd_audio.stream_id, NULL, 0) & 0xff] = true;
+			}
+		}
+
+		if(all || strcmp(token, "subtitles") == 0) {
+			for(ix = 1; ix <= dvd_track->subtitles; ix++) {
+				if(dvd_session_subtitle(dvd_session, dvd_extract->track, ix, &dvd_subtitle))
+					dvd_extract->selected[strtoul(dvd_subtitle.stream_id, NULL, 0) & 0xff] = true;
+			}
+		}
+
+		if(all || strcmp(token, "video") == 0 || strcmp(token, "audio") == 0 || strcmp(token, "subtitles") == 0)
+			continue;
+
+		stream_id = strtoul(token, &end, 0);
+
+		if(*end != '\0' || stream_id == 0 || stream_id > 0xff || stream_id == DVD_DEMUX_PRIVATE_STREAM_1) {
+			fprintf(stderr, "%s: Invalid stream id %s\n", DVD_INFO_PROGRAM, token);
+			return false;
+		}
+
+		dvd_extract->selected[stream_id] = true;
+
+	}
+
+	return true;
+
+}
+
+/**
+ * Open a file for each stream.  Video goes to the output filename, the others
+ * get their stream id added to it: dvd_extract_0x80.ac3, dvd_extract_0x20.spu
+ *
+ * AC3, DTS and LPCM are written in whole frames, and LPCM as WAV, with the
+ * audio attributes of the track.
+ */
+static bool dvd_extract_open_files(struct dvd_extract *dvd_extract, struct dvd_session *dvd_session) {
+
+	char prefix[PATH_MAX];
+	char filename[PATH_MAX + 16];
+	char *extension = NULL;
+	ifo_handle_t *vts_ifo = dvd_session_track_ifo(dvd_session, dvd_extract->track);
+	int stream_id = 0;
+	uint8_t audio_track = 0;
+
+	snprintf(prefix, PATH_MAX, "%s", dvd_extract->filename);
+	extension = strrchr(prefix, '.');
+	if(extension != NULL && strchr(extension, '/') == NULL)
+		*extension = '\0';
+
+	for(stream_id = 0; stream_id < 256; stream_id++) {
+
+		if(!dvd_extract->selected[stream_id])
+			continue;
+
+		if(stream_id == DVD_DEMUX_VIDEO)
+			snprintf(filename, sizeof(filename), "%s", dvd_extract->filename);
+		else
+			snprintf(filename, sizeof(filename), "%s_0x%02x.%s", prefix, stream_id, dvd_extract_extension((uint8_t)stream_id));
+
+		dvd_extract->files[stream_id] = fopen(filename, "w+");
+
+		if(dvd_extract->files[stream_id] == NULL) {
+			fprintf(stderr, "Could not open file %s\n", filename);
+			return false;
+		}
+
+		printf("Stream id: 0x%02x, Filename: %s\n", stream_id, filename);
+
+		if(dvd_audio_es_format((uint8_t)stream_id) == DVD_AUDIO_ES_RAW || vts_ifo == NULL)
+			continue;
+
+		// 0x80, 0x88 and 0xa0 are the first audio track
+		audio_track = stream_id & 0x07;
+
+		dvd_extract->audio_es[stream_id] = malloc(sizeof(struct dvd_audio_es));
+
+		if(dvd_extract->audio_es[stream_id] == NULL || !dvd_audio_es_open(dvd_extract->audio_es[stream_id], dvd_extract->files[stream_id], (uint8_t)stream_id, dvd_audio_channels(vts_ifo, audio_track), dvd_audio_sample_rate(vts_ifo, audio_track), dvd_audio_quantization(vts_ifo, audio_track))) {
+			fprintf(stderr, "Could not start audio stream 0x%02x\n", stream_id);
+			return false;
+		}
+
+	}
+
+	return true;
+
+}
+
+/**
+ * Write each elementary stream to its file
+ */
+static bool dvd_extract_write(void *data, const struct dvd_demux_packet *dvd_demux_packet) {
+
+	struct dvd_extract *dvd_extract = (struct dvd_extract *)data;
+	uint8_t stream_id = dvd_demux_packet->stream_id;
+
+	if(stream_id == DVD_DEMUX_PRIVATE_STREAM_1)
+		stream_id = dvd_demux_packet->substream_id;
+
+	if(dvd_extract->files[stream_id] == NULL)
+		return true;
+
+	if(dvd_extract->audio_es[stream_id] != NULL) {
+		if(!dvd_audio_es_write(dvd_extract->audio_es[stream_id], dvd_demux_packet)) {
+			fprintf(stderr, "Could not write stream 0x%02x\n", stream_id);
+			return false;
+		}
+		return true;
+	}
+
+	if(fwrite(dvd_demux_packet->buffer, dvd_demux_packet->length, 1, dvd_extract->files[stream_id]) != 1) {
+		fprintf(stderr, "Could not write stream 0x%02x\n", stream_id);
+		return false;
+	}
+
+	return true;
+
+}
+
+/**
+ * Subpicture packs go to the VobSub as they are, timed from the NAV pack of
+ * their VOBU so the times carry on across cells
+ */
+static bool dvd_extract_vobsub_write(void *data, const struct dvd_pipeline_blocks *dvd_pipeline_blocks) {
+
+	struct dvd_extract *dvd_extract = (struct dvd_extract *)data;
+	const uint8_t *block = NULL;
+	uint32_t msecs = 0;
+	uint64_t pts = 0;
+	uint8_t stream = 0;
+	bool has_pts = false;
+	ssize_t ix = 0;
+
+	for(ix = 0; ix < dvd_pipeline_blocks->blocks; ix++) {
+
+		block = dvd_pipeline_blocks->buffer + ix * DVD_VIDEO_LB_LEN;
+
+		if(dvd_vobu_parse(&dvd_extract->dvd_vobu, block)) {
+			dvd_extract->has_vobu = true;
+			continue;
+		}
+
+		if(!dvd_vobsub_pack(block, &stream, &has_pts, &pts))
+			continue;
+
+		if(has_pts)
+			msecs = dvd_extract->has_vobu ? dvd_extract->cell_start[dvd_pipeline_blocks->cell] + dvd_vobu_pts_msecs(&dvd_extract->dvd_vobu, pts) : (uint32_t)(pts / 90);
+
+		if(!dvd_vobsub_add(&dvd_extract->dvd_vobsub, block, stream, has_pts, msecs)) {
+			fprintf(stderr, "Could not write VobSub subtitles\n");
+			return false;
+		}
+
+	}
+
+	return true;
+
+}
+
+/**
+ * Move the selected subtitle streams to the VobSub, and start it, with the
+ * palette of the track and the start of each cell
+ */
+static bool dvd_extract_open_vobsub(struct dvd_extract *dvd_extract, struct dvd_session *dvd_session, const struct dvd_track *dvd_track) {
+
+	char prefix[PATH_MAX];
+	char filename[PATH_MAX + 4];
+	char *extension = NULL;
+	ifo_handle_t *vmg_ifo = dvd_session_vmg_ifo(dvd_session);
+	ifo_handle_t *vts_ifo = dvd_session_track_ifo(dvd_session, dvd_extract->track);
+	uint32_t palette[16];
+	uint8_t first_cell = dvd_chapter_first_cell(vmg_ifo, vts_ifo, dvd_extract->track, dvd_extract->first_chapter);
+	uint8_t ix = 0;
+
+	snprintf(prefix, PATH_MAX, "%s", dvd_extract->filename);
+	extension = strrchr(prefix, '.');
+	if(extension != NULL && strchr(extension, '/') == NULL)
+		*extension = '\0';
+
+	snprintf(filename, sizeof(filename), "%s.sub", prefix);
+	snprintf(dvd_extract->idx_filename, sizeof(dvd_extract->idx_filename), "%s.idx", prefix);
+
+	if(!dvd_vobsub_open(&dvd_extract->dvd_vobsub, filename)) {
+		fprintf(stderr, "Could not open file %s\n", filename);
+		return false;
+	}
+
+	for(ix = 0; ix < DVD_VOBSUB_STREAMS; ix++) {
+		if(!dvd_extract->selected[0x20 + ix])
+			continue;
+		dvd_extract->selected[0x20 + ix] = false;
+		dvd_vobsub_stream(&dvd_extract->dvd_vobsub, ix, ix < dvd_track->subtitles ? dvd_track->dvd_subtitles[ix].lang_code : "");
+		printf("Stream id: 0x%02x, Filename: %s\n", 0x20 + ix, filename);
+	}
+
+	dvd_subtitle_palette(vmg_ifo, vts_ifo, dvd_extract->track, palette);
+	dvd_vobsub_video(&dvd_extract->dvd_vobsub, dvd_track->dvd_video.width, dvd_track->dvd_video.height, palette);
+
+	// Times are from the start of the first chapter
+	dvd_cell_starts(vmg_ifo, vts_ifo, dvd_extract->track, first_cell, dvd_extract->cell_start);
+
+	return true;
+
+}
+
 int main(int argc, char **argv) {
 
 	/**
@@ -101,39 +322,46 @@ int main(int argc, char **argv) {
 	int opt = 0;
 	opterr = 1;
 	const char *str_options;
-	str_options = "c:ht:";
+	str_options = "b:c:ho:s:t:vV";
 	uint8_t arg_first_chapter = 1;
 	uint8_t arg_last_chapter = 99;
 	char *token = NULL;
-	struct dvd_copy dvd_copy;
-
-	mpeg_file = fopen(mpeg_filename, "w+");
-
-	if(!mpeg_file) {
-		printf("Could not open file %s\n", mpeg_filename);
-		return 1;
-	}
+	char *arg_streams = NULL;
+	struct dvd_extract dvd_extract;
 
 	struct option long_options[] = {
 
+		{ "blocks", required_argument, 0, 'b' },
 		{ "chapters", required_argument, 0, 'c' },
+		{ "output", required_argument, 0, 'o' },
+		{ "streams", required_argument, 0, 's' },
 		{ "track", required_argument, 0, 't' },
+		{ "vobsub", no_argument, 0, 'v' },
+		{ "help", no_argument, 0, 'h' },
+		{ "version", no_argument, 0, 'V' },
 		{ 0, 0, 0, 0 }
 
 	};
 
-	dvd_copy.track = 1;
-	dvd_copy.first_chapter = 1;
-	dvd_copy.last_chapter = 99;
-	dvd_copy.first_cell = 1;
-	dvd_copy.last_cell = 1;
-	dvd_copy.blocks = 0;
-	dvd_copy.filesize = 0;
+	memset(&dvd_extract, 0, sizeof(dvd_extract));
+	dvd_extract.track = 1;
+	dvd_extract.first_chapter = 1;
+	dvd_extract.last_chapter = 99;
+	dvd_extract.block_limit = DVD_PIPELINE_BLOCK_LIMIT;
+	snprintf(dvd_extract.filename, PATH_MAX, "dvd_extract.mpg");
 
 	while((opt = getopt_long(argc, argv, str_options, long_options, &long_index )) != -1) {
 
 		switch(opt) {
 
+			case 'b':
+				dvd_extract.block_limit = (ssize_t)strtoumax(optarg, NULL, 0);
+				if(dvd_extract.block_limit < 1) {
+					fprintf(stderr, "Blocks to read at a time must be at least 1\n");
+					return 1;
+				}
+				break;
+
 			case 'c':
 				opt_chapter_number = true;
 				token = strtok(optarg, "-"); {
@@ -161,17 +389,37 @@ int main(int argc, char **argv) {
 				break;
 
 			case 'h':
-				print_usage("dvd_copy");
+				print_usage(DVD_INFO_PROGRAM);
 				return 0;
 
+			case 'o':
+				if(strlen(optarg) >= PATH_MAX) {
+					fprintf(stderr, "Output filename is too long\n");
+					return 1;
+				}
+				snprintf(dvd_extract.filename, PATH_MAX, "%s", optarg);
+				break;
+
+			case 's':
+				arg_streams = optarg;
+				break;
+
 			case 't':
 				opt_track_number = true;
 				arg_track_number = (uint16_t)strtoumax(optarg, NULL, 0);
 				break;
 
+			case 'v':
+				dvd_extract.vobsub = true;
+				break;
+
+			case 'V':
+				print_version(DVD_INFO_PROGRAM);
+				return 0;
+
 			// ignore unknown arguments
 			case '?':
-				print_usage("dvd_copy");
+				print_usage(DVD_INFO_PROGRAM);
 				return 1;
 
 			// let getopt_long set the variable
@@ -188,614 +436,189 @@ int main(int argc, char **argv) {
 	if (argv[optind])
 		device_filename = argv[optind];
 
-	if(access(device_filename, F_OK) != 0) {
-		fprintf(stderr, "cannot access %s\n", device_filename);
-		return 1;
-	}
+	// Open the DVD, the VMG IFO and check the drive status
+	struct dvd_session *dvd_session = NULL;
+	int session_error = DVD_SESSION_OK;
 
-	// Check to see if device can be opened
-	int dvd_fd = 0;
-	dvd_fd = dvd_device_open(device_filename);
-	if(dvd_fd < 0) {
-		fprintf(stderr, "dvd_copy: error opening %s\n", device_filename);
-		return 1;
-	}
-	dvd_device_close(dvd_fd);
+	dvd_session = dvd_session_open(device_filename, &session_error);
 
+	if(dvd_session == NULL) {
 
 #ifdef __linux__
-
-	// Poll drive status if it is hardware
-	if(dvd_device_is_hardware(device_filename)) {
-
-		// Wait for the drive to become ready
-		if(!dvd_drive_has_media(device_filename)) {
-
+		if(session_error == DVD_SESSION_ERR_NO_MEDIA) {
 			fprintf(stderr, "drive status: ");
 			dvd_drive_display_status(device_filename);
-
 			return 1;
-
 		}
-
-	}
-
 #endif
 
-	dvd_reader_t *dvdread_dvd = NULL;
-	dvdread_dvd = DVDOpen(device_filename);
-
-	if(!dvdread_dvd) {
-		printf("* dvdread could not open %s\n", device_filename);
+		fprintf(stderr, "%s: %s: %s\n", DVD_INFO_PROGRAM, device_filename, dvd_session_strerror(session_error));
 		return 1;
-	}
-
-	ifo_handle_t *vmg_ifo = NULL;
-	vmg_ifo = ifoOpen(dvdread_dvd, 0);
 
-	if(vmg_ifo == NULL) {
-		printf("* Could not open IFO zero\n");
-		DVDClose(dvdread_dvd);
-		return 1;
-	}
-
-	printf("Disc Title: %s\n", dvd_title(device_filename));
-
-	uint16_t num_ifos = 1;
-	num_ifos = vmg_ifo->vts_atrt->nr_of_vtss;
-
-	if(num_ifos < 1) {
-		printf("* DVD has no title IFOs?!\n");
-		printf("* Most likely a bug in libdvdread or a bad master or problems reading the disc\n");
-		ifoClose(vmg_ifo);
-		DVDClose(dvdread_dvd);
-		return 1;
 	}
 
 	// DVD
 	struct dvd_info dvd_info;
-	memset(&dvd_info, 0, sizeof(dvd_info));
-	dvd_info.tracks = dvd_tracks(vmg_ifo);
-	dvd_info.longest_track = 1;
-	dvd_info.video_title_sets = dvd_video_title_sets(vmg_ifo);
-	dvd_info.tracks = dvd_tracks(vmg_ifo);
+	dvd_session_info(dvd_session, &dvd_info);
 
-	// Track
-	struct dvd_track dvd_track;
-	memset(&dvd_track, 0, sizeof(dvd_track));
-
-	struct dvd_track dvd_tracks[DVD_MAX_TRACKS];
-	memset(&dvd_tracks, 0, sizeof(dvd_track) * dvd_info.tracks);
-
-	// Cells
-	struct dvd_cell dvd_cell;
-	dvd_cell.cell = 1;
-	memset(dvd_cell.length, '\0', sizeof(dvd_cell.length));
-	snprintf(dvd_cell.length, DVD_CELL_LENGTH + 1, "00:00:00.000");
-	dvd_cell.msecs = 0;
-
-	// Open first IFO
-	uint16_t vts = 1;
-	ifo_handle_t *vts_ifo = NULL;
-
-	vts_ifo = ifoOpen(dvdread_dvd, vts);
-	if(vts_ifo == NULL) {
-		printf("* Could not open VTS_IFO for track %u\n", 1);
-		return 1;
-	}
-	ifoClose(vts_ifo);
-	vts_ifo = NULL;
-
-	// Create an array of all the IFOs
-	ifo_handle_t *vts_ifos[DVD_MAX_VTS_IFOS];
-	vts_ifos[0] = NULL;
+	printf("Disc Title: %s\n", dvd_info.title);
 
-	for(vts = 1; vts < dvd_info.video_title_sets + 1; vts++) {
-
-		vts_ifos[vts] = ifoOpen(dvdread_dvd, vts);
-
-		if(!vts_ifos[vts]) {
-			vts_ifos[vts] = NULL;
-		} else if(!ifo_is_vts(vts_ifos[vts])) {
-			ifoClose(vts_ifos[vts]);
-			vts_ifos[vts] = NULL;
-		}
-
-	}
-	
 	// Exit if track number requested does not exist
-	if(opt_track_number && (arg_track_number > dvd_info.tracks)) {
-		fprintf(stderr, "dvd_copy: Invalid track number %d\n", arg_track_number);
-		fprintf(stderr, "dvd_copy: Valid track numbers: 1 to %u\n", dvd_info.tracks);
-		ifoClose(vmg_ifo);
-		DVDClose(dvdread_dvd);
+	if(opt_track_number && (arg_track_number > dvd_info.tracks || arg_track_number < 1)) {
+		fprintf(stderr, "%s: Invalid track number %d\n", DVD_INFO_PROGRAM, arg_track_number);
+		fprintf(stderr, "%s: Valid track numbers: 1 to %u\n", DVD_INFO_PROGRAM, dvd_info.tracks);
+		dvd_session_close(dvd_session);
 		return 1;
 	} else if(opt_track_number) {
-		dvd_copy.track = arg_track_number;
-	}
-
-	uint16_t ix = 0;
-	uint16_t track = 1;
-	
-	uint32_t longest_msecs = 0;
-	
-	for(ix = 0, track = 1; ix < dvd_info.tracks; ix++, track++) {
- 
-		vts = dvd_vts_ifo_number(vmg_ifo, ix + 1);
-		vts_ifo = vts_ifos[vts];
-		dvd_track_info(&dvd_tracks[ix], track, vmg_ifo, vts_ifo);
-
-		if(dvd_tracks[ix].msecs > longest_msecs) {
-			dvd_info.longest_track = track;
-			longest_msecs = dvd_tracks[ix].msecs;
-		}
-
+		dvd_extract.track = arg_track_number;
 	}
 
 	// Set the track number to rip if none is passed as an argument
 	if(!opt_track_number)
-		dvd_copy.track = dvd_info.longest_track;
-	
-	dvd_track = dvd_tracks[dvd_copy.track - 1];
+		dvd_extract.track = dvd_info.longest_track;
+
+	// Track
+	struct dvd_track dvd_track;
+	dvd_session_track(dvd_session, dvd_extract.track, &dvd_track);
+
+	if(!dvd_track.valid) {
+		fprintf(stderr, "* Could not open VTS_IFO for track %u\n", dvd_extract.track);
+		dvd_session_close(dvd_session);
+		return 1;
+	}
 
 	// Set the proper chapter range
 	if(opt_chapter_number) {
 		if(arg_first_chapter > dvd_track.chapters) {
-			dvd_copy.first_chapter = dvd_track.chapters;
-			fprintf(stderr, "Resetting first chapter to %u\n", dvd_copy.first_chapter);
+			dvd_extract.first_chapter = dvd_track.chapters;
+			fprintf(stderr, "Resetting first chapter to %u\n", dvd_extract.first_chapter);
 		} else
-			dvd_copy.first_chapter = arg_first_chapter;
-		
+			dvd_extract.first_chapter = arg_first_chapter;
+
 		if(arg_last_chapter > dvd_track.chapters) {
-			dvd_copy.last_chapter = dvd_track.chapters;
-			fprintf(stderr, "Resetting last chapter to %u\n", dvd_copy.last_chapter);
+			dvd_extract.last_chapter = dvd_track.chapters;
+			fprintf(stderr, "Resetting last chapter to %u\n", dvd_extract.last_chapter);
 		} else
-			dvd_copy.last_chapter = arg_last_chapter;
+			dvd_extract.last_chapter = arg_last_chapter;
 	} else {
-		dvd_copy.first_chapter = 1;
-		dvd_copy.last_chapter = dvd_track.chapters;
+		dvd_extract.first_chapter = 1;
+		dvd_extract.last_chapter = dvd_track.chapters;
 	}
-	
-	/**
-	 * Integers for numbers of blocks read, copied, counters
-	 */
-	int offset = 0;
-	ssize_t read_blocks = DVD_READ_BLOCKS;
-	ssize_t dvdread_read_blocks = 0; // num blocks passed by dvdread function
-	ssize_t cell_blocks_written = 0;
-	ssize_t dvd_blocks_written = 0;
-	ssize_t bytes_written = 0;
-	uint32_t cell_sectors = 0;
-
-	/**
-	 * File descriptors and filenames
-	 */
-	dvd_file_t *dvdread_vts_file = NULL;
-
-	vts = dvd_vts_ifo_number(vmg_ifo, dvd_copy.track);
-	vts_ifo = vts_ifos[vts];
-
-	// Open the VTS VOB
-	dvdread_vts_file = DVDOpenFile(dvdread_dvd, vts, DVD_READ_TITLE_VOBS);
 
 	printf("Track: %02u, Length: %s Chapters: %02u, Cells: %02u, Audio streams: %02u, Subpictures: %02u, Filesize: %lu, Blocks: %lu\n", dvd_track.track, dvd_track.length, dvd_track.chapters, dvd_track.cells, dvd_track.audio_tracks, dvd_track.subtitles, dvd_track.filesize, dvd_track.blocks);
 
-	dvd_copy.first_cell = dvd_chapter_first_cell(vmg_ifo, vts_ifo, dvd_copy.track, dvd_copy.first_chapter);
-	dvd_copy.last_cell = dvd_chapter_last_cell(vmg_ifo, vts_ifo, dvd_copy.track, dvd_copy.last_chapter);
-
-	// Get limits of copy
-	for(dvd_cell.cell = dvd_copy.first_cell; dvd_cell.cell < dvd_copy.last_cell + 1; dvd_cell.cell++) {
-		
-		dvd_copy.blocks += dvd_cell_blocks(vmg_ifo, vts_ifo, dvd_track.track, dvd_cell.cell);
-		dvd_copy.filesize += dvd_cell_filesize(vmg_ifo, vts_ifo, dvd_track.track, dvd_cell.cell);
-
+	struct dvd_demux *dvd_demux = NULL;
+	struct dvd_pipeline *dvd_pipeline = NULL;
+	bool extracted = false;
+	bool demux = false;
+	int stream_id = 0;
+	uint8_t ix = 0;
+
+	// VobSub on its own is every active subtitle stream
+	if(arg_streams == NULL && dvd_extract.vobsub) {
+		for(ix = 0; ix < dvd_track.subtitles && ix < DVD_VOBSUB_STREAMS; ix++) {
+			if(dvd_track.dvd_subtitles[ix].active)
+				dvd_extract.selected[0x20 + ix] = true;
+		}
+	} else if(arg_streams == NULL)
+		dvd_extract.selected[DVD_DEMUX_VIDEO] = true;
+	else if(!dvd_extract_select(&dvd_extract, dvd_session, &dvd_track, arg_streams)) {
+		dvd_session_track_free(&dvd_track);
+		dvd_session_close(dvd_session);
+		return 1;
 	}
 
-	uint8_t *end = NULL;
-	uint8_t dvd_read_buffer[DVD_BUFFER_SIZE];
-
-	struct dvd_chapter dvd_chapter;
-	unsigned long progress = 0;
-	unsigned long last_pass = 0;
-
-	for(dvd_chapter.chapter = dvd_copy.first_chapter; dvd_chapter.chapter < dvd_copy.last_chapter + 1; dvd_chapter.chapter++) {
-
-		dvd_chapter.first_cell = dvd_chapter_first_cell(vmg_ifo, vts_ifo, dvd_copy.track, dvd_chapter.chapter);
-		dvd_chapter.last_cell = dvd_chapter_last_cell(vmg_ifo, vts_ifo, dvd_copy.track, dvd_chapter.chapter);
-		strncpy(dvd_chapter.length, dvd_chapter_length(vmg_ifo, vts_ifo, dvd_copy.track, dvd_chapter.chapter), DVD_CHAPTER_LENGTH);
-
-		for(dvd_cell.cell = dvd_chapter.first_cell; dvd_cell.cell < dvd_chapter.last_cell + 1; dvd_cell.cell++) {
-
-			dvd_cell.blocks = dvd_cell_blocks(vmg_ifo, vts_ifo, dvd_track.track, dvd_cell.cell);
-			dvd_cell.filesize = dvd_cell_filesize(vmg_ifo, vts_ifo, dvd_track.track, dvd_cell.cell);
-			dvd_cell.first_sector = dvd_cell_first_sector(vmg_ifo, vts_ifo, dvd_track.track, dvd_cell.cell);
-			dvd_cell.last_sector = dvd_cell_last_sector(vmg_ifo, vts_ifo, dvd_track.track, dvd_cell.cell);
-			strncpy(dvd_cell.length, dvd_cell_length(vmg_ifo, vts_ifo, dvd_track.track, dvd_cell.cell), DVD_CELL_LENGTH);
-			cell_sectors = dvd_cell.last_sector - dvd_cell.first_sector;
-
-			printf("        Chapter: %02u, Cell: %02u, VTS: %u, Filesize: %lu, Blocks: %lu, Sectors: %i to %i\n", dvd_chapter.chapter, dvd_cell.cell, vts, dvd_cell.filesize, dvd_cell.blocks, dvd_cell.first_sector, dvd_cell.last_sector);
-
-			cell_blocks_written = 0;
-
-			if(dvd_cell.last_sector > dvd_cell.first_sector)
-				cell_sectors++;
-
-			if(dvd_cell.last_sector < dvd_cell.first_sector) {
-				printf("* DEBUG Someone doing something nasty? The last sector is listed before the first; skipping cell\n");
-				continue;
-			}
-			
-			offset = (int)dvd_cell.first_sector;
-
-			// This is where you would change the boundaries -- are you dumping to a track file (no boundaries) or a VOB (boundaries)
-			while(cell_blocks_written < dvd_cell.blocks) {
-
-				// libmpeg2
-				do {
-
-					// Limit blocks to be read based on how close we are to finishing
-					if(read_blocks > (dvd_cell.blocks - cell_blocks_written)) {
-						read_blocks = dvd_cell.blocks - cell_blocks_written;
-					}
-
-					dvdread_read_blocks = DVDReadBlocks(dvdread_vts_file, offset, (uint64_t)read_blocks, dvd_read_buffer);
-					if(!dvdread_read_blocks) {
-						printf("* Could not read data from cell %u\n", dvd_cell.cell);
-						return 1;
-					}
-
-					// Check to make sure the amount read was what we wanted
-					if(dvdread_read_blocks != read_blocks) {
-						printf("*** Asked for %ld and only got %ld\n", read_blocks, dvdread_read_blocks);
-						return 1;
-					}
+	// All the streams come out of the same pass over the disc
+	if((!dvd_extract.vobsub || dvd_extract_open_vobsub(&dvd_extract, dvd_session, &dvd_track)) && dvd_extract_open_files(&dvd_extract, dvd_session)) {
+		dvd_demux = dvd_demux_open_streams(dvd_extract_write, &dvd_extract);
+		dvd_pipeline = dvd_pipeline_open(dvd_session, dvd_extract.track, dvd_extract.first_chapter, dvd_extract.last_chapter);
+	}
 
-					offset += dvdread_read_blocks;
+	if(dvd_demux != NULL && dvd_pipeline != NULL) {
 
-					bytes_written = read_blocks * DVD_VIDEO_LB_LEN;
+		for(stream_id = 0; stream_id < 256; stream_id++) {
+			dvd_demux_select(dvd_demux, (uint8_t)stream_id, dvd_extract.selected[stream_id]);
+			demux = demux || dvd_extract.selected[stream_id];
+		}
 
-					end = dvd_read_buffer + bytes_written;
+		dvd_pipeline_block_limit(dvd_pipeline, dvd_extract.block_limit);
+		if(demux)
+			dvd_demux_pipeline(dvd_pipeline, dvd_demux);
+		if(dvd_extract.vobsub)
+			dvd_pipeline_add(dvd_pipeline, "vobsub", dvd_extract_vobsub_write, NULL, &dvd_extract);
+		dvd_pipeline_add_progress(dvd_pipeline);
 
-					if(demux(dvd_read_buffer, end, 0)) {
-						break;
-					}
+		extracted = dvd_pipeline_run(dvd_pipeline);
 
-					cell_blocks_written += dvdread_read_blocks;
-					dvd_blocks_written += dvdread_read_blocks;
+	}
 
-					progress = dvd_blocks_written * 100 / dvd_copy.blocks;
-					if(progress > last_pass) {
-						printf("Progress: %lu%%\r", progress);
-						fflush(stdout);
-					}
+	printf("\n");
 
-					last_pass = progress;
+	dvd_pipeline_close(dvd_pipeline);
 
-				} while(dvdread_read_blocks && cell_blocks_written < dvd_cell.blocks);
+	dvd_demux_close(dvd_demux);
 
-			}
+	if(dvd_extract.vobsub && dvd_extract.dvd_vobsub.sub != NULL && !dvd_vobsub_close(&dvd_extract.dvd_vobsub, dvd_extract.idx_filename)) {
+		fprintf(stderr, "Could not write VobSub file %s\n", dvd_extract.idx_filename);
+		extracted = false;
+	}
 
+	for(stream_id = 0; stream_id < 256; stream_id++) {
+		if(dvd_extract.audio_es[stream_id] == NULL)
+			continue;
+		if(!dvd_audio_es_close(dvd_extract.audio_es[stream_id])) {
+			fprintf(stderr, "Could not write stream 0x%02x\n", stream_id);
+			extracted = false;
 		}
-
+		if(dvd_extract.audio_es[stream_id]->dropped)
+			printf("Stream id: 0x%02x, Frames: %" PRIu32 ", Bytes dropped: %" PRIu64 "\n", stream_id, dvd_extract.audio_es[stream_id]->frames, dvd_extract.audio_es[stream_id]->dropped);
+		free(dvd_extract.audio_es[stream_id]);
 	}
 
-	if(mpeg_file)
-		fclose(mpeg_file);
-	
-	DVDCloseFile(dvdread_vts_file);
-
-	if(vts_ifo)
-		ifoClose(vts_ifo);
-	
-	if(vmg_ifo)
-		ifoClose(vmg_ifo);
+	for(stream_id = 0; stream_id < 256; stream_id++) {
+		if(dvd_extract.files[stream_id] != NULL && fclose(dvd_extract.files[stream_id]) != 0) {
+			fprintf(stderr, "Could not write stream 0x%02x\n", stream_id);
+			extracted = false;
+		}
+	}
 
-	if(dvdread_dvd)
-		DVDClose(dvdread_dvd);
-	
-	return 0;
+	dvd_session_track_free(&dvd_track);
 
-}
+	dvd_session_close(dvd_session);
 
-void dvd_track_info(struct dvd_track *dvd_track, const uint16_t track_number, const ifo_handle_t *vmg_ifo, const ifo_handle_t *vts_ifo) {
-
-	dvd_track->track = track_number;
-	dvd_track->valid = 1;
-	dvd_track->vts = dvd_vts_ifo_number(vmg_ifo, track_number);
-	dvd_track->ttn = dvd_track_ttn(vmg_ifo, track_number);
-	strncpy(dvd_track->length, dvd_track_length(vmg_ifo, vts_ifo, track_number), DVD_TRACK_LENGTH);
-	dvd_track->msecs = dvd_track_msecs(vmg_ifo, vts_ifo, track_number);
-	dvd_track->chapters = dvd_track_chapters(vmg_ifo, vts_ifo, track_number);
-	dvd_track->audio_tracks = dvd_track_audio_tracks(vts_ifo);
-	dvd_track->subtitles = dvd_track_subtitles(vts_ifo);
-	dvd_track->active_audio = dvd_audio_active_tracks(vmg_ifo, vts_ifo, track_number);
-	dvd_track->active_subs = dvd_track_active_subtitles(vmg_ifo, vts_ifo, track_number);
-	dvd_track->cells = dvd_track_cells(vmg_ifo, vts_ifo, track_number);
-	dvd_track->blocks = dvd_track_blocks(vmg_ifo, vts_ifo, track_number);
-	dvd_track->filesize = dvd_track_filesize(vmg_ifo, vts_ifo, track_number);
+	return extracted ? 0 : 1;
 
 }
 
 void print_usage(char *binary) {
 
-	printf("%s - Copy a DVD track\n", binary);
+	printf("%s %s - extract the elementary streams of a DVD track\n", binary, VERSION);
 	printf("\n");
-	printf("Usage: %s [-t track] [dvd path]\n", binary);
+	printf("Usage: %s [-t track] [-c chapter[-chapter]] [-o filename] [-s streams] [-v] [dvd path]\n", binary);
+	printf("\n");
+	printf("Options:\n");
+	printf("  -s, --streams <list>	Streams to extract, comma separated: video, audio,\n");
+	printf("			subtitles, all, or stream ids (0xe0, 0x80, 0x20, ...)\n");
+	printf("  -v, --vobsub		Save the subtitle streams as VobSub (.idx and .sub),\n");
+	printf("			every active one if no streams are given\n");
+	printf("  -b, --blocks <#>	Blocks to read from the disc at a time (default: %u)\n", DVD_PIPELINE_BLOCK_LIMIT);
 	printf("\n");
 	printf("DVD path can be a directory, a device filename, or a local file.\n");
 	printf("\n");
 	printf("Examples:\n");
-	printf("  dvd_info " DEFAULT_DVD_DEVICE "	# Read a DVD drive directly\n");
-	printf("  dvd_info movie.iso	# Read an image file\n");
-	printf("  dvd_info movie/	# Read a directory that contains VIDEO_TS\n");
+	printf("  %s " DEFAULT_DVD_DEVICE "	# Read a DVD drive directly\n", binary);
+	printf("  %s movie.iso	# Read an image file\n", binary);
+	printf("  %s movie/	# Read a directory that contains VIDEO_TS\n", binary);
 	printf("\n");
 	printf("If no DVD path is given, %s is used in its place.\n", DEFAULT_DVD_DEVICE);
+	printf("If no output filename is given, the video is saved to dvd_extract.mpg\n");
+	printf("Other streams are saved next to it, with their stream id: dvd_extract_0x80.ac3\n");
+	printf("AC3 and DTS are cut to whole frames, and LPCM is saved as WAV.\n");
 
 }
 
-static int demux(uint8_t *buf, uint8_t *end, int flags) {
-
-#define DEMUX_HEADER 0
-#define DEMUX_DATA 1
-#define DEMUX_SKIP 2
-
-	static int mpeg1_skip_table[16] = {
-		0, 0, 4, 9, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
-	};
-	static int state = DEMUX_SKIP;
-	static int state_bytes = 0;
-	static uint8_t head_buf[264];
-	uint8_t *header = NULL;
-	int bytes = 0;
-	int len = 0;
-	size_t writeval = 0;
-
-#define NEEDBYTES(x)								\
-	do {									\
-		int missing = 0;						\
-		missing = (x) - bytes;						\
-		if(missing > 0) {						\
-			if (header == head_buf) {				\
-				if(missing <= end - buf) {			\
-					memcpy(header + bytes, buf, missing);	\
-					buf += missing;				\
-					bytes = (x);				\
-				} else {					\
-					memcpy(header + bytes, buf, end - buf);	\
-					state_bytes = bytes + end - buf;	\
-					return 0;				\
-				}						\
-			} else {						\
-				memcpy (head_buf, header, bytes);		\
-				state = DEMUX_HEADER;				\
-				state_bytes = bytes;				\
-				return 0;					\
-			}							\
-		}								\
-	} while (0)
-
-#define DONEBYTES(x)				\
-	do {					\
-		if (header != head_buf)		\
-	    		buf = header + (x);	\
-	} while (0)
-
-	if(flags & DEMUX_PAYLOAD_START)
-		goto payload_start;
-
-	switch (state) {
-		case DEMUX_HEADER:
-			if(state_bytes > 0) {
-				header = head_buf;
-				bytes = state_bytes;
-				goto continue_header;
-			}
-			break;
-		case DEMUX_DATA:
-			if(demux_pid || (state_bytes > end - buf)) {
-				writeval = fwrite(buf, end - buf, 1, mpeg_file);
-				if(!writeval) {
-					printf("Could not write to %s\n", mpeg_filename);
-					return 1;
-				}
-				state_bytes -= end - buf;
-				return 0;
-			}
-			writeval = fwrite(buf, state_bytes, 1, mpeg_file);
-			if(!writeval) {
-				printf("Could not write to %s\n", mpeg_filename);
-				return 1;
-			}
-			buf += state_bytes;
-			break;
-		case DEMUX_SKIP:
-			if(demux_pid || (state_bytes > end - buf)) {
-				state_bytes -= end - buf;
-				return 0;
-			}
-			buf += state_bytes;
-			break;
-	}
-
-	while(true) {
-
-		if(demux_pid) {
-			state = DEMUX_SKIP;
-			return 0;
-		}
-
-		payload_start:
-
-		header = buf;
-		bytes = end - buf;
-
-		continue_header:
-
-		NEEDBYTES (4);
-
-		if(header[0] || header[1] || (header[2] != 1)) {
+void print_version(char *binary) {
 
-			if (demux_pid) {
-
-				state = DEMUX_SKIP;
-
-				return 0;
-
-			} else if(header != head_buf) {
-
-				buf++;
-				goto payload_start;
-
-			} else {
-
-				header[0] = header[1];
-				header[1] = header[2];
-				header[2] = header[3];
-				bytes = 3;
-
-				goto continue_header;
-
-			}
-
-		}
-
-		if(demux_pid) {
-
-			if((header[3] >= 0xe0) && (header[3] <= 0xef))
-				goto pes;
-
-			fprintf(stderr, "bad stream id %x\n", header[3]);
-
-			exit(1);
-
-		}
-
-		switch (header[3]) {
-
-			/* program end code */
-			case 0xb9:
-					/* DONEBYTES (4); */
-					/* break;         */
-				return 1;
-
-			/* pack header */
-			case 0xba:
-
-				NEEDBYTES (5);
-
-				if((header[4] & 0xc0) == 0x40) {	/* mpeg2 */
-
-					NEEDBYTES (14);
-					len = 14 + (header[13] & 7);
-					NEEDBYTES (len);
-					DONEBYTES (len);
-
-				/* header points to the mpeg2 pack header */
-				} else if((header[4] & 0xf0) == 0x20) {	/* mpeg1 */
-
-					NEEDBYTES (12);
-					DONEBYTES (12);
-
-				/* header points to the mpeg1 pack header */
-				} else {
-
-					fprintf (stderr, "weird pack header\n");
-					DONEBYTES (5);
-
-				}
-
-				break;
-
-			default:
-
-				if (header[3] == demux_track) {
-
-					pes:
-					NEEDBYTES (7);
-
-					if((header[6] & 0xc0) == 0x80) {	/* mpeg2 */
-						NEEDBYTES (9);
-						len = 9 + header[8];
-						NEEDBYTES (len);
-					/* header points to the mpeg2 pes header */
-					} else {	/* mpeg1 */
-
-						len = 7;
-
-						while((header-1)[len] == 0xff) {
-
-							len++;
-							NEEDBYTES (len);
-
-							if(len > 23) {
-								fprintf(stderr, "too much stuffing\n");
-								break;
-							}
-
-						}
-
-						if(((header-1)[len] & 0xc0) == 0x40) {
-
-							len += 2;
-							NEEDBYTES (len);
-
-						}
-
-						len += mpeg1_skip_table[(header - 1)[len] >> 4];
-
-						NEEDBYTES (len);
-
-						/* header points to the mpeg1 pes header */
-					}
-
-					DONEBYTES (len);
-
-					bytes = 6 + (header[4] << 8) + header[5] - len;
-
-					if(demux_pid || (bytes > end - buf)) {
-
-						writeval = fwrite(buf, end - buf, 1, mpeg_file);
-						if(!writeval) {
-							printf("Could not write to %s\n", mpeg_filename);
-							return 1;
-						}
-
-						state = DEMUX_DATA;
-						state_bytes = bytes - (end - buf);
-
-						return 0;
-
-					} else if(bytes <= 0) {
-						continue;
-					}
-
-					writeval = fwrite(buf, bytes, 1, mpeg_file);
-					if(!writeval) {
-						printf("Could not write to %s\n", mpeg_filename);
-						return 1;
-					}
-					buf += bytes;
-
-				} else if(header[3] < 0xb9) {
-					fprintf (stderr, "looks like a video stream, not system stream\n");
-					DONEBYTES (4);
-				} else {
-
-					NEEDBYTES (6);
-					DONEBYTES (6);
-
-					bytes = (header[4] << 8) + header[5];
-
-					if(bytes > end - buf) {
-						state = DEMUX_SKIP;
-						state_bytes = bytes - (end - buf);
-						return 0;
-					}
-
-					buf += bytes;
-		
-				}
-			}
-		}
-	}
+	printf("%s %s - http://dvds.beandog.org/ - (c) 2018 Steve Dibb <steve.dibb@gmail.com>, licensed under GPL-2\n", binary, VERSION);
 
+}
@@ -19,8 +19,16 @@
 #include "dvd_subtitles.h"
 #include "dvd_time.h"
 #include "dvd_json.h"
+#include "dvd_cbor.h"
 #include "dvd_ogm.h"
 #include "dvd_vob.h"
+#include "dvd_session.h"
+#include "dvd_pipeline.h"
+#include "dvd_es.h"
+#include "dvd_crop.h"
+#ifdef DVD_INFO_MPEG2
+#include "dvd_crop_detect.h"
+#endif
 #ifdef __linux__
 #include <linux/cdrom.h>
 #include "dvd_drive.h"
@@ -37,6 +45,7 @@ int main(int argc, char **argv) {
 
 	// Program name
 	bool p_dvd_json = false;
+	bool p_dvd_cbor = false;
 	bool p_dvd_id = false;
 	bool p_dvd_title = false;
 	bool p_dvd_ogm = false;
@@ -51,23 +60,18 @@ int main(int argc, char **argv) {
 	bool d_quiet = false;
 
 	// dvd_info
-	char dvdread_id[DVD_DVDREAD_ID + 1] = {'\0'};
 	bool d_all_tracks = true;
 	uint16_t d_first_track = 1;
 	uint16_t d_last_track = 1;
 	uint16_t track_number = 1;
-	uint16_t vts = 1;
-	bool has_invalid_ifos = false;
 	uint8_t c = 0;
 
 	// Device hardware
-	int dvd_fd = 0;
 	const char *device_filename = NULL;
 
-	// libdvdread
-	dvd_reader_t *dvdread_dvd = NULL;
-	ifo_handle_t *vmg_ifo = NULL;
-	ifo_handle_t *vts_ifo = NULL;
+	// libdvdinfo
+	struct dvd_session *dvd_session = NULL;
+	int session_error = DVD_SESSION_OK;
 
 	// DVD
 	struct dvd_info dvd_info;
@@ -80,11 +84,6 @@ int main(int argc, char **argv) {
 	dvd_info.tracks = 1;
 	dvd_info.longest_track = 1;
 
-	// Video Title Set
-	struct dvd_vts dvd_vts;
-	dvd_vts.vts = 1;
-	memset(dvd_vts.id, '\0', sizeof(dvd_vts.id));
-
 	// Track
 	struct dvd_track dvd_track;
 	dvd_track.track = 1;
@@ -112,6 +111,8 @@ int main(int argc, char **argv) {
 	dvd_video.df = 0;
 	memset(dvd_video.fps, '\0', sizeof(dvd_video.fps));
 	dvd_video.angles = 1;
+	dvd_video.crop = false;
+	memset(&dvd_video.dvd_es_stats, 0, sizeof(dvd_video.dvd_es_stats));
 
 	// Audio
 	struct dvd_audio dvd_audio;
@@ -144,22 +145,27 @@ int main(int argc, char **argv) {
 	dvd_cell.msecs = 0;
 	dvd_cell.first_sector = 0;
 	dvd_cell.last_sector = 0;
+	memset(&dvd_cell.dvd_es_stats, 0, sizeof(dvd_cell.dvd_es_stats));
 
 	// Display formats
 	const char *display_formats[4] = { "Pan and Scan or Letterbox", "Pan and Scan", "Letterbox", "Unset" };
 
-	// Statistics
-	uint32_t longest_msecs = 0;
+	// All tracks
+	struct dvd_track dvd_tracks[DVD_MAX_TRACKS];
+	memset(dvd_tracks, 0, sizeof(dvd_tracks));
 
 	// getopt_long
 	bool valid_args = true;
 	bool opt_track_number = false;
 	unsigned int arg_track_number = 0;
+	bool opt_crop = false;
+	bool opt_scan = false;
+	uint16_t arg_crop_samples = DVD_CROP_SAMPLES;
 	int ix = 0;
 	int opt = 0;
 	// Send 'invalid argument' to stderr
 	opterr = 1;
-	const char p_short_opts[] = "acdhijoqsTt:Vvx";
+	const char p_short_opts[] = "abcC::dhiIjoqsTt:Vvx";
 
 	struct option p_long_opts[] = {
 
@@ -168,8 +174,11 @@ int main(int argc, char **argv) {
 		{ "chapters", no_argument, NULL, 'c' },
 		{ "subtitles", no_argument, NULL, 's' },
 		{ "cells", no_argument, NULL, 'd' },
+		{ "crop", optional_argument, NULL, 'C' },
+		{ "scan", no_argument, NULL, 'I' },
 		{ "all", no_argument, NULL, 'x' },
 		{ "json", no_argument, NULL, 'j' },
+		{ "cbor", no_argument, NULL, 'b' },
 		{ "track", required_argument, NULL, 't' },
 		{ "quiet", no_argument, NULL, 'q' },
 		{ "id", no_argument, NULL, 'i' },
@@ -200,14 +209,33 @@ int main(int argc, char **argv) {
 				d_audio = true;
 				break;
 
+			case 'b':
+				p_dvd_cbor = true;
+				break;
+
 			case 'c':
 				d_chapters = true;
 				break;
 
+			case 'C':
+				opt_crop = true;
+				if(optarg != NULL) {
+					arg_crop_samples = (uint16_t)strtoumax(optarg, NULL, 0);
+					if(arg_crop_samples < 1 || arg_crop_samples > DVD_CROP_MAX_SAMPLES) {
+						fprintf(stderr, "[%s] crop samples must be between 1 and %u\n", program_name, DVD_CROP_MAX_SAMPLES);
+						valid_args = false;
+					}
+				}
+				break;
+
 			case 'd':
 				d_cells = true;
 				break;
 
+			case 'I':
+				opt_scan = true;
+				break;
+
 			case 'i':
 				p_dvd_id = true;
 				break;
@@ -275,78 +303,57 @@ int main(int argc, char **argv) {
 		return 1;
 
 	/** Begin dvd_info :) */
-	
-	// Check to see if device can be accessed
-	if(!dvd_device_access(device_filename)) {
-		fprintf(stderr, "%s: cannot access %s\n", program_name, device_filename);
-		return 1;
-	}
-
-	// Check to see if device can be opened
-	dvd_fd = dvd_device_open(device_filename);
-	if(dvd_fd < 0) {
-		fprintf(stderr, "%s: error opening %s\n", program_name, device_filename);
-		return 1;
-	}
-	dvd_device_close(dvd_fd);
 
-#ifdef __linux__
+	// Open the DVD, the VMG IFO and check the drive status
+	dvd_session = dvd_session_open(device_filename, &session_error);
 
-	// Poll drive status if it is hardware
-	if(dvd_device_is_hardware(device_filename)) {
+	if(dvd_session == NULL) {
 
-		// Wait for the drive to become ready
-		if(!dvd_drive_has_media(device_filename)) {
+		switch(session_error) {
 
-			fprintf(stderr, "drive status: ");
-			dvd_drive_display_status(device_filename);
+			case DVD_SESSION_ERR_ACCESS:
+				fprintf(stderr, "%s: cannot access %s\n", program_name, device_filename);
+				break;
 
-			return 1;
+			case DVD_SESSION_ERR_DEVICE:
+				fprintf(stderr, "%s: error opening %s\n", program_name, device_filename);
+				break;
 
-		}
+#ifdef __linux__
+			case DVD_SESSION_ERR_NO_MEDIA:
+				fprintf(stderr, "drive status: ");
+				dvd_drive_display_status(device_filename);
+				break;
+#endif
 
-	}
+			case DVD_SESSION_ERR_DVDREAD:
+			case DVD_SESSION_ERR_DVDREAD_ID:
+				fprintf(stderr, "%s: Opening DVD %s failed\n", program_name, device_filename);
+				break;
 
-#endif
+			default:
+				fprintf(stderr, "%s: %s\n", program_name, dvd_session_strerror(session_error));
+				break;
 
-	// begin libdvdread usage
+		}
 
-	// Open DVD device
-	dvdread_dvd = DVDOpen(device_filename);
-	if(!dvdread_dvd) {
-		fprintf(stderr, "%s: Opening DVD %s failed\n", program_name, device_filename);
 		return 1;
-	}
 
-	// Check if DVD has an identifier, fail otherwise
-	dvd_dvdread_id(dvdread_id, dvdread_dvd);
-	if(strlen(dvdread_id) == 0) {
-		fprintf(stderr, "%s: Opening DVD %s failed\n", program_name, device_filename);
-		return 1;
 	}
 
+	// GRAB ALL THE THINGS
+	dvd_session_info(dvd_session, &dvd_info);
+
 	// dvd_id
 	if(p_dvd_id) {
-		printf("%s\n", dvdread_id);
-		return 0;
-	}
-	
-	// Open VMG IFO -- where all the cool stuff is
-	vmg_ifo = ifoOpen(dvdread_dvd, 0);
-	if(vmg_ifo == NULL || !ifo_is_vmg(vmg_ifo)) {
-		fprintf(stderr, "%s: Opening VMG IFO failed\n", program_name);
-		DVDClose(dvdread_dvd);
-		return 1;
+		printf("%s\n", dvd_info.dvdread_id);
+		goto cleanup;
 	}
 
-	// Get the total number of title tracks on the DVD
-	dvd_info.tracks = dvd_tracks(vmg_ifo);
-
 	// Exit if track number requested does not exist
 	if(opt_track_number && (arg_track_number > dvd_info.tracks || arg_track_number < 1)) {
 		fprintf(stderr, "[%s] valid track numbers: 1 to %u\n", program_name, dvd_info.tracks);
-		ifoClose(vmg_ifo);
-		DVDClose(dvdread_dvd);
+		dvd_session_close(dvd_session);
 		return 1;
 	} else if(opt_track_number) {
 		d_first_track = (uint16_t)arg_track_number;
@@ -359,46 +366,9 @@ int main(int argc, char **argv) {
 		d_all_tracks = true;
 	}
 
-	// Exit if all the IFOs cannot be opened
-	dvd_info.video_title_sets = dvd_video_title_sets(vmg_ifo);
-	bool valid_ifos[DVD_MAX_VTS_IFOS] = { false };
-	ifo_handle_t *vts_ifos[DVD_MAX_VTS_IFOS];
-	vts_ifos[0] = NULL;
-
-	for(vts = 1; vts < dvd_info.video_title_sets + 1; vts++) {
-
-		vts_ifos[vts] = ifoOpen(dvdread_dvd, vts);
-
-		if(vts_ifos[vts] == NULL) {
-			valid_ifos[vts] = false;
-			has_invalid_ifos = true;
-			vts_ifos[vts] = NULL;
-		} else if(!ifo_is_vts(vts_ifos[vts])) {
-			valid_ifos[vts] = false;
-			has_invalid_ifos = true;
-			ifoClose(vts_ifos[vts]);
-			vts_ifos[vts] = NULL;
-		} else {
-			valid_ifos[vts] = true;
-		}
-
-	}
-
-	if(has_invalid_ifos)
+	if(dvd_session_invalid_ifos(dvd_session))
 		fprintf(stderr, "[NOTICE] %s: You can safely ignore \"Invalid IFOs\" warnings since we work around them :)\n", program_name);
 
-	// Exit if the track requested is on an invalid IFO
-	if(has_invalid_ifos && opt_track_number) {
-		vts = dvd_vts_ifo_number(vmg_ifo, track_number);
-	}
-
-	// GRAB ALL THE THINGS
-	dvd_title(dvd_info.title, device_filename);
-	dvd_info.side = dvd_info_side(vmg_ifo);
-	dvd_provider_id(dvd_info.provider_id, vmg_ifo);
-	dvd_vmg_id(dvd_info.vmg_id, vmg_ifo);
-	strncpy(dvd_info.dvdread_id, dvdread_id, DVD_DVDREAD_ID);
-
 	if(p_dvd_title) {
 		printf("%s\n", dvd_info.title);
 		goto cleanup;
@@ -408,189 +378,54 @@ int main(int argc, char **argv) {
 	 * Track information
 	 */
 
-	struct dvd_track dvd_tracks[DVD_MAX_TRACKS];
-
-	for(track_number = d_first_track; track_number <= d_last_track; track_number++) {
-
-		// Open IFO
-		dvd_track.vts = dvd_vts_ifo_number(vmg_ifo, track_number);
-
-		// Set track values to empty if it is invalid
-		if(valid_ifos[dvd_track.vts] == false) {
-
-			dvd_track.track = track_number;
-			dvd_track.valid = false;
-
-			dvd_track.ttn = dvd_track_ttn(vmg_ifo, dvd_track.track);
-			snprintf(dvd_track.length, DVD_TRACK_LENGTH + 1, "00:00:00.000");
-			dvd_track.msecs = 0;
-			dvd_track.chapters = 0;
-			dvd_track.audio_tracks = 0;
-			dvd_track.active_audio_streams = 0;
-			dvd_track.subtitles = 0;
-			dvd_track.active_subs = 0;
-			dvd_track.cells = 0;
-
-			dvd_tracks[track_number - 1] = dvd_track;
-
-			continue;
-
-		}
-
-		vts_ifo = vts_ifos[dvd_track.vts];
-
-		dvd_track.track = track_number;
-		dvd_track.valid = true;
-		dvd_track.ttn = dvd_track_ttn(vmg_ifo, dvd_track.track);
-		snprintf(dvd_track.length, DVD_TRACK_LENGTH + 1, "00:00:00.000");
-		dvd_track_length(dvd_track.length, vmg_ifo, vts_ifo, dvd_track.track);
-		dvd_track.msecs = dvd_track_msecs(vmg_ifo, vts_ifo, dvd_track.track);
-		dvd_track.chapters = dvd_track_chapters(vmg_ifo, vts_ifo, dvd_track.track);
-
-		if(dvd_track.msecs > longest_msecs) {
-			dvd_info.longest_track = dvd_track.track;
-			longest_msecs = dvd_track.msecs;
-		}
-
-		/** Video **/
-
-		memset(dvd_video.codec, '\0', sizeof(dvd_video.codec));
-		dvd_video_codec(dvd_video.codec, vts_ifo);
-
-		memset(dvd_video.format, '\0', sizeof(dvd_video.format));
-		dvd_track_video_format(dvd_video.format, vts_ifo);
-
-		dvd_video.width = dvd_video_width(vts_ifo);
-		dvd_video.height = dvd_video_height(vts_ifo);
-
-		memset(dvd_video.aspect_ratio, '\0', sizeof(dvd_video.aspect_ratio));
-		dvd_video_aspect_ratio(dvd_video.aspect_ratio, vts_ifo);
-
-		dvd_video.letterbox = dvd_video_letterbox(vts_ifo);
-		dvd_video.pan_and_scan = dvd_video_pan_scan(vts_ifo);
-		dvd_video.df = dvd_video_df(vts_ifo);
-		dvd_video.angles = dvd_video_angles(vmg_ifo, dvd_track.track);
-		dvd_track.audio_tracks = dvd_track_audio_tracks(vts_ifo);
-		dvd_track.active_audio_streams = 0;
-		dvd_track.subtitles = dvd_track_subtitles(vts_ifo);
-		dvd_track.active_subs = 0;
-		dvd_track.cells = dvd_track_cells(vmg_ifo, vts_ifo, dvd_track.track);
-
-		memset(dvd_video.fps, '\0', sizeof(dvd_video.fps));
-		dvd_track_str_fps(dvd_video.fps, vmg_ifo, vts_ifo, dvd_track.track);
-
-		dvd_track.dvd_video = dvd_video;
-
-		/** Audio Streams **/
-
-		dvd_track.dvd_audio_tracks = calloc(dvd_track.audio_tracks, sizeof(*dvd_track.dvd_audio_tracks));
-
-		if(dvd_track.audio_tracks && dvd_track.dvd_audio_tracks != NULL) {
-
-			for(c = 0; c < dvd_track.audio_tracks; c++) {
-
-				memset(&dvd_audio, 0, sizeof(dvd_audio));
-
-				dvd_audio.track = c + 1;
-				dvd_audio.active = dvd_audio_active(vmg_ifo, vts_ifo, dvd_track.track, dvd_audio.track);
-				if(dvd_audio.active)
-					dvd_track.active_audio_streams++;
-
-				dvd_audio.channels = dvd_audio_channels(vts_ifo, c);
-
-				memset(dvd_audio.stream_id, '\0', sizeof(dvd_audio.stream_id));
-				dvd_audio_stream_id(dvd_audio.stream_id, vts_ifo, c);
-
-				memset(dvd_audio.lang_code, '\0', sizeof(dvd_audio.lang_code));
-				dvd_audio_lang_code(dvd_audio.lang_code, vts_ifo, c);
-
-				memset(dvd_audio.codec, '\0', sizeof(dvd_audio.codec));
-				dvd_audio_codec(dvd_audio.codec, vts_ifo, c);
-
-				dvd_track.dvd_audio_tracks[c] = dvd_audio;
-
-			}
+	for(track_number = d_first_track; track_number <= d_last_track; track_number++)
+		dvd_session_track(dvd_session, track_number, &dvd_tracks[track_number - 1]);
 
+	// Crop detection decodes frames from each track
+	if(opt_crop) {
+#ifdef DVD_INFO_MPEG2
+		for(track_number = d_first_track; track_number <= d_last_track; track_number++) {
+			if(dvd_tracks[track_number - 1].valid && dvd_tracks[track_number - 1].msecs)
+				dvd_crop_detect(dvd_session, track_number, arg_crop_samples, &dvd_tracks[track_number - 1].dvd_video);
 		}
+#else
+		fprintf(stderr, "[%s] crop detection needs libmpeg2, and this was built without it\n", program_name);
+#endif
+	}
 
-		/** Subtitles **/
-
-		dvd_track.dvd_subtitles = calloc(dvd_track.subtitles, sizeof(*dvd_track.dvd_subtitles));
-
-		if(dvd_track.subtitles && dvd_track.dvd_subtitles != NULL) {
-
-			for(c = 0; c < dvd_track.subtitles; c++) {
+	// The video headers of the whole track are read, one cell at a time
+	struct dvd_pipeline *dvd_pipeline = NULL;
+	struct dvd_es_stats *dvd_es_stats = NULL;
 
-				memset(&dvd_subtitle, 0, sizeof(dvd_subtitle));
-				memset(dvd_subtitle.lang_code, '\0', sizeof(dvd_subtitle.lang_code));
+	if(opt_scan) {
 
-				dvd_subtitle.track = c + 1;
-				dvd_subtitle.active = dvd_subtitle_active(vmg_ifo, vts_ifo, dvd_track.track, dvd_subtitle.track);
-				if(dvd_subtitle.active)
-					dvd_track.active_subs++;
+		for(track_number = d_first_track; track_number <= d_last_track; track_number++) {
 
+			dvd_track = dvd_tracks[track_number - 1];
 
-				memset(dvd_subtitle.stream_id, 0, sizeof(dvd_subtitle.stream_id));
-				dvd_subtitle_stream_id(dvd_subtitle.stream_id, c);
+			if(!dvd_track.valid || dvd_track.cells == 0 || dvd_track.dvd_cells == NULL)
+				continue;
 
+			dvd_es_stats = calloc(dvd_track.cells, sizeof(struct dvd_es_stats));
+			dvd_pipeline = dvd_pipeline_open(dvd_session, track_number, 1, dvd_track.chapters);
 
-				memset(dvd_subtitle.lang_code, 0, sizeof(dvd_subtitle.lang_code));
-				dvd_subtitle_lang_code(dvd_subtitle.lang_code, vts_ifo, c);
+			if(dvd_es_stats != NULL && dvd_pipeline != NULL && dvd_es_pipeline(dvd_pipeline, dvd_es_stats, dvd_track.cells)) {
 
-				dvd_track.dvd_subtitles[c] = dvd_subtitle;
+				if(dvd_pipeline_run(dvd_pipeline)) {
+					dvd_es_classify_sections(&dvd_tracks[track_number - 1].dvd_video.dvd_es_stats, dvd_es_stats, dvd_track.cells);
+					for(c = 0; c < dvd_track.cells; c++)
+						dvd_tracks[track_number - 1].dvd_cells[c].dvd_es_stats = dvd_es_stats[c];
+				} else {
+					fprintf(stderr, "[%s] could not read the video of track %u\n", program_name, track_number);
+				}
 
 			}
 
-		}
-
-		/** Chapters **/
-
-		dvd_track.dvd_chapters = calloc(dvd_track.chapters, sizeof(*dvd_track.dvd_chapters));
-
-		if(dvd_track.chapters && dvd_track.dvd_chapters != NULL) {
-
-			for(c = 0; c < dvd_track.chapters; c++) {
-
-				dvd_chapter.chapter = c + 1;
-
-				snprintf(dvd_chapter.length, DVD_CHAPTER_LENGTH + 1, "00:00:00.000");
-				dvd_chapter_length(dvd_chapter.length, vmg_ifo, vts_ifo, dvd_track.track, dvd_chapter.chapter);
-
-				dvd_chapter.msecs = dvd_chapter_msecs(vmg_ifo, vts_ifo, dvd_track.track, dvd_chapter.chapter);
-				dvd_chapter.first_cell = dvd_chapter_first_cell(vmg_ifo, vts_ifo, dvd_track.track, dvd_chapter.chapter);
-				dvd_chapter.last_cell = dvd_chapter_last_cell(vmg_ifo, vts_ifo, dvd_track.track, dvd_chapter.chapter);
-
-				dvd_track.dvd_chapters[c] = dvd_chapter;
-
-			};
+			dvd_pipeline_close(dvd_pipeline);
+			free(dvd_es_stats);
 
 		}
 
-		/** Cells **/
-
-		dvd_track.dvd_cells = calloc(dvd_track.cells, sizeof(*dvd_track.dvd_cells));
-
-		if(dvd_track.cells && dvd_track.dvd_cells != NULL) {
-
-			for(c = 0; c < dvd_track.cells; c++) {
-
-				dvd_cell.cell = c + 1;
-
-				snprintf(dvd_cell.length, DVD_CELL_LENGTH + 1, "00:00:00.000");
-				dvd_cell_length(dvd_cell.length, vmg_ifo, vts_ifo, dvd_track.track, dvd_cell.cell);
-
-				dvd_cell.msecs = dvd_cell_msecs(vmg_ifo, vts_ifo, dvd_track.track, dvd_cell.cell);
-				dvd_cell.first_sector = dvd_cell_first_sector(vmg_ifo, vts_ifo, dvd_track.track, dvd_cell.cell);
-				dvd_cell.last_sector = dvd_cell_last_sector(vmg_ifo, vts_ifo, dvd_track.track, dvd_cell.cell);
-
-				dvd_track.dvd_cells[c] = dvd_cell;
-
-			}
-
-		}
-
-		dvd_tracks[track_number - 1] = dvd_track;
-
 	}
 
 	/** JSON display output **/
@@ -600,6 +435,13 @@ int main(int argc, char **argv) {
 		goto cleanup;
 	}
 
+	/** CBOR display output **/
+
+	if(p_dvd_cbor) {
+		dvd_cbor(dvd_info, dvd_tracks, track_number, d_first_track, d_last_track);
+		goto cleanup;
+	}
+
 	/** dvdxchap display output **/
 	if(p_dvd_ogm) {
 		if(opt_track_number)
@@ -638,6 +480,10 @@ int main(int argc, char **argv) {
 		// Display video information
 		if(d_video) {
 			printf("	Video format: %s, Aspect ratio: %s, Width: %u, Height: %u, FPS: %s, Display format: %s\n", dvd_video.format, dvd_video.aspect_ratio, dvd_video.width, dvd_video.height, dvd_video.fps, display_formats[dvd_video.df]);
+			if(dvd_video.crop)
+				printf("	Crop: %ux%u, Top: %u, Bottom: %u, Left: %u, Right: %u\n", dvd_video.width - dvd_video.crop_left - dvd_video.crop_right, dvd_video.height - dvd_video.crop_top - dvd_video.crop_bottom, dvd_video.crop_top, dvd_video.crop_bottom, dvd_video.crop_left, dvd_video.crop_right);
+			if(dvd_video.dvd_es_stats.frames)
+				printf("	Scan: %s, Frames: %u, Progressive: %u, Repeat first field: %u, Top field first: %u, Closed captions: %s\n", dvd_es_scan_name(dvd_video.dvd_es_stats.scan), dvd_video.dvd_es_stats.frames, dvd_video.dvd_es_stats.progressive, dvd_video.dvd_es_stats.repeat_first_field, dvd_video.dvd_es_stats.top_field_first, dvd_video.dvd_es_stats.captions ? "yes" : "no");
 		}
 
 		// Display audio tracks
@@ -670,7 +516,10 @@ int main(int argc, char **argv) {
 			for(c = 0; c < dvd_track.cells; c++) {
 
 				dvd_cell = dvd_track.dvd_cells[c];
-				printf("	Cell: %02u, Length: %s\n", dvd_cell.cell, dvd_cell.length);
+				if(dvd_track.dvd_video.dvd_es_stats.frames)
+					printf("	Cell: %02u, Length: %s, Scan: %s, Frames: %u\n", dvd_cell.cell, dvd_cell.length, dvd_es_scan_name(dvd_cell.dvd_es_stats.scan), dvd_cell.dvd_es_stats.frames);
+				else
+					printf("	Cell: %02u, Length: %s\n", dvd_cell.cell, dvd_cell.length);
 
 			}
 
@@ -697,14 +546,10 @@ int main(int argc, char **argv) {
 	
 	cleanup:
 
-	if(vmg_ifo)
-		ifoClose(vmg_ifo);
-
-	if(vts_ifo)
-		ifoClose(vts_ifo);
+	for(track_number = d_first_track; track_number <= d_last_track; track_number++)
+		dvd_session_track_free(&dvd_tracks[track_number - 1]);
 
-	if(dvdread_dvd)
-		DVDClose(dvdread_dvd);
+	dvd_session_close(dvd_session);
 
 	return 0;
 
@@ -726,9 +571,14 @@ void print_usage(char *binary) {
 	printf("  -s, --subtitles	subtitles\n");
 	printf("  -d, --cells		cells\n");
 	printf("  -x, --all		display all\n");
+	printf("  -C, --crop[=#]	detect letterbox crop from # frames per track (default: %u)\n", DVD_CROP_SAMPLES);
+	printf("  -I, --scan		progressive, interlaced or telecine, and closed captions,\n");
+	printf("			from the video headers\n");
+	printf("			(reads the whole track)\n");
 	printf("\n");
 	printf("Formatting:\n");
 	printf("  -j, --json		Display output in JSON format\n");
+	printf("  -b, --cbor		Display output in CBOR format (binary JSON)\n");
 	printf("  -o, --ogm		Display OGM chapter format for track (default: longest)\n");
 	printf("  -i, --id		Display DVD id only (from libdvdread)\n");
 	printf("  -T, --title		Display DVD title only (path must be device or file)\n");
@@ -0,0 +1,1011 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdbool.h>
+#include <limits.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include "dvd_session.h"
+#ifdef __linux__
+#include <linux/cdrom.h>
+#include "dvd_drive.h"
+#endif
+#ifndef VERSION
+#define VERSION "1.2"
+#endif
+
+/**
+ * dvd_infod - keep DVDs open and answer metadata requests over a Unix socket
+ *
+ * Opening a disc on a hardware drive and authenticating CSS takes seconds,
+ * every time.  Programs that ask a lot of small questions about the same disc
+ * (a frontend listing tracks, then chapters, then looking up sectors) can ask
+ * this daemon instead, which keeps a libdvdinfo session open for each source
+ * it has been asked about.
+ *
+ * The protocol is one JSON object per line, and one JSON object per line back.
+ * A client can send as many requests as it likes on one connection.
+ *
+ * Requests:
+ *
+ * {"request": "disc", "device": "/dev/sr0"}
+ * {"request": "track", "device": "/dev/sr0", "track": 1}
+ * {"request": "chapters", "device": "/dev/sr0", "track": 1}
+ * {"request": "sector", "device": "/dev/sr0", "track": 1, "sector": 1024}
+ *
+ * "device" defaults to the default DVD device, and "track" to the longest
+ * track.  A sector lookup returns the chapter and cell that the sector is in.
+ *
+ * Every response has "status" set to either "ok" or "error", and an error has
+ * the reason in "error".
+ *
+ * A source is closed and opened again when the disc has changed.  For a drive,
+ * that is when the kernel reports a media change (Linux only) or there is no
+ * disc anymore.  For an image or directory, it is when the file's mtime, size
+ * or inode is different than when it was opened.
+ *
+ * The socket is only for the user running it: it is made with mode 0600, by
+ * default in $XDG_RUNTIME_DIR, or else in a directory of their own in /tmp
+ * (/tmp/dvd_infod-<uid>, mode 0700).
+ *
+ * Clients are served by a fixed pool of threads.  Each source has its own
+ * lock, so requests for different sources run at the same time, while requests
+ * for the same one take turns (libdvdread handles are not thread-safe).
+ */
+
+#define DVD_INFOD_SOCKET "dvd_infod.socket"
+#define DVD_INFOD_THREADS 4
+#define DVD_INFOD_MAX_THREADS 64
+#define DVD_INFOD_SOURCES 8
+#define DVD_INFOD_QUEUE 64
+#define DVD_INFOD_TIMEOUT 30
+#define DVD_INFOD_REQUEST 4096
+#define DVD_INFOD_REQUEST_NAME 16
+
+struct dvd_infod_source {
+	char device_filename[PATH_MAX];
+	struct dvd_session *dvd_session;
+	pthread_mutex_t lock;
+	bool hardware;
+	struct stat stat;
+	time_t last_used;
+	uint16_t users;
+};
+
+int main(int argc, char **argv);
+void print_usage(char *binary);
+void print_version(char *binary);
+
+static struct dvd_infod_source dvd_infod_sources[DVD_INFOD_SOURCES];
+static pthread_mutex_t dvd_infod_sources_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static int dvd_infod_queue[DVD_INFOD_QUEUE];
+static uint16_t dvd_infod_queue_head = 0;
+static uint16_t dvd_infod_queue_length = 0;
+static pthread_mutex_t dvd_infod_queue_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t dvd_infod_queue_ready = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t dvd_infod_queue_space = PTHREAD_COND_INITIALIZER;
+
+static volatile sig_atomic_t dvd_infod_quit = 0;
+
+static void dvd_infod_signal(int signal_number) {
+
+	(void)signal_number;
+	dvd_infod_quit = 1;
+
+}
+
+/**
+ * Find a value in a flat JSON object
+ *
+ * This isn't a JSON parser, requests are a single object with string and
+ * number values, and that's all that is looked at.  Returns a pointer to the
+ * first character of the value, or NULL if the key is not there.
+ */
+static const char *dvd_infod_json_value(const char *json, const char *key) {
+
+	char needle[DVD_INFOD_REQUEST_NAME + 3];
+	const char *str = json;
+	const char *value = NULL;
+
+	snprintf(needle, sizeof(needle), "\"%s\"", key);
+
+	while((str = strstr(str, needle)) != NULL) {
+
+		str += strlen(needle);
+		value = str;
+
+		while(*value == ' ' || *value == '\t')
+			value++;
+
+		// A string value that happens to be the same as the key
+		if(*value != ':')
+			continue;
+
+		value++;
+
+		while(*value == ' ' || *value == '\t')
+			value++;
+
+		return value;
+
+	}
+
+	return NULL;
+
+}
+
+static bool dvd_infod_json_string(char *dest_str, const size_t size, const char *json, const char *key) {
+
+	const char *value = dvd_infod_json_value(json, key);
+	size_t len = 0;
+
+	if(value == NULL || *value != '"')
+		return false;
+
+	value++;
+
+	while(*value != '"' && *value != '\0') {
+
+		if(*value == '\\' && value[1] != '\0')
+			value++;
+
+		if(len + 1 == size)
+			return false;
+
+		dest_str[len] = *value;
+		len++;
+		value++;
+
+	}
+
+	dest_str[len] = '\0';
+
+	if(*value != '"')
+		return false;
+
+	return true;
+
+}
+
+static bool dvd_infod_json_uint(uint32_t *dest, const char *json, const char *key) {
+
+	const char *value = dvd_infod_json_value(json, key);
+	char *end = NULL;
+	uintmax_t number = 0;
+
+	if(value == NULL || *value < '0' || *value > '9')
+		return false;
+
+	number = strtoumax(value, &end, 10);
+
+	if(end == value || number > UINT32_MAX)
+		return false;
+
+	*dest = (uint32_t)number;
+
+	return true;
+
+}
+
+/**
+ * Write a JSON string, escaping quotes, backslashes and control characters
+ */
+static void dvd_infod_json_text(FILE *out, const char *str) {
+
+	fputc('"', out);
+
+	for(; *str != '\0'; str++) {
+
+		if(*str == '"' || *str == '\\')
+			fprintf(out, "\\%c", *str);
+		else if((unsigned char)*str < 0x20)
+			fprintf(out, "\\u%04x", (unsigned char)*str);
+		else
+			fputc(*str, out);
+
+	}
+
+	fputc('"', out);
+
+}
+
+static void dvd_infod_error(FILE *out, const char *error) {
+
+	fprintf(out, "{\"status\": \"error\", \"error\": ");
+	dvd_infod_json_text(out, error);
+	fprintf(out, "}\n");
+
+}
+
+/**
+ * Check if the source has changed since its session was opened
+ *
+ * Linux drives report a media change through an ioctl, which is cleared
+ * every time it is read, so the flag is cleared when the session is opened
+ * and anything set after that is a new disc.
+ *
+ * Other drives on other systems have no check, other than there being a disc
+ * in it.
+ */
+static bool dvd_infod_source_changed(struct dvd_infod_source *dvd_infod_source) {
+
+	struct stat current;
+
+#ifdef __linux__
+
+	int dvd_fd = -1;
+	int media_changed = 0;
+
+	if(dvd_infod_source->hardware) {
+
+		if(!dvd_drive_has_media(dvd_infod_source->device_filename))
+			return true;
+
+		dvd_fd = dvd_device_open(dvd_infod_source->device_filename);
+		if(dvd_fd < 0)
+			return true;
+
+		media_changed = ioctl(dvd_fd, CDROM_MEDIA_CHANGED, CDSL_CURRENT);
+		dvd_device_close(dvd_fd);
+
+		return media_changed == 1;
+
+	}
+
+#endif
+
+	if(stat(dvd_infod_source->device_filename, &current) != 0)
+		return true;
+
+	if(dvd_infod_source->hardware)
+		return false;
+
+	if(current.st_mtime != dvd_infod_source->stat.st_mtime || current.st_size != dvd_infod_source->stat.st_size || current.st_ino != dvd_infod_source->stat.st_ino)
+		return true;
+
+	return false;
+
+}
+
+/**
+ * Get the session for a source, opening it if it isn't open yet or if the
+ * disc has changed.  The source must be locked.
+ */
+static struct dvd_session *dvd_infod_source_session(struct dvd_infod_source *dvd_infod_source, int *error) {
+
+	*error = DVD_SESSION_OK;
+
+	if(dvd_infod_source->dvd_session != NULL && dvd_infod_source_changed(dvd_infod_source)) {
+		dvd_session_close(dvd_infod_source->dvd_session);
+		dvd_infod_source->dvd_session = NULL;
+	}
+
+	if(dvd_infod_source->dvd_session != NULL)
+		return dvd_infod_source->dvd_session;
+
+	dvd_infod_source->hardware = dvd_device_is_hardware(dvd_infod_source->device_filename);
+	memset(&dvd_infod_source->stat, 0, sizeof(dvd_infod_source->stat));
+	stat(dvd_infod_source->device_filename, &dvd_infod_source->stat);
+
+#ifdef __linux__
+
+	int dvd_fd = -1;
+
+	if(dvd_infod_source->hardware) {
+		dvd_fd = dvd_device_open(dvd_infod_source->device_filename);
+		if(dvd_fd >= 0) {
+			ioctl(dvd_fd, CDROM_MEDIA_CHANGED, CDSL_CURRENT);
+			dvd_device_close(dvd_fd);
+		}
+	}
+
+#endif
+
+	dvd_infod_source->dvd_session = dvd_session_open(dvd_infod_source->device_filename, error);
+
+	return dvd_infod_source->dvd_session;
+
+}
+
+/**
+ * Get a source and lock it, adding it to the table if it's new
+ *
+ * If the table is full, the source that was used the longest time ago, and is
+ * not being used right now, is closed and its slot reused.
+ *
+ * @return locked source, or NULL if all of them are busy
+ */
+static struct dvd_infod_source *dvd_infod_source_acquire(const char *device_filename) {
+
+	struct dvd_infod_source *dvd_infod_source = NULL;
+	uint16_t ix = 0;
+
+	pthread_mutex_lock(&dvd_infod_sources_lock);
+
+	for(ix = 0; ix < DVD_INFOD_SOURCES; ix++) {
+		if(strcmp(dvd_infod_sources[ix].device_filename, device_filename) == 0) {
+			dvd_infod_source = &dvd_infod_sources[ix];
+			break;
+		}
+	}
+
+	if(dvd_infod_source == NULL) {
+
+		for(ix = 0; ix < DVD_INFOD_SOURCES; ix++) {
+
+			if(dvd_infod_sources[ix].users)
+				continue;
+
+			if(dvd_infod_source == NULL || dvd_infod_sources[ix].last_used < dvd_infod_source->last_used)
+				dvd_infod_source = &dvd_infod_sources[ix];
+
+		}
+
+		if(dvd_infod_source == NULL) {
+			pthread_mutex_unlock(&dvd_infod_sources_lock);
+			return NULL;
+		}
+
+		// Nobody else can be holding it, since there are no users
+		dvd_session_close(dvd_infod_source->dvd_session);
+		dvd_infod_source->dvd_session = NULL;
+		memset(dvd_infod_source->device_filename, '\0', sizeof(dvd_infod_source->device_filename));
+		snprintf(dvd_infod_source->device_filename, sizeof(dvd_infod_source->device_filename), "%s", device_filename);
+
+	}
+
+	dvd_infod_source->users++;
+	dvd_infod_source->last_used = time(NULL);
+
+	pthread_mutex_unlock(&dvd_infod_sources_lock);
+
+	pthread_mutex_lock(&dvd_infod_source->lock);
+
+	return dvd_infod_source;
+
+}
+
+static void dvd_infod_source_release(struct dvd_infod_source *dvd_infod_source) {
+
+	pthread_mutex_unlock(&dvd_infod_source->lock);
+
+	pthread_mutex_lock(&dvd_infod_sources_lock);
+	dvd_infod_source->users--;
+	pthread_mutex_unlock(&dvd_infod_sources_lock);
+
+}
+
+static void dvd_infod_disc(FILE *out, struct dvd_session *dvd_session) {
+
+	struct dvd_info dvd_info;
+
+	dvd_session_info(dvd_session, &dvd_info);
+
+	fprintf(out, "{\"status\": \"ok\", \"dvd\": {");
+	fprintf(out, "\"title\": ");
+	dvd_infod_json_text(out, dvd_info.title);
+	fprintf(out, ", \"side\": %u", dvd_info.side);
+	fprintf(out, ", \"tracks\": %u", dvd_info.tracks);
+	fprintf(out, ", \"longest track\": %u", dvd_info.longest_track);
+	if(strlen(dvd_info.provider_id)) {
+		fprintf(out, ", \"provider id\": ");
+		dvd_infod_json_text(out, dvd_info.provider_id);
+	}
+	if(strlen(dvd_info.vmg_id)) {
+		fprintf(out, ", \"vmg id\": ");
+		dvd_infod_json_text(out, dvd_info.vmg_id);
+	}
+	fprintf(out, ", \"video title sets\": %u", dvd_info.video_title_sets);
+	fprintf(out, ", \"dvdread id\": \"%s\"", dvd_info.dvdread_id);
+	fprintf(out, "}}\n");
+
+}
+
+static void dvd_infod_track(FILE *out, struct dvd_session *dvd_session, const uint16_t track_number) {
+
+	struct dvd_track dvd_track;
+	struct dvd_video dvd_video;
+	struct dvd_audio dvd_audio;
+	struct dvd_subtitle dvd_subtitle;
+	uint8_t c = 0;
+
+	if(!dvd_session_track(dvd_session, track_number, &dvd_track)) {
+		dvd_infod_error(out, "invalid track number");
+		return;
+	}
+
+	fprintf(out, "{\"status\": \"ok\", \"track\": {");
+	fprintf(out, "\"track\": %u", dvd_track.track);
+	fprintf(out, ", \"valid\": %u", dvd_track.valid);
+
+	if(dvd_track.valid == false) {
+		fprintf(out, "}}\n");
+		return;
+	}
+
+	dvd_video = dvd_track.dvd_video;
+
+	fprintf(out, ", \"length\": \"%s\"", dvd_track.length);
+	fprintf(out, ", \"msecs\": %u", dvd_track.msecs);
+	fprintf(out, ", \"vts\": %u", dvd_track.vts);
+	fprintf(out, ", \"ttn\": %u", dvd_track.ttn);
+	fprintf(out, ", \"chapters\": %u", dvd_track.chapters);
+	fprintf(out, ", \"cells\": %u", dvd_track.cells);
+	fprintf(out, ", \"blocks\": %zd", dvd_track.blocks);
+	fprintf(out, ", \"filesize\": %zd", dvd_track.filesize);
+
+	fprintf(out, ", \"video\": {");
+	fprintf(out, "\"codec\": \"%s\"", dvd_video.codec);
+	fprintf(out, ", \"format\": \"%s\"", dvd_video.format);
+	fprintf(out, ", \"aspect ratio\": \"%s\"", dvd_video.aspect_ratio);
+	fprintf(out, ", \"width\": %u", dvd_video.width);
+	fprintf(out, ", \"height\": %u", dvd_video.height);
+	fprintf(out, ", \"angles\": %u", dvd_video.angles);
+	fprintf(out, ", \"fps\": \"%s\"", dvd_video.fps);
+	fprintf(out, "}");
+
+	fprintf(out, ", \"audio\": [");
+	for(c = 0; c < dvd_track.audio_tracks; c++) {
+
+		dvd_audio = dvd_track.dvd_audio_tracks[c];
+
+		if(c)
+			fprintf(out, ", ");
+		fprintf(out, "{\"track\": %u", dvd_audio.track);
+		fprintf(out, ", \"active\": %u", dvd_audio.active);
+		if(strlen(dvd_audio.lang_code) == DVD_AUDIO_LANG_CODE) {
+			fprintf(out, ", \"lang code\": ");
+			dvd_infod_json_text(out, dvd_audio.lang_code);
+		}
+		fprintf(out, ", \"codec\": \"%s\"", dvd_audio.codec);
+		fprintf(out, ", \"channels\": %u", dvd_audio.channels);
+		fprintf(out, ", \"stream id\": \"%s\"}", dvd_audio.stream_id);
+
+	}
+	fprintf(out, "]");
+
+	fprintf(out, ", \"subtitles\": [");
+	for(c = 0; c < dvd_track.subtitles; c++) {
+
+		dvd_subtitle = dvd_track.dvd_subtitles[c];
+
+		if(c)
+			fprintf(out, ", ");
+		fprintf(out, "{\"track\": %u", dvd_subtitle.track);
+		fprintf(out, ", \"active\": %u", dvd_subtitle.active);
+		if(strlen(dvd_subtitle.lang_code) == DVD_SUBTITLE_LANG_CODE) {
+			fprintf(out, ", \"lang code\": ");
+			dvd_infod_json_text(out, dvd_subtitle.lang_code);
+		}
+		fprintf(out, ", \"stream id\": \"%s\"}", dvd_subtitle.stream_id);
+
+	}
+	fprintf(out, "]");
+
+	fprintf(out, "}}\n");
+
+	dvd_session_track_free(&dvd_track);
+
+}
+
+/**
+ * Chapter table for a track, with the sector range of each chapter taken from
+ * its first and last cells.
+ */
+static void dvd_infod_chapters(FILE *out, struct dvd_session *dvd_session, const uint16_t track_number) {
+
+	struct dvd_track dvd_track;
+	struct dvd_chapter dvd_chapter;
+	struct dvd_cell first_cell;
+	struct dvd_cell last_cell;
+	uint8_t c = 0;
+
+	if(!dvd_session_track(dvd_session, track_number, &dvd_track)) {
+		dvd_infod_error(out, "invalid track number");
+		return;
+	}
+
+	if(dvd_track.valid == false) {
+		dvd_infod_error(out, "track is on an invalid IFO");
+		return;
+	}
+
+	fprintf(out, "{\"status\": \"ok\", \"track\": %u, \"chapters\": [", dvd_track.track);
+
+	for(c = 0; c < dvd_track.chapters; c++) {
+
+		dvd_chapter = dvd_track.dvd_chapters[c];
+		dvd_session_cell(dvd_session, track_number, dvd_chapter.first_cell, &first_cell);
+		dvd_session_cell(dvd_session, track_number, dvd_chapter.last_cell, &last_cell);
+
+		if(c)
+			fprintf(out, ", ");
+		fprintf(out, "{\"chapter\": %u", dvd_chapter.chapter);
+		fprintf(out, ", \"length\": \"%s\"", dvd_chapter.length);
+		fprintf(out, ", \"msecs\": %u", dvd_chapter.msecs);
+		fprintf(out, ", \"first cell\": %u", dvd_chapter.first_cell);
+		fprintf(out, ", \"last cell\": %u", dvd_chapter.last_cell);
+		fprintf(out, ", \"first sector\": %u", first_cell.first_sector);
+		fprintf(out, ", \"last sector\": %u}", last_cell.last_sector);
+
+	}
+
+	fprintf(out, "]}\n");
+
+	dvd_session_track_free(&dvd_track);
+
+}
+
+/**
+ * Find the cell and chapter that a sector is in
+ */
+static void dvd_infod_sector(FILE *out, struct dvd_session *dvd_session, const uint16_t track_number, const uint32_t sector) {
+
+	struct dvd_track dvd_track;
+	struct dvd_cell dvd_cell;
+	struct dvd_chapter dvd_chapter;
+	uint8_t c = 0;
+	uint8_t cell_number = 0;
+	uint8_t chapter_number = 0;
+
+	if(!dvd_session_track(dvd_session, track_number, &dvd_track)) {
+		dvd_infod_error(out, "invalid track number");
+		return;
+	}
+
+	if(dvd_track.valid == false) {
+		dvd_infod_error(out, "track is on an invalid IFO");
+		return;
+	}
+
+	for(c = 0; c < dvd_track.cells; c++) {
+		if(sector >= dvd_track.dvd_cells[c].first_sector && sector <= dvd_track.dvd_cells[c].last_sector) {
+			dvd_cell = dvd_track.dvd_cells[c];
+			cell_number = dvd_cell.cell;
+			break;
+		}
+	}
+
+	for(c = 0; c < dvd_track.chapters && cell_number; c++) {
+		if(cell_number >= dvd_track.dvd_chapters[c].first_cell && cell_number <= dvd_track.dvd_chapters[c].last_cell) {
+			dvd_chapter = dvd_track.dvd_chapters[c];
+			chapter_number = dvd_chapter.chapter;
+			break;
+		}
+	}
+
+	if(cell_number == 0) {
+		dvd_infod_error(out, "sector is not in track");
+		dvd_session_track_free(&dvd_track);
+		return;
+	}
+
+	fprintf(out, "{\"status\": \"ok\", \"track\": %u", track_number);
+	fprintf(out, ", \"sector\": %" PRIu32, sector);
+	fprintf(out, ", \"chapter\": %u", chapter_number);
+	fprintf(out, ", \"cell\": %u", cell_number);
+	fprintf(out, ", \"cell first sector\": %u", dvd_cell.first_sector);
+	fprintf(out, ", \"cell last sector\": %u", dvd_cell.last_sector);
+	fprintf(out, "}\n");
+
+	dvd_session_track_free(&dvd_track);
+
+}
+
+static void dvd_infod_request(FILE *out, const char *request) {
+
+	char request_name[DVD_INFOD_REQUEST_NAME];
+	char device_filename[PATH_MAX];
+	struct dvd_infod_source *dvd_infod_source = NULL;
+	struct dvd_session *dvd_session = NULL;
+	int session_error = DVD_SESSION_OK;
+	uint32_t arg_track_number = 0;
+	uint32_t arg_sector = 0;
+	bool opt_track_number = false;
+	uint16_t track_number = 1;
+
+	if(!dvd_infod_json_string(request_name, sizeof(request_name), request, "request")) {
+		dvd_infod_error(out, "no request");
+		return;
+	}
+
+	if(strcmp(request_name, "disc") && strcmp(request_name, "track") && strcmp(request_name, "chapters") && strcmp(request_name, "sector")) {
+		dvd_infod_error(out, "unknown request");
+		return;
+	}
+
+	if(!dvd_infod_json_string(device_filename, sizeof(device_filename), request, "device"))
+		snprintf(device_filename, sizeof(device_filename), "%s", DEFAULT_DVD_DEVICE);
+
+	opt_track_number = dvd_infod_json_uint(&arg_track_number, request, "track");
+
+	if(strcmp(request_name, "sector") == 0 && !dvd_infod_json_uint(&arg_sector, request, "sector")) {
+		dvd_infod_error(out, "no sector");
+		return;
+	}
+
+	dvd_infod_source = dvd_infod_source_acquire(device_filename);
+
+	if(dvd_infod_source == NULL) {
+		dvd_infod_error(out, "too many sources open");
+		return;
+	}
+
+	dvd_session = dvd_infod_source_session(dvd_infod_source, &session_error);
+
+	if(dvd_session == NULL) {
+		dvd_infod_error(out, dvd_session_strerror(session_error));
+		dvd_infod_source_release(dvd_infod_source);
+		return;
+	}
+
+	if(opt_track_number && (arg_track_number < 1 || arg_track_number > dvd_session_tracks(dvd_session))) {
+		dvd_infod_error(out, "invalid track number");
+		dvd_infod_source_release(dvd_infod_source);
+		return;
+	}
+
+	if(opt_track_number)
+		track_number = (uint16_t)arg_track_number;
+	else
+		track_number = dvd_session_longest_track(dvd_session);
+
+	if(strcmp(request_name, "disc") == 0)
+		dvd_infod_disc(out, dvd_session);
+	else if(strcmp(request_name, "track") == 0)
+		dvd_infod_track(out, dvd_session, track_number);
+	else if(strcmp(request_name, "chapters") == 0)
+		dvd_infod_chapters(out, dvd_session, track_number);
+	else if(strcmp(request_name, "sector") == 0)
+		dvd_infod_sector(out, dvd_session, track_number, arg_sector);
+
+	dvd_infod_source_release(dvd_infod_source);
+
+}
+
+/**
+ * Answer requests from one client until it hangs up, or goes quiet for longer
+ * than the timeout.
+ */
+static void dvd_infod_client(int client_fd) {
+
+	FILE *in = NULL;
+	FILE *out = NULL;
+	int out_fd = -1;
+	char request[DVD_INFOD_REQUEST];
+	size_t len = 0;
+	bool truncated = false;
+
+	out_fd = dup(client_fd);
+	in = fdopen(client_fd, "r");
+	if(out_fd >= 0)
+		out = fdopen(out_fd, "w");
+
+	if(in == NULL || out == NULL) {
+		if(in)
+			fclose(in);
+		else
+			close(client_fd);
+		if(out)
+			fclose(out);
+		else if(out_fd >= 0)
+			close(out_fd);
+		return;
+	}
+
+	while(fgets(request, DVD_INFOD_REQUEST, in) != NULL) {
+
+		len = strlen(request);
+
+		// Skip the rest of a request that doesn't fit in the buffer
+		if(len && request[len - 1] != '\n' && !feof(in)) {
+			truncated = true;
+			continue;
+		}
+
+		if(truncated) {
+			truncated = false;
+			dvd_infod_error(out, "request too long");
+		} else if(strspn(request, " \t\r\n") < len) {
+			dvd_infod_request(out, request);
+		}
+
+		if(fflush(out) != 0)
+			break;
+
+	}
+
+	fclose(in);
+	fclose(out);
+
+}
+
+static void *dvd_infod_worker(void *arg) {
+
+	int client_fd = -1;
+
+	(void)arg;
+
+	while(true) {
+
+		pthread_mutex_lock(&dvd_infod_queue_lock);
+
+		while(dvd_infod_queue_length == 0)
+			pthread_cond_wait(&dvd_infod_queue_ready, &dvd_infod_queue_lock);
+
+		client_fd = dvd_infod_queue[dvd_infod_queue_head];
+		dvd_infod_queue_head = (dvd_infod_queue_head + 1) % DVD_INFOD_QUEUE;
+		dvd_infod_queue_length--;
+
+		pthread_cond_signal(&dvd_infod_queue_space);
+		pthread_mutex_unlock(&dvd_infod_queue_lock);
+
+		dvd_infod_client(client_fd);
+
+	}
+
+	return NULL;
+
+}
+
+/**
+ * Default socket, in $XDG_RUNTIME_DIR or a directory in /tmp that only the
+ * user can get into.  Anything already there that isn't a directory of
+ * theirs with nobody else let in isn't used.
+ *
+ * @return false if there is nowhere safe for it
+ */
+static bool dvd_infod_socket_default(char *socket_filename, const size_t size) {
+
+	char directory[PATH_MAX];
+	const char *runtime_dir = getenv("XDG_RUNTIME_DIR");
+	struct stat directory_stat;
+
+	if(runtime_dir != NULL && runtime_dir[0] == '/') {
+		snprintf(directory, sizeof(directory), "%s", runtime_dir);
+	} else {
+		snprintf(directory, sizeof(directory), "/tmp/dvd_infod-%u", (unsigned int)getuid());
+		if(mkdir(directory, 0700) != 0 && errno != EEXIST)
+			return false;
+	}
+
+	if(lstat(directory, &directory_stat) != 0 || !S_ISDIR(directory_stat.st_mode) || directory_stat.st_uid != getuid() || (directory_stat.st_mode & 0077))
+		return false;
+
+	return snprintf(socket_filename, size, "%s/%s", directory, DVD_INFOD_SOCKET) < (int)size;
+
+}
+
+int main(int argc, char **argv) {
+
+	char program_name[] = "dvd_infod";
+	char socket_filename[sizeof(((struct sockaddr_un *)0)->sun_path)];
+	uint16_t threads = DVD_INFOD_THREADS;
+	unsigned int arg_threads = 0;
+	int server_fd = -1;
+	int client_fd = -1;
+	struct sockaddr_un server_addr;
+	struct stat socket_stat;
+	struct timeval timeout;
+	struct sigaction sa;
+	sigset_t signals;
+	sigset_t old_signals;
+	mode_t old_umask;
+	pthread_t thread;
+	uint16_t ix = 0;
+	int retval = 0;
+
+	memset(socket_filename, '\0', sizeof(socket_filename));
+
+	// getopt_long
+	int long_ix = 0;
+	int opt = 0;
+	opterr = 1;
+	const char p_short_opts[] = "hs:t:V";
+
+	struct option p_long_opts[] = {
+
+		{ "socket", required_argument, NULL, 's' },
+		{ "threads", required_argument, NULL, 't' },
+		{ "help", no_argument, NULL, 'h' },
+		{ "version", no_argument, NULL, 'V' },
+		{ 0, 0, 0, 0 }
+
+	};
+
+	while((opt = getopt_long(argc, argv, p_short_opts, p_long_opts, &long_ix)) != -1) {
+
+		switch(opt) {
+
+			case 'h':
+				print_usage(program_name);
+				return 0;
+
+			case 'V':
+				print_version(program_name);
+				return 0;
+
+			case 's':
+				if(strlen(optarg) >= sizeof(socket_filename)) {
+					fprintf(stderr, "%s: socket filename is too long\n", program_name);
+					return 1;
+				}
+				snprintf(socket_filename, sizeof(socket_filename), "%s", optarg);
+				break;
+
+			case 't':
+				arg_threads = (unsigned int)strtoumax(optarg, NULL, 0);
+				if(arg_threads < 1 || arg_threads > DVD_INFOD_MAX_THREADS) {
+					fprintf(stderr, "%s: threads must be between 1 and %u\n", program_name, DVD_INFOD_MAX_THREADS);
+					return 1;
+				}
+				threads = (uint16_t)arg_threads;
+				break;
+
+			case '?':
+				print_usage(program_name);
+				return 1;
+
+			case 0:
+			default:
+				break;
+
+		}
+
+	}
+
+	if(strlen(socket_filename) == 0 && !dvd_infod_socket_default(socket_filename, sizeof(socket_filename))) {
+		fprintf(stderr, "%s: no private directory for the socket, give one with -s\n", program_name);
+		return 1;
+	}
+
+	for(ix = 0; ix < DVD_INFOD_SOURCES; ix++)
+		pthread_mutex_init(&dvd_infod_sources[ix].lock, NULL);
+
+	// Clients hanging up are handled by the write failing
+	signal(SIGPIPE, SIG_IGN);
+
+	// No SA_RESTART, so accept() is interrupted
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = dvd_infod_signal;
+	sigemptyset(&sa.sa_mask);
+	sigaction(SIGINT, &sa, NULL);
+	sigaction(SIGTERM, &sa, NULL);
+
+	server_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if(server_fd < 0) {
+		fprintf(stderr, "%s: could not create socket: %s\n", program_name, strerror(errno));
+		return 1;
+	}
+
+	// Remove a socket left behind by a daemon that didn't exit cleanly
+	if(lstat(socket_filename, &socket_stat) == 0 && S_ISSOCK(socket_stat.st_mode))
+		unlink(socket_filename);
+
+	memset(&server_addr, 0, sizeof(server_addr));
+	server_addr.sun_family = AF_UNIX;
+	memcpy(server_addr.sun_path, socket_filename, strlen(socket_filename));
+
+	// Only the user can connect
+	old_umask = umask(0177);
+	retval = bind(server_fd, (struct sockaddr *)&server_addr, sizeof(server_addr));
+	umask(old_umask);
+
+	if(retval != 0) {
+		fprintf(stderr, "%s: could not bind to %s: %s\n", program_name, socket_filename, strerror(errno));
+		close(server_fd);
+		return 1;
+	}
+
+	if(listen(server_fd, DVD_INFOD_QUEUE) != 0) {
+		fprintf(stderr, "%s: could not listen on %s: %s\n", program_name, socket_filename, strerror(errno));
+		retval = 1;
+		goto cleanup;
+	}
+
+	// The workers start with SIGINT and SIGTERM blocked, so they always go to
+	// this thread and interrupt accept()
+	sigemptyset(&signals);
+	sigaddset(&signals, SIGINT);
+	sigaddset(&signals, SIGTERM);
+	pthread_sigmask(SIG_BLOCK, &signals, &old_signals);
+
+	for(ix = 0; ix < threads; ix++) {
+		if(pthread_create(&thread, NULL, dvd_infod_worker, NULL) != 0) {
+			fprintf(stderr, "%s: could not start thread\n", program_name);
+			retval = 1;
+			break;
+		}
+		pthread_detach(thread);
+	}
+
+	pthread_sigmask(SIG_SETMASK, &old_signals, NULL);
+
+	if(retval)
+		goto cleanup;
+
+	timeout.tv_sec = DVD_INFOD_TIMEOUT;
+	timeout.tv_usec = 0;
+
+	while(!dvd_infod_quit) {
+
+		client_fd = accept(server_fd, NULL, NULL);
+
+		if(client_fd < 0) {
+			if(errno != EINTR)
+				fprintf(stderr, "%s: accept failed: %s\n", program_name, strerror(errno));
+			continue;
+		}
+
+		// A client that goes quiet gives its thread back
+		setsockopt(client_fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+		pthread_mutex_lock(&dvd_infod_queue_lock);
+
+		while(dvd_infod_queue_length == DVD_INFOD_QUEUE)
+			pthread_cond_wait(&dvd_infod_queue_space, &dvd_infod_queue_lock);
+
+		dvd_infod_queue[(dvd_infod_queue_head + dvd_infod_queue_length) % DVD_INFOD_QUEUE] = client_fd;
+		dvd_infod_queue_length++;
+
+		pthread_cond_signal(&dvd_infod_queue_ready);
+		pthread_mutex_unlock(&dvd_infod_queue_lock);
+
+	}
+
+	cleanup:
+
+	close(server_fd);
+	unlink(socket_filename);
+
+	// Close the sessions that aren't busy, the rest go away with the process
+	pthread_mutex_lock(&dvd_infod_sources_lock);
+	for(ix = 0; ix < DVD_INFOD_SOURCES; ix++) {
+		if(dvd_infod_sources[ix].users == 0 && dvd_infod_sources[ix].dvd_session != NULL) {
+			dvd_session_close(dvd_infod_sources[ix].dvd_session);
+			dvd_infod_sources[ix].dvd_session = NULL;
+		}
+	}
+	pthread_mutex_unlock(&dvd_infod_sources_lock);
+
+	return retval;
+
+}
+
+void print_usage(char *binary) {
+
+	printf("%s %s - serve DVD information over a local socket\n", binary, VERSION);
+	printf("\n");
+	printf("Usage: %s [-s socket] [-t threads]\n", binary);
+	printf("\n");
+	printf("Options:\n");
+	printf("  -s, --socket <filename>	Socket to listen on (default: $XDG_RUNTIME_DIR/%s)\n", DVD_INFOD_SOCKET);
+	printf("  -t, --threads #		Number of clients to serve at once (default: %u)\n", DVD_INFOD_THREADS);
+	printf("  -h, --help			Display these help options\n");
+	printf("  -V, --version			Version information\n");
+	printf("\n");
+	printf("Requests are one JSON object per line:\n");
+	printf("  {\"request\": \"disc\", \"device\": \"%s\"}\n", DEFAULT_DVD_DEVICE);
+	printf("  {\"request\": \"track\", \"device\": \"movie.iso\", \"track\": 1}\n");
+	printf("  {\"request\": \"chapters\", \"device\": \"movie.iso\", \"track\": 1}\n");
+	printf("  {\"request\": \"sector\", \"device\": \"movie.iso\", \"track\": 1, \"sector\": 1024}\n");
+
+}
+
+void print_version(char *binary) {
+
+	printf("%s %s - http://dvds.beandog.org/ - (c) 2014 Steve Dibb <steve.dibb@gmail.com>, licensed under GPL-2\n", binary, VERSION);
+
+}
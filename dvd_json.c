@@ -1,5 +1,22 @@
 #include "dvd_json.h"
 
+/**
+ * Frame flags from the video headers, as an object
+ */
+static void dvd_json_scan(const struct dvd_es_stats *dvd_es_stats, const char *indent) {
+
+	printf("%s\"scan\": {\n", indent);
+	printf("%s \"type\": \"%s\",\n", indent, dvd_es_scan_name(dvd_es_stats->scan));
+	printf("%s \"frames\": %u,\n", indent, dvd_es_stats->frames);
+	printf("%s \"progressive frames\": %u,\n", indent, dvd_es_stats->progressive);
+	printf("%s \"repeat first field\": %u,\n", indent, dvd_es_stats->repeat_first_field);
+	printf("%s \"top field first\": %u,\n", indent, dvd_es_stats->top_field_first);
+	printf("%s \"3:2 cadence\": %u,\n", indent, dvd_es_stats->cadence);
+	printf("%s \"fields\": %u\n", indent, dvd_es_stats->fields);
+	printf("%s}", indent);
+
+}
+
 void dvd_json(struct dvd_info dvd_info, struct dvd_track dvd_tracks[], uint16_t track_number, uint16_t d_first_track, uint16_t d_last_track) {
 
 	struct dvd_track dvd_track;
@@ -77,12 +94,31 @@ void dvd_json(struct dvd_info dvd_info, struct dvd_track dvd_tracks[], uint16_t
 
 		printf("    \"width\": %u,\n", dvd_video.width);
 		printf("    \"height\": %u,\n", dvd_video.height);
-		printf("    \"angles\": %u", dvd_video.angles);
+		printf("    \"angles\": %u,\n", dvd_video.angles);
+		printf("    \"letterbox\": %s", dvd_video.letterbox ? "true" : "false");
 
 		// Only display FPS if it's been populated as a string
 		if(strlen(dvd_video.fps))
-			printf(",\n    \"fps\": \"%s\"\n", dvd_video.fps);
-		printf("   },\n");
+			printf(",\n    \"fps\": \"%s\"", dvd_video.fps);
+
+		// Crop is only there if it was detected
+		if(dvd_video.crop) {
+			printf(",\n    \"crop\": {\n");
+			printf("     \"top\": %u,\n", dvd_video.crop_top);
+			printf("     \"bottom\": %u,\n", dvd_video.crop_bottom);
+			printf("     \"left\": %u,\n", dvd_video.crop_left);
+			printf("     \"right\": %u,\n", dvd_video.crop_right);
+			printf("     \"width\": %u,\n", dvd_video.width - dvd_video.crop_left - dvd_video.crop_right);
+			printf("     \"height\": %u\n", dvd_video.height - dvd_video.crop_top - dvd_video.crop_bottom);
+			printf("    }");
+		}
+
+		if(dvd_video.dvd_es_stats.frames) {
+			printf(",\n    \"closed captions\": %s", dvd_video.dvd_es_stats.captions ? "true" : "false");
+			printf(",\n");
+			dvd_json_scan(&dvd_video.dvd_es_stats, "    ");
+		}
+		printf("\n   },\n");
 
 		// Audio tracks
 		if(dvd_track.audio_tracks) {
@@ -186,8 +222,12 @@ void dvd_json(struct dvd_info dvd_info, struct dvd_track dvd_tracks[], uint16_t
 				printf("     \"length\": \"%s\",\n", dvd_cell.length);
 				printf("     \"msecs\": %u,\n", dvd_cell.msecs);
 				printf("     \"first sector\": %u,\n", dvd_cell.first_sector);
-				printf("     \"last sector\": %u\n", dvd_cell.last_sector);
-				printf("    }");
+				printf("     \"last sector\": %u", dvd_cell.last_sector);
+				if(dvd_video.dvd_es_stats.frames) {
+					printf(",\n");
+					dvd_json_scan(&dvd_cell.dvd_es_stats, "     ");
+				}
+				printf("\n    }");
 
 				if(c  + 1 < dvd_track.cells)
 					printf(",");
@@ -0,0 +1,160 @@
+#include "dvd_md5.h"
+
+/**
+ * MD5 (RFC 1321), so that a copy can be checksummed while it is being read,
+ * and the result compared with md5sum.
+ *
+ * struct dvd_md5 dvd_md5;
+ * char md5[DVD_MD5_HEX + 1];
+ * dvd_md5_init(&dvd_md5);
+ * dvd_md5_update(&dvd_md5, buffer, len);
+ * dvd_md5_final(&dvd_md5);
+ * dvd_md5_hex(md5, &dvd_md5);
+ */
+
+#define DVD_MD5_ROTATE(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+
+static const uint32_t dvd_md5_k[64] = {
+	0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
+	0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be, 0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
+	0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+	0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
+	0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c, 0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+	0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+	0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+	0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1, 0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391
+};
+
+static const uint8_t dvd_md5_shift[64] = {
+	7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22,
+	5, 9, 14, 20, 5, 9, 14, 20, 5, 9, 14, 20, 5, 9, 14, 20,
+	4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23,
+	6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21
+};
+
+static void dvd_md5_block(struct dvd_md5 *dvd_md5, const unsigned char *block) {
+
+	uint32_t m[16];
+	uint32_t a = dvd_md5->state[0];
+	uint32_t b = dvd_md5->state[1];
+	uint32_t c = dvd_md5->state[2];
+	uint32_t d = dvd_md5->state[3];
+	uint32_t f = 0;
+	uint32_t tmp = 0;
+	uint8_t g = 0;
+	uint8_t i = 0;
+
+	for(i = 0; i < 16; i++)
+		m[i] = (uint32_t)block[i * 4] | ((uint32_t)block[i * 4 + 1] << 8) | ((uint32_t)block[i * 4 + 2] << 16) | ((uint32_t)block[i * 4 + 3] << 24);
+
+	for(i = 0; i < 64; i++) {
+
+		if(i < 16) {
+			f = (b & c) | (~b & d);
+			g = i;
+		} else if(i < 32) {
+			f = (d & b) | (~d & c);
+			g = (5 * i + 1) % 16;
+		} else if(i < 48) {
+			f = b ^ c ^ d;
+			g = (3 * i + 5) % 16;
+		} else {
+			f = c ^ (b | ~d);
+			g = (7 * i) % 16;
+		}
+
+		tmp = d;
+		d = c;
+		c = b;
+		b = b + DVD_MD5_ROTATE(a + f + dvd_md5_k[i] + m[g], dvd_md5_shift[i]);
+		a = tmp;
+
+	}
+
+	dvd_md5->state[0] += a;
+	dvd_md5->state[1] += b;
+	dvd_md5->state[2] += c;
+	dvd_md5->state[3] += d;
+
+}
+
+void dvd_md5_init(struct dvd_md5 *dvd_md5) {
+
+	memset(dvd_md5, 0, sizeof(*dvd_md5));
+
+	dvd_md5->state[0] = 0x67452301;
+	dvd_md5->state[1] = 0xefcdab89;
+	dvd_md5->state[2] = 0x98badcfe;
+	dvd_md5->state[3] = 0x10325476;
+
+}
+
+void dvd_md5_update(struct dvd_md5 *dvd_md5, const unsigned char *data, size_t len) {
+
+	size_t used = (size_t)(dvd_md5->length % 64);
+	size_t fill = 0;
+
+	dvd_md5->length += len;
+
+	if(used) {
+
+		fill = 64 - used;
+
+		if(len < fill) {
+			memcpy(dvd_md5->buffer + used, data, len);
+			return;
+		}
+
+		memcpy(dvd_md5->buffer + used, data, fill);
+		dvd_md5_block(dvd_md5, dvd_md5->buffer);
+		data += fill;
+		len -= fill;
+
+	}
+
+	// DVD blocks are a multiple of 64 bytes, so this is where the work is done
+	while(len >= 64) {
+		dvd_md5_block(dvd_md5, data);
+		data += 64;
+		len -= 64;
+	}
+
+	if(len)
+		memcpy(dvd_md5->buffer, data, len);
+
+}
+
+void dvd_md5_final(struct dvd_md5 *dvd_md5) {
+
+	unsigned char padding[72];
+	uint64_t bits = dvd_md5->length * 8;
+	size_t used = (size_t)(dvd_md5->length % 64);
+	size_t len = used < 56 ? 56 - used : 120 - used;
+	uint8_t i = 0;
+
+	memset(padding, 0, sizeof(padding));
+	padding[0] = 0x80;
+
+	for(i = 0; i < 8; i++)
+		padding[len + i] = (unsigned char)(bits >> (8 * i));
+
+	dvd_md5_update(dvd_md5, padding, len + 8);
+
+	for(i = 0; i < 16; i++)
+		dvd_md5->digest[i] = (unsigned char)(dvd_md5->state[i / 4] >> (8 * (i % 4)));
+
+}
+
+/**
+ * Digest as a lowercase hex string, the same as md5sum
+ *
+ * @param dest_str string to copy to, DVD_MD5_HEX + 1 long
+ */
+void dvd_md5_hex(char *dest_str, const struct dvd_md5 *dvd_md5) {
+
+	uint8_t i = 0;
+
+	for(i = 0; i < DVD_MD5_DIGEST; i++)
+		snprintf(dest_str + i * 2, 3, "%02x", dvd_md5->digest[i]);
+
+}
@@ -0,0 +1,26 @@
+#ifndef DVD_INFO_MD5_H
+#define DVD_INFO_MD5_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#define DVD_MD5_DIGEST 16
+#define DVD_MD5_HEX 32
+
+struct dvd_md5 {
+	uint32_t state[4];
+	uint64_t length;
+	unsigned char buffer[64];
+	unsigned char digest[DVD_MD5_DIGEST];
+};
+
+void dvd_md5_init(struct dvd_md5 *dvd_md5);
+
+void dvd_md5_update(struct dvd_md5 *dvd_md5, const unsigned char *data, size_t len);
+
+void dvd_md5_final(struct dvd_md5 *dvd_md5);
+
+void dvd_md5_hex(char *dest_str, const struct dvd_md5 *dvd_md5);
+
+#endif
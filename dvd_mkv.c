@@ -0,0 +1,1519 @@
+#include "dvd_mkv.h"
+#include "dvd_pipeline.h"
+
+// EBML header
+#define MKV_EBML 0x1a45dfa3
+#define MKV_EBML_VERSION 0x4286
+#define MKV_EBML_READ_VERSION 0x42f7
+#define MKV_EBML_MAX_ID_LENGTH 0x42f2
+#define MKV_EBML_MAX_SIZE_LENGTH 0x42f3
+#define MKV_DOC_TYPE 0x4282
+#define MKV_DOC_TYPE_VERSION 0x4287
+#define MKV_DOC_TYPE_READ_VERSION 0x4285
+
+#define MKV_SEGMENT 0x18538067
+#define MKV_VOID 0xec
+
+// Meta seek
+#define MKV_SEEK_HEAD 0x114d9b74
+#define MKV_SEEK 0x4dbb
+#define MKV_SEEK_ID 0x53ab
+#define MKV_SEEK_POSITION 0x53ac
+
+// Segment information
+#define MKV_INFO 0x1549a966
+#define MKV_TIMESTAMP_SCALE 0x2ad7b1
+#define MKV_DURATION 0x4489
+#define MKV_MUXING_APP 0x4d80
+#define MKV_WRITING_APP 0x5741
+#define MKV_TITLE 0x7ba9
+
+// Tracks
+#define MKV_TRACKS 0x1654ae6b
+#define MKV_TRACK_ENTRY 0xae
+#define MKV_TRACK_NUMBER 0xd7
+#define MKV_TRACK_UID 0x73c5
+#define MKV_TRACK_TYPE 0x83
+#define MKV_FLAG_DEFAULT 0x88
+#define MKV_FLAG_LACING 0x9c
+#define MKV_DEFAULT_DURATION 0x23e383
+#define MKV_LANGUAGE 0x22b59c
+#define MKV_LANGUAGE_BCP47 0x22b59d
+#define MKV_CODEC_ID 0x86
+#define MKV_CODEC_PRIVATE 0x63a2
+#define MKV_VIDEO 0xe0
+#define MKV_PIXEL_WIDTH 0xb0
+#define MKV_PIXEL_HEIGHT 0xba
+#define MKV_DISPLAY_WIDTH 0x54b0
+#define MKV_DISPLAY_HEIGHT 0x54ba
+#define MKV_AUDIO 0xe1
+#define MKV_SAMPLING_FREQUENCY 0xb5
+#define MKV_CHANNELS 0x9f
+#define MKV_BIT_DEPTH 0x6264
+
+// Chapters
+#define MKV_CHAPTERS 0x1043a770
+#define MKV_EDITION_ENTRY 0x45b9
+#define MKV_EDITION_UID 0x45bc
+#define MKV_CHAPTER_ATOM 0xb6
+#define MKV_CHAPTER_UID 0x73c4
+#define MKV_CHAPTER_TIME_START 0x91
+#define MKV_CHAPTER_TIME_END 0x92
+#define MKV_CHAPTER_DISPLAY 0x80
+#define MKV_CHAP_STRING 0x85
+#define MKV_CHAP_LANGUAGE 0x437c
+
+// Clusters
+#define MKV_CLUSTER 0x1f43b675
+#define MKV_TIMESTAMP 0xe7
+#define MKV_SIMPLE_BLOCK 0xa3
+#define MKV_BLOCK_GROUP 0xa0
+#define MKV_BLOCK 0xa1
+#define MKV_BLOCK_DURATION 0x9b
+#define MKV_REFERENCE_BLOCK 0xfb
+
+// Cues
+#define MKV_CUES 0x1c53bb6b
+#define MKV_CUE_POINT 0xbb
+#define MKV_CUE_TIME 0xb3
+#define MKV_CUE_TRACK_POSITIONS 0xb7
+#define MKV_CUE_TRACK 0xf7
+#define MKV_CUE_CLUSTER_POSITION 0xf1
+
+// SimpleBlock flags
+#define MKV_KEYFRAME 0x80
+#define MKV_DISCARDABLE 0x01
+
+// Frames waiting for the next I or P frame
+#define DVD_MKV_PICTURES 16
+
+// Room left in the header for the seek head
+#define DVD_MKV_SEEK_HEAD 48
+
+/**
+ * Languages are two letters (ISO 639-1) in the IFO, and Matroska wants three
+ * (ISO 639-2/B).  The two letters are written as well, as a BCP 47 tag, so
+ * the ones not here are still kept.
+ */
+static const char *dvd_mkv_languages[][2] = {
+	{ "ar", "ara" }, { "bg", "bul" }, { "bn", "ben" }, { "ca", "cat" }, { "cs", "cze" },
+	{ "cy", "wel" }, { "da", "dan" }, { "de", "ger" }, { "el", "gre" }, { "en", "eng" },
+	{ "es", "spa" }, { "et", "est" }, { "eu", "baq" }, { "fa", "per" }, { "fi", "fin" },
+	{ "fr", "fre" }, { "ga", "gle" }, { "gl", "glg" }, { "he", "heb" }, { "hi", "hin" },
+	{ "hr", "hrv" }, { "hu", "hun" }, { "id", "ind" }, { "is", "ice" }, { "it", "ita" },
+	{ "ja", "jpn" }, { "ko", "kor" }, { "la", "lat" }, { "lt", "lit" }, { "lv", "lav" },
+	{ "ms", "may" }, { "nl", "dut" }, { "no", "nor" }, { "pl", "pol" }, { "pt", "por" },
+	{ "ro", "rum" }, { "ru", "rus" }, { "sk", "slo" }, { "sl", "slv" }, { "sr", "srp" },
+	{ "sv", "swe" }, { "ta", "tam" }, { "th", "tha" }, { "tl", "tgl" }, { "tr", "tur" },
+	{ "uk", "ukr" }, { "ur", "urd" }, { "vi", "vie" }, { "yi", "yid" }, { "zh", "chi" },
+};
+
+struct dvd_mkv_buffer {
+	uint8_t *data;
+	size_t length;
+	size_t size;
+	bool error;
+};
+
+/**
+ * track: Matroska track number, 0 if the stream isn't muxed
+ * block: audio or subpicture data waiting to be written, starting at ticks
+ * spu_size: length of the subpicture being put back together
+ */
+struct dvd_mkv_stream {
+	uint8_t track;
+	uint8_t type;
+	uint8_t format;
+	bool aligned;
+	bool has_time;
+	int64_t ticks;
+	uint16_t spu_size;
+	struct dvd_mkv_buffer block;
+};
+
+struct dvd_mkv_cue {
+	uint32_t msecs;
+	uint64_t position;
+};
+
+/**
+ * A frame in the queue
+ *
+ * offset: where it is in the queue's buffer
+ * fields: how many fields it is shown for
+ */
+struct dvd_mkv_picture {
+	size_t offset;
+	size_t length;
+	uint16_t temporal_reference;
+	uint8_t type;
+	uint8_t fields;
+	bool has_time;
+	int64_t ticks;
+};
+
+/**
+ * Times are in 90 kHz ticks from the start of the first chapter, and base
+ * turns a PTS into one
+ *
+ * frame: video since the last frame that was written
+ * scan: where to look for the next start code in it
+ * picture, extension, sequence: where the picture header, its coding
+ *   extension and the sequence extension are in the frame, plus one (0 is
+ *   none)
+ * pending: a PTS that goes with the next picture
+ * queue, pictures: frames that can't be timed yet, see dvd_mkv_frame()
+ * gop_fields: fields each temporal reference in the GOP is shown for, 0 if
+ *   it hasn't been seen
+ * gop_base: time of temporal reference 0 in the GOP
+ * next_ticks: end of the latest frame so far
+ * anchor_ticks: times of the last two I or P frames written, the ones a
+ *   frame after them can refer to
+ * position: bytes written after the segment header
+ * segment: where the segment's data starts in the file, -1 if it can't be
+ *   seeked
+ */
+struct dvd_mkv {
+	int fd;
+	bool error;
+	uint64_t position;
+	off_t segment;
+	uint8_t tracks;
+	uint8_t video_track;
+	struct dvd_demux *dvd_demux;
+	struct dvd_vobu dvd_vobu;
+	bool has_base;
+	int64_t base;
+	uint32_t cell_start[256];
+	struct dvd_mkv_stream streams[256];
+	struct dvd_mkv_buffer frame;
+	size_t scan;
+	size_t picture;
+	size_t extension;
+	size_t sequence;
+	uint8_t fields;
+	bool progressive_sequence;
+	bool pending;
+	int64_t pending_ticks;
+	bool picture_time;
+	int64_t picture_ticks;
+	struct dvd_mkv_buffer queue;
+	struct dvd_mkv_picture pictures[DVD_MKV_PICTURES];
+	uint8_t queued;
+	uint8_t gop_fields[1024];
+	bool has_gop;
+	int64_t gop_base;
+	int64_t next_ticks;
+	int64_t anchor_ticks[2];
+	uint8_t anchors;
+	uint32_t frame_ticks;
+	bool started;
+	bool has_cluster;
+	int64_t cluster_msecs;
+	struct dvd_mkv_buffer cluster;
+	struct dvd_mkv_buffer head;
+	struct dvd_mkv_cue *cues;
+	uint32_t cue_count;
+	uint32_t cue_size;
+};
+
+/** EBML **/
+
+static bool dvd_mkv_reserve(struct dvd_mkv_buffer *buffer, const size_t bytes) {
+
+	uint8_t *data = NULL;
+	size_t size = 0;
+
+	if(buffer->error)
+		return false;
+
+	if(buffer->length + bytes <= buffer->size)
+		return true;
+
+	size = buffer->size ? buffer->size : 4096;
+	while(size < buffer->length + bytes)
+		size *= 2;
+
+	data = realloc(buffer->data, size);
+	if(data == NULL) {
+		buffer->error = true;
+		return false;
+	}
+
+	buffer->data = data;
+	buffer->size = size;
+
+	return true;
+
+}
+
+static void dvd_mkv_bytes(struct dvd_mkv_buffer *buffer, const uint8_t *bytes, const size_t length) {
+
+	if(length == 0 || !dvd_mkv_reserve(buffer, length))
+		return;
+
+	memcpy(buffer->data + buffer->length, bytes, length);
+	buffer->length += length;
+
+}
+
+static void dvd_mkv_id(struct dvd_mkv_buffer *buffer, const uint32_t id) {
+
+	uint8_t bytes[4];
+	uint8_t length = id > 0xffffff ? 4 : id > 0xffff ? 3 : id > 0xff ? 2 : 1;
+	uint8_t ix = 0;
+
+	for(ix = 0; ix < length; ix++)
+		bytes[ix] = (uint8_t)(id >> (8 * (length - 1 - ix)));
+
+	dvd_mkv_bytes(buffer, bytes, length);
+
+}
+
+/**
+ * Element size, as a variable length integer: the number of leading zero
+ * bits is how many more bytes there are.  All ones is an unknown size.
+ */
+static void dvd_mkv_size(struct dvd_mkv_buffer *buffer, const uint64_t size) {
+
+	uint8_t bytes[8];
+	uint8_t length = 1;
+	uint8_t ix = 0;
+
+	while(length < 8 && size >= ((uint64_t)1 << (7 * length)) - 1)
+		length++;
+
+	for(ix = 0; ix < length; ix++)
+		bytes[ix] = (uint8_t)(size >> (8 * (length - 1 - ix)));
+
+	bytes[0] |= (uint8_t)(0x80 >> (length - 1));
+
+	dvd_mkv_bytes(buffer, bytes, length);
+
+}
+
+static void dvd_mkv_uint(struct dvd_mkv_buffer *buffer, const uint32_t id, const uint64_t value) {
+
+	uint8_t bytes[8];
+	uint8_t length = 1;
+	uint8_t ix = 0;
+
+	while(length < 8 && (value >> (8 * length)))
+		length++;
+
+	for(ix = 0; ix < length; ix++)
+		bytes[ix] = (uint8_t)(value >> (8 * (length - 1 - ix)));
+
+	dvd_mkv_id(buffer, id);
+	dvd_mkv_size(buffer, length);
+	dvd_mkv_bytes(buffer, bytes, length);
+
+}
+
+static void dvd_mkv_int(struct dvd_mkv_buffer *buffer, const uint32_t id, const int64_t value) {
+
+	uint8_t bytes[8];
+	uint8_t length = 1;
+	uint8_t ix = 0;
+
+	while(length < 8 && (value < -((int64_t)1 << (8 * length - 1)) || value >= ((int64_t)1 << (8 * length - 1))))
+		length++;
+
+	for(ix = 0; ix < length; ix++)
+		bytes[ix] = (uint8_t)((uint64_t)value >> (8 * (length - 1 - ix)));
+
+	dvd_mkv_id(buffer, id);
+	dvd_mkv_size(buffer, length);
+	dvd_mkv_bytes(buffer, bytes, length);
+
+}
+
+static void dvd_mkv_float(struct dvd_mkv_buffer *buffer, const uint32_t id, const double value) {
+
+	uint8_t bytes[8];
+	uint64_t bits = 0;
+	uint8_t ix = 0;
+
+	memcpy(&bits, &value, sizeof(bits));
+
+	for(ix = 0; ix < 8; ix++)
+		bytes[ix] = (uint8_t)(bits >> (8 * (7 - ix)));
+
+	dvd_mkv_id(buffer, id);
+	dvd_mkv_size(buffer, 8);
+	dvd_mkv_bytes(buffer, bytes, 8);
+
+}
+
+static void dvd_mkv_binary(struct dvd_mkv_buffer *buffer, const uint32_t id, const uint8_t *data, const size_t length) {
+
+	dvd_mkv_id(buffer, id);
+	dvd_mkv_size(buffer, length);
+	dvd_mkv_bytes(buffer, data, length);
+
+}
+
+static void dvd_mkv_string(struct dvd_mkv_buffer *buffer, const uint32_t id, const char *str) {
+
+	dvd_mkv_binary(buffer, id, (const uint8_t *)str, strlen(str));
+
+}
+
+/**
+ * Start a master element, with room for an eight byte size
+ *
+ * @return where the size goes, for dvd_mkv_end()
+ */
+static size_t dvd_mkv_master(struct dvd_mkv_buffer *buffer, const uint32_t id) {
+
+	const uint8_t size[8] = { 0x01, 0, 0, 0, 0, 0, 0, 0 };
+	size_t offset = 0;
+
+	dvd_mkv_id(buffer, id);
+	offset = buffer->length;
+	dvd_mkv_bytes(buffer, size, 8);
+
+	return offset;
+
+}
+
+static void dvd_mkv_end(struct dvd_mkv_buffer *buffer, const size_t offset) {
+
+	uint64_t size = 0;
+	uint8_t ix = 0;
+
+	if(buffer->error)
+		return;
+
+	size = buffer->length - offset - 8;
+
+	for(ix = 1; ix < 8; ix++)
+		buffer->data[offset + ix] = (uint8_t)(size >> (8 * (7 - ix)));
+
+}
+
+/**
+ * Padding, length bytes long in all
+ */
+static void dvd_mkv_void(struct dvd_mkv_buffer *buffer, const size_t length) {
+
+	const uint8_t zeros[126] = { 0 };
+
+	dvd_mkv_id(buffer, MKV_VOID);
+	dvd_mkv_size(buffer, length - 2);
+	dvd_mkv_bytes(buffer, zeros, length - 2);
+
+}
+
+/** Output **/
+
+static bool dvd_mkv_output(struct dvd_mkv *dvd_mkv, const struct dvd_mkv_buffer *buffer) {
+
+	size_t bytes_written = 0;
+	ssize_t retval = 0;
+
+	if(buffer->error) {
+		dvd_mkv->error = true;
+		return false;
+	}
+
+	while(bytes_written < buffer->length) {
+
+		retval = write(dvd_mkv->fd, buffer->data + bytes_written, buffer->length - bytes_written);
+
+		if(retval <= 0) {
+			dvd_mkv->error = true;
+			return false;
+		}
+
+		bytes_written += (size_t)retval;
+
+	}
+
+	dvd_mkv->position += bytes_written;
+
+	return true;
+
+}
+
+/**
+ * Write the cluster that has been put together, and start a new one
+ *
+ * @param cue add it to the cues (it starts with an I frame)
+ */
+static bool dvd_mkv_cluster(struct dvd_mkv *dvd_mkv, int64_t msecs, const bool cue) {
+
+	struct dvd_mkv_cue *cues = NULL;
+	uint32_t size = 0;
+
+	if(dvd_mkv->has_cluster) {
+
+		dvd_mkv->head.length = 0;
+		dvd_mkv_id(&dvd_mkv->head, MKV_CLUSTER);
+		dvd_mkv_size(&dvd_mkv->head, dvd_mkv->cluster.length);
+
+		if(!dvd_mkv_output(dvd_mkv, &dvd_mkv->head) || !dvd_mkv_output(dvd_mkv, &dvd_mkv->cluster))
+			return false;
+
+	}
+
+	if(msecs < 0)
+		msecs = 0;
+
+	// Nothing could find the cues without a seek head
+	if(cue && dvd_mkv->segment >= 0) {
+
+		if(dvd_mkv->cue_count == dvd_mkv->cue_size) {
+			size = dvd_mkv->cue_size ? dvd_mkv->cue_size * 2 : 1024;
+			cues = realloc(dvd_mkv->cues, size * sizeof(struct dvd_mkv_cue));
+			if(cues == NULL) {
+				dvd_mkv->error = true;
+				return false;
+			}
+			dvd_mkv->cues = cues;
+			dvd_mkv->cue_size = size;
+		}
+
+		dvd_mkv->cues[dvd_mkv->cue_count].msecs = (uint32_t)msecs;
+		dvd_mkv->cues[dvd_mkv->cue_count].position = dvd_mkv->position;
+		dvd_mkv->cue_count++;
+
+	}
+
+	dvd_mkv->cluster.length = 0;
+	dvd_mkv_uint(&dvd_mkv->cluster, MKV_TIMESTAMP, (uint64_t)msecs);
+	dvd_mkv->has_cluster = true;
+	dvd_mkv->cluster_msecs = msecs;
+
+	return true;
+
+}
+
+static int64_t dvd_mkv_msecs(const int64_t ticks) {
+
+	return ticks > 0 ? (ticks + 45) / 90 : 0;
+
+}
+
+/**
+ * The track number, time and flags a block starts with.  Its time is
+ * relative to the cluster's, and has to fit in 16 bits, so a new one is
+ * started if it doesn't.
+ */
+static bool dvd_mkv_block_header(struct dvd_mkv *dvd_mkv, const struct dvd_mkv_stream *dvd_mkv_stream, const int64_t ticks, const uint8_t flags, uint8_t header[4]) {
+
+	int64_t msecs = dvd_mkv_msecs(ticks);
+	int64_t relative = msecs - dvd_mkv->cluster_msecs;
+
+	if(relative > INT16_MAX) {
+		if(!dvd_mkv_cluster(dvd_mkv, msecs, false))
+			return false;
+		relative = 0;
+	}
+
+	if(relative < INT16_MIN)
+		relative = INT16_MIN;
+
+	header[0] = 0x80 | dvd_mkv_stream->track;
+	header[1] = (uint8_t)(((uint16_t)relative) >> 8);
+	header[2] = (uint8_t)relative;
+	header[3] = flags;
+
+	return true;
+
+}
+
+/**
+ * Add a block to the cluster
+ */
+static bool dvd_mkv_block(struct dvd_mkv *dvd_mkv, const struct dvd_mkv_stream *dvd_mkv_stream, const int64_t ticks, const uint8_t flags, const uint8_t *data, const size_t length) {
+
+	uint8_t header[4];
+
+	if(!dvd_mkv->has_cluster)
+		return true;
+
+	if(!dvd_mkv_block_header(dvd_mkv, dvd_mkv_stream, ticks, flags, header))
+		return false;
+
+	dvd_mkv_id(&dvd_mkv->cluster, MKV_SIMPLE_BLOCK);
+	dvd_mkv_size(&dvd_mkv->cluster, length + 4);
+	dvd_mkv_bytes(&dvd_mkv->cluster, header, 4);
+	dvd_mkv_bytes(&dvd_mkv->cluster, data, length);
+
+	if(dvd_mkv->cluster.error) {
+		dvd_mkv->error = true;
+		return false;
+	}
+
+	return true;
+
+}
+
+/**
+ * Add a block that isn't as long as the track's default duration to the
+ * cluster.  It has to be in a block group to have a duration of its own, and
+ * there the frames it refers to say it isn't a keyframe.
+ *
+ * @param references times of the frames it refers to
+ */
+static bool dvd_mkv_block_group(struct dvd_mkv *dvd_mkv, const struct dvd_mkv_stream *dvd_mkv_stream, const int64_t ticks, const int64_t duration, const int64_t *references, const uint8_t count, const uint8_t *data, const size_t length) {
+
+	uint8_t header[4];
+	size_t group = 0;
+	uint8_t ix = 0;
+
+	if(!dvd_mkv->has_cluster)
+		return true;
+
+	if(!dvd_mkv_block_header(dvd_mkv, dvd_mkv_stream, ticks, 0, header))
+		return false;
+
+	group = dvd_mkv_master(&dvd_mkv->cluster, MKV_BLOCK_GROUP);
+	dvd_mkv_id(&dvd_mkv->cluster, MKV_BLOCK);
+	dvd_mkv_size(&dvd_mkv->cluster, length + 4);
+	dvd_mkv_bytes(&dvd_mkv->cluster, header, 4);
+	dvd_mkv_bytes(&dvd_mkv->cluster, data, length);
+	dvd_mkv_uint(&dvd_mkv->cluster, MKV_BLOCK_DURATION, (uint64_t)(dvd_mkv_msecs(ticks + duration) - dvd_mkv_msecs(ticks)));
+	for(ix = 0; ix < count; ix++)
+		dvd_mkv_int(&dvd_mkv->cluster, MKV_REFERENCE_BLOCK, dvd_mkv_msecs(references[ix]) - dvd_mkv_msecs(ticks));
+	dvd_mkv_end(&dvd_mkv->cluster, group);
+
+	if(dvd_mkv->cluster.error) {
+		dvd_mkv->error = true;
+		return false;
+	}
+
+	return true;
+
+}
+
+/**
+ * Time of a packet, if it has a PTS and there has been a NAV pack
+ */
+static bool dvd_mkv_ticks(const struct dvd_mkv *dvd_mkv, const struct dvd_demux_packet *dvd_demux_packet, int64_t *ticks) {
+
+	if(!dvd_demux_packet->has_pts || !dvd_mkv->has_base)
+		return false;
+
+	*ticks = dvd_mkv->base + (int64_t)dvd_demux_packet->pts;
+
+	return true;
+
+}
+
+/** Video **/
+
+/**
+ * Number of fields the picture in the frame buffer is shown for, from its
+ * coding extension.  A frame picture with repeat_first_field set is shown
+ * for three (soft telecine), or in a progressive sequence for two or three
+ * frames, depending on top_field_first.  Two field pictures are one frame.
+ */
+static uint8_t dvd_mkv_picture_fields(const struct dvd_mkv *dvd_mkv, const size_t length) {
+
+	const uint8_t *extension = NULL;
+
+	if(dvd_mkv->fields != 1 || dvd_mkv->extension == 0 || dvd_mkv->extension + 7 > length)
+		return 2;
+
+	extension = dvd_mkv->frame.data + dvd_mkv->extension - 1;
+
+	if((extension[4] >> 4) != 8 || (extension[6] & 0x03) != 3 || !(extension[7] & 0x02))
+		return 2;
+
+	if(dvd_mkv->progressive_sequence)
+		return (extension[7] & 0x80) ? 6 : 4;
+
+	return 3;
+
+}
+
+/**
+ * Time from the start of the GOP to a temporal reference, adding up how long
+ * each picture before it is shown.  One that hasn't been seen counts as a
+ * frame.
+ */
+static int64_t dvd_mkv_gop_ticks(const struct dvd_mkv *dvd_mkv, const uint16_t temporal_reference) {
+
+	uint32_t fields = 0;
+	uint16_t ix = 0;
+
+	for(ix = 0; ix < temporal_reference && ix < 1024; ix++)
+		fields += dvd_mkv->gop_fields[ix] ? dvd_mkv->gop_fields[ix] : 2;
+
+	return (int64_t)fields * dvd_mkv->frame_ticks / 2;
+
+}
+
+/**
+ * Write a frame from the queue.  I frames start a cluster, and nothing is
+ * written until the first one.  A frame that isn't shown for two fields
+ * gets a duration of its own.
+ */
+static bool dvd_mkv_picture_block(struct dvd_mkv *dvd_mkv, const struct dvd_mkv_picture *dvd_mkv_picture, const int64_t ticks) {
+
+	const uint8_t *data = dvd_mkv->queue.data + dvd_mkv_picture->offset;
+	const struct dvd_mkv_stream *dvd_mkv_stream = &dvd_mkv->streams[DVD_DEMUX_VIDEO];
+	int64_t duration = (int64_t)dvd_mkv_picture->fields * dvd_mkv->frame_ticks / 2;
+	uint8_t references = 0;
+	uint8_t flags = 0;
+	bool written = true;
+
+	if(dvd_mkv_picture->type == 1) {
+		if(!dvd_mkv_cluster(dvd_mkv, dvd_mkv_msecs(ticks), true))
+			return false;
+		dvd_mkv->started = true;
+		flags = MKV_KEYFRAME;
+	}
+
+	if(!dvd_mkv->started)
+		return true;
+
+	// A P frame refers to the last I or P frame, and a B frame to the last two
+	if(dvd_mkv_picture->type == 2)
+		references = dvd_mkv->anchors ? 1 : 0;
+	else if(dvd_mkv_picture->type == 3)
+		references = dvd_mkv->anchors;
+
+	// Nothing refers to a B frame
+	if(dvd_mkv_picture->type == 3)
+		flags |= MKV_DISCARDABLE;
+
+	if(dvd_mkv_picture->fields == 2)
+		written = dvd_mkv_block(dvd_mkv, dvd_mkv_stream, ticks, flags, data, dvd_mkv_picture->length);
+	else
+		written = dvd_mkv_block_group(dvd_mkv, dvd_mkv_stream, ticks, duration, dvd_mkv->anchor_ticks + 2 - references, references, data, dvd_mkv_picture->length);
+
+	if(dvd_mkv_picture->type != 3) {
+		dvd_mkv->anchor_ticks[0] = dvd_mkv->anchor_ticks[1];
+		dvd_mkv->anchor_ticks[1] = ticks;
+		if(dvd_mkv->anchors < 2)
+			dvd_mkv->anchors++;
+	}
+
+	return written;
+
+}
+
+/**
+ * Time the frames in the queue and write them, in the order they came in.  A
+ * picture with a PTS sets when the GOP starts, for the ones after it that
+ * don't have one.
+ */
+static bool dvd_mkv_pictures(struct dvd_mkv *dvd_mkv) {
+
+	const struct dvd_mkv_picture *dvd_mkv_picture = NULL;
+	int64_t ticks = 0;
+	uint8_t ix = 0;
+
+	for(ix = 0; ix < dvd_mkv->queued; ix++) {
+
+		dvd_mkv_picture = &dvd_mkv->pictures[ix];
+
+		if(dvd_mkv_picture->has_time) {
+			ticks = dvd_mkv_picture->ticks;
+			dvd_mkv->gop_base = ticks - dvd_mkv_gop_ticks(dvd_mkv, dvd_mkv_picture->temporal_reference);
+			dvd_mkv->has_gop = true;
+		} else {
+			// A GOP that doesn't start with a PTS carries on from the last one
+			if(!dvd_mkv->has_gop && !dvd_mkv->started)
+				continue;
+			if(!dvd_mkv->has_gop) {
+				dvd_mkv->gop_base = dvd_mkv->next_ticks;
+				dvd_mkv->has_gop = true;
+			}
+			ticks = dvd_mkv->gop_base + dvd_mkv_gop_ticks(dvd_mkv, dvd_mkv_picture->temporal_reference);
+		}
+
+		if(ticks + (int64_t)dvd_mkv_picture->fields * dvd_mkv->frame_ticks / 2 > dvd_mkv->next_ticks)
+			dvd_mkv->next_ticks = ticks + (int64_t)dvd_mkv_picture->fields * dvd_mkv->frame_ticks / 2;
+
+		if(!dvd_mkv_picture_block(dvd_mkv, dvd_mkv_picture, ticks))
+			return false;
+
+	}
+
+	dvd_mkv->queued = 0;
+	dvd_mkv->queue.length = 0;
+
+	return true;
+
+}
+
+/**
+ * Queue the first length bytes of the frame buffer as one frame.
+ *
+ * A frame without a PTS is timed from the start of its GOP and how long each
+ * of the pictures shown before it is, which isn't always a frame: soft
+ * telecine repeats a field of some of them.  An I or P frame is shown after
+ * the B frames that come after it, so the frames are kept until the next I
+ * or P frame, by when all of those are known.
+ */
+static bool dvd_mkv_frame(struct dvd_mkv *dvd_mkv, const size_t length) {
+
+	const uint8_t *header = NULL;
+	const uint8_t *extension = NULL;
+	struct dvd_mkv_picture *dvd_mkv_picture = NULL;
+	uint16_t temporal_reference = 0;
+	uint8_t picture_type = 0;
+
+	if(dvd_mkv->sequence && dvd_mkv->sequence + 5 <= length) {
+		extension = dvd_mkv->frame.data + dvd_mkv->sequence - 1;
+		if((extension[4] >> 4) == 1)
+			dvd_mkv->progressive_sequence = (extension[5] & 0x08) != 0;
+	}
+
+	if(dvd_mkv->picture == 0 || dvd_mkv->picture + 5 > length)
+		return true;
+
+	header = dvd_mkv->frame.data + dvd_mkv->picture - 1;
+	temporal_reference = (uint16_t)((header[4] << 2) | (header[5] >> 6));
+	picture_type = (header[5] >> 3) & 0x07;
+
+	if((picture_type != 3 || dvd_mkv->queued == DVD_MKV_PICTURES) && !dvd_mkv_pictures(dvd_mkv))
+		return false;
+
+	dvd_mkv_picture = &dvd_mkv->pictures[dvd_mkv->queued];
+	dvd_mkv_picture->offset = dvd_mkv->queue.length;
+	dvd_mkv_picture->length = length;
+	dvd_mkv_picture->temporal_reference = temporal_reference;
+	dvd_mkv_picture->type = picture_type;
+	dvd_mkv_picture->fields = dvd_mkv_picture_fields(dvd_mkv, length);
+	dvd_mkv_picture->has_time = dvd_mkv->picture_time;
+	dvd_mkv_picture->ticks = dvd_mkv->picture_ticks;
+
+	dvd_mkv_bytes(&dvd_mkv->queue, dvd_mkv->frame.data, length);
+	if(dvd_mkv->queue.error) {
+		dvd_mkv->error = true;
+		return false;
+	}
+
+	dvd_mkv->gop_fields[temporal_reference] = dvd_mkv_picture->fields;
+	dvd_mkv->queued++;
+
+	return true;
+
+}
+
+/**
+ * Check if the picture in the frame buffer is the first of two fields, from
+ * the picture structure in its coding extension
+ */
+static bool dvd_mkv_first_field(const struct dvd_mkv *dvd_mkv, const size_t end) {
+
+	const uint8_t *extension = NULL;
+
+	if(dvd_mkv->fields != 1 || dvd_mkv->extension == 0 || dvd_mkv->extension + 6 > end)
+		return false;
+
+	extension = dvd_mkv->frame.data + dvd_mkv->extension - 1;
+
+	return (extension[4] >> 4) == 8 && (extension[6] & 0x03) != 3;
+
+}
+
+/**
+ * Split the video into frames.  A frame ends where the next sequence header,
+ * GOP header or picture header starts, unless it is the second field of the
+ * same frame.  A PTS goes with the first picture that starts in its packet.
+ */
+static bool dvd_mkv_video(struct dvd_mkv *dvd_mkv, const struct dvd_demux_packet *dvd_demux_packet) {
+
+	struct dvd_mkv_buffer *frame = &dvd_mkv->frame;
+	const uint8_t *p = NULL;
+	size_t start = frame->length;
+	size_t ix = dvd_mkv->scan;
+	uint8_t code = 0;
+	int64_t ticks = 0;
+
+	if(dvd_mkv_ticks(dvd_mkv, dvd_demux_packet, &ticks)) {
+		dvd_mkv->pending = true;
+		dvd_mkv->pending_ticks = ticks;
+	}
+
+	dvd_mkv_bytes(frame, dvd_demux_packet->buffer, dvd_demux_packet->length);
+	if(frame->error) {
+		dvd_mkv->error = true;
+		return false;
+	}
+
+	while(ix + 3 < frame->length) {
+
+		p = frame->data + ix;
+
+		if(p[0] != 0x00 || p[1] != 0x00 || p[2] != 0x01) {
+			ix++;
+			continue;
+		}
+
+		code = p[3];
+
+		if(code == 0x00 || code == 0xb3 || code == 0xb8) {
+
+			if(code == 0x00 && dvd_mkv_first_field(dvd_mkv, ix)) {
+				dvd_mkv->fields = 2;
+				ix += 4;
+				continue;
+			}
+
+			if(dvd_mkv->picture) {
+
+				if(!dvd_mkv_frame(dvd_mkv, ix))
+					return false;
+
+				memmove(frame->data, frame->data + ix, frame->length - ix);
+				frame->length -= ix;
+				start = start > ix ? start - ix : 0;
+				ix = 0;
+
+				dvd_mkv->picture = 0;
+				dvd_mkv->extension = 0;
+				dvd_mkv->sequence = 0;
+				dvd_mkv->fields = 0;
+				dvd_mkv->picture_time = false;
+
+			}
+
+			// Every frame of the last GOP is in the queue
+			if(code == 0xb8) {
+				if(!dvd_mkv_pictures(dvd_mkv))
+					return false;
+				memset(dvd_mkv->gop_fields, 0, sizeof(dvd_mkv->gop_fields));
+				dvd_mkv->has_gop = false;
+			}
+
+			if(code == 0x00) {
+				dvd_mkv->picture = ix + 1;
+				dvd_mkv->fields = 1;
+				dvd_mkv->picture_time = dvd_mkv->pending && ix >= start;
+				if(dvd_mkv->picture_time) {
+					dvd_mkv->picture_ticks = dvd_mkv->pending_ticks;
+					dvd_mkv->pending = false;
+				}
+			}
+
+		} else if(code == 0xb5 && dvd_mkv->picture && dvd_mkv->extension == 0) {
+			dvd_mkv->extension = ix + 1;
+		} else if(code == 0xb5 && dvd_mkv->picture == 0 && dvd_mkv->sequence == 0) {
+			dvd_mkv->sequence = ix + 1;
+		}
+
+		ix += 4;
+
+	}
+
+	dvd_mkv->scan = ix;
+
+	return true;
+
+}
+
+/** Audio and subpictures **/
+
+static bool dvd_mkv_flush(struct dvd_mkv *dvd_mkv, struct dvd_mkv_stream *dvd_mkv_stream) {
+
+	bool written = true;
+
+	if(dvd_mkv->started && dvd_mkv_stream->has_time && dvd_mkv_stream->block.length)
+		written = dvd_mkv_block(dvd_mkv, dvd_mkv_stream, dvd_mkv_stream->ticks, MKV_KEYFRAME, dvd_mkv_stream->block.data, dvd_mkv_stream->block.length);
+
+	dvd_mkv_stream->block.length = 0;
+
+	return written;
+
+}
+
+static bool dvd_mkv_append(struct dvd_mkv *dvd_mkv, struct dvd_mkv_stream *dvd_mkv_stream, const uint8_t *buf, const size_t length) {
+
+	dvd_mkv_bytes(&dvd_mkv_stream->block, buf, length);
+
+	if(dvd_mkv_stream->block.error) {
+		dvd_mkv->error = true;
+		return false;
+	}
+
+	return true;
+
+}
+
+/**
+ * Each block starts at the first frame of a packet that has a PTS, so it is
+ * whole frames with the time of the first one.  MPEG audio doesn't have a
+ * pointer to its first frame, so its blocks are each packet with a PTS.
+ */
+static bool dvd_mkv_audio(struct dvd_mkv *dvd_mkv, struct dvd_mkv_stream *dvd_mkv_stream, const struct dvd_demux_packet *dvd_demux_packet) {
+
+	const uint8_t *buf = dvd_demux_packet->buffer;
+	size_t length = dvd_demux_packet->length;
+	size_t access_unit = dvd_demux_packet->access_unit;
+	int64_t ticks = 0;
+	bool has_time = dvd_mkv_ticks(dvd_mkv, dvd_demux_packet, &ticks);
+
+	if(dvd_mkv_stream->format == DVD_AUDIO_ES_RAW) {
+		access_unit = 0;
+	} else if(dvd_demux_packet->frames == 0 || access_unit >= length) {
+		has_time = false;
+	}
+
+	if(!dvd_mkv_stream->aligned && !has_time)
+		return true;
+
+	if(!has_time)
+		return dvd_mkv_append(dvd_mkv, dvd_mkv_stream, buf, length);
+
+	if(dvd_mkv_stream->aligned && !dvd_mkv_append(dvd_mkv, dvd_mkv_stream, buf, access_unit))
+		return false;
+
+	if(!dvd_mkv_flush(dvd_mkv, dvd_mkv_stream))
+		return false;
+
+	dvd_mkv_stream->aligned = true;
+	dvd_mkv_stream->has_time = true;
+	dvd_mkv_stream->ticks = ticks;
+
+	return dvd_mkv_append(dvd_mkv, dvd_mkv_stream, buf + access_unit, length - access_unit);
+
+}
+
+/**
+ * A subpicture starts with its length, in a packet with a PTS, and is
+ * written once all of it is there
+ */
+static bool dvd_mkv_subpicture(struct dvd_mkv *dvd_mkv, struct dvd_mkv_stream *dvd_mkv_stream, const struct dvd_demux_packet *dvd_demux_packet) {
+
+	int64_t ticks = 0;
+
+	if(dvd_mkv_ticks(dvd_mkv, dvd_demux_packet, &ticks)) {
+		dvd_mkv_stream->block.length = 0;
+		dvd_mkv_stream->has_time = true;
+		dvd_mkv_stream->ticks = ticks;
+		dvd_mkv_stream->spu_size = 0;
+	}
+
+	if(!dvd_mkv_stream->has_time)
+		return true;
+
+	if(!dvd_mkv_append(dvd_mkv, dvd_mkv_stream, dvd_demux_packet->buffer, dvd_demux_packet->length))
+		return false;
+
+	if(dvd_mkv_stream->spu_size == 0 && dvd_mkv_stream->block.length >= 2)
+		dvd_mkv_stream->spu_size = (uint16_t)((dvd_mkv_stream->block.data[0] << 8) | dvd_mkv_stream->block.data[1]);
+
+	if(dvd_mkv_stream->spu_size < 2 || dvd_mkv_stream->block.length < dvd_mkv_stream->spu_size)
+		return true;
+
+	dvd_mkv_stream->block.length = dvd_mkv_stream->spu_size;
+
+	if(!dvd_mkv_flush(dvd_mkv, dvd_mkv_stream))
+		return false;
+
+	dvd_mkv_stream->has_time = false;
+
+	return true;
+
+}
+
+static bool dvd_mkv_packet(void *data, const struct dvd_demux_packet *dvd_demux_packet) {
+
+	struct dvd_mkv *dvd_mkv = (struct dvd_mkv *)data;
+	struct dvd_mkv_stream *dvd_mkv_stream = NULL;
+	uint8_t stream_id = dvd_demux_packet->stream_id;
+
+	if(stream_id == DVD_DEMUX_PRIVATE_STREAM_1)
+		stream_id = dvd_demux_packet->substream_id;
+
+	dvd_mkv_stream = &dvd_mkv->streams[stream_id];
+
+	if(dvd_mkv_stream->track == 0)
+		return true;
+
+	if(dvd_mkv_stream->type == DVD_MKV_VIDEO)
+		return dvd_mkv_video(dvd_mkv, dvd_demux_packet);
+
+	if(dvd_mkv_stream->type == DVD_MKV_AUDIO)
+		return dvd_mkv_audio(dvd_mkv, dvd_mkv_stream, dvd_demux_packet);
+
+	return dvd_mkv_subpicture(dvd_mkv, dvd_mkv_stream, dvd_demux_packet);
+
+}
+
+/** Header **/
+
+/**
+ * ISO 639-2/B code for a language code from the IFO, "und" if it isn't known
+ */
+const char *dvd_mkv_language(const char *lang_code) {
+
+	size_t ix = 0;
+
+	for(ix = 0; ix < sizeof(dvd_mkv_languages) / sizeof(dvd_mkv_languages[0]); ix++) {
+		if(strcmp(lang_code, dvd_mkv_languages[ix][0]) == 0)
+			return dvd_mkv_languages[ix][1];
+	}
+
+	return "und";
+
+}
+
+/**
+ * Start a track entry, with what every track has
+ *
+ * @return offset for dvd_mkv_end()
+ */
+static size_t dvd_mkv_track(struct dvd_mkv *dvd_mkv, const uint8_t stream_id, const uint8_t type, const char *codec_id, const char *lang_code) {
+
+	struct dvd_mkv_buffer *head = &dvd_mkv->head;
+	struct dvd_mkv_stream *dvd_mkv_stream = &dvd_mkv->streams[stream_id];
+	size_t offset = 0;
+
+	dvd_mkv->tracks++;
+	dvd_mkv_stream->track = dvd_mkv->tracks;
+	dvd_mkv_stream->type = type;
+	dvd_mkv_stream->format = dvd_audio_es_format(stream_id);
+
+	dvd_demux_select(dvd_mkv->dvd_demux, stream_id, true);
+
+	offset = dvd_mkv_master(head, MKV_TRACK_ENTRY);
+	dvd_mkv_uint(head, MKV_TRACK_NUMBER, dvd_mkv_stream->track);
+	dvd_mkv_uint(head, MKV_TRACK_UID, dvd_mkv_stream->track);
+	dvd_mkv_uint(head, MKV_TRACK_TYPE, type);
+	dvd_mkv_uint(head, MKV_FLAG_LACING, 0);
+	dvd_mkv_string(head, MKV_CODEC_ID, codec_id);
+	dvd_mkv_string(head, MKV_LANGUAGE, dvd_mkv_language(lang_code));
+
+	if(strlen(lang_code) == 2 && islower(lang_code[0]) && islower(lang_code[1]))
+		dvd_mkv_string(head, MKV_LANGUAGE_BCP47, lang_code);
+
+	return offset;
+
+}
+
+static void dvd_mkv_tracks_header(struct dvd_mkv *dvd_mkv, struct dvd_session *dvd_session, const struct dvd_track *dvd_track) {
+
+	struct dvd_mkv_buffer *head = &dvd_mkv->head;
+	ifo_handle_t *vmg_ifo = dvd_session_vmg_ifo(dvd_session);
+	ifo_handle_t *vts_ifo = dvd_session_track_ifo(dvd_session, dvd_track->track);
+	const char *codec_id = NULL;
+	char codec_private[256];
+	uint32_t palette[16];
+	uint16_t width = dvd_track->dvd_video.width;
+	uint16_t height = dvd_track->dvd_video.height;
+	uint8_t stream_id = 0;
+	uint8_t bits = 0;
+	uint8_t ix = 0;
+	bool first_audio = true;
+	size_t tracks = 0;
+	size_t track = 0;
+	size_t info = 0;
+	int length = 0;
+
+	tracks = dvd_mkv_master(head, MKV_TRACKS);
+
+	// Video, with the display size from the aspect ratio
+	track = dvd_mkv_track(dvd_mkv, DVD_DEMUX_VIDEO, DVD_MKV_VIDEO, "V_MPEG2", "");
+	dvd_mkv->video_track = dvd_mkv->streams[DVD_DEMUX_VIDEO].track;
+	// Frames with a repeated field have a duration of their own
+	dvd_mkv_uint(head, MKV_DEFAULT_DURATION, ((uint64_t)dvd_mkv->frame_ticks * 100000 + 4) / 9);
+	info = dvd_mkv_master(head, MKV_VIDEO);
+	dvd_mkv_uint(head, MKV_PIXEL_WIDTH, width);
+	dvd_mkv_uint(head, MKV_PIXEL_HEIGHT, height);
+	dvd_mkv_uint(head, MKV_DISPLAY_WIDTH, dvd_track_aspect_ratio_16x9(vts_ifo) ? (height * 16u + 4) / 9 : height * 4u / 3);
+	dvd_mkv_uint(head, MKV_DISPLAY_HEIGHT, height);
+	dvd_mkv_end(head, info);
+	dvd_mkv_end(head, track);
+
+	for(ix = 0; ix < dvd_track->audio_tracks && dvd_track->dvd_audio_tracks != NULL; ix++) {
+
+		if(!dvd_track->dvd_audio_tracks[ix].active)
+			continue;
+
+		stream_id = strtoul(dvd_track->dvd_audio_tracks[ix].stream_id, NULL, 0) & 0xff;
+		bits = 0;
+
+		switch(dvd_audio_es_format(stream_id)) {
+			case DVD_AUDIO_ES_AC3:
+				codec_id = "A_AC3";
+				break;
+			case DVD_AUDIO_ES_DTS:
+				codec_id = "A_DTS";
+				break;
+			case DVD_AUDIO_ES_LPCM:
+				// 20 and 24 bit samples are in groups, that would have to be taken apart
+				bits = dvd_audio_quantization(vts_ifo, ix);
+				codec_id = bits == 16 ? "A_PCM/INT/BIG" : NULL;
+				break;
+			default:
+				codec_id = stream_id >= 0xc0 && stream_id <= 0xc7 ? "A_MPEG/L2" : NULL;
+				break;
+		}
+
+		if(codec_id == NULL)
+			continue;
+
+		track = dvd_mkv_track(dvd_mkv, stream_id, DVD_MKV_AUDIO, codec_id, dvd_track->dvd_audio_tracks[ix].lang_code);
+		dvd_mkv_uint(head, MKV_FLAG_DEFAULT, first_audio);
+		info = dvd_mkv_master(head, MKV_AUDIO);
+		dvd_mkv_float(head, MKV_SAMPLING_FREQUENCY, dvd_audio_sample_rate(vts_ifo, ix));
+		dvd_mkv_uint(head, MKV_CHANNELS, dvd_audio_channels(vts_ifo, ix));
+		if(bits)
+			dvd_mkv_uint(head, MKV_BIT_DEPTH, bits);
+		dvd_mkv_end(head, info);
+		dvd_mkv_end(head, track);
+
+		first_audio = false;
+
+	}
+
+	// VobSub keeps the size of the video and the palette in the codec data
+	memset(palette, 0, sizeof(palette));
+	dvd_subtitle_palette(vmg_ifo, vts_ifo, dvd_track->track, palette);
+	length = snprintf(codec_private, sizeof(codec_private), "size: %ux%u\npalette: ", width, height);
+	for(ix = 0; ix < 16; ix++)
+		length += snprintf(codec_private + length, sizeof(codec_private) - (size_t)length, "%s%06x", ix ? ", " : "", dvd_vobsub_rgb(palette[ix]));
+	length += snprintf(codec_private + length, sizeof(codec_private) - (size_t)length, "\n");
+
+	for(ix = 0; ix < dvd_track->subtitles && dvd_track->dvd_subtitles != NULL; ix++) {
+
+		if(!dvd_track->dvd_subtitles[ix].active)
+			continue;
+
+		stream_id = strtoul(dvd_track->dvd_subtitles[ix].stream_id, NULL, 0) & 0xff;
+		if(stream_id < 0x20 || stream_id > 0x3f)
+			continue;
+
+		track = dvd_mkv_track(dvd_mkv, stream_id, DVD_MKV_SUBTITLE, "S_VOBSUB", dvd_track->dvd_subtitles[ix].lang_code);
+		dvd_mkv_uint(head, MKV_FLAG_DEFAULT, 0);
+		dvd_mkv_binary(head, MKV_CODEC_PRIVATE, (const uint8_t *)codec_private, (size_t)length);
+		dvd_mkv_end(head, track);
+
+	}
+
+	dvd_mkv_end(head, tracks);
+
+}
+
+/**
+ * The EBML header, then the segment, with the info, tracks and chapters
+ */
+static bool dvd_mkv_header(struct dvd_mkv *dvd_mkv, struct dvd_session *dvd_session, const struct dvd_track *dvd_track, const uint8_t first_chapter, const uint8_t last_chapter) {
+
+	struct dvd_mkv_buffer *head = &dvd_mkv->head;
+	struct dvd_info dvd_info;
+	const uint8_t unknown_size[8] = { 0x01, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff };
+	char chapter_name[16];
+	uint64_t msecs = 0;
+	uint64_t chapter_msecs = 0;
+	uint8_t chapter = 0;
+	size_t segment = 0;
+	size_t offset = 0;
+	size_t edition = 0;
+	size_t atom = 0;
+	size_t display = 0;
+
+	for(chapter = first_chapter; chapter <= last_chapter && chapter <= dvd_track->chapters && dvd_track->dvd_chapters != NULL; chapter++)
+		msecs += dvd_track->dvd_chapters[chapter - 1].msecs;
+
+	head->length = 0;
+	dvd_mkv->segment = lseek(dvd_mkv->fd, 0, SEEK_CUR);
+
+	offset = dvd_mkv_master(head, MKV_EBML);
+	dvd_mkv_uint(head, MKV_EBML_VERSION, 1);
+	dvd_mkv_uint(head, MKV_EBML_READ_VERSION, 1);
+	dvd_mkv_uint(head, MKV_EBML_MAX_ID_LENGTH, 4);
+	dvd_mkv_uint(head, MKV_EBML_MAX_SIZE_LENGTH, 8);
+	dvd_mkv_string(head, MKV_DOC_TYPE, "matroska");
+	dvd_mkv_uint(head, MKV_DOC_TYPE_VERSION, 4);
+	dvd_mkv_uint(head, MKV_DOC_TYPE_READ_VERSION, 2);
+	dvd_mkv_end(head, offset);
+
+	// Unknown size, so nothing has to be written over at the end when it
+	// can't be.  Otherwise it is, and room is kept for the seek head.
+	dvd_mkv_id(head, MKV_SEGMENT);
+	dvd_mkv_bytes(head, unknown_size, 8);
+	segment = head->length;
+
+	if(dvd_mkv->segment >= 0) {
+		dvd_mkv->segment += (off_t)segment;
+		dvd_mkv_void(head, DVD_MKV_SEEK_HEAD);
+	}
+
+	dvd_session_info(dvd_session, &dvd_info);
+
+	offset = dvd_mkv_master(head, MKV_INFO);
+	dvd_mkv_uint(head, MKV_TIMESTAMP_SCALE, 1000000);
+	dvd_mkv_float(head, MKV_DURATION, (double)msecs);
+	dvd_mkv_string(head, MKV_MUXING_APP, "libdvdinfo");
+	dvd_mkv_string(head, MKV_WRITING_APP, "libdvdinfo");
+	if(strlen(dvd_info.title))
+		dvd_mkv_string(head, MKV_TITLE, dvd_info.title);
+	dvd_mkv_end(head, offset);
+
+	dvd_mkv_tracks_header(dvd_mkv, dvd_session, dvd_track);
+
+	if(msecs) {
+
+		offset = dvd_mkv_master(head, MKV_CHAPTERS);
+		edition = dvd_mkv_master(head, MKV_EDITION_ENTRY);
+		dvd_mkv_uint(head, MKV_EDITION_UID, 1);
+
+		msecs = 0;
+
+		for(chapter = first_chapter; chapter <= last_chapter && chapter <= dvd_track->chapters; chapter++) {
+
+			chapter_msecs = dvd_track->dvd_chapters[chapter - 1].msecs;
+			snprintf(chapter_name, sizeof(chapter_name), "Chapter %02u", chapter);
+
+			atom = dvd_mkv_master(head, MKV_CHAPTER_ATOM);
+			dvd_mkv_uint(head, MKV_CHAPTER_UID, chapter);
+			dvd_mkv_uint(head, MKV_CHAPTER_TIME_START, msecs * 1000000);
+			dvd_mkv_uint(head, MKV_CHAPTER_TIME_END, (msecs + chapter_msecs) * 1000000);
+			display = dvd_mkv_master(head, MKV_CHAPTER_DISPLAY);
+			dvd_mkv_string(head, MKV_CHAP_STRING, chapter_name);
+			dvd_mkv_string(head, MKV_CHAP_LANGUAGE, "eng");
+			dvd_mkv_end(head, display);
+			dvd_mkv_end(head, atom);
+
+			msecs += chapter_msecs;
+
+		}
+
+		dvd_mkv_end(head, edition);
+		dvd_mkv_end(head, offset);
+
+	}
+
+	if(!dvd_mkv_output(dvd_mkv, head))
+		return false;
+
+	// Cue positions are from the start of the segment's data
+	dvd_mkv->position = head->length - segment;
+
+	return true;
+
+}
+
+/**
+ * Start a Matroska file for a range of chapters of a track, and write its
+ * header
+ *
+ * @param fd where to write it, doesn't have to be seekable, but there are no
+ *   cues if it isn't
+ * @return NULL if it couldn't be written
+ */
+struct dvd_mkv *dvd_mkv_open(struct dvd_session *dvd_session, const struct dvd_track *dvd_track, const uint8_t first_chapter, const uint8_t last_chapter, const int fd) {
+
+	struct dvd_mkv *dvd_mkv = NULL;
+	ifo_handle_t *vmg_ifo = dvd_session_vmg_ifo(dvd_session);
+	ifo_handle_t *vts_ifo = dvd_session_track_ifo(dvd_session, dvd_track->track);
+	uint8_t first_cell = 0;
+
+	if(vts_ifo == NULL)
+		return NULL;
+
+	dvd_mkv = calloc(1, sizeof(struct dvd_mkv));
+	if(dvd_mkv == NULL)
+		return NULL;
+
+	dvd_mkv->fd = fd;
+	dvd_mkv->segment = -1;
+	dvd_mkv->frame_ticks = strcmp(dvd_track->dvd_video.format, "PAL") == 0 ? 3600 : 3003;
+
+	// Times are from the start of the first chapter
+	first_cell = dvd_chapter_first_cell(vmg_ifo, vts_ifo, dvd_track->track, first_chapter);
+	dvd_cell_starts(vmg_ifo, vts_ifo, dvd_track->track, first_cell, dvd_mkv->cell_start);
+
+	dvd_mkv->dvd_demux = dvd_demux_open_streams(dvd_mkv_packet, dvd_mkv);
+
+	if(dvd_mkv->dvd_demux == NULL || !dvd_mkv_header(dvd_mkv, dvd_session, dvd_track, first_chapter, last_chapter)) {
+		dvd_mkv_close(dvd_mkv);
+		return NULL;
+	}
+
+	return dvd_mkv;
+
+}
+
+uint8_t dvd_mkv_tracks(const struct dvd_mkv *dvd_mkv) {
+
+	return dvd_mkv->tracks;
+
+}
+
+/**
+ * Mux a batch of blocks read from the disc
+ *
+ * The PTS can start over at a cell boundary, so the NAV packs' elapsed time
+ * is used to carry the times on whenever it jumps (dvd_vobu_pts_base()).
+ *
+ * @param cell cell the blocks are in
+ * @return false if it couldn't be written
+ */
+bool dvd_mkv_blocks(struct dvd_mkv *dvd_mkv, const uint8_t *buffer, const ssize_t blocks, const uint8_t cell) {
+
+	const uint8_t *block = NULL;
+	ssize_t ix = 0;
+
+	for(ix = 0; ix < blocks; ix++) {
+
+		block = buffer + ix * DVD_VIDEO_LB_LEN;
+
+		if(dvd_vobu_parse(&dvd_mkv->dvd_vobu, block)) {
+			dvd_vobu_pts_base(&dvd_mkv->dvd_vobu, dvd_mkv->cell_start[cell], &dvd_mkv->has_base, &dvd_mkv->base);
+			continue;
+		}
+
+		if(dvd_demux(dvd_mkv->dvd_demux, (uint8_t *)block, (uint8_t *)block + DVD_VIDEO_LB_LEN, 0) == DVD_DEMUX_ERROR)
+			return false;
+
+	}
+
+	return !dvd_mkv->error;
+
+}
+
+/**
+ * Go back and write the segment's size, and the seek head with where the
+ * cues are in the room left for it
+ *
+ * @param cues position of the cues, 0 if there aren't any
+ */
+static bool dvd_mkv_seek_head(struct dvd_mkv *dvd_mkv, const uint64_t cues) {
+
+	struct dvd_mkv_buffer *head = &dvd_mkv->head;
+	const uint8_t cues_id[4] = { 0x1c, 0x53, 0xbb, 0x6b };
+	uint8_t size[8];
+	size_t seek_head = 0;
+	size_t seek = 0;
+	uint8_t ix = 0;
+
+	head->length = 0;
+
+	if(cues) {
+		seek_head = dvd_mkv_master(head, MKV_SEEK_HEAD);
+		seek = dvd_mkv_master(head, MKV_SEEK);
+		dvd_mkv_binary(head, MKV_SEEK_ID, cues_id, 4);
+		dvd_mkv_uint(head, MKV_SEEK_POSITION, cues);
+		dvd_mkv_end(head, seek);
+		dvd_mkv_end(head, seek_head);
+	}
+
+	dvd_mkv_void(head, DVD_MKV_SEEK_HEAD - head->length);
+
+	size[0] = 0x01;
+	for(ix = 1; ix < 8; ix++)
+		size[ix] = (uint8_t)(dvd_mkv->position >> (8 * (7 - ix)));
+
+	if(head->error || pwrite(dvd_mkv->fd, head->data, head->length, dvd_mkv->segment) != (ssize_t)head->length || pwrite(dvd_mkv->fd, size, 8, dvd_mkv->segment - 8) != 8) {
+		dvd_mkv->error = true;
+		return false;
+	}
+
+	return true;
+
+}
+
+/**
+ * Write the last frame, what is left of the audio, the last cluster and the
+ * cues, and free everything
+ *
+ * @return false if any of it couldn't be written
+ */
+bool dvd_mkv_close(struct dvd_mkv *dvd_mkv) {
+
+	struct dvd_mkv_buffer *head = NULL;
+	bool written = false;
+	uint32_t ix = 0;
+	size_t cues = 0;
+	uint64_t position = 0;
+	size_t point = 0;
+	size_t positions = 0;
+
+	if(dvd_mkv == NULL)
+		return false;
+
+	head = &dvd_mkv->head;
+
+	if(dvd_mkv->picture && !dvd_mkv->error)
+		dvd_mkv_frame(dvd_mkv, dvd_mkv->frame.length);
+
+	if(!dvd_mkv->error)
+		dvd_mkv_pictures(dvd_mkv);
+
+	for(ix = 0; ix < 256 && !dvd_mkv->error; ix++) {
+		if(dvd_mkv->streams[ix].type == DVD_MKV_AUDIO)
+			dvd_mkv_flush(dvd_mkv, &dvd_mkv->streams[ix]);
+	}
+
+	if(dvd_mkv->has_cluster && !dvd_mkv->error) {
+
+		head->length = 0;
+		dvd_mkv_id(head, MKV_CLUSTER);
+		dvd_mkv_size(head, dvd_mkv->cluster.length);
+
+		if(dvd_mkv_output(dvd_mkv, head))
+			dvd_mkv_output(dvd_mkv, &dvd_mkv->cluster);
+
+	}
+
+	if(dvd_mkv->cue_count && !dvd_mkv->error) {
+
+		head->length = 0;
+		position = dvd_mkv->position;
+		cues = dvd_mkv_master(head, MKV_CUES);
+
+		for(ix = 0; ix < dvd_mkv->cue_count; ix++) {
+			point = dvd_mkv_master(head, MKV_CUE_POINT);
+			dvd_mkv_uint(head, MKV_CUE_TIME, dvd_mkv->cues[ix].msecs);
+			positions = dvd_mkv_master(head, MKV_CUE_TRACK_POSITIONS);
+			dvd_mkv_uint(head, MKV_CUE_TRACK, dvd_mkv->video_track);
+			dvd_mkv_uint(head, MKV_CUE_CLUSTER_POSITION, dvd_mkv->cues[ix].position);
+			dvd_mkv_end(head, positions);
+			dvd_mkv_end(head, point);
+		}
+
+		dvd_mkv_end(head, cues);
+		dvd_mkv_output(dvd_mkv, head);
+
+	}
+
+	if(dvd_mkv->segment >= 0 && !dvd_mkv->error)
+		dvd_mkv_seek_head(dvd_mkv, cues ? position : 0);
+
+	written = !dvd_mkv->error;
+
+	dvd_demux_close(dvd_mkv->dvd_demux);
+
+	for(ix = 0; ix < 256; ix++)
+		free(dvd_mkv->streams[ix].block.data);
+
+	free(dvd_mkv->frame.data);
+	free(dvd_mkv->queue.data);
+	free(dvd_mkv->cluster.data);
+	free(dvd_mkv->head.data);
+	free(dvd_mkv->cues);
+	free(dvd_mkv);
+
+	return written;
+
+}
+
+static bool dvd_mkv_pipeline_write(void *data, const struct dvd_pipeline_blocks *dvd_pipeline_blocks) {
+
+	if(!dvd_mkv_blocks((struct dvd_mkv *)data, dvd_pipeline_blocks->buffer, dvd_pipeline_blocks->blocks, dvd_pipeline_blocks->cell)) {
+		fprintf(stderr, "* Could not write Matroska data from cell %u\n", dvd_pipeline_blocks->cell);
+		return false;
+	}
+
+	return true;
+
+}
+
+/**
+ * Remux everything a pipeline reads.  The muxer is not closed.
+ */
+bool dvd_mkv_pipeline(struct dvd_pipeline *dvd_pipeline, struct dvd_mkv *dvd_mkv) {
+
+	return dvd_pipeline_add(dvd_pipeline, "mkv", dvd_mkv_pipeline_write, NULL, dvd_mkv);
+
+}
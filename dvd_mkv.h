@@ -0,0 +1,80 @@
+#ifndef DVD_INFO_MKV_H
+#define DVD_INFO_MKV_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <unistd.h>
+#include <dvdread/dvd_reader.h>
+#include <dvdread/ifo_read.h>
+#include "dvd_session.h"
+#include "dvd_track.h"
+#include "dvd_chapter.h"
+#include "dvd_time.h"
+#include "dvd_video.h"
+#include "dvd_audio.h"
+#include "dvd_subtitles.h"
+#include "dvd_demux.h"
+#include "dvd_vobu.h"
+#include "dvd_audio_es.h"
+#include "dvd_vobsub.h"
+
+#ifndef DVD_VIDEO_LB_LEN
+#define DVD_VIDEO_LB_LEN 2048
+#endif
+
+/**
+ * Matroska remuxing
+ *
+ * Writes a track as Matroska straight from the blocks read off the disc, with
+ * nothing re-encoded: the MPEG-2 video, every active audio stream (AC3, DTS,
+ * MPEG, and 16 bit LPCM) and every active subtitle stream (VobSub), with the
+ * language of each one from the IFO, and the chapters.
+ *
+ * Everything is written front to back, so it can go to a pipe.  The header
+ * (tracks, chapters and the length from the IFO) is written when it is
+ * opened, and the segment is left with an unknown size.  Each cluster starts
+ * at an I frame, and is kept in memory until the next one starts, so it can
+ * be written with its size.  When the file can be seeked, the cues, one for
+ * each cluster, are written at the end, and the segment's size and a seek
+ * head pointing to them are written over the header.  A pipe gets no cues,
+ * since nothing could find them.
+ *
+ * Video is split into frames at the picture headers, and frames without a PTS
+ * are timed from the last one that had one, their temporal reference and how
+ * many fields each picture shown before them repeats.  Frames with a
+ * repeated field (soft telecine) are written with their own duration.
+ * Audio blocks start at the frame the substream header points to, and
+ * subpictures are put back together whole.  Times are from the start of the
+ * first chapter, carried across cells from the NAV packs.
+ *
+ * struct dvd_mkv *dvd_mkv = dvd_mkv_open(dvd_session, &dvd_track, 1, 99, fd);
+ * dvd_mkv_blocks(dvd_mkv, buffer, blocks, cell);
+ * dvd_mkv_close(dvd_mkv);
+ */
+
+// Track types
+#define DVD_MKV_VIDEO 1
+#define DVD_MKV_AUDIO 2
+#define DVD_MKV_SUBTITLE 0x11
+
+struct dvd_mkv;
+
+struct dvd_mkv *dvd_mkv_open(struct dvd_session *dvd_session, const struct dvd_track *dvd_track, const uint8_t first_chapter, const uint8_t last_chapter, const int fd);
+
+const char *dvd_mkv_language(const char *lang_code);
+
+uint8_t dvd_mkv_tracks(const struct dvd_mkv *dvd_mkv);
+
+bool dvd_mkv_blocks(struct dvd_mkv *dvd_mkv, const uint8_t *buffer, const ssize_t blocks, const uint8_t cell);
+
+bool dvd_mkv_close(struct dvd_mkv *dvd_mkv);
+
+struct dvd_pipeline;
+
+bool dvd_mkv_pipeline(struct dvd_pipeline *dvd_pipeline, struct dvd_mkv *dvd_mkv);
+
+#endif
@@ -41,3 +41,32 @@ void dvd_ogm(struct dvd_track dvd_track) {
 	}
 
 }
+
+/**
+ * The same format, for chapter points that don't come from the IFO, such as
+ * ones dvd_scenes finds
+ *
+ * @param msecs start of each chapter after the first, in order
+ * @param points number of them
+ */
+void dvd_ogm_msecs(const uint32_t *msecs, const uint16_t points) {
+
+	char chapter_start[DVD_CHAPTER_LENGTH + 1] = {'\0'};
+	uint16_t chapter_number = 1;
+	uint16_t ix = 0;
+
+	printf("CHAPTER01=00:00:00.000\n");
+	printf("CHAPTER01NAME=Chapter 01\n");
+
+	for(ix = 0; ix < points; ix++) {
+
+		chapter_number = ix + 2;
+
+		milliseconds_length_format(chapter_start, msecs[ix]);
+
+		printf("CHAPTER%02u=%s\n", chapter_number, chapter_start);
+		printf("CHAPTER%02uNAME=Chapter %02u\n", chapter_number, chapter_number);
+
+	}
+
+}
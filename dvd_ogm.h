@@ -8,4 +8,6 @@
 
 void dvd_ogm(struct dvd_track dvd_track);
 
+void dvd_ogm_msecs(const uint32_t *msecs, const uint16_t points);
+
 #endif
@@ -0,0 +1,664 @@
+#include "dvd_pipeline.h"
+
+/**
+ * Functions to read a track once and pass it on to many consumers
+ */
+
+struct dvd_pipeline_batch {
+	struct dvd_pipeline_blocks dvd_pipeline_blocks;
+	unsigned char *buffer;
+	uint8_t refs;
+};
+
+struct dvd_pipeline_consumer {
+	char name[DVD_PIPELINE_CONSUMER_NAME + 1];
+	dvd_pipeline_write_t write;
+	dvd_pipeline_close_t close;
+	void *data;
+	struct dvd_pipeline *dvd_pipeline;
+	pthread_t thread;
+	bool started;
+	bool failed;
+	bool closed;
+	struct dvd_pipeline_batch *queue[DVD_PIPELINE_QUEUE];
+	uint8_t queue_head;
+	uint8_t queue_length;
+	pthread_mutex_t lock;
+	pthread_cond_t ready;
+	pthread_cond_t space;
+};
+
+struct dvd_pipeline {
+	struct dvd_session *dvd_session;
+	uint16_t track;
+	uint8_t first_chapter;
+	uint8_t last_chapter;
+	ssize_t block_limit;
+	bool sectors;
+	uint8_t first_cell;
+	uint32_t first_sector;
+	uint8_t last_cell;
+	uint32_t last_sector;
+	struct dvd_pipeline_consumer consumers[DVD_PIPELINE_MAX_CONSUMERS];
+	uint8_t num_consumers;
+	pthread_mutex_t lock;
+	bool failed;
+};
+
+/**
+ * Set up a pipeline for a range of chapters of a track
+ *
+ * The chapter range is not checked, it has to be valid for the track.
+ *
+ * @return pipeline, or NULL if the track is invalid
+ */
+struct dvd_pipeline *dvd_pipeline_open(struct dvd_session *dvd_session, const uint16_t track_number, const uint8_t first_chapter, const uint8_t last_chapter) {
+
+	struct dvd_pipeline *dvd_pipeline = NULL;
+
+	if(dvd_session_track_ifo(dvd_session, track_number) == NULL)
+		return NULL;
+
+	dvd_pipeline = calloc(1, sizeof(*dvd_pipeline));
+	if(dvd_pipeline == NULL)
+		return NULL;
+
+	dvd_pipeline->dvd_session = dvd_session;
+	dvd_pipeline->track = track_number;
+	dvd_pipeline->first_chapter = first_chapter;
+	dvd_pipeline->last_chapter = last_chapter;
+	dvd_pipeline->block_limit = DVD_PIPELINE_BLOCK_LIMIT;
+	pthread_mutex_init(&dvd_pipeline->lock, NULL);
+
+	return dvd_pipeline;
+
+}
+
+/**
+ * Change the number of blocks read at a time.  Fewer blocks gets data to the
+ * consumers sooner (streaming), more is faster.
+ */
+void dvd_pipeline_block_limit(struct dvd_pipeline *dvd_pipeline, const ssize_t block_limit) {
+
+	if(block_limit < 1)
+		dvd_pipeline->block_limit = 1;
+	else
+		dvd_pipeline->block_limit = block_limit;
+
+}
+
+/**
+ * Only read part of the chapter range: from a sector in one cell to a sector
+ * in another (inclusive).  Cells outside of it are skipped.
+ */
+void dvd_pipeline_sectors(struct dvd_pipeline *dvd_pipeline, const uint8_t first_cell, const uint32_t first_sector, const uint8_t last_cell, const uint32_t last_sector) {
+
+	dvd_pipeline->sectors = true;
+	dvd_pipeline->first_cell = first_cell;
+	dvd_pipeline->first_sector = first_sector;
+	dvd_pipeline->last_cell = last_cell;
+	dvd_pipeline->last_sector = last_sector;
+
+}
+
+/**
+ * Get the sectors to read from a cell
+ *
+ * @return false if the cell is skipped
+ */
+static bool dvd_pipeline_cell(const struct dvd_pipeline *dvd_pipeline, const ifo_handle_t *vmg_ifo, const ifo_handle_t *vts_ifo, struct dvd_cell *dvd_cell) {
+
+	uint16_t track_number = dvd_pipeline->track;
+
+	dvd_cell->blocks = dvd_cell_blocks(vmg_ifo, vts_ifo, track_number, dvd_cell->cell);
+	dvd_cell->first_sector = dvd_cell_first_sector(vmg_ifo, vts_ifo, track_number, dvd_cell->cell);
+	dvd_cell->last_sector = dvd_cell_last_sector(vmg_ifo, vts_ifo, track_number, dvd_cell->cell);
+
+	if(!dvd_pipeline->sectors)
+		return true;
+
+	if(dvd_cell->cell < dvd_pipeline->first_cell || dvd_cell->cell > dvd_pipeline->last_cell)
+		return false;
+
+	if(dvd_cell->cell == dvd_pipeline->first_cell && dvd_pipeline->first_sector > dvd_cell->first_sector)
+		dvd_cell->first_sector = dvd_pipeline->first_sector;
+
+	if(dvd_cell->cell == dvd_pipeline->last_cell && dvd_pipeline->last_sector < dvd_cell->last_sector)
+		dvd_cell->last_sector = dvd_pipeline->last_sector;
+
+	if(dvd_cell->last_sector < dvd_cell->first_sector)
+		return false;
+
+	dvd_cell->blocks = dvd_cell->last_sector - dvd_cell->first_sector + 1;
+
+	return true;
+
+}
+
+/**
+ * Add a consumer
+ *
+ * @param name name used in error messages
+ * @param write function called with each batch
+ * @param close function called when the pipeline is finished, can be NULL
+ * @param data passed to both functions
+ * @return false if there are too many consumers already
+ */
+bool dvd_pipeline_add(struct dvd_pipeline *dvd_pipeline, const char *name, dvd_pipeline_write_t write, dvd_pipeline_close_t close, void *data) {
+
+	struct dvd_pipeline_consumer *consumer = NULL;
+
+	if(dvd_pipeline->num_consumers == DVD_PIPELINE_MAX_CONSUMERS)
+		return false;
+
+	consumer = &dvd_pipeline->consumers[dvd_pipeline->num_consumers];
+	memset(consumer, 0, sizeof(*consumer));
+
+	strncpy(consumer->name, name, DVD_PIPELINE_CONSUMER_NAME);
+	consumer->write = write;
+	consumer->close = close;
+	consumer->data = data;
+	consumer->dvd_pipeline = dvd_pipeline;
+	pthread_mutex_init(&consumer->lock, NULL);
+	pthread_cond_init(&consumer->ready, NULL);
+	pthread_cond_init(&consumer->space, NULL);
+
+	dvd_pipeline->num_consumers++;
+
+	return true;
+
+}
+
+static void dvd_pipeline_fail(struct dvd_pipeline *dvd_pipeline) {
+
+	pthread_mutex_lock(&dvd_pipeline->lock);
+	dvd_pipeline->failed = true;
+	pthread_mutex_unlock(&dvd_pipeline->lock);
+
+}
+
+static bool dvd_pipeline_failed(struct dvd_pipeline *dvd_pipeline) {
+
+	bool failed = false;
+
+	pthread_mutex_lock(&dvd_pipeline->lock);
+	failed = dvd_pipeline->failed;
+	pthread_mutex_unlock(&dvd_pipeline->lock);
+
+	return failed;
+
+}
+
+/**
+ * Let go of a batch, freeing it once every consumer is done with it
+ */
+static void dvd_pipeline_batch_release(struct dvd_pipeline *dvd_pipeline, struct dvd_pipeline_batch *batch) {
+
+	bool done = false;
+
+	pthread_mutex_lock(&dvd_pipeline->lock);
+	batch->refs--;
+	done = (batch->refs == 0);
+	pthread_mutex_unlock(&dvd_pipeline->lock);
+
+	if(done) {
+		free(batch->buffer);
+		free(batch);
+	}
+
+}
+
+/**
+ * Queue a batch for a consumer, waiting if its queue is full.  A NULL batch
+ * tells the consumer there is nothing left.
+ */
+static void dvd_pipeline_push(struct dvd_pipeline_consumer *consumer, struct dvd_pipeline_batch *batch) {
+
+	pthread_mutex_lock(&consumer->lock);
+
+	while(consumer->queue_length == DVD_PIPELINE_QUEUE)
+		pthread_cond_wait(&consumer->space, &consumer->lock);
+
+	consumer->queue[(consumer->queue_head + consumer->queue_length) % DVD_PIPELINE_QUEUE] = batch;
+	consumer->queue_length++;
+
+	pthread_cond_signal(&consumer->ready);
+	pthread_mutex_unlock(&consumer->lock);
+
+}
+
+static void *dvd_pipeline_consumer_thread(void *arg) {
+
+	struct dvd_pipeline_consumer *consumer = (struct dvd_pipeline_consumer *)arg;
+	struct dvd_pipeline_batch *batch = NULL;
+
+	while(true) {
+
+		pthread_mutex_lock(&consumer->lock);
+
+		while(consumer->queue_length == 0)
+			pthread_cond_wait(&consumer->ready, &consumer->lock);
+
+		batch = consumer->queue[consumer->queue_head];
+		consumer->queue_head = (consumer->queue_head + 1) % DVD_PIPELINE_QUEUE;
+		consumer->queue_length--;
+
+		pthread_cond_signal(&consumer->space);
+		pthread_mutex_unlock(&consumer->lock);
+
+		if(batch == NULL)
+			break;
+
+		// Once a consumer fails, it keeps emptying its queue so that the
+		// reader is never left waiting on it
+		if(!consumer->failed && !consumer->write(consumer->data, &batch->dvd_pipeline_blocks)) {
+			fprintf(stderr, "* Pipeline consumer %s failed\n", consumer->name);
+			consumer->failed = true;
+			dvd_pipeline_fail(consumer->dvd_pipeline);
+		}
+
+		dvd_pipeline_batch_release(consumer->dvd_pipeline, batch);
+
+	}
+
+	return NULL;
+
+}
+
+/**
+ * Read the chapters, passing everything to the consumers, and wait for all
+ * of them to finish.
+ *
+ * Reading stops at the first read error, or when a consumer fails.
+ *
+ * @return true if everything was read and every consumer succeeded
+ */
+bool dvd_pipeline_run(struct dvd_pipeline *dvd_pipeline) {
+
+	struct dvd_session *dvd_session = dvd_pipeline->dvd_session;
+	ifo_handle_t *vmg_ifo = dvd_session_vmg_ifo(dvd_session);
+	ifo_handle_t *vts_ifo = dvd_session_track_ifo(dvd_session, dvd_pipeline->track);
+	uint16_t track_number = dvd_pipeline->track;
+	uint16_t vts = dvd_vts_ifo_number(vmg_ifo, track_number);
+	uint8_t first_cell = dvd_chapter_first_cell(vmg_ifo, vts_ifo, track_number, dvd_pipeline->first_chapter);
+	uint8_t last_cell = dvd_chapter_last_cell(vmg_ifo, vts_ifo, track_number, dvd_pipeline->last_chapter);
+	struct dvd_pipeline_consumer *consumer = NULL;
+	struct dvd_pipeline_batch *batch = NULL;
+	struct dvd_chapter dvd_chapter;
+	struct dvd_cell dvd_cell;
+	dvd_file_t *dvdread_vts_file = NULL;
+	ssize_t track_blocks = 0;
+	ssize_t blocks_read = 0;
+	ssize_t cell_blocks_read = 0;
+	ssize_t read_blocks = 0;
+	ssize_t dvdread_read_blocks = 0;
+	int offset = 0;
+	uint8_t ix = 0;
+
+	dvdread_vts_file = DVDOpenFile(dvd_session_dvdread(dvd_session), vts, DVD_READ_TITLE_VOBS);
+	if(dvdread_vts_file == NULL) {
+		fprintf(stderr, "* Could not open VOBs for VTS %u\n", vts);
+		return false;
+	}
+
+	for(dvd_cell.cell = first_cell; dvd_cell.cell < last_cell + 1; dvd_cell.cell++) {
+		if(dvd_pipeline_cell(dvd_pipeline, vmg_ifo, vts_ifo, &dvd_cell))
+			track_blocks += dvd_cell.blocks;
+	}
+
+	for(ix = 0; ix < dvd_pipeline->num_consumers; ix++) {
+
+		consumer = &dvd_pipeline->consumers[ix];
+
+		if(pthread_create(&consumer->thread, NULL, dvd_pipeline_consumer_thread, consumer) != 0) {
+			fprintf(stderr, "* Could not start pipeline consumer %s\n", consumer->name);
+			dvd_pipeline_fail(dvd_pipeline);
+			break;
+		}
+
+		consumer->started = true;
+
+	}
+
+	for(dvd_chapter.chapter = dvd_pipeline->first_chapter; dvd_chapter.chapter < dvd_pipeline->last_chapter + 1 && !dvd_pipeline_failed(dvd_pipeline); dvd_chapter.chapter++) {
+
+		dvd_chapter.first_cell = dvd_chapter_first_cell(vmg_ifo, vts_ifo, track_number, dvd_chapter.chapter);
+		dvd_chapter.last_cell = dvd_chapter_last_cell(vmg_ifo, vts_ifo, track_number, dvd_chapter.chapter);
+
+		for(dvd_cell.cell = dvd_chapter.first_cell; dvd_cell.cell < dvd_chapter.last_cell + 1 && !dvd_pipeline_failed(dvd_pipeline); dvd_cell.cell++) {
+
+			if(!dvd_pipeline_cell(dvd_pipeline, vmg_ifo, vts_ifo, &dvd_cell))
+				continue;
+
+			// The last sector is listed before the first, there's nothing to read
+			if(dvd_cell.last_sector < dvd_cell.first_sector)
+				continue;
+
+			offset = (int)dvd_cell.first_sector;
+			cell_blocks_read = 0;
+
+			while(cell_blocks_read < dvd_cell.blocks && !dvd_pipeline_failed(dvd_pipeline)) {
+
+				read_blocks = dvd_pipeline->block_limit;
+
+				if(read_blocks > (dvd_cell.blocks - cell_blocks_read))
+					read_blocks = dvd_cell.blocks - cell_blocks_read;
+
+				batch = calloc(1, sizeof(*batch));
+				if(batch != NULL)
+					batch->buffer = malloc((size_t)read_blocks * DVD_VIDEO_LB_LEN);
+
+				if(batch == NULL || batch->buffer == NULL) {
+					fprintf(stderr, "Couldn't allocate memory\n");
+					free(batch);
+					dvd_pipeline_fail(dvd_pipeline);
+					break;
+				}
+
+				dvdread_read_blocks = DVDReadBlocks(dvdread_vts_file, offset, (size_t)read_blocks, batch->buffer);
+
+				if(dvdread_read_blocks != read_blocks) {
+					if(dvdread_read_blocks <= 0)
+						fprintf(stderr, "* Could not read data from cell %u\n", dvd_cell.cell);
+					else
+						fprintf(stderr, "*** Asked for %ld and only got %ld\n", read_blocks, dvdread_read_blocks);
+					free(batch->buffer);
+					free(batch);
+					dvd_pipeline_fail(dvd_pipeline);
+					break;
+				}
+
+				offset += dvdread_read_blocks;
+				cell_blocks_read += dvdread_read_blocks;
+				blocks_read += dvdread_read_blocks;
+
+				batch->dvd_pipeline_blocks.buffer = batch->buffer;
+				batch->dvd_pipeline_blocks.blocks = dvdread_read_blocks;
+				batch->dvd_pipeline_blocks.sector = (uint32_t)(offset - dvdread_read_blocks);
+				batch->dvd_pipeline_blocks.vts = vts;
+				batch->dvd_pipeline_blocks.track = track_number;
+				batch->dvd_pipeline_blocks.chapter = dvd_chapter.chapter;
+				batch->dvd_pipeline_blocks.cell = dvd_cell.cell;
+				batch->dvd_pipeline_blocks.cell_first_sector = dvd_cell.first_sector;
+				batch->dvd_pipeline_blocks.cell_last_sector = dvd_cell.last_sector;
+				batch->dvd_pipeline_blocks.cell_blocks = dvd_cell.blocks;
+				batch->dvd_pipeline_blocks.track_blocks = track_blocks;
+				batch->dvd_pipeline_blocks.blocks_read = blocks_read;
+
+				// Nothing is listening, the read is all there is to do
+				if(dvd_pipeline->num_consumers == 0) {
+					free(batch->buffer);
+					free(batch);
+					continue;
+				}
+
+				batch->refs = dvd_pipeline->num_consumers;
+
+				for(ix = 0; ix < dvd_pipeline->num_consumers; ix++) {
+					if(dvd_pipeline->consumers[ix].started)
+						dvd_pipeline_push(&dvd_pipeline->consumers[ix], batch);
+					else
+						dvd_pipeline_batch_release(dvd_pipeline, batch);
+				}
+
+			}
+
+		}
+
+	}
+
+	DVDCloseFile(dvdread_vts_file);
+
+	for(ix = 0; ix < dvd_pipeline->num_consumers; ix++) {
+
+		consumer = &dvd_pipeline->consumers[ix];
+
+		if(!consumer->started)
+			continue;
+
+		dvd_pipeline_push(consumer, NULL);
+		pthread_join(consumer->thread, NULL);
+		consumer->started = false;
+
+	}
+
+	for(ix = 0; ix < dvd_pipeline->num_consumers; ix++) {
+
+		consumer = &dvd_pipeline->consumers[ix];
+		consumer->closed = true;
+
+		if(consumer->close != NULL && !consumer->close(consumer->data)) {
+			fprintf(stderr, "* Pipeline consumer %s failed\n", consumer->name);
+			dvd_pipeline_fail(dvd_pipeline);
+		}
+
+	}
+
+	return !dvd_pipeline_failed(dvd_pipeline);
+
+}
+
+void dvd_pipeline_close(struct dvd_pipeline *dvd_pipeline) {
+
+	uint8_t ix = 0;
+
+	if(dvd_pipeline == NULL)
+		return;
+
+	// Consumers still need to clean up if the pipeline was never run
+	for(ix = 0; ix < dvd_pipeline->num_consumers; ix++) {
+		if(!dvd_pipeline->consumers[ix].closed && dvd_pipeline->consumers[ix].close != NULL)
+			dvd_pipeline->consumers[ix].close(dvd_pipeline->consumers[ix].data);
+		pthread_mutex_destroy(&dvd_pipeline->consumers[ix].lock);
+		pthread_cond_destroy(&dvd_pipeline->consumers[ix].ready);
+		pthread_cond_destroy(&dvd_pipeline->consumers[ix].space);
+	}
+
+	pthread_mutex_destroy(&dvd_pipeline->lock);
+
+	free(dvd_pipeline);
+
+}
+
+/** File descriptor writer **/
+
+static bool dvd_pipeline_fd_write(void *data, const struct dvd_pipeline_blocks *dvd_pipeline_blocks) {
+
+	int fd = *(int *)data;
+	ssize_t bytes = dvd_pipeline_blocks->blocks * DVD_VIDEO_LB_LEN;
+	ssize_t bytes_written = 0;
+	ssize_t retval = 0;
+
+	while(bytes_written < bytes) {
+
+		retval = write(fd, dvd_pipeline_blocks->buffer + bytes_written, (size_t)(bytes - bytes_written));
+
+		if(retval <= 0) {
+			fprintf(stderr, "* Could not write data from cell %u\n", dvd_pipeline_blocks->cell);
+			return false;
+		}
+
+		bytes_written += retval;
+
+	}
+
+	return true;
+
+}
+
+static bool dvd_pipeline_free_data(void *data) {
+
+	free(data);
+
+	return true;
+
+}
+
+/**
+ * Write everything to a file descriptor (a file, a pipe, 1 for stdout).  The
+ * descriptor is not closed.
+ */
+bool dvd_pipeline_add_fd(struct dvd_pipeline *dvd_pipeline, const int fd) {
+
+	int *data = malloc(sizeof(int));
+
+	if(data == NULL)
+		return false;
+
+	*data = fd;
+
+	if(!dvd_pipeline_add(dvd_pipeline, "fd", dvd_pipeline_fd_write, dvd_pipeline_free_data, data)) {
+		free(data);
+		return false;
+	}
+
+	return true;
+
+}
+
+/** MD5 checksum **/
+
+static bool dvd_pipeline_md5_write(void *data, const struct dvd_pipeline_blocks *dvd_pipeline_blocks) {
+
+	dvd_md5_update((struct dvd_md5 *)data, dvd_pipeline_blocks->buffer, (size_t)dvd_pipeline_blocks->blocks * DVD_VIDEO_LB_LEN);
+
+	return true;
+
+}
+
+static bool dvd_pipeline_md5_close(void *data) {
+
+	dvd_md5_final((struct dvd_md5 *)data);
+
+	return true;
+
+}
+
+/**
+ * Checksum everything that is read.  The digest is ready in dvd_md5 once
+ * dvd_pipeline_run() returns.
+ */
+bool dvd_pipeline_add_md5(struct dvd_pipeline *dvd_pipeline, struct dvd_md5 *dvd_md5) {
+
+	dvd_md5_init(dvd_md5);
+
+	return dvd_pipeline_add(dvd_pipeline, "md5", dvd_pipeline_md5_write, dvd_pipeline_md5_close, dvd_md5);
+
+}
+
+/** Statistics **/
+
+struct dvd_pipeline_stats_data {
+	struct dvd_pipeline_stats *dvd_pipeline_stats;
+	struct timespec start;
+	uint8_t cell;
+};
+
+static uint32_t dvd_pipeline_msecs_since(const struct timespec *start) {
+
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (uint32_t)((now.tv_sec - start->tv_sec) * 1000 + (now.tv_nsec - start->tv_nsec) / 1000000);
+
+}
+
+static bool dvd_pipeline_stats_write(void *data, const struct dvd_pipeline_blocks *dvd_pipeline_blocks) {
+
+	struct dvd_pipeline_stats_data *stats_data = (struct dvd_pipeline_stats_data *)data;
+	struct dvd_pipeline_stats *dvd_pipeline_stats = stats_data->dvd_pipeline_stats;
+
+	if(dvd_pipeline_stats->batches == 0)
+		clock_gettime(CLOCK_MONOTONIC, &stats_data->start);
+
+	if(dvd_pipeline_blocks->cell != stats_data->cell) {
+		stats_data->cell = dvd_pipeline_blocks->cell;
+		dvd_pipeline_stats->cells++;
+	}
+
+	dvd_pipeline_stats->blocks += dvd_pipeline_blocks->blocks;
+	dvd_pipeline_stats->batches++;
+	dvd_pipeline_stats->msecs = dvd_pipeline_msecs_since(&stats_data->start);
+
+	return true;
+
+}
+
+/**
+ * Count what goes through the pipeline, and how long it takes from the
+ * first batch to the last one.
+ */
+bool dvd_pipeline_add_stats(struct dvd_pipeline *dvd_pipeline, struct dvd_pipeline_stats *dvd_pipeline_stats) {
+
+	struct dvd_pipeline_stats_data *data = calloc(1, sizeof(*data));
+
+	if(data == NULL)
+		return false;
+
+	memset(dvd_pipeline_stats, 0, sizeof(*dvd_pipeline_stats));
+	data->dvd_pipeline_stats = dvd_pipeline_stats;
+
+	if(!dvd_pipeline_add(dvd_pipeline, "stats", dvd_pipeline_stats_write, dvd_pipeline_free_data, data)) {
+		free(data);
+		return false;
+	}
+
+	return true;
+
+}
+
+/** Progress display **/
+
+struct dvd_pipeline_progress_data {
+	uint8_t cell;
+	ssize_t percent;
+};
+
+/**
+ * Only goes to the terminal when the cell or the percentage changes, so a
+ * pipeline reading a few blocks at a time isn't held up by it.
+ */
+static bool dvd_pipeline_progress_write(void *data, const struct dvd_pipeline_blocks *dvd_pipeline_blocks) {
+
+	struct dvd_pipeline_progress_data *progress = (struct dvd_pipeline_progress_data *)data;
+	ssize_t percent = 0;
+
+	if(dvd_pipeline_blocks->cell != progress->cell) {
+		progress->cell = dvd_pipeline_blocks->cell;
+		progress->percent = -1;
+		printf("        Chapter: %02u, Cell: %02u, VTS: %u, Filesize: %zd, Blocks: %zd, Sectors: %u to %u\n", dvd_pipeline_blocks->chapter, dvd_pipeline_blocks->cell, dvd_pipeline_blocks->vts, dvd_pipeline_blocks->cell_blocks * DVD_VIDEO_LB_LEN, dvd_pipeline_blocks->cell_blocks, dvd_pipeline_blocks->cell_first_sector, dvd_pipeline_blocks->cell_last_sector);
+	}
+
+	percent = dvd_pipeline_blocks->blocks_read * 100 / dvd_pipeline_blocks->track_blocks;
+
+	if(percent == progress->percent)
+		return true;
+
+	progress->percent = percent;
+
+	printf("Progress %zd%%\r", percent);
+	fflush(stdout);
+
+	return true;
+
+}
+
+/**
+ * Display each cell as it is started, and the progress, on stdout
+ */
+bool dvd_pipeline_add_progress(struct dvd_pipeline *dvd_pipeline) {
+
+	struct dvd_pipeline_progress_data *data = calloc(1, sizeof(*data));
+
+	if(data == NULL)
+		return false;
+
+	if(!dvd_pipeline_add(dvd_pipeline, "progress", dvd_pipeline_progress_write, dvd_pipeline_free_data, data)) {
+		free(data);
+		return false;
+	}
+
+	return true;
+
+}
@@ -0,0 +1,108 @@
+#ifndef DVD_INFO_PIPELINE_H
+#define DVD_INFO_PIPELINE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <dvdread/dvd_reader.h>
+#include <dvdread/ifo_read.h>
+#include "dvd_session.h"
+#include "dvd_md5.h"
+
+#ifndef DVD_VIDEO_LB_LEN
+#define DVD_VIDEO_LB_LEN 2048
+#endif
+
+/**
+ * libdvdinfo read pipeline
+ *
+ * Reads a range of chapters of a track from the disc once, and hands every
+ * batch of blocks to each of the consumers that are added to it.  Every
+ * consumer runs on its own thread, and is fed through its own queue, so a
+ * slow one (writing to a network drive, decoding) doesn't hold up the others
+ * until its queue is full.  The read itself is never done more than once.
+ *
+ * Feature modules add their own consumers on top of dvd_pipeline_add(), such
+ * as dvd_demux_pipeline() and dvd_mkv_pipeline().
+ *
+ * struct dvd_pipeline *dvd_pipeline = dvd_pipeline_open(dvd_session, 1, 1, 99);
+ * dvd_pipeline_add_fd(dvd_pipeline, fd);
+ * dvd_pipeline_add_md5(dvd_pipeline, &dvd_md5);
+ * dvd_pipeline_run(dvd_pipeline);
+ * dvd_pipeline_close(dvd_pipeline);
+ */
+
+// Blocks read at a time, 2048 * 512 = 1 MB
+#define DVD_PIPELINE_BLOCK_LIMIT 512
+
+// Batches waiting for each consumer
+#define DVD_PIPELINE_QUEUE 8
+
+#define DVD_PIPELINE_MAX_CONSUMERS 16
+#define DVD_PIPELINE_CONSUMER_NAME 31
+
+/**
+ * One batch of blocks, and where on the disc it came from
+ */
+struct dvd_pipeline_blocks {
+	const unsigned char *buffer;
+	ssize_t blocks;
+	uint32_t sector;
+	uint16_t vts;
+	uint16_t track;
+	uint8_t chapter;
+	uint8_t cell;
+	uint32_t cell_first_sector;
+	uint32_t cell_last_sector;
+	ssize_t cell_blocks;
+	ssize_t track_blocks;
+	ssize_t blocks_read;
+};
+
+struct dvd_pipeline_stats {
+	ssize_t blocks;
+	uint32_t batches;
+	uint8_t cells;
+	uint32_t msecs;
+};
+
+/**
+ * Called for every batch, in order, on the consumer's thread.  Returning
+ * false stops the pipeline.
+ */
+typedef bool (*dvd_pipeline_write_t)(void *data, const struct dvd_pipeline_blocks *dvd_pipeline_blocks);
+
+/**
+ * Called once after the last batch, from the thread that ran the pipeline.
+ * Returning false marks the pipeline as failed.  Can be NULL.
+ */
+typedef bool (*dvd_pipeline_close_t)(void *data);
+
+struct dvd_pipeline;
+
+struct dvd_pipeline *dvd_pipeline_open(struct dvd_session *dvd_session, const uint16_t track_number, const uint8_t first_chapter, const uint8_t last_chapter);
+
+void dvd_pipeline_block_limit(struct dvd_pipeline *dvd_pipeline, const ssize_t block_limit);
+
+void dvd_pipeline_sectors(struct dvd_pipeline *dvd_pipeline, const uint8_t first_cell, const uint32_t first_sector, const uint8_t last_cell, const uint32_t last_sector);
+
+bool dvd_pipeline_add(struct dvd_pipeline *dvd_pipeline, const char *name, dvd_pipeline_write_t write, dvd_pipeline_close_t close, void *data);
+
+bool dvd_pipeline_add_fd(struct dvd_pipeline *dvd_pipeline, const int fd);
+
+bool dvd_pipeline_add_md5(struct dvd_pipeline *dvd_pipeline, struct dvd_md5 *dvd_md5);
+
+bool dvd_pipeline_add_stats(struct dvd_pipeline *dvd_pipeline, struct dvd_pipeline_stats *dvd_pipeline_stats);
+
+bool dvd_pipeline_add_progress(struct dvd_pipeline *dvd_pipeline);
+
+bool dvd_pipeline_run(struct dvd_pipeline *dvd_pipeline);
+
+void dvd_pipeline_close(struct dvd_pipeline *dvd_pipeline);
+
+#endif
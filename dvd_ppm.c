@@ -4,84 +4,834 @@
 #include <unistd.h>
 #include <string.h>
 #include <ctype.h>
-#include <sys/ioctl.h>
 #include <sys/stat.h>
-#include <dirent.h>
+#include <sys/types.h>
 #include <fcntl.h>
 #include <stdbool.h>
 #include <getopt.h>
 #include <limits.h>
-#include <sys/mman.h>
 #include <inttypes.h>
 #include <errno.h>
+#include <sys/uio.h>
 #ifdef __linux__
 #include <linux/cdrom.h>
 #include "dvd_drive.h"
 #endif
 #include <dvdread/dvd_reader.h>
 #include <dvdread/ifo_read.h>
-#include "mpeg2dec/mpeg2.h"
-#include "mpeg2dec/mpeg2convert.h"
+#include <mpeg2dec/mpeg2.h>
+#include <mpeg2dec/mpeg2convert.h>
 #include "dvd_info.h"
 #include "dvd_device.h"
-#include "dvd_drive.h"
-#include "dvd_vmg_ifo.h"
 #include "dvd_track.h"
 #include "dvd_chapter.h"
 #include "dvd_cell.h"
-#include "dvd_video.h"
-#include "dvd_audio.h"
-#include "dvd_subtitles.h"
-#include "dvd_time.h"
+#include "dvd_session.h"
+#include "dvd_pipeline.h"
+#include "dvd_demux.h"
+#include "dvd_vobu.h"
+#include "dvd_preview.h"
+#include "dvd_workers.h"
+#ifndef VERSION
+#define VERSION "1.2"
+#endif
 
 #ifndef DVD_VIDEO_LB_LEN
 #define DVD_VIDEO_LB_LEN 2048
 #endif
 
-// libmpeg2 reads 4096 bytes at a time, do the same here
-#define DVD_READ_BLOCKS 1
-#define DVD_BUFFER_SIZE ( DVD_VIDEO_LB_LEN * DVD_READ_BLOCKS )
+#define DVD_INFO_PROGRAM "dvd_ppm"
 
-// #define DVD_COPY_BLOCK_LIMIT 512
+#define DVD_PPM_MAX_THUMBNAILS 999
+#define DVD_PPM_MAX_JOBS 64
+#define DVD_PPM_MAX_COLUMNS 32
+#define DVD_PPM_SHEET_WIDTH 160
+#define DVD_PPM_Y4M_HEADER 80
 
-// 2048 * 512 = 1 MB
-// #define DVD_COPY_BYTES_LIMIT ( DVD_COPY_BLOCK_LIMIT * DVD_VIDEO_LB_LEN )
+// The last picture coding type to decode, the rest are skipped
+#define DVD_PPM_DECODE_ALL 0
+#define DVD_PPM_DECODE_I 1
+#define DVD_PPM_DECODE_IP 2
 
 int main(int, char **);
-void dvd_track_info(struct dvd_track *dvd_track, const uint16_t track_number, const ifo_handle_t *vmg_ifo, const ifo_handle_t *vts_ifo);
 void print_usage(char *binary);
+void print_version(char *binary);
 
-static void save_ppm (unsigned int width, unsigned int height, uint8_t * buf, int num, bool dvd)
-{
-    char filename[100];
-    FILE * ppmfile;
-
-    if(dvd)
-    	sprintf (filename, "ppm/%d.ppm.dvd", num);
-    else
-    	sprintf (filename, "ppm/%d.ppm.vob", num);
-    ppmfile = fopen (filename, "wb");
-    if (!ppmfile) {
-	fprintf (stderr, "Could not open file \"%s\".\n", filename);
-	exit (1);
-    }
-    fprintf (ppmfile, "P6\n%d %d\n255\n", width, height);
-    fwrite (buf, 3 * width, height, ppmfile);
-    fclose (ppmfile);
-}
-
-struct dvd_copy {
+struct dvd_ppm {
 	uint16_t track;
 	uint8_t first_chapter;
 	uint8_t last_chapter;
-	uint8_t first_cell;
-	uint8_t last_cell;
-	ssize_t blocks;
-	ssize_t filesize;
-	char filename[PATH_MAX];
-	int fd;
+	ssize_t block_limit;
+	char directory[PATH_MAX];
+	mpeg2dec_t *mpeg2dec;
+	const mpeg2_info_t *mpeg2_info;
+	uint32_t frames;
+	uint8_t chapter;
+	uint32_t thumbnail;
+	bool thumbnail_saved;
+	uint16_t preview_width;
+	uint16_t preview_height;
+	struct dvd_preview *dvd_preview;
+	uint8_t *preview_rgb;
+	uint16_t sheet_columns;
+	struct dvd_preview_sheet *dvd_preview_sheet;
+	uint32_t tile;
+	int y4m_fd;
+	bool y4m_header;
+	const char *y4m_rate;
+	uint32_t y4m_sar_width;
+	uint32_t y4m_sar_height;
+	uint8_t coding_types;
+	FILE *frames_file;
+	struct dvd_demux *dvd_demux;
+	struct dvd_vobu dvd_vobu;
+	bool has_base;
+	int64_t base;
+	uint32_t cell_start[256];
+};
+
+/**
+ * Save a decoded frame as a PPM image
+ */
+static bool dvd_ppm_save(struct dvd_ppm *dvd_ppm, const unsigned int width, const unsigned int height, const uint8_t *buf) {
+
+	char filename[PATH_MAX + 32];
+	FILE *ppm_file = NULL;
+	bool saved = true;
+
+	if(dvd_ppm->thumbnail)
+		snprintf(filename, sizeof(filename), "%s/thumbnail_%03u.ppm", dvd_ppm->directory, dvd_ppm->thumbnail);
+	else if(dvd_ppm->chapter)
+		snprintf(filename, sizeof(filename), "%s/chapter_%02u_%06u.ppm", dvd_ppm->directory, dvd_ppm->chapter, dvd_ppm->frames + 1);
+	else
+		snprintf(filename, sizeof(filename), "%s/%06u.ppm", dvd_ppm->directory, dvd_ppm->frames + 1);
+
+	ppm_file = fopen(filename, "wb");
+
+	if(ppm_file == NULL) {
+		fprintf(stderr, "Could not open file %s\n", filename);
+		return false;
+	}
+
+	fprintf(ppm_file, "P6\n%u %u\n255\n", width, height);
+
+	if(fwrite(buf, 3 * width, height, ppm_file) != height)
+		saved = false;
+
+	if(fclose(ppm_file) != 0)
+		saved = false;
+
+	if(!saved) {
+		fprintf(stderr, "Could not write to %s\n", filename);
+		return false;
+	}
+
+	dvd_ppm->frames++;
+
+	if(dvd_ppm->thumbnail)
+		dvd_ppm->thumbnail_saved = true;
+
+	return true;
+
+}
+
+/**
+ * Write all of a set of buffers, picking up where a short write left off
+ */
+static bool dvd_ppm_writev(const int fd, struct iovec *iov, int iovcnt) {
+
+	ssize_t written = 0;
+
+	while(iovcnt > 0) {
+
+		written = writev(fd, iov, iovcnt);
+
+		if(written < 0 && errno == EINTR)
+			continue;
+		if(written < 0)
+			return false;
+
+		while(iovcnt > 0 && (size_t)written >= iov->iov_len) {
+			written -= (ssize_t)iov->iov_len;
+			iov++;
+			iovcnt--;
+		}
+
+		if(iovcnt > 0) {
+			iov->iov_base = (uint8_t *)iov->iov_base + written;
+			iov->iov_len -= (size_t)written;
+		}
+
+	}
+
+	return true;
+
+}
+
+/**
+ * Write a frame as YUV4MPEG2, with the planes straight from the decoder and
+ * one write for each frame.  The stream header is written with the first
+ * one, once the frame size and whether it is interlaced are known.
+ */
+static bool dvd_ppm_y4m(struct dvd_ppm *dvd_ppm) {
+
+	const mpeg2_sequence_t *sequence = dvd_ppm->mpeg2_info->sequence;
+	const mpeg2_fbuf_t *display_fbuf = dvd_ppm->mpeg2_info->display_fbuf;
+	const mpeg2_picture_t *display_picture = dvd_ppm->mpeg2_info->display_picture;
+	char header[DVD_PPM_Y4M_HEADER + 1] = {'\0'};
+	char frame_header[] = "FRAME\n";
+	char interlacing = 'p';
+	struct iovec iov[4];
+	size_t luma = (size_t)sequence->width * sequence->height;
+	size_t chroma = (size_t)sequence->chroma_width * sequence->chroma_height;
+
+	if(!dvd_ppm->y4m_header) {
+
+		// Progressive, top field first or bottom field first
+		if(display_picture != NULL && !(display_picture->flags & PIC_FLAG_PROGRESSIVE_FRAME))
+			interlacing = (display_picture->flags & PIC_FLAG_TOP_FIELD_FIRST) ? 't' : 'b';
+
+		snprintf(header, sizeof(header), "YUV4MPEG2 W%u H%u F%s I%c A%u:%u C420mpeg2\n", sequence->width, sequence->height, dvd_ppm->y4m_rate, interlacing, dvd_ppm->y4m_sar_width, dvd_ppm->y4m_sar_height);
+
+		iov[0].iov_base = header;
+		iov[0].iov_len = strlen(header);
+
+		if(!dvd_ppm_writev(dvd_ppm->y4m_fd, iov, 1)) {
+			fprintf(stderr, "Could not write YUV4MPEG2 header\n");
+			return false;
+		}
+
+		dvd_ppm->y4m_header = true;
+
+	}
+
+	iov[0].iov_base = frame_header;
+	iov[0].iov_len = strlen(frame_header);
+	iov[1].iov_base = display_fbuf->buf[0];
+	iov[1].iov_len = luma;
+	iov[2].iov_base = display_fbuf->buf[1];
+	iov[2].iov_len = chroma;
+	iov[3].iov_base = display_fbuf->buf[2];
+	iov[3].iov_len = chroma;
+
+	if(!dvd_ppm_writev(dvd_ppm->y4m_fd, iov, 4)) {
+		fprintf(stderr, "Could not write frame %u\n", dvd_ppm->frames + 1);
+		return false;
+	}
+
+	dvd_ppm->frames++;
+
+	return true;
+
+}
+
+/**
+ * Save the frame that is ready to be displayed.  Previews are scaled straight
+ * from the YUV planes, into their own image or a tile on the contact sheet.
+ */
+static bool dvd_ppm_frame(struct dvd_ppm *dvd_ppm) {
+
+	const mpeg2_sequence_t *sequence = dvd_ppm->mpeg2_info->sequence;
+	const mpeg2_fbuf_t *display_fbuf = dvd_ppm->mpeg2_info->display_fbuf;
+	struct dvd_preview_frame dvd_preview_frame;
+
+	if(dvd_ppm->y4m_fd != -1)
+		return dvd_ppm_y4m(dvd_ppm);
+
+	if(!dvd_ppm->preview_width)
+		return dvd_ppm_save(dvd_ppm, sequence->width, sequence->height, display_fbuf->buf[0]);
+
+	dvd_preview_frame.y = display_fbuf->buf[0];
+	dvd_preview_frame.u = display_fbuf->buf[1];
+	dvd_preview_frame.v = display_fbuf->buf[2];
+	dvd_preview_frame.width = (uint16_t)sequence->width;
+	dvd_preview_frame.height = (uint16_t)sequence->height;
+	dvd_preview_frame.chroma_width = (uint16_t)sequence->chroma_width;
+	dvd_preview_frame.chroma_height = (uint16_t)sequence->chroma_height;
+
+	if(dvd_ppm->dvd_preview_sheet != NULL) {
+
+		if(!dvd_preview_scale(dvd_ppm->dvd_preview, &dvd_preview_frame, dvd_preview_sheet_tile(dvd_ppm->dvd_preview_sheet, dvd_ppm->tile), dvd_preview_sheet_stride(dvd_ppm->dvd_preview_sheet))) {
+			fprintf(stderr, "Could not scale frame\n");
+			return false;
+		}
+
+		dvd_ppm->frames++;
+		dvd_ppm->thumbnail_saved = true;
+
+		return true;
+
+	}
+
+	if(!dvd_preview_scale(dvd_ppm->dvd_preview, &dvd_preview_frame, dvd_ppm->preview_rgb, (size_t)dvd_ppm->preview_width * 3)) {
+		fprintf(stderr, "Could not scale frame\n");
+		return false;
+	}
+
+	return dvd_ppm_save(dvd_ppm, dvd_ppm->preview_width, dvd_ppm->preview_height, dvd_ppm->preview_rgb);
+
+}
+
+/**
+ * List a saved frame, its picture type and its presentation time from the
+ * start of the first chapter, for when only some of them are decoded
+ */
+static void dvd_ppm_frame_index(struct dvd_ppm *dvd_ppm) {
+
+	const mpeg2_picture_t *display_picture = dvd_ppm->mpeg2_info->display_picture;
+	const char coding_types[8] = { '?', 'I', 'P', 'B', 'D', '?', '?', '?' };
+	char length[DVD_CHAPTER_LENGTH + 1] = {'\0'};
+	uint64_t pts = 0;
+
+	if(dvd_ppm->frames_file == NULL || display_picture == NULL)
+		return;
+
+	if(!(display_picture->flags & PIC_FLAG_TAGS)) {
+		fprintf(dvd_ppm->frames_file, "%06u.ppm %c - -\n", dvd_ppm->frames, coding_types[display_picture->flags & PIC_MASK_CODING_TYPE]);
+		return;
+	}
+
+	pts = ((uint64_t)display_picture->tag2 << 32) | display_picture->tag;
+	milliseconds_length_format(length, (uint32_t)(pts / 90));
+
+	fprintf(dvd_ppm->frames_file, "%06u.ppm %c %s %" PRIu64 "\n", dvd_ppm->frames, coding_types[display_picture->flags & PIC_MASK_CODING_TYPE], length, pts);
+
+}
+
+/**
+ * Run the decoder over what it has been given, and save every frame that is
+ * ready to be displayed
+ */
+static bool dvd_ppm_parse(struct dvd_ppm *dvd_ppm) {
+
+	mpeg2_state_t state;
+
+	while(true) {
+
+		state = mpeg2_parse(dvd_ppm->mpeg2dec);
+
+		switch(state) {
+
+			case STATE_BUFFER:
+				return true;
+
+			// Skipped pictures aren't decoded at all
+			case STATE_PICTURE:
+				if(dvd_ppm->coding_types)
+					mpeg2_skip(dvd_ppm->mpeg2dec, (dvd_ppm->mpeg2_info->current_picture->flags & PIC_MASK_CODING_TYPE) > dvd_ppm->coding_types);
+				break;
+
+			case STATE_SEQUENCE:
+				if(!dvd_ppm->preview_width && dvd_ppm->y4m_fd == -1)
+					mpeg2_convert(dvd_ppm->mpeg2dec, mpeg2convert_rgb24, NULL);
+				break;
+
+			case STATE_SLICE:
+			case STATE_END:
+			case STATE_INVALID_END:
+				// Thumbnails only need the first picture
+				if(dvd_ppm->thumbnail_saved)
+					break;
+				if(dvd_ppm->mpeg2_info->display_fbuf == NULL)
+					break;
+				if(dvd_ppm->mpeg2_info->display_picture != NULL && (dvd_ppm->mpeg2_info->display_picture->flags & PIC_FLAG_SKIP))
+					break;
+				if(!dvd_ppm_frame(dvd_ppm))
+					return false;
+				dvd_ppm_frame_index(dvd_ppm);
+				break;
+
+			default:
+				break;
+
+		}
+
+	}
+
+}
+
+/**
+ * Hand the video stream, a whole batch of blocks at a time, to libmpeg2
+ */
+static bool dvd_ppm_decode(void *data, const struct dvd_demux_packet *dvd_demux_packet) {
+
+	struct dvd_ppm *dvd_ppm = (struct dvd_ppm *)data;
+	uint8_t *buf = (uint8_t *)dvd_demux_packet->buffer;
+
+	int64_t ticks = 0;
+
+	// libmpeg2 hands the tag to the picture that starts next in the buffer
+	if(dvd_demux_packet->has_pts && dvd_ppm->has_base) {
+		ticks = dvd_ppm->base + (int64_t)dvd_demux_packet->pts;
+		if(ticks < 0)
+			ticks = 0;
+		mpeg2_tag_picture(dvd_ppm->mpeg2dec, (uint32_t)ticks, (uint32_t)((uint64_t)ticks >> 32));
+	}
+
+	mpeg2_buffer(dvd_ppm->mpeg2dec, buf, buf + dvd_demux_packet->length);
+
+	return dvd_ppm_parse(dvd_ppm);
+
+}
+
+/**
+ * Feed the blocks to the demuxer, and keep the time from the NAV packs.  The
+ * PTS can start over at a cell boundary, so the elapsed time in them carries
+ * it on (dvd_vobu_pts_base()).
+ */
+static bool dvd_ppm_pipeline_write(void *data, const struct dvd_pipeline_blocks *dvd_pipeline_blocks) {
+
+	struct dvd_ppm *dvd_ppm = (struct dvd_ppm *)data;
+	uint8_t *block = NULL;
+	ssize_t ix = 0;
+
+	for(ix = 0; ix < dvd_pipeline_blocks->blocks; ix++) {
+
+		block = (uint8_t *)dvd_pipeline_blocks->buffer + ix * DVD_VIDEO_LB_LEN;
+
+		if(dvd_vobu_parse(&dvd_ppm->dvd_vobu, block)) {
+			dvd_vobu_pts_base(&dvd_ppm->dvd_vobu, dvd_ppm->cell_start[dvd_pipeline_blocks->cell], &dvd_ppm->has_base, &dvd_ppm->base);
+			continue;
+		}
+
+		if(dvd_demux(dvd_ppm->dvd_demux, block, block + DVD_VIDEO_LB_LEN, 0) == DVD_DEMUX_ERROR)
+			return false;
+
+	}
+
+	return true;
+
+}
+
+/**
+ * One thumbnail or chapter for a worker, and what came out of it
+ */
+struct dvd_ppm_job {
+	uint32_t index;
+	uint32_t number;
+	uint32_t msecs;
+	bool ok;
+	uint8_t cell;
+	uint32_t sector;
+	uint32_t blocks;
+	uint32_t frames;
+};
+
+/**
+ * The jobs all the workers take from, in order
+ */
+struct dvd_ppm_jobs {
+	struct dvd_ppm *dvd_ppm;
+	struct dvd_ppm_job *job;
+	uint32_t jobs;
+	bool thumbnails;
+	const struct dvd_vobu_index *dvd_vobu_index;
+};
+
+/**
+ * Every worker has its own demuxer and decoder, since neither can be shared
+ * between threads.  The first one borrows the decoder main() set up.
+ */
+struct dvd_ppm_worker {
+	struct dvd_ppm dvd_ppm;
+	struct dvd_session *dvd_session;
+	dvd_file_t *dvdread_vts_file;
+	struct dvd_demux *dvd_ppm_demux;
 };
 
+/**
+ * Save one thumbnail, from the I frame at the start of the VOBU a time is in
+ *
+ * Only the blocks up to the end of that picture are read, then the decoder
+ * is flushed with a sequence end code so it displays it.
+ */
+static bool dvd_ppm_thumbnail(struct dvd_ppm *dvd_ppm, struct dvd_session *dvd_session, const struct dvd_vobu_index *dvd_vobu_index, dvd_file_t *dvdread_vts_file, struct dvd_demux *dvd_ppm_demux, struct dvd_ppm_job *dvd_ppm_job) {
+
+	struct dvd_vobu dvd_vobu;
+	uint8_t sequence_end[4] = { 0x00, 0x00, 0x01, 0xb7 };
+	bool decoded = false;
+
+	dvd_ppm->thumbnail = dvd_ppm_job->number;
+	dvd_ppm->tile = dvd_ppm_job->index;
+	dvd_ppm->thumbnail_saved = false;
+
+	memset(&dvd_vobu, 0, sizeof(dvd_vobu));
+
+	// Start with a clean decoder, that waits for a sequence header
+	mpeg2_reset(dvd_ppm->mpeg2dec, 1);
+
+	decoded = dvd_vobu_index_sample(dvd_session, dvd_vobu_index, dvdread_vts_file, dvd_ppm_job->msecs, &dvd_vobu, dvd_ppm_demux);
+
+	dvd_ppm_job->cell = dvd_vobu.cell;
+	dvd_ppm_job->sector = dvd_vobu.sector;
+	dvd_ppm_job->blocks = dvd_vobu_first_ref_blocks(&dvd_vobu);
+
+	if(decoded && !dvd_ppm->thumbnail_saved) {
+		mpeg2_buffer(dvd_ppm->mpeg2dec, sequence_end, sequence_end + sizeof(sequence_end));
+		decoded = dvd_ppm_parse(dvd_ppm);
+	}
+
+	if(decoded && !dvd_ppm->thumbnail_saved)
+		fprintf(stderr, "* Could not decode a picture for thumbnail %u\n", dvd_ppm->thumbnail);
+
+	if(dvd_ppm->thumbnail_saved)
+		dvd_ppm_job->frames = 1;
+
+	return decoded;
+
+}
+
+/**
+ * Decode every frame of one chapter, with its own read pipeline.  The frames
+ * are numbered within the chapter, and renamed once all of them are done.
+ */
+static bool dvd_ppm_chapter(struct dvd_ppm *dvd_ppm, struct dvd_session *dvd_session, struct dvd_demux *dvd_ppm_demux, struct dvd_ppm_job *dvd_ppm_job) {
+
+	struct dvd_pipeline *dvd_pipeline = NULL;
+	uint8_t sequence_end[4] = { 0x00, 0x00, 0x01, 0xb7 };
+	bool decoded = false;
+
+	dvd_ppm->chapter = (uint8_t)dvd_ppm_job->number;
+	dvd_ppm->frames = 0;
+
+	mpeg2_reset(dvd_ppm->mpeg2dec, 1);
+	dvd_demux_reset(dvd_ppm_demux);
+
+	dvd_pipeline = dvd_pipeline_open(dvd_session, dvd_ppm->track, dvd_ppm->chapter, dvd_ppm->chapter);
+	if(dvd_pipeline == NULL)
+		return false;
+
+	dvd_pipeline_block_limit(dvd_pipeline, dvd_ppm->block_limit);
+	dvd_demux_pipeline(dvd_pipeline, dvd_ppm_demux);
+
+	decoded = dvd_pipeline_run(dvd_pipeline);
+
+	dvd_pipeline_close(dvd_pipeline);
+
+	if(decoded) {
+		mpeg2_buffer(dvd_ppm->mpeg2dec, sequence_end, sequence_end + sizeof(sequence_end));
+		decoded = dvd_ppm_parse(dvd_ppm);
+	}
+
+	dvd_ppm_job->frames = dvd_ppm->frames;
+
+	return decoded;
+
+}
+
+static bool dvd_ppm_worker_open(void *data, void *worker, const uint16_t index, struct dvd_session *dvd_session) {
+
+	struct dvd_ppm_jobs *dvd_ppm_jobs = (struct dvd_ppm_jobs *)data;
+	struct dvd_ppm_worker *dvd_ppm_worker = (struct dvd_ppm_worker *)worker;
+	struct dvd_ppm *dvd_ppm = &dvd_ppm_worker->dvd_ppm;
+	uint16_t vts = 0;
+
+	*dvd_ppm = *dvd_ppm_jobs->dvd_ppm;
+	dvd_ppm_worker->dvd_session = dvd_session;
+
+	if(index > 0) {
+		dvd_ppm->dvd_preview = NULL;
+		dvd_ppm->preview_rgb = NULL;
+		dvd_ppm->mpeg2dec = mpeg2_init();
+		if(dvd_ppm->mpeg2dec == NULL) {
+			fprintf(stderr, "%s: Could not create an MPEG-2 decoder\n", DVD_INFO_PROGRAM);
+			return false;
+		}
+		dvd_ppm->mpeg2_info = mpeg2_info(dvd_ppm->mpeg2dec);
+		if(dvd_ppm->preview_width) {
+			dvd_ppm->dvd_preview = dvd_preview_open(dvd_ppm->preview_width, dvd_ppm->preview_height);
+			dvd_ppm->preview_rgb = malloc((size_t)dvd_ppm->preview_width * dvd_ppm->preview_height * 3);
+			if(dvd_ppm->dvd_preview == NULL || dvd_ppm->preview_rgb == NULL) {
+				fprintf(stderr, "Couldn't allocate memory\n");
+				return false;
+			}
+		}
+	}
+
+	if(dvd_ppm_jobs->thumbnails) {
+		vts = dvd_vts_ifo_number(dvd_session_vmg_ifo(dvd_session), dvd_ppm->track);
+		dvd_ppm_worker->dvdread_vts_file = DVDOpenFile(dvd_session_dvdread(dvd_session), vts, DVD_READ_TITLE_VOBS);
+		if(dvd_ppm_worker->dvdread_vts_file == NULL) {
+			fprintf(stderr, "* Could not open VOBs for VTS %u\n", vts);
+			return false;
+		}
+	}
+
+	dvd_ppm_worker->dvd_ppm_demux = dvd_demux_open(DVD_DEMUX_VIDEO, dvd_ppm_decode, dvd_ppm);
+	if(dvd_ppm_worker->dvd_ppm_demux == NULL)
+		return false;
+
+	return true;
+
+}
+
+static bool dvd_ppm_worker_job(void *data, void *worker, const uint32_t job) {
+
+	struct dvd_ppm_jobs *dvd_ppm_jobs = (struct dvd_ppm_jobs *)data;
+	struct dvd_ppm_worker *dvd_ppm_worker = (struct dvd_ppm_worker *)worker;
+	struct dvd_ppm_job *dvd_ppm_job = &dvd_ppm_jobs->job[job];
+
+	if(dvd_ppm_jobs->thumbnails)
+		dvd_ppm_job->ok = dvd_ppm_thumbnail(&dvd_ppm_worker->dvd_ppm, dvd_ppm_worker->dvd_session, dvd_ppm_jobs->dvd_vobu_index, dvd_ppm_worker->dvdread_vts_file, dvd_ppm_worker->dvd_ppm_demux, dvd_ppm_job);
+	else
+		dvd_ppm_job->ok = dvd_ppm_chapter(&dvd_ppm_worker->dvd_ppm, dvd_ppm_worker->dvd_session, dvd_ppm_worker->dvd_ppm_demux, dvd_ppm_job);
+
+	return dvd_ppm_job->ok;
+
+}
+
+static void dvd_ppm_worker_close(void *data, void *worker, const uint16_t index) {
+
+	struct dvd_ppm_worker *dvd_ppm_worker = (struct dvd_ppm_worker *)worker;
+	struct dvd_ppm *dvd_ppm = &dvd_ppm_worker->dvd_ppm;
+
+	(void)data;
+
+	dvd_demux_close(dvd_ppm_worker->dvd_ppm_demux);
+
+	if(dvd_ppm_worker->dvdread_vts_file != NULL)
+		DVDCloseFile(dvd_ppm_worker->dvdread_vts_file);
+
+	// The first worker's decoder is main()'s
+	if(index == 0)
+		return;
+
+	if(dvd_ppm->mpeg2dec != NULL)
+		mpeg2_close(dvd_ppm->mpeg2dec);
+	dvd_preview_close(dvd_ppm->dvd_preview);
+	free(dvd_ppm->preview_rgb);
+
+}
+
+/**
+ * Split the jobs across a number of workers, and wait for all of them
+ */
+static bool dvd_ppm_run(struct dvd_ppm *dvd_ppm, struct dvd_session *dvd_session, struct dvd_ppm_jobs *dvd_ppm_jobs, const bool thumbnails, const uint16_t workers) {
+
+	struct dvd_workers dvd_workers;
+	uint32_t job = 0;
+	bool ok = false;
+
+	dvd_ppm_jobs->dvd_ppm = dvd_ppm;
+	dvd_ppm_jobs->thumbnails = thumbnails;
+
+	memset(&dvd_workers, 0, sizeof(dvd_workers));
+	dvd_workers.jobs = dvd_ppm_jobs->jobs;
+	dvd_workers.size = sizeof(struct dvd_ppm_worker);
+	dvd_workers.open = dvd_ppm_worker_open;
+	dvd_workers.job = dvd_ppm_worker_job;
+	dvd_workers.close = dvd_ppm_worker_close;
+	dvd_workers.data = dvd_ppm_jobs;
+
+	ok = dvd_workers_run(dvd_session, &dvd_workers, workers);
+
+	for(job = 0; job < dvd_ppm_jobs->jobs; job++)
+		dvd_ppm->frames += dvd_ppm_jobs->job[job].frames;
+
+	return ok;
+
+}
+
+/**
+ * Save thumbnails at the start of each chapter, or at evenly spaced points in
+ * the track, and list them in order once they are all done
+ */
+static bool dvd_ppm_thumbnails(struct dvd_ppm *dvd_ppm, struct dvd_session *dvd_session, const uint16_t thumbnails, const uint16_t workers) {
+
+	ifo_handle_t *vmg_ifo = dvd_session_vmg_ifo(dvd_session);
+	ifo_handle_t *vts_ifo = dvd_session_track_ifo(dvd_session, dvd_ppm->track);
+	uint32_t track_msecs = dvd_track_msecs(vmg_ifo, vts_ifo, dvd_ppm->track);
+	struct dvd_ppm_jobs dvd_ppm_jobs;
+	struct dvd_ppm_job *dvd_ppm_job = NULL;
+	struct dvd_vobu_index dvd_vobu_index;
+	struct dvd_preview_sheet dvd_preview_sheet;
+	char sheet_filename[PATH_MAX + 32];
+	char length[DVD_CHAPTER_LENGTH + 1] = {'\0'};
+	uint32_t cell_start[256];
+	uint8_t chapter = 0;
+	uint32_t ix = 0;
+	bool saved = false;
+
+	memset(&dvd_ppm_jobs, 0, sizeof(dvd_ppm_jobs));
+
+	// Index the track once, so every thumbnail is a lookup
+	if(vts_ifo == NULL || !dvd_vobu_index_track(dvd_session, dvd_ppm->track, &dvd_vobu_index)) {
+		fprintf(stderr, "* Could not index the VOBUs of track %u\n", dvd_ppm->track);
+		if(vts_ifo != NULL)
+			dvd_vobu_index_free(&dvd_vobu_index);
+		return false;
+	}
+	dvd_ppm_jobs.dvd_vobu_index = &dvd_vobu_index;
+
+	dvd_cell_starts(vmg_ifo, vts_ifo, dvd_ppm->track, 1, cell_start);
+
+	dvd_ppm_jobs.jobs = thumbnails ? thumbnails : (uint32_t)(dvd_ppm->last_chapter - dvd_ppm->first_chapter + 1);
+	dvd_ppm_jobs.job = calloc(dvd_ppm_jobs.jobs, sizeof(*dvd_ppm_jobs.job));
+	if(dvd_ppm_jobs.job == NULL) {
+		fprintf(stderr, "Couldn't allocate memory\n");
+		dvd_vobu_index_free(&dvd_vobu_index);
+		return false;
+	}
+
+	for(ix = 0; ix < dvd_ppm_jobs.jobs; ix++) {
+
+		dvd_ppm_job = &dvd_ppm_jobs.job[ix];
+		dvd_ppm_job->index = ix;
+
+		// Chapters start on a cell
+		if(thumbnails == 0) {
+			chapter = (uint8_t)(dvd_ppm->first_chapter + ix);
+			dvd_ppm_job->msecs = cell_start[dvd_chapter_first_cell(vmg_ifo, vts_ifo, dvd_ppm->track, chapter)];
+			dvd_ppm_job->number = chapter;
+		} else {
+			dvd_ppm_job->msecs = (uint32_t)((uint64_t)track_msecs * (2 * ix + 1) / (2 * thumbnails));
+			dvd_ppm_job->number = ix + 1;
+		}
+
+	}
+
+	// Every thumbnail goes in its own tile, in order
+	if(dvd_ppm->sheet_columns) {
+		if(!dvd_preview_sheet_init(&dvd_preview_sheet, dvd_ppm->sheet_columns, dvd_ppm_jobs.jobs, dvd_ppm->preview_width, dvd_ppm->preview_height)) {
+			fprintf(stderr, "Could not create a contact sheet\n");
+			dvd_preview_sheet_free(&dvd_preview_sheet);
+			free(dvd_ppm_jobs.job);
+			dvd_vobu_index_free(&dvd_vobu_index);
+			return false;
+		}
+		dvd_ppm->dvd_preview_sheet = &dvd_preview_sheet;
+	}
+
+	saved = dvd_ppm_run(dvd_ppm, dvd_session, &dvd_ppm_jobs, true, workers);
+
+	if(dvd_ppm->sheet_columns) {
+		snprintf(sheet_filename, sizeof(sheet_filename), "%s/contact_sheet.ppm", dvd_ppm->directory);
+		if(dvd_preview_sheet_save(&dvd_preview_sheet, sheet_filename)) {
+			printf("Contact sheet: %s, Columns: %u, Rows: %u, Size: %ux%u\n", sheet_filename, dvd_preview_sheet.columns, dvd_preview_sheet.rows, dvd_preview_sheet.sheet_width, dvd_preview_sheet.sheet_height);
+		} else {
+			fprintf(stderr, "Could not write to %s\n", sheet_filename);
+			saved = false;
+		}
+		dvd_preview_sheet_free(&dvd_preview_sheet);
+		dvd_ppm->dvd_preview_sheet = NULL;
+	}
+
+	for(ix = 0; ix < dvd_ppm_jobs.jobs; ix++) {
+
+		dvd_ppm_job = &dvd_ppm_jobs.job[ix];
+
+		if(!dvd_ppm_job->ok)
+			continue;
+
+		milliseconds_length_format(length, dvd_ppm_job->msecs);
+		printf("Thumbnail: %03u, Time: %s, Cell: %02u, Sector: %u, Blocks: %u\n", dvd_ppm_job->number, length, dvd_ppm_job->cell, dvd_ppm_job->sector, dvd_ppm_job->blocks);
+
+	}
+
+	free(dvd_ppm_jobs.job);
+	dvd_vobu_index_free(&dvd_vobu_index);
+
+	return saved;
+
+}
+
+/**
+ * Decode chapters in parallel, then number all the frames in order, the same
+ * as a single pass would
+ */
+static bool dvd_ppm_chapters(struct dvd_ppm *dvd_ppm, struct dvd_session *dvd_session, const uint16_t workers) {
+
+	struct dvd_ppm_jobs dvd_ppm_jobs;
+	struct dvd_ppm_job *dvd_ppm_job = NULL;
+	char chapter_filename[PATH_MAX + 32];
+	char filename[PATH_MAX + 16];
+	uint32_t frame = 0;
+	uint32_t ix = 0;
+	uint32_t frames = 0;
+	bool decoded = false;
+
+	memset(&dvd_ppm_jobs, 0, sizeof(dvd_ppm_jobs));
+
+	dvd_ppm_jobs.jobs = (uint32_t)(dvd_ppm->last_chapter - dvd_ppm->first_chapter + 1);
+	dvd_ppm_jobs.job = calloc(dvd_ppm_jobs.jobs, sizeof(*dvd_ppm_jobs.job));
+	if(dvd_ppm_jobs.job == NULL) {
+		fprintf(stderr, "Couldn't allocate memory\n");
+		return false;
+	}
+
+	for(ix = 0; ix < dvd_ppm_jobs.jobs; ix++)
+		dvd_ppm_jobs.job[ix].number = dvd_ppm->first_chapter + ix;
+
+	decoded = dvd_ppm_run(dvd_ppm, dvd_session, &dvd_ppm_jobs, false, workers);
+
+	for(ix = 0; ix < dvd_ppm_jobs.jobs; ix++) {
+
+		dvd_ppm_job = &dvd_ppm_jobs.job[ix];
+
+		printf("Chapter: %02u, Frames: %u\n", dvd_ppm_job->number, dvd_ppm_job->frames);
+
+		for(frame = 1; frame < dvd_ppm_job->frames + 1; frame++) {
+
+			frames++;
+
+			snprintf(chapter_filename, sizeof(chapter_filename), "%s/chapter_%02u_%06u.ppm", dvd_ppm->directory, dvd_ppm_job->number, frame);
+			snprintf(filename, sizeof(filename), "%s/%06u.ppm", dvd_ppm->directory, frames);
+
+			if(rename(chapter_filename, filename) != 0) {
+				fprintf(stderr, "Could not rename %s to %s\n", chapter_filename, filename);
+				decoded = false;
+			}
+
+		}
+
+	}
+
+	free(dvd_ppm_jobs.job);
+
+	return decoded;
+
+}
+
+/**
+ * The sample aspect ratio: the display aspect ratio, spread over the frame
+ * size the IFO gives (8:9 for 4:3 NTSC, 32:27 for 16:9 NTSC, and so on)
+ */
+static void dvd_ppm_sar(struct dvd_ppm *dvd_ppm, const struct dvd_video *dvd_video) {
+
+	uint32_t width = 4;
+	uint32_t height = 3;
+	uint32_t a = 0;
+	uint32_t b = 0;
+	uint32_t r = 0;
+
+	if(strcmp(dvd_video->aspect_ratio, "16:9") == 0) {
+		width = 16;
+		height = 9;
+	}
+
+	// Unknown, so leave it to the player
+	if(dvd_video->width == 0 || dvd_video->height == 0) {
+		dvd_ppm->y4m_sar_width = 0;
+		dvd_ppm->y4m_sar_height = 0;
+		return;
+	}
+
+	width *= dvd_video->height;
+	height *= dvd_video->width;
+
+	a = width;
+	b = height;
+	while(b) {
+		r = a % b;
+		a = b;
+		b = r;
+	}
+
+	dvd_ppm->y4m_sar_width = width / a;
+	dvd_ppm->y4m_sar_height = height / a;
+
+}
+
 int main(int argc, char **argv) {
 
 	/**
@@ -95,34 +845,55 @@ int main(int argc, char **argv) {
 	int opt = 0;
 	opterr = 1;
 	const char *str_options;
-	str_options = "c:ht:";
+	str_options = "b:c:f:hj:o:S:t:T:VW:y:";
 	uint8_t arg_first_chapter = 1;
 	uint8_t arg_last_chapter = 99;
 	char *token = NULL;
-	struct dvd_copy dvd_copy;
+	bool opt_thumbnails = false;
+	uint16_t arg_thumbnails = 0;
+	uint16_t arg_jobs = 1;
+	bool p_dvd_ppm = true;
+	const char *arg_y4m_filename = NULL;
+	struct dvd_ppm dvd_ppm;
 
 	struct option long_options[] = {
 
+		{ "blocks", required_argument, 0, 'b' },
 		{ "chapters", required_argument, 0, 'c' },
+		{ "frames", required_argument, 0, 'f' },
+		{ "jobs", required_argument, 0, 'j' },
+		{ "output", required_argument, 0, 'o' },
+		{ "sheet", required_argument, 0, 'S' },
 		{ "track", required_argument, 0, 't' },
+		{ "thumbnails", required_argument, 0, 'T' },
+		{ "width", required_argument, 0, 'W' },
+		{ "y4m", required_argument, 0, 'y' },
+		{ "help", no_argument, 0, 'h' },
+		{ "version", no_argument, 0, 'V' },
 		{ 0, 0, 0, 0 }
 
 	};
 
-	dvd_copy.track = 1;
-	dvd_copy.first_chapter = 1;
-	dvd_copy.last_chapter = 99;
-	dvd_copy.first_cell = 1;
-	dvd_copy.last_cell = 1;
-	dvd_copy.blocks = 0;
-	dvd_copy.filesize = 0;
-	strncpy(dvd_copy.filename, "dvd_track_01.vob", 17);
-	dvd_copy.fd = -1;
+	memset(&dvd_ppm, 0, sizeof(dvd_ppm));
+	dvd_ppm.track = 1;
+	dvd_ppm.first_chapter = 1;
+	dvd_ppm.last_chapter = 99;
+	dvd_ppm.block_limit = DVD_PIPELINE_BLOCK_LIMIT;
+	snprintf(dvd_ppm.directory, PATH_MAX, "ppm");
+	dvd_ppm.y4m_fd = -1;
 
 	while((opt = getopt_long(argc, argv, str_options, long_options, &long_index )) != -1) {
 
 		switch(opt) {
 
+			case 'b':
+				dvd_ppm.block_limit = (ssize_t)strtoumax(optarg, NULL, 0);
+				if(dvd_ppm.block_limit < 1) {
+					fprintf(stderr, "Blocks to read at a time must be at least 1\n");
+					return 1;
+				}
+				break;
+
 			case 'c':
 				opt_chapter_number = true;
 				token = strtok(optarg, "-"); {
@@ -149,18 +920,88 @@ int main(int argc, char **argv) {
 
 				break;
 
+			case 'f':
+				if(strcmp(optarg, "all") == 0) {
+					dvd_ppm.coding_types = DVD_PPM_DECODE_ALL;
+				} else if(strcmp(optarg, "ip") == 0) {
+					dvd_ppm.coding_types = DVD_PPM_DECODE_IP;
+				} else if(strcmp(optarg, "i") == 0) {
+					dvd_ppm.coding_types = DVD_PPM_DECODE_I;
+				} else {
+					fprintf(stderr, "Frames must be one of: all, ip, i\n");
+					return 1;
+				}
+				break;
+
 			case 'h':
-				print_usage("dvd_copy");
+				print_usage(DVD_INFO_PROGRAM);
 				return 0;
 
+			case 'j':
+				arg_jobs = (uint16_t)strtoumax(optarg, NULL, 0);
+				if(arg_jobs < 1 || arg_jobs > DVD_PPM_MAX_JOBS) {
+					fprintf(stderr, "Jobs must be between 1 and %u\n", DVD_PPM_MAX_JOBS);
+					return 1;
+				}
+				break;
+
+			case 'o':
+				if(strlen(optarg) >= PATH_MAX) {
+					fprintf(stderr, "Output directory name is too long\n");
+					return 1;
+				}
+				snprintf(dvd_ppm.directory, PATH_MAX, "%s", optarg);
+				break;
+
+			case 'S':
+				dvd_ppm.sheet_columns = (uint16_t)strtoumax(optarg, NULL, 0);
+				if(dvd_ppm.sheet_columns < 1 || dvd_ppm.sheet_columns > DVD_PPM_MAX_COLUMNS) {
+					fprintf(stderr, "Contact sheet columns must be between 1 and %u\n", DVD_PPM_MAX_COLUMNS);
+					return 1;
+				}
+				break;
+
 			case 't':
 				opt_track_number = true;
 				arg_track_number = (uint16_t)strtoumax(optarg, NULL, 0);
 				break;
 
+			case 'T':
+				opt_thumbnails = true;
+				if(strcmp(optarg, "chapters") == 0) {
+					arg_thumbnails = 0;
+				} else {
+					arg_thumbnails = (uint16_t)strtoumax(optarg, NULL, 0);
+					if(arg_thumbnails < 1 || arg_thumbnails > DVD_PPM_MAX_THUMBNAILS) {
+						fprintf(stderr, "Thumbnails must be \"chapters\" or between 1 and %u\n", DVD_PPM_MAX_THUMBNAILS);
+						return 1;
+					}
+				}
+				break;
+
+			case 'V':
+				print_version(DVD_INFO_PROGRAM);
+				return 0;
+
+			case 'y':
+				arg_y4m_filename = optarg;
+				if(strcmp(optarg, "-") == 0) {
+					p_dvd_ppm = false;
+					fprintf(stderr, "[%s] outputting YUV4MPEG2 stream to stdout\n", DVD_INFO_PROGRAM);
+				}
+				break;
+
+			case 'W':
+				dvd_ppm.preview_width = (uint16_t)strtoumax(optarg, NULL, 0);
+				if(dvd_ppm.preview_width < DVD_PREVIEW_MIN_WIDTH || dvd_ppm.preview_width > DVD_PREVIEW_MAX_WIDTH) {
+					fprintf(stderr, "Preview width must be between %u and %u\n", DVD_PREVIEW_MIN_WIDTH, DVD_PREVIEW_MAX_WIDTH);
+					return 1;
+				}
+				break;
+
 			// ignore unknown arguments
 			case '?':
-				print_usage("dvd_copy");
+				print_usage(DVD_INFO_PROGRAM);
 				return 1;
 
 			// let getopt_long set the variable
@@ -172,469 +1013,322 @@ int main(int argc, char **argv) {
 
 	}
 
-	const char *device_filename = DEFAULT_DVD_DEVICE;
-
-	if (argv[optind])
-		device_filename = argv[optind];
+	// A stream is every frame, as it is decoded, and nothing else
+	if(arg_y4m_filename != NULL && (opt_thumbnails || dvd_ppm.preview_width || dvd_ppm.sheet_columns || arg_jobs > 1)) {
+		fprintf(stderr, "%s: YUV4MPEG2 output can't be used with thumbnails, previews or jobs\n", DVD_INFO_PROGRAM);
+		return 1;
+	}
 
-	if(access(device_filename, F_OK) != 0) {
-		fprintf(stderr, "cannot access %s\n", device_filename);
+	// Thumbnails are I frames already, and a stream has a fixed frame rate
+	if(dvd_ppm.coding_types && (opt_thumbnails || arg_y4m_filename != NULL || arg_jobs > 1)) {
+		fprintf(stderr, "%s: Decoding some of the frames can't be used with thumbnails, YUV4MPEG2 output or jobs\n", DVD_INFO_PROGRAM);
 		return 1;
 	}
 
-	// Check to see if device can be opened
-	int dvd_fd = 0;
-	dvd_fd = dvd_device_open(device_filename);
-	if(dvd_fd < 0) {
-		fprintf(stderr, "dvd_copy: error opening %s\n", device_filename);
+	if(dvd_ppm.sheet_columns && !opt_thumbnails) {
+		fprintf(stderr, "%s: A contact sheet needs thumbnails (-T)\n", DVD_INFO_PROGRAM);
 		return 1;
 	}
-	dvd_device_close(dvd_fd);
 
+	// Contact sheets are always previews
+	if(dvd_ppm.sheet_columns && !dvd_ppm.preview_width)
+		dvd_ppm.preview_width = DVD_PPM_SHEET_WIDTH;
 
-#ifdef __linux__
+	const char *device_filename = DEFAULT_DVD_DEVICE;
 
-	// Poll drive status if it is hardware
-	if(dvd_device_is_hardware(device_filename)) {
+	if (argv[optind])
+		device_filename = argv[optind];
 
-		// Wait for the drive to become ready
-		if(!dvd_drive_has_media(device_filename)) {
+	if(arg_y4m_filename == NULL && mkdir(dvd_ppm.directory, 0755) != 0 && errno != EEXIST) {
+		fprintf(stderr, "%s: Could not create directory %s\n", DVD_INFO_PROGRAM, dvd_ppm.directory);
+		return 1;
+	}
+
+	// Open the DVD, the VMG IFO and check the drive status
+	struct dvd_session *dvd_session = NULL;
+	int session_error = DVD_SESSION_OK;
 
+	dvd_session = dvd_session_open(device_filename, &session_error);
+
+	if(dvd_session == NULL) {
+
+#ifdef __linux__
+		if(session_error == DVD_SESSION_ERR_NO_MEDIA) {
 			fprintf(stderr, "drive status: ");
 			dvd_drive_display_status(device_filename);
-
 			return 1;
-
 		}
-
-	}
-
 #endif
 
-	dvd_reader_t *dvdread_dvd = NULL;
-	dvdread_dvd = DVDOpen(device_filename);
-
-	if(!dvdread_dvd) {
-		printf("* dvdread could not open %s\n", device_filename);
+		fprintf(stderr, "%s: %s: %s\n", DVD_INFO_PROGRAM, device_filename, dvd_session_strerror(session_error));
 		return 1;
-	}
-
-	ifo_handle_t *vmg_ifo = NULL;
-	vmg_ifo = ifoOpen(dvdread_dvd, 0);
-
-	if(vmg_ifo == NULL) {
-		printf("* Could not open IFO zero\n");
-		DVDClose(dvdread_dvd);
-		return 1;
-	}
-
-	printf("Disc Title: %s\n", dvd_title(device_filename));
 
-	uint16_t num_ifos = 1;
-	num_ifos = vmg_ifo->vts_atrt->nr_of_vtss;
-
-	if(num_ifos < 1) {
-		printf("* DVD has no title IFOs?!\n");
-		printf("* Most likely a bug in libdvdread or a bad master or problems reading the disc\n");
-		ifoClose(vmg_ifo);
-		DVDClose(dvdread_dvd);
-		return 1;
 	}
 
 	// DVD
 	struct dvd_info dvd_info;
-	memset(&dvd_info, 0, sizeof(dvd_info));
-	dvd_info.tracks = dvd_tracks(vmg_ifo);
-	dvd_info.longest_track = 1;
-	dvd_info.video_title_sets = dvd_video_title_sets(vmg_ifo);
-	dvd_info.tracks = dvd_tracks(vmg_ifo);
-
-	// Track
-	struct dvd_track dvd_track;
-	memset(&dvd_track, 0, sizeof(dvd_track));
-
-	struct dvd_track dvd_tracks[DVD_MAX_TRACKS];
-	memset(&dvd_tracks, 0, sizeof(dvd_track) * dvd_info.tracks);
+	dvd_session_info(dvd_session, &dvd_info);
 
-	// Cells
-	struct dvd_cell dvd_cell;
-	dvd_cell.cell = 1;
-	memset(dvd_cell.length, '\0', sizeof(dvd_cell.length));
-	snprintf(dvd_cell.length, DVD_CELL_LENGTH + 1, "00:00:00.000");
-	dvd_cell.msecs = 0;
+	if(p_dvd_ppm)
+		printf("Disc Title: %s\n", dvd_info.title);
 
-	// Open first IFO
-	uint16_t vts = 1;
-	ifo_handle_t *vts_ifo = NULL;
-
-	vts_ifo = ifoOpen(dvdread_dvd, vts);
-	if(vts_ifo == NULL) {
-		printf("* Could not open VTS_IFO for track %u\n", 1);
-		return 1;
-	}
-	ifoClose(vts_ifo);
-	vts_ifo = NULL;
-
-	// Create an array of all the IFOs
-	ifo_handle_t *vts_ifos[DVD_MAX_VTS_IFOS];
-	vts_ifos[0] = NULL;
-
-	for(vts = 1; vts < dvd_info.video_title_sets + 1; vts++) {
-
-		vts_ifos[vts] = ifoOpen(dvdread_dvd, vts);
-
-		if(!vts_ifos[vts]) {
-			vts_ifos[vts] = NULL;
-		} else if(!ifo_is_vts(vts_ifos[vts])) {
-			ifoClose(vts_ifos[vts]);
-			vts_ifos[vts] = NULL;
-		}
-
-	}
-	
 	// Exit if track number requested does not exist
-	if(opt_track_number && (arg_track_number > dvd_info.tracks)) {
-		fprintf(stderr, "dvd_copy: Invalid track number %d\n", arg_track_number);
-		fprintf(stderr, "dvd_copy: Valid track numbers: 1 to %u\n", dvd_info.tracks);
-		ifoClose(vmg_ifo);
-		DVDClose(dvdread_dvd);
+	if(opt_track_number && (arg_track_number > dvd_info.tracks || arg_track_number < 1)) {
+		fprintf(stderr, "%s: Invalid track number %d\n", DVD_INFO_PROGRAM, arg_track_number);
+		fprintf(stderr, "%s: Valid track numbers: 1 to %u\n", DVD_INFO_PROGRAM, dvd_info.tracks);
+		dvd_session_close(dvd_session);
 		return 1;
 	} else if(opt_track_number) {
-		dvd_copy.track = arg_track_number;
-	}
-
-	uint16_t ix = 0;
-	uint16_t track = 1;
-	
-	uint32_t longest_msecs = 0;
-	
-	for(ix = 0, track = 1; ix < dvd_info.tracks; ix++, track++) {
- 
-		vts = dvd_vts_ifo_number(vmg_ifo, ix + 1);
-		vts_ifo = vts_ifos[vts];
-		dvd_track_info(&dvd_tracks[ix], track, vmg_ifo, vts_ifo);
-
-		if(dvd_tracks[ix].msecs > longest_msecs) {
-			dvd_info.longest_track = track;
-			longest_msecs = dvd_tracks[ix].msecs;
-		}
-
+		dvd_ppm.track = arg_track_number;
 	}
 
 	// Set the track number to rip if none is passed as an argument
 	if(!opt_track_number)
-		dvd_copy.track = dvd_info.longest_track;
-	
-	dvd_track = dvd_tracks[dvd_copy.track - 1];
+		dvd_ppm.track = dvd_info.longest_track;
+
+	// Track
+	struct dvd_track dvd_track;
+	dvd_session_track(dvd_session, dvd_ppm.track, &dvd_track);
+
+	if(!dvd_track.valid) {
+		fprintf(stderr, "* Could not open VTS_IFO for track %u\n", dvd_ppm.track);
+		dvd_session_close(dvd_session);
+		return 1;
+	}
 
 	// Set the proper chapter range
 	if(opt_chapter_number) {
 		if(arg_first_chapter > dvd_track.chapters) {
-			dvd_copy.first_chapter = dvd_track.chapters;
-			fprintf(stderr, "Resetting first chapter to %u\n", dvd_copy.first_chapter);
+			dvd_ppm.first_chapter = dvd_track.chapters;
+			fprintf(stderr, "Resetting first chapter to %u\n", dvd_ppm.first_chapter);
 		} else
-			dvd_copy.first_chapter = arg_first_chapter;
-		
+			dvd_ppm.first_chapter = arg_first_chapter;
+
 		if(arg_last_chapter > dvd_track.chapters) {
-			dvd_copy.last_chapter = dvd_track.chapters;
-			fprintf(stderr, "Resetting last chapter to %u\n", dvd_copy.last_chapter);
+			dvd_ppm.last_chapter = dvd_track.chapters;
+			fprintf(stderr, "Resetting last chapter to %u\n", dvd_ppm.last_chapter);
 		} else
-			dvd_copy.last_chapter = arg_last_chapter;
+			dvd_ppm.last_chapter = arg_last_chapter;
 	} else {
-		dvd_copy.first_chapter = 1;
-		dvd_copy.last_chapter = dvd_track.chapters;
+		dvd_ppm.first_chapter = 1;
+		dvd_ppm.last_chapter = dvd_track.chapters;
 	}
-	
-	/**
-	 * Integers for numbers of blocks read, copied, counters
-	 */
-	int offset = 0;
-	ssize_t read_blocks = DVD_READ_BLOCKS; // this can be changed, if you want to to do testing on different block sizes (grab more / less data on each read)
-	ssize_t dvdread_read_blocks = 0; // num blocks passed by dvdread function
-	ssize_t cell_blocks_written = 0;
-	ssize_t bytes_written = 0;
-	uint32_t cell_sectors = 0;
-
-	uint8_t buffer[DVD_BUFFER_SIZE];
-	uint8_t dvd_read_buffer[DVD_BUFFER_SIZE];
-	// printf("size of buffer: %u\n", sizeof(buffer));
-	// printf("size of dvd_read_buffer: %u\n", sizeof(dvd_read_buffer));
-
-	/**
-	 * File descriptors and filenames
-	 */
-	dvd_file_t *dvdread_vts_file = NULL;
 
-	vts = dvd_vts_ifo_number(vmg_ifo, dvd_copy.track);
-	vts_ifo = vts_ifos[vts];
+	if(p_dvd_ppm)
+		printf("Track: %02u, Length: %s Chapters: %02u, Cells: %02u, Audio streams: %02u, Subpictures: %02u, Filesize: %lu, Blocks: %lu\n", dvd_track.track, dvd_track.length, dvd_track.chapters, dvd_track.cells, dvd_track.audio_tracks, dvd_track.subtitles, dvd_track.filesize, dvd_track.blocks);
 
-	// Open the VTS VOB
-	dvdread_vts_file = DVDOpenFile(dvdread_dvd, vts, DVD_READ_TITLE_VOBS);
+	// libmpeg2
+	dvd_ppm.mpeg2dec = mpeg2_init();
 
-	printf("Track: %02u, Length: %s Chapters: %02u, Cells: %02u, Audio streams: %02u, Subpictures: %02u, Filesize: %lu, Blocks: %lu\n", dvd_track.track, dvd_track.length, dvd_track.chapters, dvd_track.cells, dvd_track.audio_tracks, dvd_track.subtitles, dvd_track.filesize, dvd_track.blocks);
+	if(dvd_ppm.mpeg2dec == NULL) {
+		fprintf(stderr, "%s: Could not create an MPEG-2 decoder\n", DVD_INFO_PROGRAM);
+		dvd_session_track_free(&dvd_track);
+		dvd_session_close(dvd_session);
+		return 1;
+	}
 
-	dvd_copy.fd = open(dvd_copy.filename, O_WRONLY | O_CREAT | O_APPEND | O_TRUNC, 0644);
+	dvd_ppm.mpeg2_info = mpeg2_info(dvd_ppm.mpeg2dec);
 
-	dvd_copy.first_cell = dvd_chapter_first_cell(vmg_ifo, vts_ifo, dvd_copy.track, dvd_copy.first_chapter);
-	dvd_copy.last_cell = dvd_chapter_last_cell(vmg_ifo, vts_ifo, dvd_copy.track, dvd_copy.last_chapter);
+	// Previews have square pixels, so the height comes from the display
+	// aspect ratio, not the frame size
+	if(dvd_ppm.preview_width) {
 
-	// Get limits of copy
-	for(dvd_cell.cell = dvd_copy.first_cell; dvd_cell.cell < dvd_copy.last_cell + 1; dvd_cell.cell++) {
-		
-		dvd_copy.blocks += dvd_cell_blocks(vmg_ifo, vts_ifo, dvd_track.track, dvd_cell.cell);
-		dvd_copy.filesize += dvd_cell_filesize(vmg_ifo, vts_ifo, dvd_track.track, dvd_cell.cell);
+		dvd_ppm.preview_height = dvd_preview_aspect_height(dvd_ppm.preview_width, dvd_track.dvd_video.aspect_ratio);
+		dvd_ppm.dvd_preview = dvd_preview_open(dvd_ppm.preview_width, dvd_ppm.preview_height);
+		dvd_ppm.preview_rgb = malloc((size_t)dvd_ppm.preview_width * dvd_ppm.preview_height * 3);
 
-	}
+		if(dvd_ppm.dvd_preview == NULL || dvd_ppm.preview_rgb == NULL) {
+			fprintf(stderr, "%s: Could not create a %ux%u preview\n", DVD_INFO_PROGRAM, dvd_ppm.preview_width, dvd_ppm.preview_height);
+			dvd_preview_close(dvd_ppm.dvd_preview);
+			free(dvd_ppm.preview_rgb);
+			mpeg2_close(dvd_ppm.mpeg2dec);
+			dvd_session_track_free(&dvd_track);
+			dvd_session_close(dvd_session);
+			return 1;
+		}
 
+		printf("Preview: %ux%u, Aspect ratio: %s, Conversion: %s\n", dvd_ppm.preview_width, dvd_ppm.preview_height, dvd_track.dvd_video.aspect_ratio, dvd_preview_name());
 
-	// libmpeg2 :D
-	mpeg2dec_t *decoder = NULL;
-	const mpeg2_info_t *info = NULL;
-	mpeg2_state_t state;
-	size_t size = 0;
-	int framenum = 0;
-	decoder = mpeg2_init();
-	if(decoder == NULL) {
-		printf("couldn't create an MPEG2 decoder\n");
-		return 1;
 	}
-	info = mpeg2_info(decoder);
-	size = (size_t)-1;
 
-	FILE *dvd_stream = NULL;
-	dvd_stream = fopen("dvd_stream.vob", "w+");
-	if(dvd_stream == NULL) {
-		printf("couldn't create dvd_stream.vob");
-		return 1;
-	}
+	struct dvd_demux *dvd_demux = NULL;
+	struct dvd_pipeline *dvd_pipeline = NULL;
+	bool decoded = false;
 
-	FILE *vob_stream = NULL;
-	vob_stream = fopen("dvd_track_03.vob", "rb");
-	if(vob_stream == NULL) {
-		printf("couldn't open vob stream");
-		return 1;
-	}
+	// Thumbnails seek to each point and decode a single picture
+	if(opt_thumbnails) {
 
-	int mdix = 0;
+		decoded = dvd_ppm_thumbnails(&dvd_ppm, dvd_session, arg_thumbnails, arg_jobs);
 
-	bool ppm_vob = true;
+		printf("Saved %u thumbnails to %s\n", dvd_ppm.frames, dvd_ppm.directory);
 
-	if(ppm_vob) {
+		mpeg2_close(dvd_ppm.mpeg2dec);
+		dvd_preview_close(dvd_ppm.dvd_preview);
+		free(dvd_ppm.preview_rgb);
+		dvd_session_track_free(&dvd_track);
+		dvd_session_close(dvd_session);
 
-	// libmpeg2
-	do {
-		state = mpeg2_parse(decoder);
-		switch(state) {
-			case STATE_BUFFER:
-			// printf("STATE_BUFFER\n");
-			size = fread(buffer, 1, DVD_BUFFER_SIZE, vob_stream);
-			// printf("size read: %u, sizeof(buffer): %u\n", size, sizeof(buffer));
-			mpeg2_buffer(decoder, buffer, buffer + size);
-		case STATE_SEQUENCE:
-			// printf("STATE_SEQUENCE\n");
-			mpeg2_convert(decoder, mpeg2convert_rgb24, NULL);
-			break;
-		case STATE_SLICE:
-			// printf("STATE_SLICE\n");
-		case STATE_END:
-			// printf("STATE_END\n");
-		case STATE_INVALID_END:
-			// printf("STATE_INVALID_END\n");
-			if(info->display_fbuf) {
-				// printf("ready to save ppm\n");
-				save_ppm(info->sequence->width, info->sequence->height, info->display_fbuf->buf[0], framenum++, false);
-			}
-			break;
-		default:
-			break;
-		}
-	} while(size);
+		return decoded ? 0 : 1;
 
 	}
 
-	mdix = 0;
-	
-	struct dvd_chapter dvd_chapter;
-
-	for(dvd_chapter.chapter = dvd_copy.first_chapter; dvd_chapter.chapter < dvd_copy.last_chapter + 1; dvd_chapter.chapter++) {
+	// Chapters decode on their own, and can be split across workers
+	if(arg_jobs > 1) {
 
-		dvd_chapter.first_cell = dvd_chapter_first_cell(vmg_ifo, vts_ifo, dvd_copy.track, dvd_chapter.chapter);
-		dvd_chapter.last_cell = dvd_chapter_last_cell(vmg_ifo, vts_ifo, dvd_copy.track, dvd_chapter.chapter);
-		strncpy(dvd_chapter.length, dvd_chapter_length(vmg_ifo, vts_ifo, dvd_copy.track, dvd_chapter.chapter), DVD_CHAPTER_LENGTH);
+		decoded = dvd_ppm_chapters(&dvd_ppm, dvd_session, arg_jobs);
 
-		for(dvd_cell.cell = dvd_chapter.first_cell; dvd_cell.cell < dvd_chapter.last_cell + 1; dvd_cell.cell++) {
+		printf("Saved %u frames to %s\n", dvd_ppm.frames, dvd_ppm.directory);
 
-			dvd_cell.blocks = dvd_cell_blocks(vmg_ifo, vts_ifo, dvd_track.track, dvd_cell.cell);
-			dvd_cell.filesize = dvd_cell_filesize(vmg_ifo, vts_ifo, dvd_track.track, dvd_cell.cell);
-			dvd_cell.first_sector = dvd_cell_first_sector(vmg_ifo, vts_ifo, dvd_track.track, dvd_cell.cell);
-			dvd_cell.last_sector = dvd_cell_last_sector(vmg_ifo, vts_ifo, dvd_track.track, dvd_cell.cell);
-			strncpy(dvd_cell.length, dvd_cell_length(vmg_ifo, vts_ifo, dvd_track.track, dvd_cell.cell), DVD_CELL_LENGTH);
-			cell_sectors = dvd_cell.last_sector - dvd_cell.first_sector;
+		mpeg2_close(dvd_ppm.mpeg2dec);
+		dvd_preview_close(dvd_ppm.dvd_preview);
+		free(dvd_ppm.preview_rgb);
+		dvd_session_track_free(&dvd_track);
+		dvd_session_close(dvd_session);
 
-			printf("        Chapter: %02u, Cell: %02u, VTS: %u, Filesize: %lu, Blocks: %lu, Sectors: %i to %i\n", dvd_chapter.chapter, dvd_cell.cell, vts, dvd_cell.filesize, dvd_cell.blocks, dvd_cell.first_sector, dvd_cell.last_sector);
+		return decoded ? 0 : 1;
 
-			cell_blocks_written = 0;
+	}
 
-			if(dvd_cell.last_sector > dvd_cell.first_sector)
-				cell_sectors++;
+	// The frame rate and sample aspect ratio for the stream header come from
+	// the IFO, the frame size and interlacing from the stream itself
+	if(arg_y4m_filename != NULL) {
 
-			if(dvd_cell.last_sector < dvd_cell.first_sector) {
-				printf("* DEBUG Someone doing something nasty? The last sector is listed before the first; skipping cell\n");
-				continue;
-			}
-			
-			offset = (int)dvd_cell.first_sector;
+		if(strcmp(dvd_track.dvd_video.fps, "25.00") == 0 || (strlen(dvd_track.dvd_video.fps) == 0 && strcmp(dvd_track.dvd_video.format, "PAL") == 0))
+			dvd_ppm.y4m_rate = "25:1";
+		else
+			dvd_ppm.y4m_rate = "30000:1001";
 
-			// This is where you would change the boundaries -- are you dumping to a track file (no boundaries) or a VOB (boundaries)
-			while(cell_blocks_written < dvd_cell.blocks) {
+		dvd_ppm_sar(&dvd_ppm, &dvd_track.dvd_video);
 
-				// Reset to the defaults
-				read_blocks = DVD_READ_BLOCKS;
+		if(p_dvd_ppm)
+			dvd_ppm.y4m_fd = open(arg_y4m_filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		else
+			dvd_ppm.y4m_fd = STDOUT_FILENO;
 
-				if(read_blocks > (dvd_cell.blocks - cell_blocks_written)) {
-					read_blocks = dvd_cell.blocks - cell_blocks_written;
-				}
+		if(dvd_ppm.y4m_fd == -1) {
+			fprintf(stderr, "%s: Could not open %s for writing\n", DVD_INFO_PROGRAM, arg_y4m_filename);
+			mpeg2_close(dvd_ppm.mpeg2dec);
+			dvd_session_track_free(&dvd_track);
+			dvd_session_close(dvd_session);
+			return 1;
+		}
 
-				/*
-				dvdread_read_blocks = DVDReadBlocks(dvdread_vts_file, offset, (uint64_t)read_blocks, dvd_read_buffer);
-				if(!dvdread_read_blocks) {
-					printf("* Could not read data from cell %u\n", dvd_cell.cell);
-					return 1;
-				}
+	}
 
-				// Check to make sure the amount read was what we wanted
-				if(dvdread_read_blocks != read_blocks) {
-					printf("*** Asked for %ld and only got %ld\n", read_blocks, dvdread_read_blocks);
-					return 1;
-				}
-				*/
+	// Only some of the frames are saved, so list which ones they are
+	char frames_filename[PATH_MAX + 16];
+	if(dvd_ppm.coding_types) {
 
-				framenum = 0;
+		snprintf(frames_filename, sizeof(frames_filename), "%s/frames.txt", dvd_ppm.directory);
+		dvd_ppm.frames_file = fopen(frames_filename, "w");
 
-				// libmpeg2
-				do {
-					if(read_blocks > (dvd_cell.blocks - cell_blocks_written)) {
-						read_blocks = dvd_cell.blocks - cell_blocks_written;
-					}
-					state = mpeg2_parse(decoder);
-					switch(state) {
-						case STATE_BUFFER:
-						printf("STATE_BUFFER\n");
-						dvdread_read_blocks = DVDReadBlocks(dvdread_vts_file, offset, (uint64_t)read_blocks, dvd_read_buffer);
-						printf("dvdread_read_blocks: %lu\n", dvdread_read_blocks);
-						printf("offset: %i\n", offset);
-						offset += dvdread_read_blocks;
-						bytes_written = read_blocks * DVD_VIDEO_LB_LEN;
-						mpeg2_buffer(decoder, dvd_read_buffer, dvd_read_buffer + DVD_BUFFER_SIZE);
-						fwrite(dvd_read_buffer, 1, sizeof(dvd_read_buffer), dvd_stream);
-						cell_blocks_written += dvdread_read_blocks;
-						break;
-					case STATE_SEQUENCE:
-						printf("STATE_SEQUENCE\n");
-						mpeg2_convert(decoder, mpeg2convert_rgb24, NULL);
-						break;
-					case STATE_SLICE:
-						printf("STATE_SLICE\n");
-					case STATE_END:
-						printf("STATE_END\n");
-					case STATE_INVALID_END:
-						printf("STATE_INVALID_END\n");
-						if(info->display_fbuf) {
-							// printf("ready to save ppm\n");
-							save_ppm(info->sequence->width, info->sequence->height, info->display_fbuf->buf[0], framenum++, true);
-						}
-						break;
-					default:
-						break;
-					}
-					printf("cell blocks total, written: %lu, %lu\n", dvd_cell.blocks, cell_blocks_written);
-				} while(dvdread_read_blocks && cell_blocks_written < dvd_cell.blocks);
+		if(dvd_ppm.frames_file == NULL) {
+			fprintf(stderr, "%s: Could not open %s for writing\n", DVD_INFO_PROGRAM, frames_filename);
+			mpeg2_close(dvd_ppm.mpeg2dec);
+			dvd_preview_close(dvd_ppm.dvd_preview);
+			free(dvd_ppm.preview_rgb);
+			dvd_session_track_free(&dvd_track);
+			dvd_session_close(dvd_session);
+			return 1;
+		}
 
+	}
 
-				// Increment the offsets
-				// offset += dvdread_read_blocks;
+	// A sequence end code, to get the last frame out of the decoder
+	uint8_t sequence_end[4] = { 0x00, 0x00, 0x01, 0xb7 };
 
-				// Write the buffer to the track file
-				// bytes_written = write(dvd_copy.fd, dvd_read_buffer, (uint64_t)(read_blocks * DVD_VIDEO_LB_LEN));
-				// bytes_written = read_blocks * DVD_VIDEO_LB_LEN;
+	// Frame times are from the start of the first chapter
+	ifo_handle_t *vmg_ifo = dvd_session_vmg_ifo(dvd_session);
+	ifo_handle_t *vts_ifo = dvd_session_track_ifo(dvd_session, dvd_ppm.track);
+	dvd_cell_starts(vmg_ifo, vts_ifo, dvd_ppm.track, dvd_chapter_first_cell(vmg_ifo, vts_ifo, dvd_ppm.track, dvd_ppm.first_chapter), dvd_ppm.cell_start);
 
-				if(!bytes_written) {
-					printf("* Could not write data from cell %u\n", dvd_cell.cell);
-					return 1;
-				}
+	dvd_demux = dvd_demux_open(DVD_DEMUX_VIDEO, dvd_ppm_decode, &dvd_ppm);
+	dvd_ppm.dvd_demux = dvd_demux;
+	dvd_pipeline = dvd_pipeline_open(dvd_session, dvd_ppm.track, dvd_ppm.first_chapter, dvd_ppm.last_chapter);
 
-				// Check to make sure we wrote as much as we asked for
-				if(bytes_written != dvdread_read_blocks * DVD_VIDEO_LB_LEN) {
-					printf("*** Tried to write %ld bytes and only wrote %ld instead\n", dvdread_read_blocks * DVD_VIDEO_LB_LEN, bytes_written);
-					return 1;
-				}
+	if(dvd_demux != NULL && dvd_pipeline != NULL) {
 
-				// Increment the amount of blocks written
-				// cell_blocks_written += dvdread_read_blocks;
+		dvd_pipeline_block_limit(dvd_pipeline, dvd_ppm.block_limit);
+		dvd_pipeline_add(dvd_pipeline, "ppm", dvd_ppm_pipeline_write, NULL, &dvd_ppm);
+		if(p_dvd_ppm)
+			dvd_pipeline_add_progress(dvd_pipeline);
 
-				// fflush(stdout);
+		decoded = dvd_pipeline_run(dvd_pipeline);
 
-			}
+	}
 
-		}
+	dvd_pipeline_close(dvd_pipeline);
 
+	if(decoded) {
+		mpeg2_buffer(dvd_ppm.mpeg2dec, sequence_end, sequence_end + sizeof(sequence_end));
+		decoded = dvd_ppm_parse(&dvd_ppm);
 	}
 
-	mpeg2_close(decoder);
+	if(arg_y4m_filename != NULL && dvd_ppm.y4m_fd != STDOUT_FILENO && close(dvd_ppm.y4m_fd) != 0)
+		decoded = false;
 
-	if(dvd_stream)
-		fclose(dvd_stream);
+	if(dvd_ppm.frames_file != NULL && fclose(dvd_ppm.frames_file) != 0)
+		decoded = false;
 
-	// close(dvd_copy.fd);
-	// remove(dvd_copy.filename);
+	if(p_dvd_ppm) {
+		printf("\n");
+		if(arg_y4m_filename != NULL)
+			printf("Wrote %u frames to %s\n", dvd_ppm.frames, arg_y4m_filename);
+		else
+			printf("Saved %u frames to %s\n", dvd_ppm.frames, dvd_ppm.directory);
+	}
 
-	DVDCloseFile(dvdread_vts_file);
+	dvd_demux_close(dvd_demux);
 
-	if(vts_ifo)
-		ifoClose(vts_ifo);
-	
-	if(vmg_ifo)
-		ifoClose(vmg_ifo);
+	mpeg2_close(dvd_ppm.mpeg2dec);
 
-	if(dvdread_dvd)
-		DVDClose(dvdread_dvd);
-	
-	return 0;
+	dvd_preview_close(dvd_ppm.dvd_preview);
+	free(dvd_ppm.preview_rgb);
 
-}
+	dvd_session_track_free(&dvd_track);
 
-void dvd_track_info(struct dvd_track *dvd_track, const uint16_t track_number, const ifo_handle_t *vmg_ifo, const ifo_handle_t *vts_ifo) {
-
-	dvd_track->track = track_number;
-	dvd_track->valid = 1;
-	dvd_track->vts = dvd_vts_ifo_number(vmg_ifo, track_number);
-	dvd_track->ttn = dvd_track_ttn(vmg_ifo, track_number);
-	strncpy(dvd_track->length, dvd_track_length(vmg_ifo, vts_ifo, track_number), DVD_TRACK_LENGTH);
-	dvd_track->msecs = dvd_track_msecs(vmg_ifo, vts_ifo, track_number);
-	dvd_track->chapters = dvd_track_chapters(vmg_ifo, vts_ifo, track_number);
-	dvd_track->audio_tracks = dvd_track_audio_tracks(vts_ifo);
-	dvd_track->subtitles = dvd_track_subtitles(vts_ifo);
-	dvd_track->active_audio = dvd_audio_active_tracks(vmg_ifo, vts_ifo, track_number);
-	dvd_track->active_subs = dvd_track_active_subtitles(vmg_ifo, vts_ifo, track_number);
-	dvd_track->cells = dvd_track_cells(vmg_ifo, vts_ifo, track_number);
-	dvd_track->blocks = dvd_track_blocks(vmg_ifo, vts_ifo, track_number);
-	dvd_track->filesize = dvd_track_filesize(vmg_ifo, vts_ifo, track_number);
+	dvd_session_close(dvd_session);
+
+	return decoded ? 0 : 1;
 
 }
 
 void print_usage(char *binary) {
 
-	printf("%s - Copy a DVD track\n", binary);
+	printf("%s %s - save the frames of a DVD track as PPM images\n", binary, VERSION);
+	printf("\n");
+	printf("Usage: %s [-t track] [-c chapter[-chapter]] [-o directory] [-f all|ip|i] [-T chapters|#] [-W width] [-S columns] [-j jobs] [-y filename] [dvd path]\n", binary);
 	printf("\n");
-	printf("Usage: %s [-t track] [dvd path]\n", binary);
+	printf("Options:\n");
+	printf("  -f, --frames <all|ip|i>	Only decode I frames, or I and P frames, and list\n");
+	printf("				them in frames.txt (default: all)\n");
+	printf("  -y, --y4m <filename>	Stream the frames as YUV4MPEG2 to a file or FIFO instead,\n");
+	printf("				or \"-\" for stdout\n");
+	printf("  -W, --width <#>		Scale frames down to a preview width, the height follows\n");
+	printf("				the aspect ratio\n");
+	printf("  -S, --sheet <#>		Put the thumbnails on a contact sheet, a number of\n");
+	printf("				columns across (default width: %u)\n", DVD_PPM_SHEET_WIDTH);
+	printf("  -j, --jobs <#>			Decode with a number of workers, each with its own\n");
+	printf("				copy of the disc open (default: 1)\n");
+	printf("  -T, --thumbnails <chapters|#>	Only save one picture at the start of each chapter,\n");
+	printf("				or at a number of evenly spaced points in the track\n");
+	printf("  -b, --blocks <#>	Blocks to read from the disc at a time (default: %u)\n", DVD_PIPELINE_BLOCK_LIMIT);
 	printf("\n");
 	printf("DVD path can be a directory, a device filename, or a local file.\n");
 	printf("\n");
 	printf("Examples:\n");
-	printf("  dvd_info " DEFAULT_DVD_DEVICE "	# Read a DVD drive directly\n");
-	printf("  dvd_info movie.iso	# Read an image file\n");
-	printf("  dvd_info movie/	# Read a directory that contains VIDEO_TS\n");
+	printf("  %s " DEFAULT_DVD_DEVICE "	# Read a DVD drive directly\n", binary);
+	printf("  %s movie.iso	# Read an image file\n", binary);
+	printf("  %s movie/	# Read a directory that contains VIDEO_TS\n", binary);
+	printf("  %s -y - movie.iso | x264 --demuxer y4m -o movie.264 -\n", binary);
 	printf("\n");
 	printf("If no DVD path is given, %s is used in its place.\n", DEFAULT_DVD_DEVICE);
+	printf("If no output directory is given, the frames are saved to ppm/\n");
+
+}
+
+void print_version(char *binary) {
+
+	printf("%s %s - http://dvds.beandog.org/ - (c) 2018 Steve Dibb <steve.dibb@gmail.com>, licensed under GPL-2\n", binary, VERSION);
 
 }
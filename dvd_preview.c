@@ -0,0 +1,596 @@
+#include <pthread.h>
+#include "dvd_preview.h"
+#ifdef DVD_PREVIEW_X86
+#include <immintrin.h>
+#endif
+
+struct dvd_preview {
+	uint16_t width;
+	uint16_t height;
+	uint16_t source_width;
+	uint16_t source_height;
+	uint16_t source_chroma_width;
+	uint16_t source_chroma_height;
+	uint16_t *x;
+	uint16_t *y;
+	uint16_t *chroma_x;
+	uint16_t *chroma_y;
+	uint8_t *row;
+	uint8_t *plane_y;
+	uint8_t *plane_u;
+	uint8_t *plane_v;
+};
+
+/**
+ * Averages use a reciprocal instead of dividing: (sum + n / 2) * (65536 / n,
+ * rounded up) >> 16.  Every version uses the same one, so they all give the
+ * same result.
+ */
+static uint32_t dvd_preview_reciprocal(const uint16_t n) {
+
+	return (65536 + n - 1) / n;
+
+}
+
+/**
+ * BT.601 YUV to RGB, in 6 bits of fixed point
+ *
+ * R = 1.164 (Y - 16) + 1.596 (V - 128)
+ * G = 1.164 (Y - 16) - 0.391 (U - 128) - 0.813 (V - 128)
+ * B = 1.164 (Y - 16) + 2.018 (U - 128)
+ */
+#define DVD_PREVIEW_Y 75
+#define DVD_PREVIEW_RV 102
+#define DVD_PREVIEW_GU 25
+#define DVD_PREVIEW_GV 52
+#define DVD_PREVIEW_BU 129
+
+static uint8_t dvd_preview_clamp(const int32_t value) {
+
+	if(value < 0)
+		return 0;
+	if(value > (255 << 6))
+		return 255;
+
+	return (uint8_t)(value >> 6);
+
+}
+
+void dvd_preview_rows_scalar(const uint8_t *src, const size_t stride, const uint16_t rows, const uint16_t width, uint8_t *dst) {
+
+	uint32_t reciprocal = dvd_preview_reciprocal(rows);
+	uint32_t sum = 0;
+	uint16_t x = 0;
+	uint16_t row = 0;
+
+	for(x = 0; x < width; x++) {
+
+		sum = 0;
+		for(row = 0; row < rows; row++)
+			sum += src[row * stride + x];
+
+		dst[x] = (uint8_t)(((sum + rows / 2) * reciprocal) >> 16);
+
+	}
+
+}
+
+void dvd_preview_rgb_scalar(const uint8_t *y, const uint8_t *u, const uint8_t *v, uint8_t *rgb, const uint16_t pixels) {
+
+	int32_t luma = 0;
+	int32_t d = 0;
+	int32_t e = 0;
+	uint16_t ix = 0;
+
+	for(ix = 0; ix < pixels; ix++) {
+
+		luma = (y[ix] - 16) * DVD_PREVIEW_Y + 32;
+		d = u[ix] - 128;
+		e = v[ix] - 128;
+
+		rgb[0] = dvd_preview_clamp(luma + DVD_PREVIEW_RV * e);
+		rgb[1] = dvd_preview_clamp(luma - DVD_PREVIEW_GU * d - DVD_PREVIEW_GV * e);
+		rgb[2] = dvd_preview_clamp(luma + DVD_PREVIEW_BU * d);
+
+		rgb += 3;
+
+	}
+
+}
+
+#ifdef DVD_PREVIEW_X86
+
+/**
+ * Add up 16 columns at a time, 16 bits each.  There are never more than 256
+ * rows, so the sums can't overflow.
+ */
+__attribute__((target("sse2")))
+void dvd_preview_rows_sse2(const uint8_t *src, const size_t stride, const uint16_t rows, const uint16_t width, uint8_t *dst) {
+
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i half = _mm_set1_epi16((short)(rows / 2));
+	const __m128i reciprocal = _mm_set1_epi16((short)dvd_preview_reciprocal(rows));
+	__m128i b, lo, hi;
+	uint16_t x = 0;
+	uint16_t row = 0;
+
+	if(rows == 1) {
+		memcpy(dst, src, width);
+		return;
+	}
+
+	for(x = 0; x + 16 <= width; x += 16) {
+
+		lo = zero;
+		hi = zero;
+
+		for(row = 0; row < rows; row++) {
+			b = _mm_loadu_si128((const __m128i *)(src + row * stride + x));
+			lo = _mm_add_epi16(lo, _mm_unpacklo_epi8(b, zero));
+			hi = _mm_add_epi16(hi, _mm_unpackhi_epi8(b, zero));
+		}
+
+		lo = _mm_mulhi_epu16(_mm_add_epi16(lo, half), reciprocal);
+		hi = _mm_mulhi_epu16(_mm_add_epi16(hi, half), reciprocal);
+
+		_mm_storeu_si128((__m128i *)(dst + x), _mm_packus_epi16(lo, hi));
+
+	}
+
+	if(x < width)
+		dvd_preview_rows_scalar(src + x, stride, rows, width - x, dst + x);
+
+}
+
+/**
+ * Convert 8 pixels, 16 bits each.  The adds saturate, which only happens
+ * when the result is out of range anyway.
+ */
+__attribute__((target("sse2")))
+static inline void dvd_preview_rgb8(__m128i y, __m128i u, __m128i v, __m128i *r, __m128i *g, __m128i *b) {
+
+	__m128i luma, d, e;
+
+	luma = _mm_add_epi16(_mm_mullo_epi16(_mm_sub_epi16(y, _mm_set1_epi16(16)), _mm_set1_epi16(DVD_PREVIEW_Y)), _mm_set1_epi16(32));
+	d = _mm_sub_epi16(u, _mm_set1_epi16(128));
+	e = _mm_sub_epi16(v, _mm_set1_epi16(128));
+
+	*r = _mm_srai_epi16(_mm_adds_epi16(luma, _mm_mullo_epi16(e, _mm_set1_epi16(DVD_PREVIEW_RV))), 6);
+	*g = _mm_srai_epi16(_mm_subs_epi16(_mm_subs_epi16(luma, _mm_mullo_epi16(d, _mm_set1_epi16(DVD_PREVIEW_GU))), _mm_mullo_epi16(e, _mm_set1_epi16(DVD_PREVIEW_GV))), 6);
+	*b = _mm_srai_epi16(_mm_adds_epi16(luma, _mm_mullo_epi16(d, _mm_set1_epi16(DVD_PREVIEW_BU))), 6);
+
+}
+
+/**
+ * Convert 16 pixels into separate R, G and B vectors
+ */
+__attribute__((target("sse2")))
+static inline void dvd_preview_rgb16(const uint8_t *y, const uint8_t *u, const uint8_t *v, __m128i *r, __m128i *g, __m128i *b) {
+
+	const __m128i zero = _mm_setzero_si128();
+	__m128i vy = _mm_loadu_si128((const __m128i *)y);
+	__m128i vu = _mm_loadu_si128((const __m128i *)u);
+	__m128i vv = _mm_loadu_si128((const __m128i *)v);
+	__m128i r_lo, g_lo, b_lo, r_hi, g_hi, b_hi;
+
+	dvd_preview_rgb8(_mm_unpacklo_epi8(vy, zero), _mm_unpacklo_epi8(vu, zero), _mm_unpacklo_epi8(vv, zero), &r_lo, &g_lo, &b_lo);
+	dvd_preview_rgb8(_mm_unpackhi_epi8(vy, zero), _mm_unpackhi_epi8(vu, zero), _mm_unpackhi_epi8(vv, zero), &r_hi, &g_hi, &b_hi);
+
+	*r = _mm_packus_epi16(r_lo, r_hi);
+	*g = _mm_packus_epi16(g_lo, g_hi);
+	*b = _mm_packus_epi16(b_lo, b_hi);
+
+}
+
+/**
+ * SSE2 has no byte shuffle, so the channels are interleaved from memory
+ */
+__attribute__((target("sse2")))
+void dvd_preview_rgb_sse2(const uint8_t *y, const uint8_t *u, const uint8_t *v, uint8_t *rgb, const uint16_t pixels) {
+
+	uint8_t channels[3][16] __attribute__((aligned(16)));
+	__m128i r, g, b;
+	uint16_t ix = 0;
+	uint16_t px = 0;
+
+	for(ix = 0; ix + 16 <= pixels; ix += 16) {
+
+		dvd_preview_rgb16(y + ix, u + ix, v + ix, &r, &g, &b);
+
+		_mm_store_si128((__m128i *)channels[0], r);
+		_mm_store_si128((__m128i *)channels[1], g);
+		_mm_store_si128((__m128i *)channels[2], b);
+
+		for(px = 0; px < 16; px++) {
+			rgb[0] = channels[0][px];
+			rgb[1] = channels[1][px];
+			rgb[2] = channels[2][px];
+			rgb += 3;
+		}
+
+	}
+
+	if(ix < pixels)
+		dvd_preview_rgb_scalar(y + ix, u + ix, v + ix, rgb, pixels - ix);
+
+}
+
+/**
+ * The same, with the 16 pixels shuffled into 48 bytes of RGB
+ */
+__attribute__((target("ssse3")))
+void dvd_preview_rgb_ssse3(const uint8_t *y, const uint8_t *u, const uint8_t *v, uint8_t *rgb, const uint16_t pixels) {
+
+	const __m128i r0 = _mm_setr_epi8(0, -128, -128, 1, -128, -128, 2, -128, -128, 3, -128, -128, 4, -128, -128, 5);
+	const __m128i g0 = _mm_setr_epi8(-128, 0, -128, -128, 1, -128, -128, 2, -128, -128, 3, -128, -128, 4, -128, -128);
+	const __m128i b0 = _mm_setr_epi8(-128, -128, 0, -128, -128, 1, -128, -128, 2, -128, -128, 3, -128, -128, 4, -128);
+	const __m128i r1 = _mm_setr_epi8(-128, -128, 6, -128, -128, 7, -128, -128, 8, -128, -128, 9, -128, -128, 10, -128);
+	const __m128i g1 = _mm_setr_epi8(5, -128, -128, 6, -128, -128, 7, -128, -128, 8, -128, -128, 9, -128, -128, 10);
+	const __m128i b1 = _mm_setr_epi8(-128, 5, -128, -128, 6, -128, -128, 7, -128, -128, 8, -128, -128, 9, -128, -128);
+	const __m128i r2 = _mm_setr_epi8(-128, 11, -128, -128, 12, -128, -128, 13, -128, -128, 14, -128, -128, 15, -128, -128);
+	const __m128i g2 = _mm_setr_epi8(-128, -128, 11, -128, -128, 12, -128, -128, 13, -128, -128, 14, -128, -128, 15, -128);
+	const __m128i b2 = _mm_setr_epi8(10, -128, -128, 11, -128, -128, 12, -128, -128, 13, -128, -128, 14, -128, -128, 15);
+	__m128i r, g, b;
+	uint16_t ix = 0;
+
+	for(ix = 0; ix + 16 <= pixels; ix += 16) {
+
+		dvd_preview_rgb16(y + ix, u + ix, v + ix, &r, &g, &b);
+
+		_mm_storeu_si128((__m128i *)rgb, _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(r, r0), _mm_shuffle_epi8(g, g0)), _mm_shuffle_epi8(b, b0)));
+		_mm_storeu_si128((__m128i *)(rgb + 16), _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(r, r1), _mm_shuffle_epi8(g, g1)), _mm_shuffle_epi8(b, b1)));
+		_mm_storeu_si128((__m128i *)(rgb + 32), _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(r, r2), _mm_shuffle_epi8(g, g2)), _mm_shuffle_epi8(b, b2)));
+
+		rgb += 48;
+
+	}
+
+	if(ix < pixels)
+		dvd_preview_rgb_scalar(y + ix, u + ix, v + ix, rgb, pixels - ix);
+
+}
+
+#endif
+
+typedef void (*dvd_preview_rows_t)(const uint8_t *src, const size_t stride, const uint16_t rows, const uint16_t width, uint8_t *dst);
+typedef void (*dvd_preview_rgb_t)(const uint8_t *y, const uint8_t *u, const uint8_t *v, uint8_t *rgb, const uint16_t pixels);
+
+static dvd_preview_rows_t dvd_preview_rows_function = dvd_preview_rows_scalar;
+static dvd_preview_rgb_t dvd_preview_rgb_function = dvd_preview_rgb_scalar;
+static const char *dvd_preview_function_name = "scalar";
+static pthread_once_t dvd_preview_once = PTHREAD_ONCE_INIT;
+
+static void dvd_preview_init(void) {
+
+#ifdef DVD_PREVIEW_X86
+	__builtin_cpu_init();
+
+	if(__builtin_cpu_supports("ssse3")) {
+		dvd_preview_rows_function = dvd_preview_rows_sse2;
+		dvd_preview_rgb_function = dvd_preview_rgb_ssse3;
+		dvd_preview_function_name = "ssse3";
+	} else if(__builtin_cpu_supports("sse2")) {
+		dvd_preview_rows_function = dvd_preview_rows_sse2;
+		dvd_preview_rgb_function = dvd_preview_rgb_sse2;
+		dvd_preview_function_name = "sse2";
+	}
+#endif
+
+}
+
+/**
+ * Which version is being used: "ssse3", "sse2" or "scalar"
+ */
+const char *dvd_preview_name(void) {
+
+	pthread_once(&dvd_preview_once, dvd_preview_init);
+
+	return dvd_preview_function_name;
+
+}
+
+/**
+ * Create a preview scaler for one output size
+ *
+ * A scaler keeps its own buffers, so each thread needs its own.
+ *
+ * @param width preview width
+ * @param height preview height
+ * @return scaler, or NULL if the size is out of range
+ */
+struct dvd_preview *dvd_preview_open(const uint16_t width, const uint16_t height) {
+
+	struct dvd_preview *dvd_preview = NULL;
+	size_t pixels = (size_t)width * height;
+
+	if(width < DVD_PREVIEW_MIN_WIDTH || width > DVD_PREVIEW_MAX_WIDTH || height < DVD_PREVIEW_MIN_HEIGHT || height > DVD_PREVIEW_MAX_HEIGHT)
+		return NULL;
+
+	pthread_once(&dvd_preview_once, dvd_preview_init);
+
+	dvd_preview = calloc(1, sizeof(struct dvd_preview));
+	if(dvd_preview == NULL)
+		return NULL;
+
+	dvd_preview->width = width;
+	dvd_preview->height = height;
+
+	dvd_preview->x = calloc(width + 1, sizeof(uint16_t));
+	dvd_preview->y = calloc(height + 1, sizeof(uint16_t));
+	dvd_preview->chroma_x = calloc(width + 1, sizeof(uint16_t));
+	dvd_preview->chroma_y = calloc(height + 1, sizeof(uint16_t));
+	dvd_preview->plane_y = malloc(pixels);
+	dvd_preview->plane_u = malloc(pixels);
+	dvd_preview->plane_v = malloc(pixels);
+
+	if(dvd_preview->x == NULL || dvd_preview->y == NULL || dvd_preview->chroma_x == NULL || dvd_preview->chroma_y == NULL || dvd_preview->plane_y == NULL || dvd_preview->plane_u == NULL || dvd_preview->plane_v == NULL) {
+		dvd_preview_close(dvd_preview);
+		return NULL;
+	}
+
+	return dvd_preview;
+
+}
+
+void dvd_preview_close(struct dvd_preview *dvd_preview) {
+
+	if(dvd_preview == NULL)
+		return;
+
+	free(dvd_preview->x);
+	free(dvd_preview->y);
+	free(dvd_preview->chroma_x);
+	free(dvd_preview->chroma_y);
+	free(dvd_preview->row);
+	free(dvd_preview->plane_y);
+	free(dvd_preview->plane_u);
+	free(dvd_preview->plane_v);
+	free(dvd_preview);
+
+}
+
+/**
+ * The height of a preview with square pixels, from the display aspect ratio
+ * that dvd_video_aspect_ratio() gives ("4:3" or "16:9").  Anything else is
+ * taken as 4:3.  The height is always even.
+ */
+uint16_t dvd_preview_aspect_height(const uint16_t width, const char *aspect_ratio) {
+
+	uint32_t height = 0;
+
+	if(aspect_ratio != NULL && strcmp(aspect_ratio, "16:9") == 0)
+		height = ((uint32_t)width * 9 + 8) / 16;
+	else
+		height = ((uint32_t)width * 3 + 2) / 4;
+
+	height += height & 1;
+
+	if(height < DVD_PREVIEW_MIN_HEIGHT)
+		height = DVD_PREVIEW_MIN_HEIGHT;
+
+	return (uint16_t)height;
+
+}
+
+/**
+ * Where each output pixel starts in the source, and so how many source pixels
+ * it covers.  When a side is scaled up, some cover none, and they use the one
+ * they start on.
+ */
+static void dvd_preview_spans(uint16_t *spans, const uint16_t source, const uint16_t size) {
+
+	uint16_t ix = 0;
+
+	for(ix = 0; ix < size + 1; ix++)
+		spans[ix] = (uint16_t)((uint32_t)ix * source / size);
+
+}
+
+static uint16_t dvd_preview_span(const uint16_t *spans, const uint16_t ix) {
+
+	if(spans[ix + 1] > spans[ix])
+		return spans[ix + 1] - spans[ix];
+
+	return 1;
+
+}
+
+/**
+ * Shrink one plane: average the rows under each output row, then the columns
+ * of that under each output pixel
+ */
+static void dvd_preview_plane(struct dvd_preview *dvd_preview, const uint8_t *src, const uint16_t source_width, const uint16_t *x, const uint16_t *y, uint8_t *dst) {
+
+	uint32_t reciprocal = 0;
+	uint32_t sum = 0;
+	uint16_t columns = 0;
+	uint16_t rows = 0;
+	uint16_t row = 0;
+	uint16_t column = 0;
+	uint16_t ix = 0;
+
+	for(row = 0; row < dvd_preview->height; row++) {
+
+		rows = dvd_preview_span(y, row);
+		dvd_preview_rows_function(src + (size_t)y[row] * source_width, source_width, rows, source_width, dvd_preview->row);
+
+		for(column = 0; column < dvd_preview->width; column++) {
+
+			columns = dvd_preview_span(x, column);
+			reciprocal = dvd_preview_reciprocal(columns);
+
+			sum = 0;
+			for(ix = 0; ix < columns; ix++)
+				sum += dvd_preview->row[x[column] + ix];
+
+			dst[column] = (uint8_t)(((sum + columns / 2) * reciprocal) >> 16);
+
+		}
+
+		dst += dvd_preview->width;
+
+	}
+
+}
+
+/**
+ * Scale a frame down to the preview size, and convert it to RGB24
+ *
+ * @param dvd_preview scaler
+ * @param dvd_preview_frame decoded YUV 4:2:0 frame
+ * @param rgb where to write the top left pixel
+ * @param stride bytes from one row of rgb to the next
+ * @return success
+ */
+bool dvd_preview_scale(struct dvd_preview *dvd_preview, const struct dvd_preview_frame *dvd_preview_frame, uint8_t *rgb, const size_t stride) {
+
+	uint8_t *row = NULL;
+	size_t offset = 0;
+	uint16_t ix = 0;
+
+	if(dvd_preview_frame->width == 0 || dvd_preview_frame->height == 0 || dvd_preview_frame->chroma_width == 0 || dvd_preview_frame->chroma_height == 0)
+		return false;
+
+	// No more than 256 rows are added up at once, so the sums fit in 16 bits
+	if(dvd_preview_frame->height / dvd_preview->height > 256 || dvd_preview_frame->chroma_height / dvd_preview->height > 256)
+		return false;
+
+	// The spans only change when the source size does
+	if(dvd_preview_frame->width != dvd_preview->source_width || dvd_preview_frame->height != dvd_preview->source_height || dvd_preview_frame->chroma_width != dvd_preview->source_chroma_width || dvd_preview_frame->chroma_height != dvd_preview->source_chroma_height) {
+
+		row = realloc(dvd_preview->row, dvd_preview_frame->width);
+		if(row == NULL)
+			return false;
+		dvd_preview->row = row;
+
+		dvd_preview_spans(dvd_preview->x, dvd_preview_frame->width, dvd_preview->width);
+		dvd_preview_spans(dvd_preview->y, dvd_preview_frame->height, dvd_preview->height);
+		dvd_preview_spans(dvd_preview->chroma_x, dvd_preview_frame->chroma_width, dvd_preview->width);
+		dvd_preview_spans(dvd_preview->chroma_y, dvd_preview_frame->chroma_height, dvd_preview->height);
+
+		dvd_preview->source_width = dvd_preview_frame->width;
+		dvd_preview->source_height = dvd_preview_frame->height;
+		dvd_preview->source_chroma_width = dvd_preview_frame->chroma_width;
+		dvd_preview->source_chroma_height = dvd_preview_frame->chroma_height;
+
+	}
+
+	dvd_preview_plane(dvd_preview, dvd_preview_frame->y, dvd_preview_frame->width, dvd_preview->x, dvd_preview->y, dvd_preview->plane_y);
+	dvd_preview_plane(dvd_preview, dvd_preview_frame->u, dvd_preview_frame->chroma_width, dvd_preview->chroma_x, dvd_preview->chroma_y, dvd_preview->plane_u);
+	dvd_preview_plane(dvd_preview, dvd_preview_frame->v, dvd_preview_frame->chroma_width, dvd_preview->chroma_x, dvd_preview->chroma_y, dvd_preview->plane_v);
+
+	for(ix = 0; ix < dvd_preview->height; ix++) {
+		offset = (size_t)ix * dvd_preview->width;
+		dvd_preview_rgb_function(dvd_preview->plane_y + offset, dvd_preview->plane_u + offset, dvd_preview->plane_v + offset, rgb + ix * stride, dvd_preview->width);
+	}
+
+	return true;
+
+}
+
+/**
+ * Write an RGB24 image as a PPM file
+ */
+bool dvd_preview_ppm(const char *filename, const uint8_t *rgb, const uint16_t width, const uint16_t height) {
+
+	FILE *ppm_file = NULL;
+	bool saved = true;
+
+	ppm_file = fopen(filename, "wb");
+
+	if(ppm_file == NULL)
+		return false;
+
+	fprintf(ppm_file, "P6\n%u %u\n255\n", width, height);
+
+	if(fwrite(rgb, (size_t)width * 3, height, ppm_file) != height)
+		saved = false;
+
+	if(fclose(ppm_file) != 0)
+		saved = false;
+
+	return saved;
+
+}
+
+/**
+ * Set up a contact sheet: a grid of tiles, left to right and top to bottom,
+ * with a black border around each one
+ *
+ * @param dvd_preview_sheet contact sheet
+ * @param columns tiles across
+ * @param tiles number of tiles
+ * @param width tile width
+ * @param height tile height
+ * @return success
+ */
+bool dvd_preview_sheet_init(struct dvd_preview_sheet *dvd_preview_sheet, const uint16_t columns, const uint32_t tiles, const uint16_t width, const uint16_t height) {
+
+	uint32_t sheet_width = 0;
+	uint32_t sheet_height = 0;
+
+	memset(dvd_preview_sheet, 0, sizeof(struct dvd_preview_sheet));
+
+	if(columns == 0 || tiles == 0)
+		return false;
+
+	dvd_preview_sheet->columns = columns;
+	if(tiles < columns)
+		dvd_preview_sheet->columns = (uint16_t)tiles;
+	dvd_preview_sheet->rows = (uint16_t)((tiles + dvd_preview_sheet->columns - 1) / dvd_preview_sheet->columns);
+	dvd_preview_sheet->width = width;
+	dvd_preview_sheet->height = height;
+
+	sheet_width = (uint32_t)dvd_preview_sheet->columns * (width + DVD_PREVIEW_SHEET_BORDER) + DVD_PREVIEW_SHEET_BORDER;
+	sheet_height = (uint32_t)dvd_preview_sheet->rows * (height + DVD_PREVIEW_SHEET_BORDER) + DVD_PREVIEW_SHEET_BORDER;
+
+	if(sheet_width > UINT16_MAX || sheet_height > UINT16_MAX)
+		return false;
+
+	dvd_preview_sheet->sheet_width = (uint16_t)sheet_width;
+	dvd_preview_sheet->sheet_height = (uint16_t)sheet_height;
+
+	dvd_preview_sheet->rgb = calloc((size_t)sheet_width * sheet_height, 3);
+	if(dvd_preview_sheet->rgb == NULL)
+		return false;
+
+	return true;
+
+}
+
+/**
+ * The top left pixel of a tile, starting at 0.  Tiles don't overlap, so each
+ * one can be drawn from a different thread.
+ */
+uint8_t *dvd_preview_sheet_tile(const struct dvd_preview_sheet *dvd_preview_sheet, const uint32_t tile) {
+
+	uint32_t column = tile % dvd_preview_sheet->columns;
+	uint32_t row = tile / dvd_preview_sheet->columns;
+	size_t x = DVD_PREVIEW_SHEET_BORDER + column * (dvd_preview_sheet->width + DVD_PREVIEW_SHEET_BORDER);
+	size_t y = DVD_PREVIEW_SHEET_BORDER + row * (dvd_preview_sheet->height + DVD_PREVIEW_SHEET_BORDER);
+
+	if(row >= dvd_preview_sheet->rows)
+		return NULL;
+
+	return dvd_preview_sheet->rgb + y * dvd_preview_sheet_stride(dvd_preview_sheet) + x * 3;
+
+}
+
+size_t dvd_preview_sheet_stride(const struct dvd_preview_sheet *dvd_preview_sheet) {
+
+	return (size_t)dvd_preview_sheet->sheet_width * 3;
+
+}
+
+bool dvd_preview_sheet_save(const struct dvd_preview_sheet *dvd_preview_sheet, const char *filename) {
+
+	return dvd_preview_ppm(filename, dvd_preview_sheet->rgb, dvd_preview_sheet->sheet_width, dvd_preview_sheet->sheet_height);
+
+}
+
+void dvd_preview_sheet_free(struct dvd_preview_sheet *dvd_preview_sheet) {
+
+	free(dvd_preview_sheet->rgb);
+	dvd_preview_sheet->rgb = NULL;
+
+}
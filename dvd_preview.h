@@ -0,0 +1,98 @@
+#ifndef DVD_INFO_PREVIEW_H
+#define DVD_INFO_PREVIEW_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Video previews
+ *
+ * Scales a decoded YUV 4:2:0 frame down to a small RGB24 image, and puts
+ * them together into contact sheets.  The planes are shrunk first, with a
+ * box filter (the average of every source pixel under each one it makes),
+ * and only the pixels that are left are converted to RGB, so a 160 pixel
+ * wide preview costs a fraction of converting the whole frame.
+ *
+ * Averaging the rows and the color conversion use the widest version the CPU
+ * supports (SSSE3, SSE2, or plain C), picked the first time one is made.
+ *
+ * The planes are laid out the way libmpeg2 gives them: one row after another
+ * with no padding, and the chroma planes are half the width and height.
+ *
+ * struct dvd_preview *dvd_preview = dvd_preview_open(160, dvd_preview_aspect_height(160, "16:9"));
+ * dvd_preview_scale(dvd_preview, &dvd_preview_frame, rgb, 160 * 3);
+ * dvd_preview_close(dvd_preview);
+ */
+
+// The smallest preview, so no more than 256 rows are ever averaged together
+#define DVD_PREVIEW_MIN_WIDTH 16
+#define DVD_PREVIEW_MIN_HEIGHT 16
+#define DVD_PREVIEW_MAX_WIDTH 1920
+#define DVD_PREVIEW_MAX_HEIGHT 1080
+
+// Pixels between tiles on a contact sheet
+#define DVD_PREVIEW_SHEET_BORDER 4
+
+struct dvd_preview_frame {
+	const uint8_t *y;
+	const uint8_t *u;
+	const uint8_t *v;
+	uint16_t width;
+	uint16_t height;
+	uint16_t chroma_width;
+	uint16_t chroma_height;
+};
+
+struct dvd_preview_sheet {
+	uint16_t columns;
+	uint16_t rows;
+	uint16_t width;
+	uint16_t height;
+	uint16_t sheet_width;
+	uint16_t sheet_height;
+	uint8_t *rgb;
+};
+
+struct dvd_preview;
+
+struct dvd_preview *dvd_preview_open(const uint16_t width, const uint16_t height);
+
+void dvd_preview_close(struct dvd_preview *dvd_preview);
+
+uint16_t dvd_preview_aspect_height(const uint16_t width, const char *aspect_ratio);
+
+bool dvd_preview_scale(struct dvd_preview *dvd_preview, const struct dvd_preview_frame *dvd_preview_frame, uint8_t *rgb, const size_t stride);
+
+bool dvd_preview_ppm(const char *filename, const uint8_t *rgb, const uint16_t width, const uint16_t height);
+
+bool dvd_preview_sheet_init(struct dvd_preview_sheet *dvd_preview_sheet, const uint16_t columns, const uint32_t tiles, const uint16_t width, const uint16_t height);
+
+uint8_t *dvd_preview_sheet_tile(const struct dvd_preview_sheet *dvd_preview_sheet, const uint32_t tile);
+
+size_t dvd_preview_sheet_stride(const struct dvd_preview_sheet *dvd_preview_sheet);
+
+bool dvd_preview_sheet_save(const struct dvd_preview_sheet *dvd_preview_sheet, const char *filename);
+
+void dvd_preview_sheet_free(struct dvd_preview_sheet *dvd_preview_sheet);
+
+const char *dvd_preview_name(void);
+
+// Each version of the kernels, for comparing them
+void dvd_preview_rows_scalar(const uint8_t *src, const size_t stride, const uint16_t rows, const uint16_t width, uint8_t *dst);
+
+void dvd_preview_rgb_scalar(const uint8_t *y, const uint8_t *u, const uint8_t *v, uint8_t *rgb, const uint16_t pixels);
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define DVD_PREVIEW_X86 1
+
+void dvd_preview_rows_sse2(const uint8_t *src, const size_t stride, const uint16_t rows, const uint16_t width, uint8_t *dst);
+
+void dvd_preview_rgb_sse2(const uint8_t *y, const uint8_t *u, const uint8_t *v, uint8_t *rgb, const uint16_t pixels);
+
+void dvd_preview_rgb_ssse3(const uint8_t *y, const uint8_t *u, const uint8_t *v, uint8_t *rgb, const uint16_t pixels);
+#endif
+
+#endif
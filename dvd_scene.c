@@ -0,0 +1,231 @@
+#include "dvd_scene.h"
+
+/**
+ * Make the luma histogram of one frame
+ *
+ * @param luma luma plane, one row after another
+ * @param width frame width
+ * @param height frame height
+ * @param dvd_scene_frame frame, the cell and time are left as they are
+ */
+void dvd_scene_frame(const uint8_t *luma, const uint16_t width, const uint16_t height, struct dvd_scene_frame *dvd_scene_frame) {
+
+	const uint8_t *row = NULL;
+	uint32_t dark = 0;
+	uint16_t x = 0;
+	uint16_t y = 0;
+	uint8_t bin = 0;
+
+	memset(dvd_scene_frame->histogram, 0, sizeof(dvd_scene_frame->histogram));
+	dvd_scene_frame->pixels = 0;
+
+	for(y = 0; y < height; y += 2) {
+		row = luma + (size_t)y * width;
+		for(x = 0; x < width; x += 2)
+			dvd_scene_frame->histogram[row[x] >> 2]++;
+	}
+
+	for(bin = 0; bin < DVD_SCENE_BINS; bin++)
+		dvd_scene_frame->pixels += dvd_scene_frame->histogram[bin];
+
+	for(bin = 0; bin < DVD_SCENE_BLACK_LUMA >> 2; bin++)
+		dark += dvd_scene_frame->histogram[bin];
+
+	dvd_scene_frame->black = dvd_scene_frame->pixels && (uint64_t)dark * 1000 >= (uint64_t)dvd_scene_frame->pixels * DVD_SCENE_BLACK_RATIO;
+	dvd_scene_frame->decoded = true;
+
+}
+
+/**
+ * How far apart two histograms are, from 0 (the same) to 1000 (nothing in
+ * common)
+ */
+uint16_t dvd_scene_distance(const struct dvd_scene_frame *a, const struct dvd_scene_frame *b) {
+
+	uint64_t sum = 0;
+	uint64_t a_count = 0;
+	uint64_t b_count = 0;
+	uint8_t bin = 0;
+
+	if(a->pixels == 0 || b->pixels == 0)
+		return 0;
+
+	// Each count is scaled by the other frame's size, in case they differ
+	for(bin = 0; bin < DVD_SCENE_BINS; bin++) {
+		a_count = (uint64_t)a->histogram[bin] * b->pixels;
+		b_count = (uint64_t)b->histogram[bin] * a->pixels;
+		sum += a_count > b_count ? a_count - b_count : b_count - a_count;
+	}
+
+	return (uint16_t)(sum * 500 / ((uint64_t)a->pixels * b->pixels));
+
+}
+
+/**
+ * Find every candidate in a track's frames, in order
+ *
+ * @param dvd_scene_frames frames, the ones that weren't decoded are skipped
+ * @param frames number of frames
+ * @param cut histogram distance for a cut
+ * @param dvd_scene_points candidates, room for as many as there are frames
+ * @return number of candidates
+ */
+uint32_t dvd_scene_candidates(const struct dvd_scene_frame *dvd_scene_frames, const uint32_t frames, const uint16_t cut, struct dvd_scene_point *dvd_scene_points) {
+
+	const struct dvd_scene_frame *previous = NULL;
+	const struct dvd_scene_frame *frame = NULL;
+	uint32_t black_frames = 0;
+	uint32_t count = 0;
+	uint32_t ix = 0;
+	uint16_t distance = 0;
+
+	for(ix = 0; ix < frames; ix++) {
+
+		frame = &dvd_scene_frames[ix];
+
+		if(!frame->decoded)
+			continue;
+
+		if(frame->black) {
+			black_frames++;
+			previous = frame;
+			continue;
+		}
+
+		// The picture coming back after black, the longer the black the better
+		if(black_frames) {
+			dvd_scene_points[count].msecs = frame->msecs;
+			dvd_scene_points[count].type = DVD_SCENE_BLACK;
+			dvd_scene_points[count].score = (uint16_t)(1000 + (black_frames < 999 ? black_frames : 999));
+			count++;
+			black_frames = 0;
+		} else if(previous != NULL) {
+			distance = dvd_scene_distance(previous, frame);
+			if(distance >= cut) {
+				dvd_scene_points[count].msecs = frame->msecs;
+				dvd_scene_points[count].type = DVD_SCENE_CUT_POINT;
+				dvd_scene_points[count].score = distance;
+				count++;
+			}
+		}
+
+		previous = frame;
+
+	}
+
+	return count;
+
+}
+
+static int dvd_scene_score_compare(const void *a, const void *b) {
+
+	const struct dvd_scene_point *point_a = (const struct dvd_scene_point *)a;
+	const struct dvd_scene_point *point_b = (const struct dvd_scene_point *)b;
+
+	if(point_a->score != point_b->score)
+		return (int)point_b->score - (int)point_a->score;
+
+	return point_a->msecs < point_b->msecs ? -1 : point_a->msecs > point_b->msecs;
+
+}
+
+static int dvd_scene_msecs_compare(const void *a, const void *b) {
+
+	const struct dvd_scene_point *point_a = (const struct dvd_scene_point *)a;
+	const struct dvd_scene_point *point_b = (const struct dvd_scene_point *)b;
+
+	return point_a->msecs < point_b->msecs ? -1 : point_a->msecs > point_b->msecs;
+
+}
+
+static uint32_t dvd_scene_apart(const uint32_t a, const uint32_t b) {
+
+	return a > b ? a - b : b - a;
+
+}
+
+/**
+ * Pick the chapter points from the candidates
+ *
+ * Cell boundaries are always kept, and a candidate within snap_msecs of one
+ * is taken to be the same point.  The rest are taken best first, as long as
+ * they are at least min_msecs from every point already picked, and from the
+ * start and end of the track.
+ *
+ * @param candidates from dvd_scene_candidates()
+ * @param count number of candidates
+ * @param cells start of each cell after the first, can be NULL
+ * @param cell_count number of cell starts
+ * @param track_msecs length of the track
+ * @param min_msecs shortest chapter
+ * @param snap_msecs how close to a cell a candidate is the same point
+ * @param dvd_scene_points chapter points, room for DVD_SCENE_MAX_POINTS
+ * @return number of chapter points, in order
+ */
+uint16_t dvd_scene_select(const struct dvd_scene_point *candidates, const uint32_t count, const uint32_t *cells, const uint16_t cell_count, const uint32_t track_msecs, const uint32_t min_msecs, const uint32_t snap_msecs, struct dvd_scene_point *dvd_scene_points) {
+
+	struct dvd_scene_point *sorted = NULL;
+	uint16_t points = 0;
+	uint16_t cell_points = 0;
+	uint16_t ix = 0;
+	uint32_t candidate = 0;
+	bool keep = true;
+
+	for(ix = 0; ix < cell_count && points < DVD_SCENE_MAX_POINTS; ix++) {
+		if(cells[ix] == 0 || cells[ix] >= track_msecs)
+			continue;
+		dvd_scene_points[points].msecs = cells[ix];
+		dvd_scene_points[points].type = DVD_SCENE_CELL;
+		dvd_scene_points[points].score = 2000;
+		points++;
+	}
+
+	cell_points = points;
+
+	sorted = malloc((count ? count : 1) * sizeof(struct dvd_scene_point));
+	if(sorted == NULL)
+		return points;
+
+	memcpy(sorted, candidates, count * sizeof(struct dvd_scene_point));
+	qsort(sorted, count, sizeof(struct dvd_scene_point), dvd_scene_score_compare);
+
+	for(candidate = 0; candidate < count && points < DVD_SCENE_MAX_POINTS; candidate++) {
+
+		if(sorted[candidate].msecs < min_msecs || sorted[candidate].msecs + min_msecs > track_msecs)
+			continue;
+
+		keep = true;
+
+		for(ix = 0; ix < points && keep; ix++) {
+			if(ix < cell_points && dvd_scene_apart(sorted[candidate].msecs, dvd_scene_points[ix].msecs) <= snap_msecs)
+				keep = false;
+			else if(dvd_scene_apart(sorted[candidate].msecs, dvd_scene_points[ix].msecs) < min_msecs)
+				keep = false;
+		}
+
+		if(keep)
+			dvd_scene_points[points++] = sorted[candidate];
+
+	}
+
+	free(sorted);
+
+	qsort(dvd_scene_points, points, sizeof(struct dvd_scene_point), dvd_scene_msecs_compare);
+
+	return points;
+
+}
+
+/**
+ * Name of a type of chapter point
+ */
+const char *dvd_scene_type(const uint8_t type) {
+
+	if(type == DVD_SCENE_CELL)
+		return "cell";
+	else if(type == DVD_SCENE_BLACK)
+		return "black";
+
+	return "cut";
+
+}
@@ -0,0 +1,81 @@
+#ifndef DVD_INFO_SCENE_H
+#define DVD_INFO_SCENE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Scene changes and black frames
+ *
+ * Finds places in a track that would make good chapter points, for discs
+ * that only have one chapter per title.  Each frame checked is reduced to a
+ * histogram of its luma, taken from every other pixel of every other row.  A
+ * frame is black if nearly all of it is in the darkest bins, and there is a
+ * scene cut between two frames when their histograms are far enough apart.
+ *
+ * The frames are meant to be a sample (the I frame at the start of each
+ * VOBU, about two a second), not every one, so a cut is only ever as close as
+ * that to where it really is.
+ *
+ * The end of a run of black frames is the strongest candidate (that's where
+ * the broadcast breaks were), then the biggest cuts.  Cell boundaries can be
+ * added as well, and candidates close to one are moved onto it.
+ */
+
+#define DVD_SCENE_BINS 64
+
+// Luma under this is black (16 is black in video range), and the share of
+// the frame that has to be, in thousandths
+#define DVD_SCENE_BLACK_LUMA 40
+#define DVD_SCENE_BLACK_RATIO 980
+
+// Histogram distance for a cut, in thousandths
+#define DVD_SCENE_CUT 400
+
+// Chapters are at least this far apart, and candidates this close to a cell
+// boundary move to it
+#define DVD_SCENE_MIN_MSECS 60000
+#define DVD_SCENE_SNAP_MSECS 5000
+
+// OGM chapter numbers are two digits, and the first one is always zero
+#define DVD_SCENE_MAX_POINTS 98
+
+#define DVD_SCENE_CELL 0
+#define DVD_SCENE_BLACK 1
+#define DVD_SCENE_CUT_POINT 2
+
+struct dvd_scene_frame {
+	bool decoded;
+	bool black;
+	uint8_t cell;
+	uint32_t msecs;
+	uint32_t pixels;
+	uint32_t histogram[DVD_SCENE_BINS];
+};
+
+/**
+ * msecs: from the start of the track
+ * type: DVD_SCENE_CELL, DVD_SCENE_BLACK or DVD_SCENE_CUT_POINT
+ * score: how sure it is, cells are always 2000, black runs over 1000, and
+ * cuts are the histogram distance
+ */
+struct dvd_scene_point {
+	uint32_t msecs;
+	uint8_t type;
+	uint16_t score;
+};
+
+void dvd_scene_frame(const uint8_t *luma, const uint16_t width, const uint16_t height, struct dvd_scene_frame *dvd_scene_frame);
+
+uint16_t dvd_scene_distance(const struct dvd_scene_frame *a, const struct dvd_scene_frame *b);
+
+uint32_t dvd_scene_candidates(const struct dvd_scene_frame *dvd_scene_frames, const uint32_t frames, const uint16_t cut, struct dvd_scene_point *dvd_scene_points);
+
+uint16_t dvd_scene_select(const struct dvd_scene_point *candidates, const uint32_t count, const uint32_t *cells, const uint16_t cell_count, const uint32_t track_msecs, const uint32_t min_msecs, const uint32_t snap_msecs, struct dvd_scene_point *dvd_scene_points);
+
+const char *dvd_scene_type(const uint8_t type);
+
+#endif
@@ -0,0 +1,560 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdbool.h>
+#include <getopt.h>
+#include <inttypes.h>
+#include <time.h>
+#ifdef __linux__
+#include <linux/cdrom.h>
+#include "dvd_drive.h"
+#endif
+#include <dvdread/dvd_reader.h>
+#include <dvdread/ifo_read.h>
+#include <mpeg2dec/mpeg2.h>
+#include "dvd_info.h"
+#include "dvd_device.h"
+#include "dvd_track.h"
+#include "dvd_cell.h"
+#include "dvd_time.h"
+#include "dvd_session.h"
+#include "dvd_pipeline.h"
+#include "dvd_demux.h"
+#include "dvd_vobu.h"
+#include "dvd_scene.h"
+#include "dvd_workers.h"
+#include "dvd_ogm.h"
+#ifndef VERSION
+#define VERSION "1.2"
+#endif
+
+#ifndef DVD_VIDEO_LB_LEN
+#define DVD_VIDEO_LB_LEN 2048
+#endif
+
+#define DVD_INFO_PROGRAM "dvd_scenes"
+
+#define DVD_SCENES_MAX_JOBS 64
+
+// Segments for each worker, so one that is slow to read doesn't hold up the end
+#define DVD_SCENES_SEGMENTS 8
+
+int main(int, char **);
+void print_usage(char *binary);
+void print_version(char *binary);
+
+/**
+ * One decoder, and the frame it is filling in
+ */
+struct dvd_scenes {
+	mpeg2dec_t *mpeg2dec;
+	const mpeg2_info_t *mpeg2_info;
+	struct dvd_scene_frame *dvd_scene_frame;
+};
+
+/**
+ * The VOBUs of the track, split into segments that the workers take in order
+ */
+struct dvd_scenes_jobs {
+	uint16_t track;
+	const struct dvd_vobu_index *dvd_vobu_index;
+	const uint32_t *cell_start;
+	struct dvd_scene_frame *dvd_scene_frames;
+	uint32_t segment_vobus;
+	uint32_t segments;
+	uint32_t blocks;
+};
+
+/**
+ * Every worker has its own demuxer and decoder, the same as dvd_ppm's
+ */
+struct dvd_scenes_worker {
+	struct dvd_scenes dvd_scenes;
+	dvd_file_t *dvdread_vts_file;
+	struct dvd_demux *dvd_scenes_demux;
+	unsigned char *buffer;
+	uint32_t blocks;
+};
+
+/**
+ * Run the decoder, and make the histogram of the first picture it displays.
+ * Only I frames are decoded, the pictures after it in the blocks are
+ * skipped.
+ */
+static void dvd_scenes_parse(struct dvd_scenes *dvd_scenes) {
+
+	mpeg2_state_t state;
+
+	while(true) {
+
+		state = mpeg2_parse(dvd_scenes->mpeg2dec);
+
+		switch(state) {
+
+			case STATE_BUFFER:
+				return;
+
+			case STATE_PICTURE:
+				mpeg2_skip(dvd_scenes->mpeg2dec, (dvd_scenes->mpeg2_info->current_picture->flags & PIC_MASK_CODING_TYPE) != PIC_FLAG_CODING_TYPE_I);
+				break;
+
+			case STATE_SLICE:
+			case STATE_END:
+			case STATE_INVALID_END:
+				if(dvd_scenes->dvd_scene_frame->decoded || dvd_scenes->mpeg2_info->display_fbuf == NULL)
+					break;
+				if(dvd_scenes->mpeg2_info->display_picture != NULL && (dvd_scenes->mpeg2_info->display_picture->flags & PIC_FLAG_SKIP))
+					break;
+				dvd_scene_frame(dvd_scenes->mpeg2_info->display_fbuf->buf[0], (uint16_t)dvd_scenes->mpeg2_info->sequence->width, (uint16_t)dvd_scenes->mpeg2_info->sequence->height, dvd_scenes->dvd_scene_frame);
+				break;
+
+			default:
+				break;
+
+		}
+
+	}
+
+}
+
+static bool dvd_scenes_decode(void *data, const struct dvd_demux_packet *dvd_demux_packet) {
+
+	struct dvd_scenes *dvd_scenes = (struct dvd_scenes *)data;
+	uint8_t *buf = (uint8_t *)dvd_demux_packet->buffer;
+
+	if(dvd_scenes->dvd_scene_frame->decoded)
+		return true;
+
+	mpeg2_buffer(dvd_scenes->mpeg2dec, buf, buf + dvd_demux_packet->length);
+
+	dvd_scenes_parse(dvd_scenes);
+
+	return true;
+
+}
+
+/**
+ * Decode the I frame at the start of a VOBU, reading only the blocks up to
+ * the end of it.  A VOBU that can't be read or decoded is left out, and
+ * isn't an error.
+ */
+static bool dvd_scenes_vobu(struct dvd_scenes *dvd_scenes, dvd_file_t *dvdread_vts_file, struct dvd_demux *dvd_scenes_demux, const struct dvd_vobu *dvd_vobu, unsigned char *buffer, uint32_t *blocks_read) {
+
+	uint32_t blocks = dvd_vobu_first_ref_blocks(dvd_vobu);
+	uint8_t sequence_end[4] = { 0x00, 0x00, 0x01, 0xb7 };
+
+	if(blocks > DVD_PIPELINE_BLOCK_LIMIT)
+		blocks = DVD_PIPELINE_BLOCK_LIMIT;
+
+	if(DVDReadBlocks(dvdread_vts_file, (int)dvd_vobu->sector, blocks, buffer) != (ssize_t)blocks) {
+		fprintf(stderr, "* Could not read sector %u\n", dvd_vobu->sector);
+		return false;
+	}
+
+	*blocks_read += blocks;
+
+	mpeg2_reset(dvd_scenes->mpeg2dec, 1);
+	dvd_demux_reset(dvd_scenes_demux);
+
+	if(dvd_demux(dvd_scenes_demux, buffer, buffer + blocks * DVD_VIDEO_LB_LEN, DVD_DEMUX_PAYLOAD_START) == DVD_DEMUX_ERROR)
+		return false;
+
+	if(!dvd_scenes->dvd_scene_frame->decoded) {
+		mpeg2_buffer(dvd_scenes->mpeg2dec, sequence_end, sequence_end + sizeof(sequence_end));
+		dvd_scenes_parse(dvd_scenes);
+	}
+
+	return dvd_scenes->dvd_scene_frame->decoded;
+
+}
+
+static bool dvd_scenes_worker_open(void *data, void *worker, const uint16_t index, struct dvd_session *dvd_session) {
+
+	struct dvd_scenes_jobs *dvd_scenes_jobs = (struct dvd_scenes_jobs *)data;
+	struct dvd_scenes_worker *dvd_scenes_worker = (struct dvd_scenes_worker *)worker;
+	uint16_t vts = dvd_vts_ifo_number(dvd_session_vmg_ifo(dvd_session), dvd_scenes_jobs->track);
+
+	(void)index;
+
+	dvd_scenes_worker->dvd_scenes.mpeg2dec = mpeg2_init();
+	if(dvd_scenes_worker->dvd_scenes.mpeg2dec == NULL) {
+		fprintf(stderr, "%s: Could not create an MPEG-2 decoder\n", DVD_INFO_PROGRAM);
+		return false;
+	}
+	dvd_scenes_worker->dvd_scenes.mpeg2_info = mpeg2_info(dvd_scenes_worker->dvd_scenes.mpeg2dec);
+
+	dvd_scenes_worker->dvdread_vts_file = DVDOpenFile(dvd_session_dvdread(dvd_session), vts, DVD_READ_TITLE_VOBS);
+	if(dvd_scenes_worker->dvdread_vts_file == NULL) {
+		fprintf(stderr, "* Could not open VOBs for VTS %u\n", vts);
+		return false;
+	}
+
+	dvd_scenes_worker->buffer = malloc(DVD_PIPELINE_BLOCK_LIMIT * DVD_VIDEO_LB_LEN);
+	dvd_scenes_worker->dvd_scenes_demux = dvd_demux_open(DVD_DEMUX_VIDEO, dvd_scenes_decode, &dvd_scenes_worker->dvd_scenes);
+	if(dvd_scenes_worker->buffer == NULL || dvd_scenes_worker->dvd_scenes_demux == NULL) {
+		fprintf(stderr, "Couldn't allocate memory\n");
+		return false;
+	}
+
+	return true;
+
+}
+
+/**
+ * Decode the start of every VOBU in one segment
+ */
+static bool dvd_scenes_worker_job(void *data, void *worker, const uint32_t segment) {
+
+	struct dvd_scenes_jobs *dvd_scenes_jobs = (struct dvd_scenes_jobs *)data;
+	struct dvd_scenes_worker *dvd_scenes_worker = (struct dvd_scenes_worker *)worker;
+	struct dvd_scenes *dvd_scenes = &dvd_scenes_worker->dvd_scenes;
+	const struct dvd_vobu *dvd_vobu = NULL;
+	struct dvd_scene_frame *dvd_scene_frame = NULL;
+	uint32_t first = segment * dvd_scenes_jobs->segment_vobus;
+	uint32_t last = first + dvd_scenes_jobs->segment_vobus;
+	uint32_t ix = 0;
+
+	if(last > dvd_scenes_jobs->dvd_vobu_index->vobus)
+		last = dvd_scenes_jobs->dvd_vobu_index->vobus;
+
+	for(ix = first; ix < last; ix++) {
+
+		dvd_vobu = &dvd_scenes_jobs->dvd_vobu_index->vobu[ix];
+		dvd_scene_frame = &dvd_scenes_jobs->dvd_scene_frames[ix];
+
+		dvd_scene_frame->cell = dvd_vobu->cell;
+		dvd_scene_frame->msecs = dvd_scenes_jobs->cell_start[dvd_vobu->cell] + dvd_vobu->cell_msecs;
+
+		dvd_scenes->dvd_scene_frame = dvd_scene_frame;
+		dvd_scenes_vobu(dvd_scenes, dvd_scenes_worker->dvdread_vts_file, dvd_scenes_worker->dvd_scenes_demux, dvd_vobu, dvd_scenes_worker->buffer, &dvd_scenes_worker->blocks);
+
+	}
+
+	// A VOBU that can't be decoded is left out, it doesn't stop the others
+	return true;
+
+}
+
+static void dvd_scenes_worker_close(void *data, void *worker, const uint16_t index) {
+
+	struct dvd_scenes_jobs *dvd_scenes_jobs = (struct dvd_scenes_jobs *)data;
+	struct dvd_scenes_worker *dvd_scenes_worker = (struct dvd_scenes_worker *)worker;
+
+	(void)index;
+
+	dvd_scenes_jobs->blocks += dvd_scenes_worker->blocks;
+
+	dvd_demux_close(dvd_scenes_worker->dvd_scenes_demux);
+	free(dvd_scenes_worker->buffer);
+
+	if(dvd_scenes_worker->dvdread_vts_file != NULL)
+		DVDCloseFile(dvd_scenes_worker->dvdread_vts_file);
+
+	if(dvd_scenes_worker->dvd_scenes.mpeg2dec != NULL)
+		mpeg2_close(dvd_scenes_worker->dvd_scenes.mpeg2dec);
+
+}
+
+/**
+ * Split the segments across a number of workers, and wait for all of them
+ */
+static bool dvd_scenes_run(struct dvd_session *dvd_session, struct dvd_scenes_jobs *dvd_scenes_jobs, const uint16_t workers) {
+
+	struct dvd_workers dvd_workers;
+
+	memset(&dvd_workers, 0, sizeof(dvd_workers));
+	dvd_workers.jobs = dvd_scenes_jobs->segments;
+	dvd_workers.size = sizeof(struct dvd_scenes_worker);
+	dvd_workers.open = dvd_scenes_worker_open;
+	dvd_workers.job = dvd_scenes_worker_job;
+	dvd_workers.close = dvd_scenes_worker_close;
+	dvd_workers.data = dvd_scenes_jobs;
+
+	return dvd_workers_run(dvd_session, &dvd_workers, workers);
+
+}
+
+int main(int argc, char **argv) {
+
+	/**
+	 * Parse options
+	 */
+
+	bool opt_track_number = false;
+	bool opt_cells = false;
+	bool opt_list = false;
+	uint16_t arg_track_number = 0;
+	uint16_t arg_jobs = 1;
+	uint32_t arg_min_msecs = DVD_SCENE_MIN_MSECS;
+	uint16_t arg_cut = DVD_SCENE_CUT;
+	int long_index = 0;
+	int opt = 0;
+	opterr = 1;
+	const char *str_options;
+	str_options = "chj:lm:s:t:V";
+
+	struct option long_options[] = {
+
+		{ "cells", no_argument, 0, 'c' },
+		{ "jobs", required_argument, 0, 'j' },
+		{ "list", no_argument, 0, 'l' },
+		{ "min", required_argument, 0, 'm' },
+		{ "scene", required_argument, 0, 's' },
+		{ "track", required_argument, 0, 't' },
+		{ "help", no_argument, 0, 'h' },
+		{ "version", no_argument, 0, 'V' },
+		{ 0, 0, 0, 0 }
+
+	};
+
+	while((opt = getopt_long(argc, argv, str_options, long_options, &long_index )) != -1) {
+
+		switch(opt) {
+
+			case 'c':
+				opt_cells = true;
+				break;
+
+			case 'h':
+				print_usage(DVD_INFO_PROGRAM);
+				return 0;
+
+			case 'j':
+				arg_jobs = (uint16_t)strtoumax(optarg, NULL, 0);
+				if(arg_jobs < 1 || arg_jobs > DVD_SCENES_MAX_JOBS) {
+					fprintf(stderr, "Jobs must be between 1 and %u\n", DVD_SCENES_MAX_JOBS);
+					return 1;
+				}
+				break;
+
+			case 'l':
+				opt_list = true;
+				break;
+
+			case 'm':
+				if(!milliseconds_length_parse(&arg_min_msecs, optarg) || arg_min_msecs < 1000) {
+					fprintf(stderr, "Shortest chapter must be at least one second, as [[hh:]mm:]ss\n");
+					return 1;
+				}
+				break;
+
+			case 's':
+				arg_cut = (uint16_t)strtoumax(optarg, NULL, 0);
+				if(arg_cut < 1 || arg_cut > 100) {
+					fprintf(stderr, "Scene change must be between 1 and 100 percent\n");
+					return 1;
+				}
+				arg_cut *= 10;
+				break;
+
+			case 't':
+				opt_track_number = true;
+				arg_track_number = (uint16_t)strtoumax(optarg, NULL, 0);
+				break;
+
+			case 'V':
+				print_version(DVD_INFO_PROGRAM);
+				return 0;
+
+			// ignore unknown arguments
+			case '?':
+				print_usage(DVD_INFO_PROGRAM);
+				return 1;
+
+			// let getopt_long set the variable
+			case 0:
+			default:
+				break;
+
+		}
+
+	}
+
+	const char *device_filename = DEFAULT_DVD_DEVICE;
+
+	if (argv[optind])
+		device_filename = argv[optind];
+
+	// Open the DVD, the VMG IFO and check the drive status
+	struct dvd_session *dvd_session = NULL;
+	int session_error = DVD_SESSION_OK;
+
+	dvd_session = dvd_session_open(device_filename, &session_error);
+
+	if(dvd_session == NULL) {
+
+#ifdef __linux__
+		if(session_error == DVD_SESSION_ERR_NO_MEDIA) {
+			fprintf(stderr, "drive status: ");
+			dvd_drive_display_status(device_filename);
+			return 1;
+		}
+#endif
+
+		fprintf(stderr, "%s: %s: %s\n", DVD_INFO_PROGRAM, device_filename, dvd_session_strerror(session_error));
+		return 1;
+
+	}
+
+	struct dvd_info dvd_info;
+	dvd_session_info(dvd_session, &dvd_info);
+
+	uint16_t track_number = dvd_info.longest_track;
+
+	if(opt_track_number && (arg_track_number > dvd_info.tracks || arg_track_number < 1)) {
+		fprintf(stderr, "%s: Invalid track number %d\n", DVD_INFO_PROGRAM, arg_track_number);
+		fprintf(stderr, "%s: Valid track numbers: 1 to %u\n", DVD_INFO_PROGRAM, dvd_info.tracks);
+		dvd_session_close(dvd_session);
+		return 1;
+	} else if(opt_track_number) {
+		track_number = arg_track_number;
+	}
+
+	struct dvd_track dvd_track;
+	dvd_session_track(dvd_session, track_number, &dvd_track);
+
+	if(!dvd_track.valid) {
+		fprintf(stderr, "* Could not open VTS_IFO for track %u\n", track_number);
+		dvd_session_close(dvd_session);
+		return 1;
+	}
+
+	fprintf(stderr, "Track: %02u, Length: %s, Chapters: %02u, Cells: %02u\n", dvd_track.track, dvd_track.length, dvd_track.chapters, dvd_track.cells);
+
+	// Where each cell starts in the track, indexed by cell number
+	ifo_handle_t *vmg_ifo = dvd_session_vmg_ifo(dvd_session);
+	ifo_handle_t *vts_ifo = dvd_session_track_ifo(dvd_session, track_number);
+	uint32_t cell_start[256];
+	uint32_t cell_points[256];
+	uint16_t cell_count = 0;
+	uint16_t cell = 0;
+
+	dvd_cell_starts(vmg_ifo, vts_ifo, track_number, 1, cell_start);
+
+	if(opt_cells) {
+		for(cell = 2; cell < dvd_track.cells + 1; cell++)
+			cell_points[cell_count++] = cell_start[cell];
+	}
+
+	// Only the NAV packs are read for the index
+	struct timespec start_time;
+	struct timespec end_time;
+	struct dvd_vobu_index dvd_vobu_index;
+
+	clock_gettime(CLOCK_MONOTONIC, &start_time);
+
+	if(!dvd_vobu_index_track(dvd_session, track_number, &dvd_vobu_index) || dvd_vobu_index.vobus == 0) {
+		fprintf(stderr, "%s: Could not index the VOBUs of track %u\n", DVD_INFO_PROGRAM, track_number);
+		dvd_vobu_index_free(&dvd_vobu_index);
+		dvd_session_track_free(&dvd_track);
+		dvd_session_close(dvd_session);
+		return 1;
+	}
+
+	struct dvd_scenes_jobs dvd_scenes_jobs;
+	memset(&dvd_scenes_jobs, 0, sizeof(dvd_scenes_jobs));
+
+	dvd_scenes_jobs.track = track_number;
+	dvd_scenes_jobs.dvd_vobu_index = &dvd_vobu_index;
+	dvd_scenes_jobs.cell_start = cell_start;
+	dvd_scenes_jobs.segments = (uint32_t)arg_jobs * DVD_SCENES_SEGMENTS;
+	if(dvd_scenes_jobs.segments > dvd_vobu_index.vobus)
+		dvd_scenes_jobs.segments = dvd_vobu_index.vobus;
+	dvd_scenes_jobs.segment_vobus = (dvd_vobu_index.vobus + dvd_scenes_jobs.segments - 1) / dvd_scenes_jobs.segments;
+	dvd_scenes_jobs.segments = (dvd_vobu_index.vobus + dvd_scenes_jobs.segment_vobus - 1) / dvd_scenes_jobs.segment_vobus;
+	dvd_scenes_jobs.dvd_scene_frames = calloc(dvd_vobu_index.vobus, sizeof(struct dvd_scene_frame));
+
+	struct dvd_scene_point *candidates = calloc(dvd_vobu_index.vobus, sizeof(struct dvd_scene_point));
+	struct dvd_scene_point dvd_scene_points[DVD_SCENE_MAX_POINTS];
+	uint32_t chapter_msecs[DVD_SCENE_MAX_POINTS];
+	uint32_t candidate_count = 0;
+	uint16_t points = 0;
+	uint16_t ix = 0;
+	uint32_t decoded = 0;
+	uint32_t vobu = 0;
+	uint32_t msecs = 0;
+	char length[DVD_CHAPTER_LENGTH + 1] = {'\0'};
+	bool analyzed = false;
+
+	if(dvd_scenes_jobs.dvd_scene_frames == NULL || candidates == NULL)
+		fprintf(stderr, "Couldn't allocate memory\n");
+	else
+		analyzed = dvd_scenes_run(dvd_session, &dvd_scenes_jobs, arg_jobs);
+
+	clock_gettime(CLOCK_MONOTONIC, &end_time);
+
+	if(analyzed) {
+
+		for(vobu = 0; vobu < dvd_vobu_index.vobus; vobu++)
+			if(dvd_scenes_jobs.dvd_scene_frames[vobu].decoded)
+				decoded++;
+
+		msecs = (uint32_t)((end_time.tv_sec - start_time.tv_sec) * 1000 + (end_time.tv_nsec - start_time.tv_nsec) / 1000000);
+
+		fprintf(stderr, "VOBUs: %u, Decoded: %u, Blocks: %u of %zd, Time: %u.%03us, Speed: %.1fx\n", dvd_vobu_index.vobus, decoded, dvd_scenes_jobs.blocks, dvd_track.blocks, msecs / 1000, msecs % 1000, msecs ? (double)dvd_track.msecs / msecs : 0.0);
+
+		candidate_count = dvd_scene_candidates(dvd_scenes_jobs.dvd_scene_frames, dvd_vobu_index.vobus, arg_cut, candidates);
+		points = dvd_scene_select(candidates, candidate_count, cell_points, cell_count, dvd_track.msecs, arg_min_msecs, DVD_SCENE_SNAP_MSECS, dvd_scene_points);
+
+		if(opt_list) {
+			printf("Chapter: 01, Start: 00:00:00.000\n");
+			for(ix = 0; ix < points; ix++) {
+				milliseconds_length_format(length, dvd_scene_points[ix].msecs);
+				printf("Chapter: %02u, Start: %s, Type: %s, Score: %u\n", ix + 2, length, dvd_scene_type(dvd_scene_points[ix].type), dvd_scene_points[ix].score);
+			}
+		} else {
+			for(ix = 0; ix < points; ix++)
+				chapter_msecs[ix] = dvd_scene_points[ix].msecs;
+			dvd_ogm_msecs(chapter_msecs, points);
+		}
+
+	}
+
+	free(candidates);
+	free(dvd_scenes_jobs.dvd_scene_frames);
+	dvd_vobu_index_free(&dvd_vobu_index);
+	dvd_session_track_free(&dvd_track);
+	dvd_session_close(dvd_session);
+
+	return analyzed ? 0 : 1;
+
+}
+
+void print_usage(char *binary) {
+
+	printf("%s %s - find chapter points from scene changes and black frames\n", binary, VERSION);
+	printf("\n");
+	printf("Usage: %s [-t track] [-c] [-m length] [-s percent] [-j jobs] [-l] [dvd path]\n", binary);
+	printf("\n");
+	printf("Options:\n");
+	printf("  -t, --track <#>		Track to check (default: longest)\n");
+	printf("  -c, --cells			Add the cell boundaries, and move points close to\n");
+	printf("				one onto it\n");
+	printf("  -m, --min <[[hh:]mm:]ss>	Shortest chapter (default: %u)\n", DVD_SCENE_MIN_MSECS / 1000);
+	printf("  -s, --scene <#>		Change in the picture, as a percent, that is a scene\n");
+	printf("				cut (default: %u)\n", DVD_SCENE_CUT / 10);
+	printf("  -j, --jobs <#>			Check the track in segments with a number of workers,\n");
+	printf("				each with its own copy of the disc open (default: 1)\n");
+	printf("  -l, --list			List the points and why they were picked, instead of\n");
+	printf("				OGM chapters\n");
+	printf("\n");
+	printf("Only the I frame at the start of each VOBU is decoded.  Chapters are\n");
+	printf("displayed in the same OGM format as dvd_info -o.\n");
+	printf("\n");
+	printf("DVD path can be a directory, a device filename, or a local file.\n");
+	printf("\n");
+	printf("Examples:\n");
+	printf("  %s -j 4 movie.iso > chapters.txt\n", binary);
+	printf("  %s -c -m 5:00 " DEFAULT_DVD_DEVICE "\n", binary);
+	printf("\n");
+	printf("If no DVD path is given, %s is used in its place.\n", DEFAULT_DVD_DEVICE);
+
+}
+
+void print_version(char *binary) {
+
+	printf("%s %s - http://dvds.beandog.org/ - (c) 2018 Steve Dibb <steve.dibb@gmail.com>, licensed under GPL-2\n", binary, VERSION);
+
+}
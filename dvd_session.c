@@ -0,0 +1,573 @@
+#include "dvd_session.h"
+
+/**
+ * Functions used to keep a DVD open and query it through one handle
+ */
+
+struct dvd_session {
+	char device_filename[PATH_MAX];
+	dvd_reader_t *dvdread_dvd;
+	ifo_handle_t *vmg_ifo;
+	ifo_handle_t *vts_ifos[DVD_MAX_VTS_IFOS + 1];
+	bool opened_ifos[DVD_MAX_VTS_IFOS + 1];
+	uint16_t video_title_sets;
+	uint16_t tracks;
+	uint16_t longest_track;
+	char dvdread_id[DVD_DVDREAD_ID + 1];
+	char title[DVD_TITLE + 1];
+};
+
+/**
+ * Open a DVD source and the VMG IFO
+ *
+ * The same checks that the programs have always done before using libdvdread
+ * are done here: the source has to exist, has to be readable, and if it is a
+ * drive, it has to have a disc in it.
+ *
+ * @param device_filename device filename (/dev/dvd, dvd.iso, etc.)
+ * @param error set to one of DVD_SESSION_ERR_* on failure, can be NULL
+ * @return session handle, or NULL if it could not be opened
+ */
+struct dvd_session *dvd_session_open(const char *device_filename, int *error) {
+
+	struct dvd_session *dvd_session = NULL;
+	int dvd_fd = -1;
+	int retval = DVD_SESSION_OK;
+
+	if(error)
+		*error = DVD_SESSION_OK;
+
+	if(!dvd_device_access(device_filename)) {
+		retval = DVD_SESSION_ERR_ACCESS;
+		goto failed;
+	}
+
+	dvd_fd = dvd_device_open(device_filename);
+	if(dvd_fd < 0) {
+		retval = DVD_SESSION_ERR_DEVICE;
+		goto failed;
+	}
+	dvd_device_close(dvd_fd);
+
+#ifdef __linux__
+
+	if(dvd_device_is_hardware(device_filename) && !dvd_drive_has_media(device_filename)) {
+		retval = DVD_SESSION_ERR_NO_MEDIA;
+		goto failed;
+	}
+
+#endif
+
+	dvd_session = calloc(1, sizeof(*dvd_session));
+	if(dvd_session == NULL) {
+		retval = DVD_SESSION_ERR_MEMORY;
+		goto failed;
+	}
+
+	strncpy(dvd_session->device_filename, device_filename, PATH_MAX - 1);
+
+	dvd_session->dvdread_dvd = DVDOpen(device_filename);
+	if(!dvd_session->dvdread_dvd) {
+		retval = DVD_SESSION_ERR_DVDREAD;
+		goto failed;
+	}
+
+	dvd_dvdread_id(dvd_session->dvdread_id, dvd_session->dvdread_dvd);
+	if(strlen(dvd_session->dvdread_id) == 0) {
+		retval = DVD_SESSION_ERR_DVDREAD_ID;
+		goto failed;
+	}
+
+	dvd_session->vmg_ifo = ifoOpen(dvd_session->dvdread_dvd, 0);
+	if(dvd_session->vmg_ifo == NULL || !ifo_is_vmg(dvd_session->vmg_ifo)) {
+		retval = DVD_SESSION_ERR_VMG_IFO;
+		goto failed;
+	}
+
+	dvd_session->tracks = dvd_tracks(dvd_session->vmg_ifo);
+	dvd_session->video_title_sets = dvd_video_title_sets(dvd_session->vmg_ifo);
+
+	if(dvd_session->video_title_sets < 1) {
+		retval = DVD_SESSION_ERR_NO_VTS;
+		goto failed;
+	}
+
+	if(dvd_session->video_title_sets > DVD_MAX_VTS_IFOS)
+		dvd_session->video_title_sets = DVD_MAX_VTS_IFOS;
+
+	// The title is read from the volume, not through libdvdread, and will be
+	// empty for directories
+	dvd_title(dvd_session->title, device_filename);
+
+	return dvd_session;
+
+	failed:
+
+	if(error)
+		*error = retval;
+
+	dvd_session_close(dvd_session);
+
+	return NULL;
+
+}
+
+/**
+ * Close all the IFOs and the dvdread handle, and free the session
+ *
+ * @param dvd_session session handle, can be NULL
+ */
+void dvd_session_close(struct dvd_session *dvd_session) {
+
+	uint16_t vts = 0;
+
+	if(dvd_session == NULL)
+		return;
+
+	for(vts = 1; vts <= DVD_MAX_VTS_IFOS; vts++) {
+		if(dvd_session->vts_ifos[vts])
+			ifoClose(dvd_session->vts_ifos[vts]);
+	}
+
+	if(dvd_session->vmg_ifo)
+		ifoClose(dvd_session->vmg_ifo);
+
+	if(dvd_session->dvdread_dvd)
+		DVDClose(dvd_session->dvdread_dvd);
+
+	free(dvd_session);
+
+}
+
+/**
+ * Human readable string for a DVD_SESSION_ERR_* value
+ */
+const char *dvd_session_strerror(const int error) {
+
+	switch(error) {
+		case DVD_SESSION_OK:
+			return "no error";
+		case DVD_SESSION_ERR_ACCESS:
+			return "cannot access device";
+		case DVD_SESSION_ERR_DEVICE:
+			return "error opening device";
+		case DVD_SESSION_ERR_NO_MEDIA:
+			return "drive has no media";
+		case DVD_SESSION_ERR_DVDREAD:
+			return "dvdread could not open device";
+		case DVD_SESSION_ERR_DVDREAD_ID:
+			return "could not get dvdread id";
+		case DVD_SESSION_ERR_VMG_IFO:
+			return "opening VMG IFO failed";
+		case DVD_SESSION_ERR_NO_VTS:
+			return "DVD has no title IFOs";
+		case DVD_SESSION_ERR_MEMORY:
+			return "could not allocate memory";
+		default:
+			return "unknown error";
+	}
+
+}
+
+const char *dvd_session_device(const struct dvd_session *dvd_session) {
+
+	return dvd_session->device_filename;
+
+}
+
+dvd_reader_t *dvd_session_dvdread(struct dvd_session *dvd_session) {
+
+	return dvd_session->dvdread_dvd;
+
+}
+
+ifo_handle_t *dvd_session_vmg_ifo(struct dvd_session *dvd_session) {
+
+	return dvd_session->vmg_ifo;
+
+}
+
+/**
+ * Get a VTS IFO, opening it the first time it is asked for
+ *
+ * IFOs that fail to open, or that libdvdread opens but aren't a VTS, are
+ * only tried once and after that are always returned as NULL.
+ *
+ * @param dvd_session session handle
+ * @param vts VTS number, starting at 1
+ * @return IFO handle, or NULL if the IFO is invalid
+ */
+ifo_handle_t *dvd_session_vts_ifo(struct dvd_session *dvd_session, const uint16_t vts) {
+
+	if(vts < 1 || vts > dvd_session->video_title_sets)
+		return NULL;
+
+	if(dvd_session->opened_ifos[vts])
+		return dvd_session->vts_ifos[vts];
+
+	dvd_session->opened_ifos[vts] = true;
+	dvd_session->vts_ifos[vts] = ifoOpen(dvd_session->dvdread_dvd, vts);
+
+	if(dvd_session->vts_ifos[vts] != NULL && !ifo_is_vts(dvd_session->vts_ifos[vts])) {
+		ifoClose(dvd_session->vts_ifos[vts]);
+		dvd_session->vts_ifos[vts] = NULL;
+	}
+
+	return dvd_session->vts_ifos[vts];
+
+}
+
+/**
+ * Get the VTS IFO that a track resides in
+ *
+ * @param dvd_session session handle
+ * @param track_number track number
+ * @return IFO handle, or NULL if the track or IFO is invalid
+ */
+ifo_handle_t *dvd_session_track_ifo(struct dvd_session *dvd_session, const uint16_t track_number) {
+
+	if(track_number < 1 || track_number > dvd_session->tracks)
+		return NULL;
+
+	uint16_t vts = dvd_vts_ifo_number(dvd_session->vmg_ifo, track_number);
+
+	return dvd_session_vts_ifo(dvd_session, vts);
+
+}
+
+/**
+ * Open all the VTS IFOs and count the ones that are invalid
+ *
+ * @param dvd_session session handle
+ * @return number of invalid IFOs
+ */
+uint16_t dvd_session_invalid_ifos(struct dvd_session *dvd_session) {
+
+	uint16_t vts = 0;
+	uint16_t invalid_ifos = 0;
+
+	for(vts = 1; vts < dvd_session->video_title_sets + 1; vts++) {
+		if(dvd_session_vts_ifo(dvd_session, vts) == NULL)
+			invalid_ifos++;
+	}
+
+	return invalid_ifos;
+
+}
+
+uint16_t dvd_session_tracks(const struct dvd_session *dvd_session) {
+
+	return dvd_session->tracks;
+
+}
+
+/**
+ * Get the longest track on the DVD, based on the track length in the PGC
+ *
+ * If two tracks have the same length, the first one wins.
+ *
+ * @param dvd_session session handle
+ * @return track number
+ */
+uint16_t dvd_session_longest_track(struct dvd_session *dvd_session) {
+
+	if(dvd_session->longest_track)
+		return dvd_session->longest_track;
+
+	uint16_t track_number = 1;
+	uint32_t msecs = 0;
+	uint32_t longest_msecs = 0;
+	ifo_handle_t *vts_ifo = NULL;
+
+	dvd_session->longest_track = 1;
+
+	for(track_number = 1; track_number < dvd_session->tracks + 1; track_number++) {
+
+		vts_ifo = dvd_session_track_ifo(dvd_session, track_number);
+
+		if(vts_ifo == NULL)
+			continue;
+
+		msecs = dvd_track_msecs(dvd_session->vmg_ifo, vts_ifo, track_number);
+
+		if(msecs > longest_msecs) {
+			dvd_session->longest_track = track_number;
+			longest_msecs = msecs;
+		}
+
+	}
+
+	return dvd_session->longest_track;
+
+}
+
+void dvd_session_info(struct dvd_session *dvd_session, struct dvd_info *dvd_info) {
+
+	memset(dvd_info, 0, sizeof(*dvd_info));
+
+	snprintf(dvd_info->dvdread_id, sizeof(dvd_info->dvdread_id), "%s", dvd_session->dvdread_id);
+	snprintf(dvd_info->title, sizeof(dvd_info->title), "%s", dvd_session->title);
+	dvd_info->video_title_sets = dvd_session->video_title_sets;
+	dvd_info->side = dvd_info_side(dvd_session->vmg_ifo);
+	dvd_provider_id(dvd_info->provider_id, dvd_session->vmg_ifo);
+	dvd_vmg_id(dvd_info->vmg_id, dvd_session->vmg_ifo);
+	dvd_info->tracks = dvd_session->tracks;
+	dvd_info->longest_track = dvd_session_longest_track(dvd_session);
+
+}
+
+/**
+ * Get everything about a track: the track itself, video, and all the audio
+ * streams, subtitles, chapters and cells.
+ *
+ * The streams, chapters and cells are allocated, and need to be released
+ * with dvd_session_track_free() afterwards.
+ *
+ * If the track is on an invalid IFO, it is still populated with its number
+ * and VTS, but is flagged as not valid and everything else is empty.
+ *
+ * @param dvd_session session handle
+ * @param track_number track number
+ * @param dvd_track track to populate
+ * @return false if the track number doesn't exist
+ */
+bool dvd_session_track(struct dvd_session *dvd_session, const uint16_t track_number, struct dvd_track *dvd_track) {
+
+	memset(dvd_track, 0, sizeof(*dvd_track));
+
+	if(track_number < 1 || track_number > dvd_session->tracks)
+		return false;
+
+	ifo_handle_t *vmg_ifo = dvd_session->vmg_ifo;
+	ifo_handle_t *vts_ifo = dvd_session_track_ifo(dvd_session, track_number);
+	uint8_t c = 0;
+
+	dvd_track->track = track_number;
+	dvd_track->vts = dvd_vts_ifo_number(vmg_ifo, track_number);
+	dvd_track->ttn = dvd_track_ttn(vmg_ifo, track_number);
+	snprintf(dvd_track->length, DVD_TRACK_LENGTH + 1, "00:00:00.000");
+
+	if(vts_ifo == NULL) {
+		dvd_track->valid = false;
+		return true;
+	}
+
+	dvd_track->valid = true;
+	dvd_track_length(dvd_track->length, vmg_ifo, vts_ifo, track_number);
+	dvd_track->msecs = dvd_track_msecs(vmg_ifo, vts_ifo, track_number);
+	dvd_track->chapters = dvd_track_chapters(vmg_ifo, vts_ifo, track_number);
+	dvd_track->cells = dvd_track_cells(vmg_ifo, vts_ifo, track_number);
+	dvd_track->audio_tracks = dvd_track_audio_tracks(vts_ifo);
+	dvd_track->subtitles = dvd_track_subtitles(vts_ifo);
+	dvd_track->blocks = dvd_track_blocks(vmg_ifo, vts_ifo, track_number);
+	dvd_track->filesize = dvd_track_filesize(vmg_ifo, vts_ifo, track_number);
+
+	dvd_session_video(dvd_session, track_number, &dvd_track->dvd_video);
+
+	/** Audio Streams **/
+
+	if(dvd_track->audio_tracks)
+		dvd_track->dvd_audio_tracks = calloc(dvd_track->audio_tracks, sizeof(*dvd_track->dvd_audio_tracks));
+
+	if(dvd_track->dvd_audio_tracks != NULL) {
+
+		for(c = 0; c < dvd_track->audio_tracks; c++) {
+
+			dvd_session_audio(dvd_session, track_number, c + 1, &dvd_track->dvd_audio_tracks[c]);
+
+			if(dvd_track->dvd_audio_tracks[c].active)
+				dvd_track->active_audio_streams++;
+
+		}
+
+	}
+
+	/** Subtitles **/
+
+	if(dvd_track->subtitles)
+		dvd_track->dvd_subtitles = calloc(dvd_track->subtitles, sizeof(*dvd_track->dvd_subtitles));
+
+	if(dvd_track->dvd_subtitles != NULL) {
+
+		for(c = 0; c < dvd_track->subtitles; c++) {
+
+			dvd_session_subtitle(dvd_session, track_number, c + 1, &dvd_track->dvd_subtitles[c]);
+
+			if(dvd_track->dvd_subtitles[c].active)
+				dvd_track->active_subs++;
+
+		}
+
+	}
+
+	/** Chapters **/
+
+	if(dvd_track->chapters)
+		dvd_track->dvd_chapters = calloc(dvd_track->chapters, sizeof(*dvd_track->dvd_chapters));
+
+	if(dvd_track->dvd_chapters != NULL) {
+
+		for(c = 0; c < dvd_track->chapters; c++)
+			dvd_session_chapter(dvd_session, track_number, c + 1, &dvd_track->dvd_chapters[c]);
+
+	}
+
+	/** Cells **/
+
+	if(dvd_track->cells)
+		dvd_track->dvd_cells = calloc(dvd_track->cells, sizeof(*dvd_track->dvd_cells));
+
+	if(dvd_track->dvd_cells != NULL) {
+
+		for(c = 0; c < dvd_track->cells; c++)
+			dvd_session_cell(dvd_session, track_number, c + 1, &dvd_track->dvd_cells[c]);
+
+	}
+
+	return true;
+
+}
+
+/**
+ * Release the streams, chapters and cells allocated by dvd_session_track()
+ */
+void dvd_session_track_free(struct dvd_track *dvd_track) {
+
+	free(dvd_track->dvd_audio_tracks);
+	free(dvd_track->dvd_subtitles);
+	free(dvd_track->dvd_chapters);
+	free(dvd_track->dvd_cells);
+
+	dvd_track->dvd_audio_tracks = NULL;
+	dvd_track->dvd_subtitles = NULL;
+	dvd_track->dvd_chapters = NULL;
+	dvd_track->dvd_cells = NULL;
+
+}
+
+bool dvd_session_video(struct dvd_session *dvd_session, const uint16_t track_number, struct dvd_video *dvd_video) {
+
+	memset(dvd_video, 0, sizeof(*dvd_video));
+
+	ifo_handle_t *vmg_ifo = dvd_session->vmg_ifo;
+	ifo_handle_t *vts_ifo = dvd_session_track_ifo(dvd_session, track_number);
+
+	if(vts_ifo == NULL)
+		return false;
+
+	dvd_video_codec(dvd_video->codec, vts_ifo);
+	dvd_track_video_format(dvd_video->format, vts_ifo);
+	dvd_video_aspect_ratio(dvd_video->aspect_ratio, vts_ifo);
+	dvd_video->width = dvd_video_width(vts_ifo);
+	dvd_video->height = dvd_video_height(vts_ifo);
+	dvd_video->letterbox = dvd_video_letterbox(vts_ifo);
+	dvd_video->pan_and_scan = dvd_video_pan_scan(vts_ifo);
+	dvd_video->df = dvd_video_df(vts_ifo);
+	dvd_video->angles = dvd_video_angles(vmg_ifo, track_number);
+	dvd_track_str_fps(dvd_video->fps, vmg_ifo, vts_ifo, track_number);
+
+	return true;
+
+}
+
+/**
+ * Get an audio stream for a track
+ *
+ * @param audio_track audio track number, starting at 1
+ */
+bool dvd_session_audio(struct dvd_session *dvd_session, const uint16_t track_number, const uint8_t audio_track, struct dvd_audio *dvd_audio) {
+
+	memset(dvd_audio, 0, sizeof(*dvd_audio));
+
+	ifo_handle_t *vmg_ifo = dvd_session->vmg_ifo;
+	ifo_handle_t *vts_ifo = dvd_session_track_ifo(dvd_session, track_number);
+
+	if(vts_ifo == NULL || audio_track < 1 || audio_track > dvd_track_audio_tracks(vts_ifo))
+		return false;
+
+	dvd_audio->track = audio_track;
+	dvd_audio->active = dvd_audio_active(vmg_ifo, vts_ifo, track_number, audio_track);
+	dvd_audio->channels = dvd_audio_channels(vts_ifo, audio_track - 1);
+	dvd_audio_stream_id(dvd_audio->stream_id, vts_ifo, audio_track - 1);
+	dvd_audio_lang_code(dvd_audio->lang_code, vts_ifo, audio_track - 1);
+	dvd_audio_codec(dvd_audio->codec, vts_ifo, audio_track - 1);
+
+	return true;
+
+}
+
+/**
+ * Get a subtitle stream for a track
+ *
+ * @param subtitle_track subtitle track number, starting at 1
+ */
+bool dvd_session_subtitle(struct dvd_session *dvd_session, const uint16_t track_number, const uint8_t subtitle_track, struct dvd_subtitle *dvd_subtitle) {
+
+	memset(dvd_subtitle, 0, sizeof(*dvd_subtitle));
+
+	ifo_handle_t *vmg_ifo = dvd_session->vmg_ifo;
+	ifo_handle_t *vts_ifo = dvd_session_track_ifo(dvd_session, track_number);
+
+	if(vts_ifo == NULL || subtitle_track < 1 || subtitle_track > dvd_track_subtitles(vts_ifo))
+		return false;
+
+	dvd_subtitle->track = subtitle_track;
+	dvd_subtitle->active = dvd_subtitle_active(vmg_ifo, vts_ifo, track_number, subtitle_track);
+	dvd_subtitle_stream_id(dvd_subtitle->stream_id, subtitle_track - 1);
+	dvd_subtitle_lang_code(dvd_subtitle->lang_code, vts_ifo, subtitle_track - 1);
+
+	return true;
+
+}
+
+/**
+ * Get a chapter for a track
+ *
+ * @param chapter_number chapter number, starting at 1
+ */
+bool dvd_session_chapter(struct dvd_session *dvd_session, const uint16_t track_number, const uint8_t chapter_number, struct dvd_chapter *dvd_chapter) {
+
+	memset(dvd_chapter, 0, sizeof(*dvd_chapter));
+
+	ifo_handle_t *vmg_ifo = dvd_session->vmg_ifo;
+	ifo_handle_t *vts_ifo = dvd_session_track_ifo(dvd_session, track_number);
+
+	if(vts_ifo == NULL || chapter_number < 1 || chapter_number > dvd_track_chapters(vmg_ifo, vts_ifo, track_number))
+		return false;
+
+	dvd_chapter->chapter = chapter_number;
+	dvd_chapter_length(dvd_chapter->length, vmg_ifo, vts_ifo, track_number, chapter_number);
+	dvd_chapter->msecs = dvd_chapter_msecs(vmg_ifo, vts_ifo, track_number, chapter_number);
+	dvd_chapter->first_cell = dvd_chapter_first_cell(vmg_ifo, vts_ifo, track_number, chapter_number);
+	dvd_chapter->last_cell = dvd_chapter_last_cell(vmg_ifo, vts_ifo, track_number, chapter_number);
+
+	return true;
+
+}
+
+/**
+ * Get a cell for a track
+ *
+ * @param cell_number cell number, starting at 1
+ */
+bool dvd_session_cell(struct dvd_session *dvd_session, const uint16_t track_number, const uint8_t cell_number, struct dvd_cell *dvd_cell) {
+
+	memset(dvd_cell, 0, sizeof(*dvd_cell));
+
+	ifo_handle_t *vmg_ifo = dvd_session->vmg_ifo;
+	ifo_handle_t *vts_ifo = dvd_session_track_ifo(dvd_session, track_number);
+
+	if(vts_ifo == NULL || cell_number < 1 || cell_number > dvd_track_cells(vmg_ifo, vts_ifo, track_number))
+		return false;
+
+	dvd_cell->cell = cell_number;
+	dvd_cell_length(dvd_cell->length, vmg_ifo, vts_ifo, track_number, cell_number);
+	dvd_cell->msecs = dvd_cell_msecs(vmg_ifo, vts_ifo, track_number, cell_number);
+	dvd_cell->first_sector = dvd_cell_first_sector(vmg_ifo, vts_ifo, track_number, cell_number);
+	dvd_cell->last_sector = dvd_cell_last_sector(vmg_ifo, vts_ifo, track_number, cell_number);
+	dvd_cell->blocks = dvd_cell_blocks(vmg_ifo, vts_ifo, track_number, cell_number);
+	dvd_cell->filesize = dvd_cell_filesize(vmg_ifo, vts_ifo, track_number, cell_number);
+
+	return true;
+
+}
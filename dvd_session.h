@@ -0,0 +1,98 @@
+#ifndef DVD_INFO_SESSION_H
+#define DVD_INFO_SESSION_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <dvdread/dvd_reader.h>
+#include <dvdread/ifo_read.h>
+#include "dvd_info.h"
+#include "dvd_device.h"
+#include "dvd_drive.h"
+#include "dvd_vmg_ifo.h"
+#include "dvd_track.h"
+#include "dvd_chapter.h"
+#include "dvd_cell.h"
+#include "dvd_video.h"
+#include "dvd_audio.h"
+#include "dvd_subtitles.h"
+#include "dvd_time.h"
+
+/**
+ * libdvdinfo session
+ *
+ * A session is one open DVD source (device, image or directory) that keeps
+ * the dvdread handle and the IFOs open for as long as it is in use, so that
+ * any number of queries can be made against it without opening the disc
+ * again.  On a hardware drive, opening the disc and authenticating CSS is the
+ * slowest part of getting anything from a DVD.
+ *
+ * The VMG IFO is opened right away, the VTS IFOs are opened the first time
+ * something asks for them and then kept.
+ *
+ * Sessions are not thread-safe.  If more than one thread uses the same one,
+ * the caller has to serialize access to it.
+ *
+ * struct dvd_session *dvd_session = dvd_session_open("/dev/sr0", &error);
+ * if(dvd_session == NULL)
+ * 	printf("%s\n", dvd_session_strerror(error));
+ *
+ * struct dvd_track dvd_track;
+ * dvd_session_track(dvd_session, 1, &dvd_track);
+ * ...
+ * dvd_session_track_free(&dvd_track);
+ * dvd_session_close(dvd_session);
+ */
+
+#define DVD_SESSION_OK 0
+#define DVD_SESSION_ERR_ACCESS 1
+#define DVD_SESSION_ERR_DEVICE 2
+#define DVD_SESSION_ERR_NO_MEDIA 3
+#define DVD_SESSION_ERR_DVDREAD 4
+#define DVD_SESSION_ERR_DVDREAD_ID 5
+#define DVD_SESSION_ERR_VMG_IFO 6
+#define DVD_SESSION_ERR_NO_VTS 7
+#define DVD_SESSION_ERR_MEMORY 8
+
+struct dvd_session;
+
+struct dvd_session *dvd_session_open(const char *device_filename, int *error);
+
+void dvd_session_close(struct dvd_session *dvd_session);
+
+const char *dvd_session_strerror(const int error);
+
+const char *dvd_session_device(const struct dvd_session *dvd_session);
+
+dvd_reader_t *dvd_session_dvdread(struct dvd_session *dvd_session);
+
+ifo_handle_t *dvd_session_vmg_ifo(struct dvd_session *dvd_session);
+
+ifo_handle_t *dvd_session_vts_ifo(struct dvd_session *dvd_session, const uint16_t vts);
+
+ifo_handle_t *dvd_session_track_ifo(struct dvd_session *dvd_session, const uint16_t track_number);
+
+uint16_t dvd_session_invalid_ifos(struct dvd_session *dvd_session);
+
+uint16_t dvd_session_tracks(const struct dvd_session *dvd_session);
+
+uint16_t dvd_session_longest_track(struct dvd_session *dvd_session);
+
+void dvd_session_info(struct dvd_session *dvd_session, struct dvd_info *dvd_info);
+
+bool dvd_session_track(struct dvd_session *dvd_session, const uint16_t track_number, struct dvd_track *dvd_track);
+
+void dvd_session_track_free(struct dvd_track *dvd_track);
+
+bool dvd_session_video(struct dvd_session *dvd_session, const uint16_t track_number, struct dvd_video *dvd_video);
+
+bool dvd_session_audio(struct dvd_session *dvd_session, const uint16_t track_number, const uint8_t audio_track, struct dvd_audio *dvd_audio);
+
+bool dvd_session_subtitle(struct dvd_session *dvd_session, const uint16_t track_number, const uint8_t subtitle_track, struct dvd_subtitle *dvd_subtitle);
+
+bool dvd_session_chapter(struct dvd_session *dvd_session, const uint16_t track_number, const uint8_t chapter_number, struct dvd_chapter *dvd_chapter);
+
+bool dvd_session_cell(struct dvd_session *dvd_session, const uint16_t track_number, const uint8_t cell_number, struct dvd_cell *dvd_cell);
+
+#endif
@@ -0,0 +1,164 @@
+#include <pthread.h>
+#include "dvd_startcode.h"
+#ifdef DVD_STARTCODE_X86
+#include <immintrin.h>
+#endif
+
+/**
+ * Where to pick up when no whole prefix was found: the last two bytes could
+ * be "00 00" or "00", the start of one split across two buffers.
+ */
+static const uint8_t *dvd_startcode_tail(const uint8_t *buf, const uint8_t *end) {
+
+	if(end - buf > 2)
+		return end - 2;
+
+	return buf;
+
+}
+
+const uint8_t *dvd_startcode_scalar(const uint8_t *buf, const uint8_t *end) {
+
+	const uint8_t *p = buf;
+
+	// The third byte has to be 1, so step by three over anything larger
+	while(p + 2 < end) {
+
+		if(p[2] > 1)
+			p += 3;
+		else if(p[2] == 0)
+			p++;
+		else if(p[0] == 0 && p[1] == 0)
+			return p;
+		else
+			p += 3;
+
+	}
+
+	return dvd_startcode_tail(buf, end);
+
+}
+
+#ifdef DVD_STARTCODE_X86
+
+/**
+ * Compare 16 (or 32) positions at a time: the byte, and the one after it,
+ * are 0, and the one after that is 1.  The scalar version finishes off what
+ * is left at the end.
+ */
+__attribute__((target("sse2")))
+const uint8_t *dvd_startcode_sse2(const uint8_t *buf, const uint8_t *end) {
+
+	const uint8_t *p = buf;
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i one = _mm_set1_epi8(1);
+	__m128i b0, b1, b2;
+	int mask = 0;
+
+	while(p + 18 <= end) {
+
+		b0 = _mm_loadu_si128((const __m128i *)p);
+		b1 = _mm_loadu_si128((const __m128i *)(p + 1));
+		b2 = _mm_loadu_si128((const __m128i *)(p + 2));
+
+		mask = _mm_movemask_epi8(_mm_and_si128(_mm_and_si128(_mm_cmpeq_epi8(b0, zero), _mm_cmpeq_epi8(b1, zero)), _mm_cmpeq_epi8(b2, one)));
+
+		if(mask)
+			return p + __builtin_ctz((unsigned int)mask);
+
+		p += 16;
+
+	}
+
+	p = dvd_startcode_scalar(p, end);
+
+	if(p + 2 < end)
+		return p;
+
+	return dvd_startcode_tail(buf, end);
+
+}
+
+__attribute__((target("avx2")))
+const uint8_t *dvd_startcode_avx2(const uint8_t *buf, const uint8_t *end) {
+
+	const uint8_t *p = buf;
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i one = _mm256_set1_epi8(1);
+	__m256i b0, b1, b2;
+	int mask = 0;
+
+	while(p + 34 <= end) {
+
+		b0 = _mm256_loadu_si256((const __m256i *)p);
+		b1 = _mm256_loadu_si256((const __m256i *)(p + 1));
+		b2 = _mm256_loadu_si256((const __m256i *)(p + 2));
+
+		mask = _mm256_movemask_epi8(_mm256_and_si256(_mm256_and_si256(_mm256_cmpeq_epi8(b0, zero), _mm256_cmpeq_epi8(b1, zero)), _mm256_cmpeq_epi8(b2, one)));
+
+		if(mask)
+			return p + __builtin_ctz((unsigned int)mask);
+
+		p += 32;
+
+	}
+
+	p = dvd_startcode_sse2(p, end);
+
+	if(p + 2 < end)
+		return p;
+
+	return dvd_startcode_tail(buf, end);
+
+}
+
+#endif
+
+typedef const uint8_t *(*dvd_startcode_t)(const uint8_t *buf, const uint8_t *end);
+
+static dvd_startcode_t dvd_startcode_function = dvd_startcode_scalar;
+static const char *dvd_startcode_function_name = "scalar";
+static pthread_once_t dvd_startcode_once = PTHREAD_ONCE_INIT;
+
+static void dvd_startcode_init(void) {
+
+#ifdef DVD_STARTCODE_X86
+	__builtin_cpu_init();
+
+	if(__builtin_cpu_supports("avx2")) {
+		dvd_startcode_function = dvd_startcode_avx2;
+		dvd_startcode_function_name = "avx2";
+	} else if(__builtin_cpu_supports("sse2")) {
+		dvd_startcode_function = dvd_startcode_sse2;
+		dvd_startcode_function_name = "sse2";
+	}
+#endif
+
+}
+
+/**
+ * Find the next start code prefix (00 00 01)
+ *
+ * @param buf start of data
+ * @param end end of data
+ * @return position of the prefix, or where a prefix cut off at the end would
+ * start
+ */
+const uint8_t *dvd_startcode(const uint8_t *buf, const uint8_t *end) {
+
+	pthread_once(&dvd_startcode_once, dvd_startcode_init);
+
+	return dvd_startcode_function(buf, end);
+
+}
+
+/**
+ * Which version is being used: "avx2", "sse2" or "scalar"
+ */
+const char *dvd_startcode_name(void) {
+
+	pthread_once(&dvd_startcode_once, dvd_startcode_init);
+
+	return dvd_startcode_function_name;
+
+}
@@ -0,0 +1,36 @@
+#ifndef DVD_INFO_STARTCODE_H
+#define DVD_INFO_STARTCODE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+/**
+ * MPEG start code search
+ *
+ * Finds the next 00 00 01 prefix in a buffer.  The widest version the CPU
+ * supports (AVX2, SSE2, or plain C) is picked the first time it is called.
+ *
+ * If there isn't a whole prefix in the buffer, the position returned is the
+ * first one that could still be the start of a prefix that is cut off at the
+ * end (two bytes before the end), so the caller can hold on to those bytes
+ * until more data comes in.  It is never before buf.
+ */
+
+const uint8_t *dvd_startcode(const uint8_t *buf, const uint8_t *end);
+
+const char *dvd_startcode_name(void);
+
+// Each version, for comparing them
+const uint8_t *dvd_startcode_scalar(const uint8_t *buf, const uint8_t *end);
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define DVD_STARTCODE_X86 1
+
+const uint8_t *dvd_startcode_sse2(const uint8_t *buf, const uint8_t *end);
+
+const uint8_t *dvd_startcode_avx2(const uint8_t *buf, const uint8_t *end);
+#endif
+
+#endif
@@ -0,0 +1,141 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+#include "dvd_startcode.h"
+
+/**
+ * Compare the start code search against the byte-at-a-time loop the demuxer
+ * used to resync with, on data with a start code every so often (the
+ * distance is random, up to the size given).
+ *
+ * Not built by default: make dvd_startcode_bench
+ */
+
+#define DVD_STARTCODE_BENCH_SIZE (64 * 1024 * 1024)
+#define DVD_STARTCODE_BENCH_ROUNDS 5
+
+typedef const uint8_t *(*dvd_startcode_t)(const uint8_t *buf, const uint8_t *end);
+
+/**
+ * The old resync loop: check for 00 00 01, and move one byte ahead if not
+ */
+static const uint8_t *dvd_startcode_bytes(const uint8_t *buf, const uint8_t *end) {
+
+	const uint8_t *p = buf;
+
+	while(p + 2 < end) {
+		if(!(p[0] || p[1] || (p[2] != 1)))
+			return p;
+		p++;
+	}
+
+	if(end - buf > 2)
+		return end - 2;
+
+	return buf;
+
+}
+
+static double dvd_startcode_msecs(void) {
+
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+
+}
+
+/**
+ * Count every start code in the buffer, return the number found
+ */
+static size_t dvd_startcode_count(dvd_startcode_t dvd_startcode_function, const uint8_t *buf, const uint8_t *end) {
+
+	size_t start_codes = 0;
+	const uint8_t *p = buf;
+
+	while(true) {
+		p = dvd_startcode_function(p, end);
+		if(p + 2 >= end)
+			break;
+		start_codes++;
+		p += 3;
+	}
+
+	return start_codes;
+
+}
+
+static bool dvd_startcode_bench(const char *name, dvd_startcode_t dvd_startcode_function, const uint8_t *buf, const uint8_t *end, const size_t expected) {
+
+	size_t start_codes = 0;
+	double start = 0;
+	double best = 0;
+	double msecs = 0;
+	int round = 0;
+
+	for(round = 0; round < DVD_STARTCODE_BENCH_ROUNDS; round++) {
+		start = dvd_startcode_msecs();
+		start_codes = dvd_startcode_count(dvd_startcode_function, buf, end);
+		msecs = dvd_startcode_msecs() - start;
+		if(round == 0 || msecs < best)
+			best = msecs;
+	}
+
+	printf("  %-8s %8.2f ms %9.1f MB/s %10zu start codes%s\n", name, best, (end - buf) / 1048576.0 / (best / 1000.0), start_codes, start_codes == expected ? "" : " MISMATCH");
+
+	return start_codes == expected;
+
+}
+
+int main(int argc, char **argv) {
+
+	uint8_t *buf = NULL;
+	size_t ix = 0;
+	size_t distance = 65536;
+	size_t expected = 0;
+	bool ok = true;
+
+	if(argc > 1)
+		distance = strtoul(argv[1], NULL, 0);
+
+	if(distance < 4)
+		distance = 4;
+
+	buf = malloc(DVD_STARTCODE_BENCH_SIZE);
+	if(buf == NULL) {
+		fprintf(stderr, "Could not allocate memory\n");
+		return 1;
+	}
+
+	// Random data, with no zero bytes, and start codes dropped in
+	srand(1);
+	for(ix = 0; ix < DVD_STARTCODE_BENCH_SIZE; ix++)
+		buf[ix] = (uint8_t)(1 + rand() % 255);
+
+	for(ix = rand() % distance; ix + 3 < DVD_STARTCODE_BENCH_SIZE; ix += 3 + rand() % distance) {
+		buf[ix] = 0;
+		buf[ix + 1] = 0;
+		buf[ix + 2] = 1;
+	}
+
+	expected = dvd_startcode_count(dvd_startcode_bytes, buf, buf + DVD_STARTCODE_BENCH_SIZE);
+
+	printf("%u MB, start codes up to %zu bytes apart, using %s\n", DVD_STARTCODE_BENCH_SIZE / 1048576, distance, dvd_startcode_name());
+
+	ok = dvd_startcode_bench("bytes", dvd_startcode_bytes, buf, buf + DVD_STARTCODE_BENCH_SIZE, expected) && ok;
+	ok = dvd_startcode_bench("scalar", dvd_startcode_scalar, buf, buf + DVD_STARTCODE_BENCH_SIZE, expected) && ok;
+#ifdef DVD_STARTCODE_X86
+	ok = dvd_startcode_bench("sse2", dvd_startcode_sse2, buf, buf + DVD_STARTCODE_BENCH_SIZE, expected) && ok;
+	if(strcmp(dvd_startcode_name(), "avx2") == 0)
+		ok = dvd_startcode_bench("avx2", dvd_startcode_avx2, buf, buf + DVD_STARTCODE_BENCH_SIZE, expected) && ok;
+#endif
+
+	free(buf);
+
+	return ok ? 0 : 1;
+
+}
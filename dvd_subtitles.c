@@ -80,6 +80,33 @@ bool dvd_subtitle_active(const ifo_handle_t *vmg_ifo, const ifo_handle_t *vts_if
 
 }
 
+/**
+ * Get the subpicture color palette of a track, from its PGC.  Each of the
+ * 16 colors is 0x00YYCrCb.
+ *
+ * @param palette 16 colors
+ * @return whether the track has a PGC to get it from
+ */
+bool dvd_subtitle_palette(const ifo_handle_t *vmg_ifo, const ifo_handle_t *vts_ifo, const uint16_t title_track, uint32_t *palette) {
+
+	memset(palette, 0, 16 * sizeof(uint32_t));
+
+	if(vts_ifo->vts_pgcit == NULL || vts_ifo->vts_ptt_srpt == NULL || vts_ifo->vts_ptt_srpt->title == NULL)
+		return false;
+
+	uint8_t ttn = dvd_track_ttn(vmg_ifo, title_track);
+	pgcit_t *vts_pgcit = vts_ifo->vts_pgcit;
+	pgc_t *pgc = vts_pgcit->pgci_srp[vts_ifo->vts_ptt_srpt->title[ttn - 1].ptt[0].pgcn - 1].pgc;
+
+	if(!pgc)
+		return false;
+
+	memcpy(palette, pgc->palette, 16 * sizeof(uint32_t));
+
+	return true;
+
+}
+
 /**
  * Get the number of subtitle streams for a specific language
  *
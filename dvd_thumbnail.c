@@ -0,0 +1,199 @@
+#include "dvd_thumbnail.h"
+
+#ifndef DVD_VIDEO_LB_LEN
+#define DVD_VIDEO_LB_LEN 2048
+#endif
+
+struct dvd_thumbnail {
+	mpeg2dec_t *mpeg2dec;
+	const mpeg2_info_t *mpeg2_info;
+	struct dvd_preview *dvd_preview;
+	uint16_t width;
+	uint16_t height;
+	uint8_t *rgb;
+	bool decoded;
+};
+
+/**
+ * Run the decoder, and scale the first picture that comes out of it.  Only
+ * the I frame is decoded, the pictures after it in the blocks are skipped.
+ */
+static void dvd_thumbnail_parse(struct dvd_thumbnail *dvd_thumbnail) {
+
+	const mpeg2_sequence_t *sequence = NULL;
+	const mpeg2_fbuf_t *display_fbuf = NULL;
+	struct dvd_preview_frame dvd_preview_frame;
+	mpeg2_state_t state;
+
+	while(true) {
+
+		state = mpeg2_parse(dvd_thumbnail->mpeg2dec);
+
+		switch(state) {
+
+			case STATE_BUFFER:
+				return;
+
+			case STATE_PICTURE:
+				mpeg2_skip(dvd_thumbnail->mpeg2dec, (dvd_thumbnail->mpeg2_info->current_picture->flags & PIC_MASK_CODING_TYPE) != PIC_FLAG_CODING_TYPE_I);
+				break;
+
+			case STATE_SLICE:
+			case STATE_END:
+			case STATE_INVALID_END:
+				if(dvd_thumbnail->decoded || dvd_thumbnail->mpeg2_info->display_fbuf == NULL)
+					break;
+				if(dvd_thumbnail->mpeg2_info->display_picture != NULL && (dvd_thumbnail->mpeg2_info->display_picture->flags & PIC_FLAG_SKIP))
+					break;
+				sequence = dvd_thumbnail->mpeg2_info->sequence;
+				display_fbuf = dvd_thumbnail->mpeg2_info->display_fbuf;
+				dvd_preview_frame.y = display_fbuf->buf[0];
+				dvd_preview_frame.u = display_fbuf->buf[1];
+				dvd_preview_frame.v = display_fbuf->buf[2];
+				dvd_preview_frame.width = (uint16_t)sequence->width;
+				dvd_preview_frame.height = (uint16_t)sequence->height;
+				dvd_preview_frame.chroma_width = (uint16_t)sequence->chroma_width;
+				dvd_preview_frame.chroma_height = (uint16_t)sequence->chroma_height;
+				dvd_thumbnail->decoded = dvd_preview_scale(dvd_thumbnail->dvd_preview, &dvd_preview_frame, dvd_thumbnail->rgb, (size_t)dvd_thumbnail->width * 3);
+				break;
+
+			default:
+				break;
+
+		}
+
+	}
+
+}
+
+static bool dvd_thumbnail_decode(void *data, const struct dvd_demux_packet *dvd_demux_packet) {
+
+	struct dvd_thumbnail *dvd_thumbnail = (struct dvd_thumbnail *)data;
+	uint8_t *buf = (uint8_t *)dvd_demux_packet->buffer;
+
+	if(dvd_thumbnail->decoded)
+		return true;
+
+	mpeg2_buffer(dvd_thumbnail->mpeg2dec, buf, buf + dvd_demux_packet->length);
+
+	dvd_thumbnail_parse(dvd_thumbnail);
+
+	return true;
+
+}
+
+/**
+ * Decode the I frame of the VOBU a time is in
+ */
+static bool dvd_thumbnail_sample(struct dvd_session *dvd_session, const struct dvd_vobu_index *dvd_vobu_index, dvd_file_t *dvdread_vts_file, struct dvd_demux *dvd_thumbnail_demux, struct dvd_thumbnail *dvd_thumbnail, const uint32_t msecs) {
+
+	struct dvd_vobu dvd_vobu;
+	uint8_t sequence_end[4] = { 0x00, 0x00, 0x01, 0xb7 };
+
+	mpeg2_reset(dvd_thumbnail->mpeg2dec, 1);
+	dvd_thumbnail->decoded = false;
+
+	if(!dvd_vobu_index_sample(dvd_session, dvd_vobu_index, dvdread_vts_file, msecs, &dvd_vobu, dvd_thumbnail_demux))
+		return false;
+
+	if(!dvd_thumbnail->decoded) {
+		mpeg2_buffer(dvd_thumbnail->mpeg2dec, sequence_end, sequence_end + sizeof(sequence_end));
+		dvd_thumbnail_parse(dvd_thumbnail);
+	}
+
+	return dvd_thumbnail->decoded;
+
+}
+
+/**
+ * Save thumbnails spread evenly across a track
+ *
+ * @param dvd_session session
+ * @param track_number track number
+ * @param count number of thumbnails
+ * @param width thumbnail width, the height follows the aspect ratio
+ * @param directory where to save them, which has to exist
+ * @return number of thumbnails saved
+ */
+uint16_t dvd_thumbnails(struct dvd_session *dvd_session, const uint16_t track_number, const uint16_t count, const uint16_t width, const char *directory) {
+
+	ifo_handle_t *vmg_ifo = dvd_session_vmg_ifo(dvd_session);
+	ifo_handle_t *vts_ifo = dvd_session_track_ifo(dvd_session, track_number);
+	char aspect_ratio[DVD_VIDEO_ASPECT_RATIO + 1] = {'\0'};
+	char filename[PATH_MAX + 32];
+	uint16_t vts = 0;
+	uint32_t track_msecs = 0;
+	uint32_t msecs = 0;
+	dvd_file_t *dvdread_vts_file = NULL;
+	struct dvd_demux *dvd_thumbnail_demux = NULL;
+	struct dvd_thumbnail dvd_thumbnail;
+	struct dvd_vobu_index dvd_vobu_index;
+	uint16_t saved = 0;
+	uint16_t ix = 0;
+
+	if(vmg_ifo == NULL || vts_ifo == NULL || count == 0)
+		return 0;
+
+	vts = dvd_vts_ifo_number(vmg_ifo, track_number);
+	track_msecs = dvd_track_msecs(vmg_ifo, vts_ifo, track_number);
+	dvd_video_aspect_ratio(aspect_ratio, vts_ifo);
+
+	memset(&dvd_thumbnail, 0, sizeof(dvd_thumbnail));
+
+	// Only the NAV packs are read, once, to find every thumbnail
+	if(!dvd_vobu_index_track(dvd_session, track_number, &dvd_vobu_index)) {
+		dvd_vobu_index_free(&dvd_vobu_index);
+		return 0;
+	}
+
+	dvd_thumbnail.width = width;
+	dvd_thumbnail.height = dvd_preview_aspect_height(width, aspect_ratio);
+	dvd_thumbnail.dvd_preview = dvd_preview_open(dvd_thumbnail.width, dvd_thumbnail.height);
+	dvd_thumbnail.rgb = malloc((size_t)dvd_thumbnail.width * dvd_thumbnail.height * 3);
+	dvd_thumbnail.mpeg2dec = mpeg2_init();
+	dvdread_vts_file = DVDOpenFile(dvd_session_dvdread(dvd_session), vts, DVD_READ_TITLE_VOBS);
+
+	if(dvd_thumbnail.dvd_preview != NULL && dvd_thumbnail.rgb != NULL && dvd_thumbnail.mpeg2dec != NULL && dvdread_vts_file != NULL) {
+
+		dvd_thumbnail.mpeg2_info = mpeg2_info(dvd_thumbnail.mpeg2dec);
+		dvd_thumbnail_demux = dvd_demux_open(DVD_DEMUX_VIDEO, dvd_thumbnail_decode, &dvd_thumbnail);
+
+	}
+
+	// The middle of each of the equal parts of the track
+	for(ix = 0; ix < count && dvd_thumbnail_demux != NULL; ix++) {
+
+		msecs = (uint32_t)((uint64_t)track_msecs * (2 * ix + 1) / (2 * count));
+
+		if(!dvd_thumbnail_sample(dvd_session, &dvd_vobu_index, dvdread_vts_file, dvd_thumbnail_demux, &dvd_thumbnail, msecs)) {
+			fprintf(stderr, "* Could not decode a picture for thumbnail %u\n", ix + 1);
+			continue;
+		}
+
+		snprintf(filename, sizeof(filename), "%s/thumbnail_%03u.ppm", directory, ix + 1);
+
+		if(!dvd_preview_ppm(filename, dvd_thumbnail.rgb, dvd_thumbnail.width, dvd_thumbnail.height)) {
+			fprintf(stderr, "* Could not write to %s\n", filename);
+			continue;
+		}
+
+		saved++;
+
+	}
+
+	dvd_demux_close(dvd_thumbnail_demux);
+
+	if(dvdread_vts_file != NULL)
+		DVDCloseFile(dvdread_vts_file);
+
+	if(dvd_thumbnail.mpeg2dec != NULL)
+		mpeg2_close(dvd_thumbnail.mpeg2dec);
+
+	dvd_preview_close(dvd_thumbnail.dvd_preview);
+	free(dvd_thumbnail.rgb);
+
+	dvd_vobu_index_free(&dvd_vobu_index);
+
+	return saved;
+
+}
@@ -0,0 +1,37 @@
+#ifndef DVD_INFO_THUMBNAIL_H
+#define DVD_INFO_THUMBNAIL_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <dvdread/dvd_reader.h>
+#include <dvdread/ifo_read.h>
+#include <mpeg2dec/mpeg2.h>
+#include "dvd_session.h"
+#include "dvd_track.h"
+#include "dvd_video.h"
+#include "dvd_time.h"
+#include "dvd_demux.h"
+#include "dvd_vobu.h"
+#include "dvd_preview.h"
+
+/**
+ * Thumbnails of a track, from the I frame at the start of the VOBU in the
+ * middle of each of a number of equal parts of it.  The track is indexed
+ * once from its NAV packs, then only the blocks up to the end of each of
+ * those pictures are read, by dvd_vobu_index_sample(), the same as dvd_ppm
+ * -T does.  Each is scaled down with dvd_preview, to the display aspect
+ * ratio, and saved as thumbnail_001.ppm, thumbnail_002.ppm, and so on.
+ *
+ * This needs libmpeg2, so it is built into the programs that can use it, and
+ * not into libdvdinfo.
+ */
+
+#define DVD_THUMBNAIL_WIDTH 320
+
+uint16_t dvd_thumbnails(struct dvd_session *dvd_session, const uint16_t track_number, const uint16_t count, const uint16_t width, const char *directory);
+
+#endif
@@ -110,6 +110,61 @@ void milliseconds_length_format(char *dest_str, const uint32_t milliseconds) {
 
 }
 
+/**
+ * Convert a length in the format [[hh:]mm:]ss[.ms] to milliseconds
+ *
+ * "90", "1:30" and "00:01:30.000" are all 90000.
+ *
+ * @return false if the string isn't a length
+ */
+bool milliseconds_length_parse(uint32_t *milliseconds, const char *str) {
+
+	uint32_t total = 0;
+	uint32_t value = 0;
+	uint32_t msecs = 0;
+	uint32_t scale = 100;
+	uint8_t fields = 0;
+	bool digits = false;
+	const char *p = str;
+
+	for(p = str; *p != '\0' && *p != '.'; p++) {
+
+		if(*p == ':') {
+			if(!digits || fields == 2)
+				return false;
+			total = (total + value) * 60;
+			value = 0;
+			digits = false;
+			fields++;
+		} else if(isdigit((unsigned char)*p) && value < 100000) {
+			value = value * 10 + (uint32_t)(*p - '0');
+			digits = true;
+		} else {
+			return false;
+		}
+
+	}
+
+	if(!digits || (fields > 0 && value > 59))
+		return false;
+
+	total += value;
+
+	if(*p == '.') {
+		for(p++; *p != '\0'; p++) {
+			if(!isdigit((unsigned char)*p))
+				return false;
+			msecs += (uint32_t)(*p - '0') * scale;
+			scale /= 10;
+		}
+	}
+
+	*milliseconds = total * 1000 + msecs;
+
+	return true;
+
+}
+
 /**
  * Get the number of milliseconds for a title track using the program chain.
  *
@@ -7,6 +7,8 @@ uint32_t dvd_time_to_milliseconds(dvd_time_t *dvd_time);
 
 void milliseconds_length_format(char *dest_str, const uint32_t milliseconds);
 
+bool milliseconds_length_parse(uint32_t *milliseconds, const char *str);
+
 uint32_t dvd_track_msecs(const ifo_handle_t *vmg_ifo, const ifo_handle_t *vts_ifo, const uint16_t track_number);
 
 void dvd_track_length(char *dest_str, const ifo_handle_t *vmg_ifo, const ifo_handle_t *vts_ifo, const uint16_t track_number);
@@ -7,6 +7,7 @@
 #include <string.h>
 #include "dvd_cell.h"
 #include "dvd_vmg_ifo.h"
+#include "dvd_es.h"
 
 struct dvd_video {
 	char codec[DVD_VIDEO_CODEC + 1];
@@ -19,6 +20,12 @@ struct dvd_video {
 	uint8_t df;
 	char fps[DVD_VIDEO_FPS + 1];
 	uint8_t angles;
+	bool crop;
+	uint16_t crop_top;
+	uint16_t crop_bottom;
+	uint16_t crop_left;
+	uint16_t crop_right;
+	struct dvd_es_stats dvd_es_stats;
 };
 
 struct dvd_track {
@@ -0,0 +1,38 @@
+#include "dvd_track_copy.h"
+
+/**
+ * Copy a range of chapters of a track, cell by cell, to a file descriptor
+ *
+ * The chapter range is not checked, it has to be valid for the track.
+ *
+ * @param dvd_session session handle
+ * @param track_number track number
+ * @param first_chapter first chapter to copy
+ * @param last_chapter last chapter to copy
+ * @param fd file descriptor to write to (1 for stdout)
+ * @param block_limit number of blocks to read at a time (DVD_COPY_BLOCK_LIMIT, DVD_CAT_BLOCK_LIMIT)
+ * @param verbose display each cell and the progress on stdout
+ * @return true if everything was copied
+ */
+bool dvd_track_copy(struct dvd_session *dvd_session, const uint16_t track_number, const uint8_t first_chapter, const uint8_t last_chapter, const int fd, const ssize_t block_limit, const bool verbose) {
+
+	struct dvd_pipeline *dvd_pipeline = NULL;
+	bool retval = false;
+
+	dvd_pipeline = dvd_pipeline_open(dvd_session, track_number, first_chapter, last_chapter);
+
+	if(dvd_pipeline == NULL) {
+		fprintf(stderr, "* Could not open VTS_IFO for track %u\n", track_number);
+		return false;
+	}
+
+	dvd_pipeline_block_limit(dvd_pipeline, block_limit);
+
+	if(dvd_pipeline_add_fd(dvd_pipeline, fd) && (!verbose || dvd_pipeline_add_progress(dvd_pipeline)))
+		retval = dvd_pipeline_run(dvd_pipeline);
+
+	dvd_pipeline_close(dvd_pipeline);
+
+	return retval;
+
+}
@@ -0,0 +1,24 @@
+#ifndef DVD_INFO_TRACK_COPY_H
+#define DVD_INFO_TRACK_COPY_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <dvdread/dvd_reader.h>
+#include <dvdread/ifo_read.h>
+#include "dvd_session.h"
+#include "dvd_pipeline.h"
+
+#ifndef DVD_VIDEO_LB_LEN
+#define DVD_VIDEO_LB_LEN 2048
+#endif
+
+// 2048 * 512 = 1 MB
+#define DVD_COPY_BLOCK_LIMIT 512
+#define DVD_CAT_BLOCK_LIMIT 1
+
+bool dvd_track_copy(struct dvd_session *dvd_session, const uint16_t track_number, const uint8_t first_chapter, const uint8_t last_chapter, const int fd, const ssize_t block_limit, const bool verbose);
+
+#endif
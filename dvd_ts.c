@@ -0,0 +1,825 @@
+#include "dvd_ts.h"
+#include "dvd_pipeline.h"
+
+// Stream types in the PMT
+#define TS_STREAM_MPEG2_VIDEO 0x02
+#define TS_STREAM_MPEG_AUDIO 0x03
+#define TS_STREAM_AC3 0x81
+
+// Descriptors
+#define TS_DESCRIPTOR_REGISTRATION 0x05
+#define TS_DESCRIPTOR_LANGUAGE 0x0a
+
+// Adaptation field flags
+#define TS_RANDOM_ACCESS 0x40
+#define TS_PCR 0x10
+
+// Room for the longest PES header, with a PTS and a DTS
+#define TS_PES_HEADER 19
+
+// Longest time between two PCRs, 100 ms
+#define TS_PCR_INTERVAL 9000
+
+// Most PCRs in one video PES packet after the first one
+#define TS_PCRS 32
+
+struct dvd_ts_buffer {
+	uint8_t *data;
+	size_t length;
+	size_t size;
+};
+
+/**
+ * pid: 0 if the stream isn't muxed
+ * pes: PES packet being put together, the header goes at the end of the
+ *   first TS_PES_HEADER bytes when it is written
+ * pts, dts, pcr: its times, already from the start of the track
+ * pcrs: PCRs further into a video PES packet, for each pack whose SCR is
+ *   TS_PCR_INTERVAL or more after the last one, at the byte of pes it
+ *   starts at
+ */
+struct dvd_ts_stream {
+	uint16_t pid;
+	uint8_t pes_id;
+	uint8_t stream_type;
+	char language[4];
+	bool has_pes;
+	bool has_pts;
+	bool has_dts;
+	int64_t pts;
+	int64_t dts;
+	int64_t pcr;
+	uint8_t pcrs;
+	int64_t pcr_ticks[TS_PCRS];
+	size_t pcr_offset[TS_PCRS];
+	struct dvd_ts_buffer pes;
+};
+
+/**
+ * Times are in 90 kHz ticks from the start of the first chapter, plus
+ * DVD_TS_OFFSET, and base turns a PTS or an SCR into one
+ *
+ * continuity: counter for each PID, carried across segments
+ * scr: SCR of the pack being demuxed
+ * random_access: the next video PES packet starts a segment
+ * stream_ids: the video, then up to 8 audio streams, as they are in the PMT
+ * segment_ticks: time the open segment starts at
+ * end_ticks: end of the last VOBU so far
+ * durations: length of each segment that has been finished, in ticks
+ */
+struct dvd_ts {
+	bool error;
+	char playlist[PATH_MAX];
+	char prefix[PATH_MAX];
+	const char *name;
+	int64_t target;
+	FILE *segment;
+	uint32_t segments;
+	uint32_t durations_size;
+	int64_t *durations;
+	int64_t segment_ticks;
+	int64_t end_ticks;
+	struct dvd_demux *dvd_demux;
+	struct dvd_vobu dvd_vobu;
+	bool has_base;
+	int64_t base;
+	uint32_t cell_start[256];
+	bool has_scr;
+	int64_t scr;
+	bool random_access;
+	uint8_t streams;
+	uint8_t stream_ids[9];
+	struct dvd_ts_stream ts_streams[256];
+	uint8_t continuity[0x2000];
+	uint8_t packet[DVD_TS_PACKET];
+};
+
+/** Transport stream packets **/
+
+/**
+ * CRC-32 of a PSI section (MPEG-2 polynomial, not reflected, no final XOR)
+ */
+static uint32_t dvd_ts_crc32(const uint8_t *data, const size_t length) {
+
+	uint32_t crc = 0xffffffff;
+	size_t ix = 0;
+	uint8_t bit = 0;
+
+	for(ix = 0; ix < length; ix++) {
+		crc ^= (uint32_t)data[ix] << 24;
+		for(bit = 0; bit < 8; bit++)
+			crc = (crc & 0x80000000) ? (crc << 1) ^ 0x04c11db7 : crc << 1;
+	}
+
+	return crc;
+
+}
+
+static bool dvd_ts_output(struct dvd_ts *dvd_ts) {
+
+	if(dvd_ts->segment == NULL || fwrite(dvd_ts->packet, DVD_TS_PACKET, 1, dvd_ts->segment) != 1) {
+		dvd_ts->error = true;
+		return false;
+	}
+
+	return true;
+
+}
+
+/**
+ * Cut some data into TS packets on a PID.  The first one has the adaptation
+ * field flags.  The last one is padded out with stuffing in its adaptation
+ * field.
+ *
+ * @param start the first packet starts a payload unit
+ * @param pcr PCR for the first packet, -1 for none
+ */
+static bool dvd_ts_packets(struct dvd_ts *dvd_ts, const uint16_t pid, const uint8_t *data, size_t length, const bool start, const uint8_t flags, const int64_t pcr) {
+
+	uint8_t *packet = dvd_ts->packet;
+	uint8_t adaptation_flags = flags;
+	bool first = true;
+	size_t adaptation = 0;
+	size_t payload = 0;
+	size_t ix = 0;
+	uint64_t base = 0;
+
+	if(pcr >= 0)
+		adaptation_flags |= TS_PCR;
+
+	while(length) {
+
+		adaptation = adaptation_flags ? 2 : 0;
+		if(adaptation_flags & TS_PCR)
+			adaptation += 6;
+
+		payload = DVD_TS_PACKET - 4 - adaptation;
+		if(length < payload) {
+			adaptation += payload - length;
+			payload = length;
+		}
+
+		packet[0] = 0x47;
+		packet[1] = (uint8_t)((first && start ? 0x40 : 0x00) | (pid >> 8));
+		packet[2] = (uint8_t)pid;
+		packet[3] = (uint8_t)((adaptation ? 0x30 : 0x10) | dvd_ts->continuity[pid]);
+
+		dvd_ts->continuity[pid] = (dvd_ts->continuity[pid] + 1) & 0x0f;
+
+		ix = 4;
+
+		if(adaptation) {
+
+			packet[ix++] = (uint8_t)(adaptation - 1);
+
+			if(adaptation > 1)
+				packet[ix++] = adaptation_flags;
+
+			// 33 bit base, 6 reserved bits and a 9 bit extension of 0
+			if(adaptation_flags & TS_PCR) {
+				base = (uint64_t)pcr & 0x1ffffffff;
+				packet[ix++] = (uint8_t)(base >> 25);
+				packet[ix++] = (uint8_t)(base >> 17);
+				packet[ix++] = (uint8_t)(base >> 9);
+				packet[ix++] = (uint8_t)(base >> 1);
+				packet[ix++] = (uint8_t)(((base & 0x01) << 7) | 0x7e);
+				packet[ix++] = 0x00;
+			}
+
+			memset(packet + ix, 0xff, 4 + adaptation - ix);
+			ix = 4 + adaptation;
+
+		}
+
+		memcpy(packet + ix, data, payload);
+
+		if(!dvd_ts_output(dvd_ts))
+			return false;
+
+		data += payload;
+		length -= payload;
+		first = false;
+		adaptation_flags = 0;
+
+	}
+
+	return true;
+
+}
+
+/**
+ * Write a PSI section, with its CRC, in a packet of its own
+ */
+static bool dvd_ts_section(struct dvd_ts *dvd_ts, const uint16_t pid, uint8_t *section, size_t length) {
+
+	uint8_t *packet = dvd_ts->packet;
+	uint32_t crc = 0;
+
+	// Section length counts from after itself, and includes the CRC
+	section[1] = (uint8_t)(0xb0 | ((length - 3) >> 8));
+	section[2] = (uint8_t)(length - 3);
+
+	crc = dvd_ts_crc32(section, length - 4);
+	section[length - 4] = (uint8_t)(crc >> 24);
+	section[length - 3] = (uint8_t)(crc >> 16);
+	section[length - 2] = (uint8_t)(crc >> 8);
+	section[length - 1] = (uint8_t)crc;
+
+	packet[0] = 0x47;
+	packet[1] = (uint8_t)(0x40 | (pid >> 8));
+	packet[2] = (uint8_t)pid;
+	packet[3] = (uint8_t)(0x10 | dvd_ts->continuity[pid]);
+	packet[4] = 0x00;
+
+	dvd_ts->continuity[pid] = (dvd_ts->continuity[pid] + 1) & 0x0f;
+
+	memcpy(packet + 5, section, length);
+	memset(packet + 5 + length, 0xff, DVD_TS_PACKET - 5 - length);
+
+	return dvd_ts_output(dvd_ts);
+
+}
+
+/**
+ * The PAT, with the one program, and its PMT
+ */
+static bool dvd_ts_tables(struct dvd_ts *dvd_ts) {
+
+	const struct dvd_ts_stream *dvd_ts_stream = NULL;
+	uint8_t section[DVD_TS_PACKET];
+	uint8_t *descriptors = NULL;
+	size_t length = 0;
+	uint8_t ix = 0;
+
+	memset(section, 0, sizeof(section));
+
+	section[0] = 0x00;
+	section[3] = 0x00;
+	section[4] = 0x01;
+	section[5] = 0xc1;
+	section[6] = 0x00;
+	section[7] = 0x00;
+	section[8] = 0x00;
+	section[9] = 0x01;
+	section[10] = (uint8_t)(0xe0 | (DVD_TS_PMT_PID >> 8));
+	section[11] = (uint8_t)DVD_TS_PMT_PID;
+
+	if(!dvd_ts_section(dvd_ts, DVD_TS_PAT_PID, section, 16))
+		return false;
+
+	memset(section, 0, sizeof(section));
+
+	section[0] = 0x02;
+	section[3] = 0x00;
+	section[4] = 0x01;
+	section[5] = 0xc1;
+	section[6] = 0x00;
+	section[7] = 0x00;
+	section[8] = (uint8_t)(0xe0 | (DVD_TS_VIDEO_PID >> 8));
+	section[9] = (uint8_t)DVD_TS_VIDEO_PID;
+	section[10] = 0xf0;
+	section[11] = 0x00;
+
+	length = 12;
+
+	for(ix = 0; ix < dvd_ts->streams; ix++) {
+
+		dvd_ts_stream = &dvd_ts->ts_streams[dvd_ts->stream_ids[ix]];
+
+		section[length] = dvd_ts_stream->stream_type;
+		section[length + 1] = (uint8_t)(0xe0 | (dvd_ts_stream->pid >> 8));
+		section[length + 2] = (uint8_t)dvd_ts_stream->pid;
+		section[length + 3] = 0xf0;
+		descriptors = section + length + 5;
+		length += 5;
+
+		if(dvd_ts_stream->stream_type == TS_STREAM_AC3) {
+			section[length] = TS_DESCRIPTOR_REGISTRATION;
+			section[length + 1] = 4;
+			memcpy(section + length + 2, "AC-3", 4);
+			length += 6;
+		}
+
+		if(strlen(dvd_ts_stream->language)) {
+			section[length] = TS_DESCRIPTOR_LANGUAGE;
+			section[length + 1] = 4;
+			memcpy(section + length + 2, dvd_ts_stream->language, 3);
+			section[length + 5] = 0x00;
+			length += 6;
+		}
+
+		descriptors[-1] = (uint8_t)(section + length - descriptors);
+
+	}
+
+	return dvd_ts_section(dvd_ts, DVD_TS_PMT_PID, section, length + 4);
+
+}
+
+/** PES packets **/
+
+static void dvd_ts_timestamp(uint8_t *header, const uint8_t prefix, const int64_t ticks) {
+
+	uint64_t value = (uint64_t)ticks & 0x1ffffffff;
+
+	header[0] = (uint8_t)((prefix << 4) | ((value >> 29) & 0x0e) | 0x01);
+	header[1] = (uint8_t)(value >> 22);
+	header[2] = (uint8_t)(((value >> 14) & 0xfe) | 0x01);
+	header[3] = (uint8_t)(value >> 7);
+	header[4] = (uint8_t)(((value << 1) & 0xfe) | 0x01);
+
+}
+
+/**
+ * Write the PES packet that has been put together, with a new header in
+ * front of it.  Video PES packets carry the PCR, in the first TS packet and
+ * in the ones the later PCRs are at, and don't have a length if they are too
+ * long for one.
+ */
+static bool dvd_ts_pes(struct dvd_ts *dvd_ts, struct dvd_ts_stream *dvd_ts_stream) {
+
+	struct dvd_ts_buffer *pes = &dvd_ts_stream->pes;
+	uint8_t header_length = 0;
+	uint8_t *header = NULL;
+	size_t length = 0;
+	uint8_t flags = 0;
+	bool video = dvd_ts_stream->pes_id == DVD_DEMUX_VIDEO;
+	bool written = true;
+	uint8_t *end = NULL;
+	uint8_t ix = 0;
+
+	if(!dvd_ts_stream->has_pes || pes->length <= TS_PES_HEADER) {
+		dvd_ts_stream->pcrs = 0;
+		dvd_ts_stream->has_pes = false;
+		return true;
+	}
+
+	if(dvd_ts_stream->has_pts)
+		header_length = dvd_ts_stream->has_dts ? 10 : 5;
+
+	header = pes->data + TS_PES_HEADER - 9 - header_length;
+	length = pes->length - TS_PES_HEADER + 3 + header_length;
+	if(length > 0xffff)
+		length = 0;
+
+	header[0] = 0x00;
+	header[1] = 0x00;
+	header[2] = 0x01;
+	header[3] = dvd_ts_stream->pes_id;
+	header[4] = (uint8_t)(length >> 8);
+	header[5] = (uint8_t)length;
+	header[6] = 0x80;
+	header[7] = dvd_ts_stream->has_pts ? (dvd_ts_stream->has_dts ? 0xc0 : 0x80) : 0x00;
+	header[8] = header_length;
+
+	if(dvd_ts_stream->has_pts)
+		dvd_ts_timestamp(header + 9, dvd_ts_stream->has_dts ? 0x03 : 0x02, dvd_ts_stream->pts);
+	if(dvd_ts_stream->has_dts)
+		dvd_ts_timestamp(header + 14, 0x01, dvd_ts_stream->dts);
+
+	if(video && dvd_ts->random_access) {
+		flags = TS_RANDOM_ACCESS;
+		dvd_ts->random_access = false;
+	}
+
+	// The packets up to the first PCR that comes after, and so on
+	end = dvd_ts_stream->pcrs ? pes->data + dvd_ts_stream->pcr_offset[0] : pes->data + pes->length;
+	written = dvd_ts_packets(dvd_ts, dvd_ts_stream->pid, header, (size_t)(end - header), true, flags, video ? dvd_ts_stream->pcr : -1);
+
+	for(ix = 0; ix < dvd_ts_stream->pcrs && written; ix++) {
+		header = end;
+		end = ix + 1 < dvd_ts_stream->pcrs ? pes->data + dvd_ts_stream->pcr_offset[ix + 1] : pes->data + pes->length;
+		written = dvd_ts_packets(dvd_ts, dvd_ts_stream->pid, header, (size_t)(end - header), false, 0, dvd_ts_stream->pcr_ticks[ix]);
+	}
+
+	pes->length = 0;
+	dvd_ts_stream->pcrs = 0;
+	dvd_ts_stream->has_pes = false;
+
+	return written;
+
+}
+
+static bool dvd_ts_append(struct dvd_ts *dvd_ts, struct dvd_ts_buffer *buffer, const uint8_t *data, const size_t length) {
+
+	uint8_t *resized = NULL;
+	size_t size = 0;
+
+	if(buffer->length + length > buffer->size) {
+
+		size = buffer->size ? buffer->size : 65536;
+		while(size < buffer->length + length)
+			size *= 2;
+
+		resized = realloc(buffer->data, size);
+		if(resized == NULL) {
+			dvd_ts->error = true;
+			return false;
+		}
+
+		buffer->data = resized;
+		buffer->size = size;
+
+	}
+
+	memcpy(buffer->data + buffer->length, data, length);
+	buffer->length += length;
+
+	return true;
+
+}
+
+/** Segments and the playlist **/
+
+/**
+ * Write the playlist to a temporary file, and move it over the old one, so a
+ * player never sees half of it
+ *
+ * @param finished the track is done, so it is a complete VOD playlist
+ */
+static bool dvd_ts_playlist(struct dvd_ts *dvd_ts, const bool finished) {
+
+	char filename[PATH_MAX];
+	FILE *playlist = NULL;
+	uint32_t ix = 0;
+	int64_t ticks = 0;
+	bool written = false;
+
+	if(snprintf(filename, PATH_MAX, "%s.tmp", dvd_ts->playlist) >= PATH_MAX)
+		return false;
+
+	playlist = fopen(filename, "w");
+	if(playlist == NULL)
+		return false;
+
+	fprintf(playlist, "#EXTM3U\n");
+	fprintf(playlist, "#EXT-X-VERSION:3\n");
+	fprintf(playlist, "#EXT-X-TARGETDURATION:%" PRId64 "\n", dvd_ts->target / 90000 + 1);
+	fprintf(playlist, "#EXT-X-MEDIA-SEQUENCE:0\n");
+	fprintf(playlist, "#EXT-X-PLAYLIST-TYPE:%s\n", finished ? "VOD" : "EVENT");
+
+	for(ix = 0; ix < dvd_ts->segments; ix++) {
+		ticks = dvd_ts->durations[ix] > 0 ? dvd_ts->durations[ix] : 0;
+		fprintf(playlist, "#EXTINF:%" PRId64 ".%03" PRId64 ",\n", ticks / 90000, (ticks % 90000) / 90);
+		fprintf(playlist, "%s_%05u.ts\n", dvd_ts->name, ix);
+	}
+
+	if(finished)
+		fprintf(playlist, "#EXT-X-ENDLIST\n");
+
+	written = !ferror(playlist);
+
+	if(fclose(playlist) != 0)
+		written = false;
+
+	if(written && rename(filename, dvd_ts->playlist) != 0)
+		written = false;
+
+	if(!written)
+		unlink(filename);
+
+	return written;
+
+}
+
+static bool dvd_ts_segment_open(struct dvd_ts *dvd_ts, const int64_t ticks) {
+
+	char filename[PATH_MAX];
+
+	if(snprintf(filename, PATH_MAX, "%s_%05u.ts", dvd_ts->prefix, dvd_ts->segments) >= PATH_MAX) {
+		dvd_ts->error = true;
+		return false;
+	}
+
+	dvd_ts->segment = fopen(filename, "wb");
+	if(dvd_ts->segment == NULL) {
+		dvd_ts->error = true;
+		return false;
+	}
+
+	dvd_ts->segment_ticks = ticks;
+	dvd_ts->random_access = true;
+
+	return dvd_ts_tables(dvd_ts);
+
+}
+
+/**
+ * Write what is left of each stream, and add the segment to the playlist
+ */
+static bool dvd_ts_segment_close(struct dvd_ts *dvd_ts, const int64_t ticks, const bool finished) {
+
+	int64_t *durations = NULL;
+	uint32_t size = 0;
+	uint8_t ix = 0;
+
+	if(dvd_ts->segment == NULL)
+		return !dvd_ts->error;
+
+	for(ix = 0; ix < dvd_ts->streams; ix++)
+		dvd_ts_pes(dvd_ts, &dvd_ts->ts_streams[dvd_ts->stream_ids[ix]]);
+
+	if(fclose(dvd_ts->segment) != 0)
+		dvd_ts->error = true;
+
+	dvd_ts->segment = NULL;
+
+	if(dvd_ts->error)
+		return false;
+
+	if(dvd_ts->segments == dvd_ts->durations_size) {
+		size = dvd_ts->durations_size ? dvd_ts->durations_size * 2 : 256;
+		durations = realloc(dvd_ts->durations, size * sizeof(int64_t));
+		if(durations == NULL) {
+			dvd_ts->error = true;
+			return false;
+		}
+		dvd_ts->durations = durations;
+		dvd_ts->durations_size = size;
+	}
+
+	dvd_ts->durations[dvd_ts->segments] = ticks - dvd_ts->segment_ticks;
+	dvd_ts->segments++;
+
+	if(!dvd_ts_playlist(dvd_ts, finished)) {
+		dvd_ts->error = true;
+		return false;
+	}
+
+	return true;
+
+}
+
+/**
+ * A PES packet goes from one packet with a PTS to the next, so the PTS still
+ * goes with the first frame that starts in it.  Audio ones are also cut when
+ * they would be too long for the length in the header.
+ */
+static bool dvd_ts_packet(void *data, const struct dvd_demux_packet *dvd_demux_packet) {
+
+	struct dvd_ts *dvd_ts = (struct dvd_ts *)data;
+	struct dvd_ts_stream *dvd_ts_stream = NULL;
+	uint8_t stream_id = dvd_demux_packet->stream_id;
+	bool video = false;
+	bool overflow = false;
+	int64_t pcr = 0;
+	int64_t last_pcr = 0;
+
+	if(stream_id == DVD_DEMUX_PRIVATE_STREAM_1)
+		stream_id = dvd_demux_packet->substream_id;
+
+	dvd_ts_stream = &dvd_ts->ts_streams[stream_id];
+
+	if(dvd_ts_stream->pid == 0 || dvd_ts->segment == NULL || !dvd_ts->has_base)
+		return true;
+
+	video = dvd_ts_stream->pes_id == DVD_DEMUX_VIDEO;
+	overflow = !video && dvd_ts_stream->has_pes && dvd_ts_stream->pes.length - TS_PES_HEADER + dvd_demux_packet->length > 0xffff - 13;
+
+	if((dvd_demux_packet->pes_start && dvd_demux_packet->has_pts) || overflow) {
+
+		if(!dvd_ts_pes(dvd_ts, dvd_ts_stream))
+			return false;
+
+		dvd_ts_stream->has_pes = true;
+		dvd_ts_stream->has_pts = dvd_demux_packet->has_pts;
+		dvd_ts_stream->has_dts = dvd_demux_packet->has_pts && dvd_demux_packet->has_dts;
+		dvd_ts_stream->pts = dvd_ts->base + (int64_t)dvd_demux_packet->pts + DVD_TS_OFFSET;
+		dvd_ts_stream->dts = dvd_ts->base + (int64_t)dvd_demux_packet->dts + DVD_TS_OFFSET;
+		dvd_ts_stream->pcr = dvd_ts->has_scr ? dvd_ts->base + dvd_ts->scr + DVD_TS_OFFSET : -1;
+		dvd_ts_stream->pes.length = TS_PES_HEADER;
+
+	}
+
+	// Nothing until the first one with a PTS
+	if(!dvd_ts_stream->has_pes)
+		return true;
+
+	// A long video PES packet gets another PCR at least every 100 ms
+	if(video && dvd_ts->has_scr && dvd_ts_stream->pcr >= 0 && dvd_ts_stream->pcrs < TS_PCRS) {
+		pcr = dvd_ts->base + dvd_ts->scr + DVD_TS_OFFSET;
+		last_pcr = dvd_ts_stream->pcrs ? dvd_ts_stream->pcr_ticks[dvd_ts_stream->pcrs - 1] : dvd_ts_stream->pcr;
+		if(pcr - last_pcr >= TS_PCR_INTERVAL) {
+			dvd_ts_stream->pcr_ticks[dvd_ts_stream->pcrs] = pcr;
+			dvd_ts_stream->pcr_offset[dvd_ts_stream->pcrs] = dvd_ts_stream->pes.length;
+			dvd_ts_stream->pcrs++;
+		}
+	}
+
+	return dvd_ts_append(dvd_ts, &dvd_ts_stream->pes, dvd_demux_packet->buffer, dvd_demux_packet->length);
+
+}
+
+/** Muxing **/
+
+static void dvd_ts_stream_add(struct dvd_ts *dvd_ts, const uint8_t stream_id, const uint8_t pes_id, const uint8_t stream_type, const char *lang_code) {
+
+	struct dvd_ts_stream *dvd_ts_stream = &dvd_ts->ts_streams[stream_id];
+
+	if(dvd_ts->streams == sizeof(dvd_ts->stream_ids))
+		return;
+
+	dvd_ts_stream->pid = stream_id == DVD_DEMUX_VIDEO ? DVD_TS_VIDEO_PID : (uint16_t)(DVD_TS_AUDIO_PID + dvd_ts->streams - 1);
+	dvd_ts_stream->pes_id = pes_id;
+	dvd_ts_stream->stream_type = stream_type;
+
+	if(strlen(lang_code))
+		snprintf(dvd_ts_stream->language, sizeof(dvd_ts_stream->language), "%s", dvd_mkv_language(lang_code));
+
+	dvd_ts->stream_ids[dvd_ts->streams] = stream_id;
+	dvd_ts->streams++;
+
+	dvd_demux_select(dvd_ts->dvd_demux, stream_id, true);
+
+}
+
+/**
+ * Start remuxing a track from a chapter to HLS.  Nothing is written until
+ * the first NAV pack.
+ *
+ * @param playlist filename of the playlist, the segments go next to it
+ * @param seconds target length of each segment
+ * @return NULL if the track can't be read
+ */
+struct dvd_ts *dvd_ts_open(struct dvd_session *dvd_session, const struct dvd_track *dvd_track, const uint8_t first_chapter, const char *playlist, const uint8_t seconds) {
+
+	struct dvd_ts *dvd_ts = NULL;
+	ifo_handle_t *vmg_ifo = dvd_session_vmg_ifo(dvd_session);
+	ifo_handle_t *vts_ifo = dvd_session_track_ifo(dvd_session, dvd_track->track);
+	char *extension = NULL;
+	uint8_t stream_id = 0;
+	uint8_t first_cell = 0;
+	uint8_t ix = 0;
+
+	if(vts_ifo == NULL || strlen(playlist) == 0 || strlen(playlist) >= PATH_MAX - 16)
+		return NULL;
+
+	dvd_ts = calloc(1, sizeof(struct dvd_ts));
+	if(dvd_ts == NULL)
+		return NULL;
+
+	snprintf(dvd_ts->playlist, PATH_MAX, "%s", playlist);
+	dvd_ts->target = (int64_t)(seconds ? seconds : DVD_TS_SEGMENT_SECONDS) * 90000;
+
+	// Segments are named after the playlist, without its extension
+	snprintf(dvd_ts->prefix, PATH_MAX, "%s", playlist);
+	extension = strrchr(dvd_ts->prefix, '.');
+	if(extension != NULL && strchr(extension, '/') == NULL && extension != dvd_ts->prefix)
+		*extension = '\0';
+
+	dvd_ts->name = strrchr(dvd_ts->prefix, '/');
+	dvd_ts->name = dvd_ts->name == NULL ? dvd_ts->prefix : dvd_ts->name + 1;
+
+	// Times are from the start of the first chapter
+	first_cell = dvd_chapter_first_cell(vmg_ifo, vts_ifo, dvd_track->track, first_chapter);
+	dvd_cell_starts(vmg_ifo, vts_ifo, dvd_track->track, first_cell, dvd_ts->cell_start);
+
+	dvd_ts->dvd_demux = dvd_demux_open_streams(dvd_ts_packet, dvd_ts);
+	if(dvd_ts->dvd_demux == NULL) {
+		dvd_ts_close(dvd_ts);
+		return NULL;
+	}
+
+	dvd_ts_stream_add(dvd_ts, DVD_DEMUX_VIDEO, DVD_DEMUX_VIDEO, TS_STREAM_MPEG2_VIDEO, "");
+
+	// HLS players take AC3 and MPEG audio, not DTS or LPCM
+	for(ix = 0; ix < dvd_track->audio_tracks && dvd_track->dvd_audio_tracks != NULL; ix++) {
+
+		if(!dvd_track->dvd_audio_tracks[ix].active)
+			continue;
+
+		stream_id = strtoul(dvd_track->dvd_audio_tracks[ix].stream_id, NULL, 0) & 0xff;
+
+		if(dvd_audio_es_format(stream_id) == DVD_AUDIO_ES_AC3)
+			dvd_ts_stream_add(dvd_ts, stream_id, DVD_DEMUX_PRIVATE_STREAM_1, TS_STREAM_AC3, dvd_track->dvd_audio_tracks[ix].lang_code);
+		else if(stream_id >= 0xc0 && stream_id <= 0xc7)
+			dvd_ts_stream_add(dvd_ts, stream_id, stream_id, TS_STREAM_MPEG_AUDIO, dvd_track->dvd_audio_tracks[ix].lang_code);
+
+	}
+
+	return dvd_ts;
+
+}
+
+uint8_t dvd_ts_streams(const struct dvd_ts *dvd_ts) {
+
+	return dvd_ts->streams;
+
+}
+
+/**
+ * SCR of a pack, from its header (MPEG-2 only)
+ */
+static bool dvd_ts_scr(const uint8_t *block, int64_t *scr) {
+
+	if(block[0] != 0x00 || block[1] != 0x00 || block[2] != 0x01 || block[3] != 0xba || (block[4] & 0xc0) != 0x40)
+		return false;
+
+	*scr = ((int64_t)(block[4] & 0x38) << 27) | ((int64_t)(block[4] & 0x03) << 28) | ((int64_t)block[5] << 20) | ((int64_t)(block[6] & 0xf8) << 12) | ((int64_t)(block[6] & 0x03) << 13) | ((int64_t)block[7] << 5) | (block[8] >> 3);
+
+	return true;
+
+}
+
+/**
+ * Remux a batch of blocks read from the disc
+ *
+ * Each NAV pack carries the times on across cells (dvd_vobu_pts_base()),
+ * and starts a new segment once the open one is as long as the target.
+ *
+ * @param cell cell the blocks are in
+ * @return false if it couldn't be written
+ */
+bool dvd_ts_blocks(struct dvd_ts *dvd_ts, const uint8_t *buffer, const ssize_t blocks, const uint8_t cell) {
+
+	const uint8_t *block = NULL;
+	int64_t ticks = 0;
+	ssize_t ix = 0;
+
+	for(ix = 0; ix < blocks && !dvd_ts->error; ix++) {
+
+		block = buffer + ix * DVD_VIDEO_LB_LEN;
+
+		if(dvd_vobu_parse(&dvd_ts->dvd_vobu, block)) {
+
+			dvd_vobu_pts_base(&dvd_ts->dvd_vobu, dvd_ts->cell_start[cell], &dvd_ts->has_base, &dvd_ts->base);
+
+			ticks = dvd_ts->base + dvd_ts->dvd_vobu.start_pts + DVD_TS_OFFSET;
+
+			if(dvd_ts->segment != NULL && ticks - dvd_ts->segment_ticks >= dvd_ts->target && !dvd_ts_segment_close(dvd_ts, ticks, false))
+				return false;
+
+			if(dvd_ts->segment == NULL && !dvd_ts_segment_open(dvd_ts, ticks))
+				return false;
+
+			dvd_ts->end_ticks = dvd_ts->base + dvd_ts->dvd_vobu.end_pts + DVD_TS_OFFSET;
+
+			continue;
+
+		}
+
+		dvd_ts->has_scr = dvd_ts_scr(block, &dvd_ts->scr);
+
+		if(dvd_demux(dvd_ts->dvd_demux, (uint8_t *)block, (uint8_t *)block + DVD_VIDEO_LB_LEN, 0) == DVD_DEMUX_ERROR)
+			return false;
+
+	}
+
+	return !dvd_ts->error;
+
+}
+
+/**
+ * Write what is left, finish the last segment and the playlist, and free
+ * everything
+ *
+ * @return false if any of it couldn't be written
+ */
+bool dvd_ts_close(struct dvd_ts *dvd_ts) {
+
+	bool written = false;
+	uint16_t ix = 0;
+
+	if(dvd_ts == NULL)
+		return false;
+
+	if(dvd_ts->segment != NULL && !dvd_ts->error)
+		dvd_ts_segment_close(dvd_ts, dvd_ts->end_ticks, true);
+
+	if(dvd_ts->segment != NULL)
+		fclose(dvd_ts->segment);
+
+	written = !dvd_ts->error && dvd_ts->segments;
+
+	dvd_demux_close(dvd_ts->dvd_demux);
+
+	for(ix = 0; ix < 256; ix++)
+		free(dvd_ts->ts_streams[ix].pes.data);
+
+	free(dvd_ts->durations);
+	free(dvd_ts);
+
+	return written;
+
+}
+
+static bool dvd_ts_pipeline_write(void *data, const struct dvd_pipeline_blocks *dvd_pipeline_blocks) {
+
+	if(!dvd_ts_blocks((struct dvd_ts *)data, dvd_pipeline_blocks->buffer, dvd_pipeline_blocks->blocks, dvd_pipeline_blocks->cell)) {
+		fprintf(stderr, "* Could not write HLS segment from cell %u\n", dvd_pipeline_blocks->cell);
+		return false;
+	}
+
+	return true;
+
+}
+
+/**
+ * Remux everything a pipeline reads to HLS segments.  The muxer is not
+ * closed.
+ */
+bool dvd_ts_pipeline(struct dvd_pipeline *dvd_pipeline, struct dvd_ts *dvd_ts) {
+
+	return dvd_pipeline_add(dvd_pipeline, "ts", dvd_ts_pipeline_write, NULL, dvd_ts);
+
+}
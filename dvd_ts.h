@@ -0,0 +1,75 @@
+#ifndef DVD_INFO_TS_H
+#define DVD_INFO_TS_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+#include <dvdread/dvd_reader.h>
+#include <dvdread/ifo_read.h>
+#include "dvd_session.h"
+#include "dvd_track.h"
+#include "dvd_chapter.h"
+#include "dvd_time.h"
+#include "dvd_audio.h"
+#include "dvd_demux.h"
+#include "dvd_vobu.h"
+#include "dvd_audio_es.h"
+#include "dvd_mkv.h"
+
+#ifndef DVD_VIDEO_LB_LEN
+#define DVD_VIDEO_LB_LEN 2048
+#endif
+
+/**
+ * HLS remuxing (MPEG-TS segments and a playlist)
+ *
+ * Rewraps the packets of the program stream as a transport stream, with
+ * nothing re-encoded: the video, and every active AC3 and MPEG audio stream
+ * (the ones HLS players take).  Each PES packet gets a new header with its
+ * time from the start of the track, and is cut into 188 byte packets with a
+ * continuity counter for its PID.  The video packets carry the PCR, from the
+ * SCR of the pack the PES packet starts in, and again in the packet where a
+ * pack starts whose SCR is 100 ms or more past the last one.
+ *
+ * The stream is cut into segments (name_00000.ts, name_00001.ts, ...) at the
+ * first VOBU that starts after the target duration, so each one starts with
+ * a GOP, the PAT and the PMT.  The playlist is written again each time a
+ * segment is finished, as an event playlist, so it can be played while it is
+ * still being written, and ends up as a VOD playlist when it is closed.
+ *
+ * struct dvd_ts *dvd_ts = dvd_ts_open(dvd_session, &dvd_track, 1, "movie.m3u8", 6);
+ * dvd_ts_blocks(dvd_ts, buffer, blocks, cell);
+ * dvd_ts_close(dvd_ts);
+ */
+
+#define DVD_TS_PACKET 188
+#define DVD_TS_PAT_PID 0x0000
+#define DVD_TS_PMT_PID 0x1000
+#define DVD_TS_VIDEO_PID 0x0100
+#define DVD_TS_AUDIO_PID 0x0101
+
+// Timestamps start a second in, so the SCR ahead of the first PTS isn't negative
+#define DVD_TS_OFFSET 90000
+
+#define DVD_TS_SEGMENT_SECONDS 6
+
+struct dvd_ts;
+
+struct dvd_ts *dvd_ts_open(struct dvd_session *dvd_session, const struct dvd_track *dvd_track, const uint8_t first_chapter, const char *playlist, const uint8_t seconds);
+
+uint8_t dvd_ts_streams(const struct dvd_ts *dvd_ts);
+
+bool dvd_ts_blocks(struct dvd_ts *dvd_ts, const uint8_t *buffer, const ssize_t blocks, const uint8_t cell);
+
+bool dvd_ts_close(struct dvd_ts *dvd_ts);
+
+struct dvd_pipeline;
+
+bool dvd_ts_pipeline(struct dvd_pipeline *dvd_pipeline, struct dvd_ts *dvd_ts);
+
+#endif
@@ -0,0 +1,240 @@
+#include "dvd_vobsub.h"
+
+/**
+ * Check if a block is a subpicture pack: a pack header, then a private
+ * stream 1 packet with a substream of 0x20 to 0x3f
+ *
+ * @param stream set to the subpicture stream, 0 to 31
+ * @param has_pts set if the packet has a PTS, which it does at the start of
+ *   each subpicture
+ * @param pts PTS (90 kHz)
+ */
+bool dvd_vobsub_pack(const uint8_t *block, uint8_t *stream, bool *has_pts, uint64_t *pts) {
+
+	const uint8_t *p = NULL;
+	const uint8_t *payload = NULL;
+
+	// MPEG-2 pack header, 14 bytes and stuffing
+	if(block[0] != 0x00 || block[1] != 0x00 || block[2] != 0x01 || block[3] != 0xba || (block[4] & 0xc0) != 0x40)
+		return false;
+
+	p = block + 14 + (block[13] & 0x07);
+
+	if(p[0] != 0x00 || p[1] != 0x00 || p[2] != 0x01 || p[3] != 0xbd)
+		return false;
+
+	payload = p + 9 + p[8];
+	if(payload >= block + DVD_VIDEO_LB_LEN || payload[0] < 0x20 || payload[0] > 0x3f)
+		return false;
+
+	*stream = payload[0] - 0x20;
+	*has_pts = p[7] & 0x80;
+	*pts = 0;
+
+	if(*has_pts)
+		*pts = ((uint64_t)(p[9] & 0x0e) << 29) | ((uint64_t)p[10] << 22) | ((uint64_t)(p[11] & 0xfe) << 14) | ((uint64_t)p[12] << 7) | (p[13] >> 1);
+
+	return true;
+
+}
+
+/**
+ * Start a .sub file.  The index is kept in memory until it is closed.
+ */
+bool dvd_vobsub_open(struct dvd_vobsub *dvd_vobsub, const char *filename) {
+
+	memset(dvd_vobsub, 0, sizeof(*dvd_vobsub));
+
+	dvd_vobsub->width = 720;
+	dvd_vobsub->height = 480;
+
+	dvd_vobsub->sub = fopen(filename, "w");
+
+	return dvd_vobsub->sub != NULL;
+
+}
+
+/**
+ * Keep a stream, with its language code (can be empty)
+ */
+void dvd_vobsub_stream(struct dvd_vobsub *dvd_vobsub, const uint8_t stream, const char *lang_code) {
+
+	if(stream >= DVD_VOBSUB_STREAMS)
+		return;
+
+	dvd_vobsub->streams[stream].selected = true;
+	snprintf(dvd_vobsub->streams[stream].lang_code, sizeof(dvd_vobsub->streams[stream].lang_code), "%s", lang_code);
+
+}
+
+/**
+ * Size of the video, and the palette from the PGC
+ */
+void dvd_vobsub_video(struct dvd_vobsub *dvd_vobsub, const uint16_t width, const uint16_t height, const uint32_t *palette) {
+
+	uint8_t ix = 0;
+
+	dvd_vobsub->width = width;
+	dvd_vobsub->height = height;
+
+	for(ix = 0; ix < 16; ix++)
+		dvd_vobsub->palette[ix] = dvd_vobsub_rgb(palette[ix]);
+
+}
+
+static uint8_t dvd_vobsub_clamp(const int32_t value) {
+
+	if(value < 0)
+		return 0;
+	if(value > 255)
+		return 255;
+
+	return (uint8_t)value;
+
+}
+
+/**
+ * Convert a palette color, 0x00YYCrCb, to 0x00RRGGBB (BT.601)
+ */
+uint32_t dvd_vobsub_rgb(const uint32_t ycrcb) {
+
+	int32_t y = (ycrcb >> 16) & 0xff;
+	int32_t cr = (int32_t)((ycrcb >> 8) & 0xff) - 128;
+	int32_t cb = (int32_t)(ycrcb & 0xff) - 128;
+	uint8_t r = dvd_vobsub_clamp(y + (1402 * cr) / 1000);
+	uint8_t g = dvd_vobsub_clamp(y - (344 * cb + 714 * cr) / 1000);
+	uint8_t b = dvd_vobsub_clamp(y + (1772 * cb) / 1000);
+
+	return ((uint32_t)r << 16) | ((uint32_t)g << 8) | b;
+
+}
+
+/**
+ * Write a subpicture pack to the .sub, and index it if a subpicture starts
+ * in it.  Packs of streams that weren't selected are skipped.
+ *
+ * @param block the whole pack
+ * @param stream subpicture stream, 0 to 31
+ * @param start a subpicture starts in it (the packet has a PTS)
+ * @param msecs time it is displayed, from the start of the track
+ * @return false if it couldn't be written
+ */
+bool dvd_vobsub_add(struct dvd_vobsub *dvd_vobsub, const uint8_t *block, const uint8_t stream, const bool start, const uint32_t msecs) {
+
+	struct dvd_vobsub_stream *dvd_vobsub_stream = NULL;
+	struct dvd_vobsub_entry *entries = NULL;
+	uint32_t size = 0;
+
+	if(stream >= DVD_VOBSUB_STREAMS || !dvd_vobsub->streams[stream].selected)
+		return true;
+
+	dvd_vobsub_stream = &dvd_vobsub->streams[stream];
+
+	if(start) {
+
+		if(dvd_vobsub_stream->count == dvd_vobsub_stream->size) {
+			size = dvd_vobsub_stream->size ? dvd_vobsub_stream->size * 2 : 256;
+			entries = realloc(dvd_vobsub_stream->entries, size * sizeof(struct dvd_vobsub_entry));
+			if(entries == NULL)
+				return false;
+			dvd_vobsub_stream->entries = entries;
+			dvd_vobsub_stream->size = size;
+		}
+
+		dvd_vobsub_stream->entries[dvd_vobsub_stream->count].msecs = msecs;
+		dvd_vobsub_stream->entries[dvd_vobsub_stream->count].filepos = dvd_vobsub->filepos;
+		dvd_vobsub_stream->count++;
+
+	}
+
+	if(fwrite(block, DVD_VIDEO_LB_LEN, 1, dvd_vobsub->sub) != 1)
+		return false;
+
+	dvd_vobsub->filepos += DVD_VIDEO_LB_LEN;
+
+	return true;
+
+}
+
+/**
+ * Write the index, and close the .sub
+ *
+ * @param filename .idx file
+ * @return false if either couldn't be written
+ */
+bool dvd_vobsub_close(struct dvd_vobsub *dvd_vobsub, const char *filename) {
+
+	struct dvd_vobsub_stream *dvd_vobsub_stream = NULL;
+	struct dvd_vobsub_entry *entry = NULL;
+	FILE *idx = NULL;
+	bool written = true;
+	uint32_t ix = 0;
+	uint8_t stream = 0;
+	uint8_t langidx = 0;
+
+	if(dvd_vobsub->sub != NULL && fclose(dvd_vobsub->sub) != 0)
+		written = false;
+
+	dvd_vobsub->sub = NULL;
+
+	for(stream = DVD_VOBSUB_STREAMS; stream > 0; stream--) {
+		if(dvd_vobsub->streams[stream - 1].selected)
+			langidx = (uint8_t)(stream - 1);
+	}
+
+	idx = fopen(filename, "w");
+
+	if(idx != NULL) {
+
+		fprintf(idx, "# VobSub index file, v7 (do not modify this line!)\n");
+		fprintf(idx, "#\n");
+		fprintf(idx, "size: %ux%u\n", dvd_vobsub->width, dvd_vobsub->height);
+		fprintf(idx, "org: 0, 0\n");
+		fprintf(idx, "scale: 100%%, 100%%\n");
+		fprintf(idx, "alpha: 100%%\n");
+		fprintf(idx, "smooth: OFF\n");
+		fprintf(idx, "fadein/out: 50, 50\n");
+		fprintf(idx, "align: OFF at LEFT TOP\n");
+		fprintf(idx, "time offset: 0\n");
+		fprintf(idx, "forced subs: OFF\n");
+		fprintf(idx, "palette: ");
+		for(ix = 0; ix < 16; ix++)
+			fprintf(idx, "%s%06x", ix ? ", " : "", dvd_vobsub->palette[ix]);
+		fprintf(idx, "\n");
+		fprintf(idx, "custom colors: OFF, tridx: 0000, colors: 000000, 000000, 000000, 000000\n");
+		fprintf(idx, "\n");
+		fprintf(idx, "# Language index in use\n");
+		fprintf(idx, "langidx: %u\n", langidx);
+
+		for(stream = 0; stream < DVD_VOBSUB_STREAMS; stream++) {
+
+			dvd_vobsub_stream = &dvd_vobsub->streams[stream];
+
+			if(!dvd_vobsub_stream->selected)
+				continue;
+
+			// "--" is an undefined language
+			fprintf(idx, "\nid: %s, index: %u\n", strlen(dvd_vobsub_stream->lang_code) ? dvd_vobsub_stream->lang_code : "--", stream);
+
+			for(ix = 0; ix < dvd_vobsub_stream->count; ix++) {
+				entry = &dvd_vobsub_stream->entries[ix];
+				fprintf(idx, "timestamp: %02u:%02u:%02u:%03u, filepos: %09" PRIx64 "\n", entry->msecs / 3600000, (entry->msecs / 60000) % 60, (entry->msecs / 1000) % 60, entry->msecs % 1000, entry->filepos);
+			}
+
+		}
+
+		if(fclose(idx) != 0)
+			written = false;
+
+	} else {
+		written = false;
+	}
+
+	for(stream = 0; stream < DVD_VOBSUB_STREAMS; stream++) {
+		free(dvd_vobsub->streams[stream].entries);
+		dvd_vobsub->streams[stream].entries = NULL;
+	}
+
+	return written;
+
+}
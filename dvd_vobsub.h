@@ -0,0 +1,72 @@
+#ifndef DVD_INFO_VOBSUB_H
+#define DVD_INFO_VOBSUB_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#ifndef DVD_VIDEO_LB_LEN
+#define DVD_VIDEO_LB_LEN 2048
+#endif
+
+/**
+ * VobSub subtitles (.idx and .sub)
+ *
+ * The .sub file is the subpicture packs of a track, exactly as they are on
+ * the disc, for any number of streams.  The .idx file is text: the size of
+ * the video, the palette in RGB, and then for each stream its language and
+ * the time and place in the .sub of every subpicture that starts in it.
+ *
+ * Packs are added as they are read, so every stream comes out of the same
+ * pass, and the index is written when it is closed.
+ *
+ * struct dvd_vobsub dvd_vobsub;
+ * dvd_vobsub_open(&dvd_vobsub, "movie.sub");
+ * dvd_vobsub_stream(&dvd_vobsub, 0, "en");
+ * dvd_vobsub_pack(block, &stream, &has_pts, &pts);
+ * dvd_vobsub_add(&dvd_vobsub, block, stream, has_pts, msecs);
+ * dvd_vobsub_close(&dvd_vobsub, "movie.idx");
+ */
+
+#define DVD_VOBSUB_STREAMS 32
+
+struct dvd_vobsub_entry {
+	uint32_t msecs;
+	uint64_t filepos;
+};
+
+struct dvd_vobsub_stream {
+	bool selected;
+	char lang_code[3];
+	struct dvd_vobsub_entry *entries;
+	uint32_t count;
+	uint32_t size;
+};
+
+struct dvd_vobsub {
+	FILE *sub;
+	uint64_t filepos;
+	uint16_t width;
+	uint16_t height;
+	uint32_t palette[16];
+	struct dvd_vobsub_stream streams[DVD_VOBSUB_STREAMS];
+};
+
+bool dvd_vobsub_pack(const uint8_t *block, uint8_t *stream, bool *has_pts, uint64_t *pts);
+
+bool dvd_vobsub_open(struct dvd_vobsub *dvd_vobsub, const char *filename);
+
+void dvd_vobsub_stream(struct dvd_vobsub *dvd_vobsub, const uint8_t stream, const char *lang_code);
+
+void dvd_vobsub_video(struct dvd_vobsub *dvd_vobsub, const uint16_t width, const uint16_t height, const uint32_t *palette);
+
+uint32_t dvd_vobsub_rgb(const uint32_t ycrcb);
+
+bool dvd_vobsub_add(struct dvd_vobsub *dvd_vobsub, const uint8_t *block, const uint8_t stream, const bool start, const uint32_t msecs);
+
+bool dvd_vobsub_close(struct dvd_vobsub *dvd_vobsub, const char *filename);
+
+#endif
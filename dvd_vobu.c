@@ -0,0 +1,650 @@
+#include "dvd_vobu.h"
+#include "dvd_pipeline.h"
+#include "dvd_demux.h"
+
+/**
+ * Functions to parse the NAV packs at the start of each VOBU, and keep an
+ * index of them
+ */
+
+/**
+ * Check that a block is a NAV pack: a pack header, the system header, then
+ * the PCI (private stream 2, substream 0) and the DSI (substream 1)
+ */
+bool dvd_vobu_nav_pack(const unsigned char *block) {
+
+	if(block[0] != 0x00 || block[1] != 0x00 || block[2] != 0x01 || block[3] != 0xba)
+		return false;
+
+	if(block[38] != 0x00 || block[39] != 0x00 || block[40] != 0x01 || block[41] != 0xbf || block[44] != 0x00)
+		return false;
+
+	if(block[1024] != 0x00 || block[1025] != 0x00 || block[1026] != 0x01 || block[1027] != 0xbf || block[1030] != 0x01)
+		return false;
+
+	return true;
+
+}
+
+/**
+ * Parse a NAV pack
+ *
+ * The sector is the one the DSI has for itself, and offset and cell are left
+ * at zero, since only the caller knows where it read the block from.
+ *
+ * @param block one block (2048 bytes)
+ * @return false if the block isn't a NAV pack
+ */
+bool dvd_vobu_parse(struct dvd_vobu *dvd_vobu, const unsigned char *block) {
+
+	pci_t pci;
+	dsi_t dsi;
+	uint8_t ix = 0;
+
+	memset(dvd_vobu, 0, sizeof(*dvd_vobu));
+
+	if(!dvd_vobu_nav_pack(block))
+		return false;
+
+	navRead_PCI(&pci, (unsigned char *)block + PCI_START_BYTE);
+	navRead_DSI(&dsi, (unsigned char *)block + DSI_START_BYTE);
+
+	dvd_vobu->sector = dsi.dsi_gi.nv_pck_lbn;
+	dvd_vobu->blocks = dsi.dsi_gi.vobu_ea + 1;
+	dvd_vobu->start_pts = pci.pci_gi.vobu_s_ptm;
+	dvd_vobu->end_pts = pci.pci_gi.vobu_e_ptm;
+	dvd_vobu->next_vobu = dsi.vobu_sri.next_vobu;
+	dvd_vobu->first_ref = dsi.dsi_gi.vobu_1stref_ea;
+	dvd_vobu->cell_msecs = dvd_time_to_milliseconds(&dsi.dsi_gi.c_eltm);
+	dvd_vobu->ilvu_ea = dsi.sml_pbi.ilvu_ea;
+	dvd_vobu->ilvu_sa = dsi.sml_pbi.ilvu_sa;
+	dvd_vobu->vob_id = dsi.dsi_gi.vobu_vob_idn;
+	dvd_vobu->category = dsi.sml_pbi.category;
+	dvd_vobu->cell_id = dsi.dsi_gi.vobu_c_idn;
+
+	for(ix = 0; ix < 9; ix++) {
+		if(dsi.sml_agli.data[ix].address)
+			dvd_vobu->angles++;
+	}
+
+	return true;
+
+}
+
+/**
+ * Number of blocks from the NAV pack to the end of the first reference
+ * (I) frame, which is all that needs to be read to decode it.  If the DSI
+ * doesn't have it, it's the whole VOBU.
+ */
+uint32_t dvd_vobu_first_ref_blocks(const struct dvd_vobu *dvd_vobu) {
+
+	if(dvd_vobu->first_ref == 0 || dvd_vobu->first_ref >= dvd_vobu->blocks)
+		return dvd_vobu->blocks;
+
+	return dvd_vobu->first_ref + 1;
+
+}
+
+/**
+ * Time into the cell of a PTS in the VOBU.  The PTS can go back to zero at a
+ * cell boundary, but the elapsed time in the DSI doesn't.
+ */
+uint32_t dvd_vobu_pts_msecs(const struct dvd_vobu *dvd_vobu, const uint64_t pts) {
+
+	int64_t msecs = (int64_t)dvd_vobu->cell_msecs + ((int64_t)pts - (int64_t)dvd_vobu->start_pts) / 90;
+
+	return msecs > 0 ? (uint32_t)msecs : 0;
+
+}
+
+/**
+ * Keep an offset that turns a PTS into time from the start of the track, in
+ * 90 kHz ticks.  It is set from the elapsed time in the first NAV pack, and
+ * only moved when the PTS jumps (more than a second off from the elapsed
+ * time), so times stay exact while the PTS carries on across cells.
+ *
+ * @param cell_start time the VOBU's cell starts at in the track (msecs)
+ */
+void dvd_vobu_pts_base(const struct dvd_vobu *dvd_vobu, const uint32_t cell_start, bool *has_base, int64_t *base) {
+
+	int64_t expected = ((int64_t)cell_start + dvd_vobu->cell_msecs) * 90;
+	int64_t drift = *base + dvd_vobu->start_pts - expected;
+
+	if(*has_base && drift <= 90000 && drift >= -90000)
+		return;
+
+	*base = expected - dvd_vobu->start_pts;
+	*has_base = true;
+
+}
+
+void dvd_vobu_index_init(struct dvd_vobu_index *dvd_vobu_index, const uint16_t track_number, const uint16_t vts) {
+
+	memset(dvd_vobu_index, 0, sizeof(*dvd_vobu_index));
+
+	dvd_vobu_index->track = track_number;
+	dvd_vobu_index->vts = vts;
+
+}
+
+bool dvd_vobu_index_add(struct dvd_vobu_index *dvd_vobu_index, const struct dvd_vobu *dvd_vobu) {
+
+	struct dvd_vobu *vobu = NULL;
+	uint32_t size = 0;
+
+	if(dvd_vobu_index->vobus == dvd_vobu_index->size) {
+
+		size = dvd_vobu_index->size ? dvd_vobu_index->size * 2 : 1024;
+
+		vobu = realloc(dvd_vobu_index->vobu, size * sizeof(struct dvd_vobu));
+		if(vobu == NULL)
+			return false;
+
+		dvd_vobu_index->vobu = vobu;
+		dvd_vobu_index->size = size;
+
+	}
+
+	dvd_vobu_index->vobu[dvd_vobu_index->vobus] = *dvd_vobu;
+	dvd_vobu_index->vobus++;
+
+	return true;
+
+}
+
+/**
+ * Add the VOBUs of one cell to an index, reading only the NAV packs
+ *
+ * Each cell starts with a NAV pack, and the DSI says where the next VOBU is,
+ * so only one block in every VOBU is read.  When the DSI doesn't have a next
+ * VOBU, the length of the current one is used to find it.
+ */
+static bool dvd_vobu_index_cell(dvd_file_t *dvdread_vts_file, const uint8_t cell, const uint32_t first_sector, const uint32_t last_sector, const uint32_t offset, struct dvd_vobu_index *dvd_vobu_index) {
+
+	unsigned char block[DVD_VIDEO_LB_LEN];
+	struct dvd_vobu dvd_vobu;
+	uint32_t sector = first_sector;
+	uint32_t next = 0;
+
+	while(sector <= last_sector) {
+
+		if(DVDReadBlocks(dvdread_vts_file, (int)sector, 1, block) != 1) {
+			fprintf(stderr, "* Could not read sector %u\n", sector);
+			return false;
+		}
+
+		// Not where a VOBU should start, look at the next block
+		if(!dvd_vobu_parse(&dvd_vobu, block)) {
+			sector++;
+			continue;
+		}
+
+		dvd_vobu.sector = sector;
+		dvd_vobu.offset = offset + (sector - first_sector);
+		dvd_vobu.cell = cell;
+
+		if(!dvd_vobu_index_add(dvd_vobu_index, &dvd_vobu)) {
+			fprintf(stderr, "Couldn't allocate memory\n");
+			return false;
+		}
+
+		if(dvd_vobu.next_vobu == SRI_END_OF_CELL)
+			break;
+
+		next = dvd_vobu.next_vobu & SRI_END_OF_CELL;
+		if(next == 0)
+			next = dvd_vobu.blocks;
+
+		sector += next;
+
+	}
+
+	return true;
+
+}
+
+/**
+ * Build the index for a range of cells of a track, by reading only the NAV
+ * packs.  Offsets are from the start of the track.
+ *
+ * @param dvd_vobu_index index, does not need to be initialized
+ * @return false if the track can't be read
+ */
+bool dvd_vobu_index_cells(struct dvd_session *dvd_session, const uint16_t track_number, const uint8_t first_cell, const uint8_t last_cell, struct dvd_vobu_index *dvd_vobu_index) {
+
+	ifo_handle_t *vmg_ifo = dvd_session_vmg_ifo(dvd_session);
+	ifo_handle_t *vts_ifo = dvd_session_track_ifo(dvd_session, track_number);
+	dvd_file_t *dvdread_vts_file = NULL;
+	uint16_t vts = 0;
+	uint8_t cell = 0;
+	uint32_t first_sector = 0;
+	uint32_t last_sector = 0;
+	uint32_t offset = 0;
+
+	if(vts_ifo == NULL)
+		return false;
+
+	vts = dvd_vts_ifo_number(vmg_ifo, track_number);
+
+	dvd_vobu_index_init(dvd_vobu_index, track_number, vts);
+
+	dvdread_vts_file = DVDOpenFile(dvd_session_dvdread(dvd_session), vts, DVD_READ_TITLE_VOBS);
+	if(dvdread_vts_file == NULL) {
+		fprintf(stderr, "* Could not open VOBs for VTS %u\n", vts);
+		return false;
+	}
+
+	for(cell = 1; cell < last_cell + 1; cell++) {
+
+		first_sector = dvd_cell_first_sector(vmg_ifo, vts_ifo, track_number, cell);
+		last_sector = dvd_cell_last_sector(vmg_ifo, vts_ifo, track_number, cell);
+
+		if(last_sector < first_sector)
+			continue;
+
+		if(cell >= first_cell && !dvd_vobu_index_cell(dvdread_vts_file, cell, first_sector, last_sector, offset, dvd_vobu_index)) {
+			DVDCloseFile(dvdread_vts_file);
+			return false;
+		}
+
+		offset += last_sector - first_sector + 1;
+
+	}
+
+	DVDCloseFile(dvdread_vts_file);
+
+	return true;
+
+}
+
+/**
+ * Build the index for a whole track, by reading only the NAV packs
+ */
+bool dvd_vobu_index_track(struct dvd_session *dvd_session, const uint16_t track_number, struct dvd_vobu_index *dvd_vobu_index) {
+
+	ifo_handle_t *vmg_ifo = dvd_session_vmg_ifo(dvd_session);
+	ifo_handle_t *vts_ifo = dvd_session_track_ifo(dvd_session, track_number);
+
+	if(vts_ifo == NULL)
+		return false;
+
+	return dvd_vobu_index_cells(dvd_session, track_number, 1, dvd_track_cells(vmg_ifo, vts_ifo, track_number), dvd_vobu_index);
+
+}
+
+/**
+ * Find the cell a time in a track falls in, and the time into that cell
+ *
+ * @return false if the time is past the end of the track
+ */
+static bool dvd_vobu_msecs_cell(struct dvd_session *dvd_session, const uint16_t track_number, const uint32_t msecs, uint8_t *cell, uint32_t *cell_msecs) {
+
+	ifo_handle_t *vmg_ifo = dvd_session_vmg_ifo(dvd_session);
+	ifo_handle_t *vts_ifo = dvd_session_track_ifo(dvd_session, track_number);
+	uint8_t cells = 0;
+	uint32_t cell_start = 0;
+	uint32_t length = 0;
+
+	if(vts_ifo == NULL)
+		return false;
+
+	cells = dvd_track_cells(vmg_ifo, vts_ifo, track_number);
+
+	for(*cell = 1; *cell < cells + 1; (*cell)++) {
+
+		length = dvd_cell_msecs(vmg_ifo, vts_ifo, track_number, *cell);
+
+		if(msecs < cell_start + length)
+			break;
+
+		cell_start += length;
+
+	}
+
+	if(*cell > cells)
+		return false;
+
+	*cell_msecs = msecs - cell_start;
+
+	return true;
+
+}
+
+/**
+ * Binary search an index for the last VOBU of a cell that starts at or
+ * before a time in it, or the first one of the cell if they all start after.
+ *
+ * @return false if the cell has no VOBUs in the index
+ */
+static bool dvd_vobu_index_search(const struct dvd_vobu_index *dvd_vobu_index, const uint8_t cell, const uint32_t cell_msecs, struct dvd_vobu *dvd_vobu) {
+
+	const struct dvd_vobu *vobu = dvd_vobu_index->vobu;
+	uint32_t lo = 0;
+	uint32_t hi = dvd_vobu_index->vobus;
+	uint32_t mid = 0;
+
+	// First VOBU that is past the time
+	while(lo < hi) {
+
+		mid = lo + (hi - lo) / 2;
+
+		if(vobu[mid].cell < cell || (vobu[mid].cell == cell && vobu[mid].cell_msecs <= cell_msecs))
+			lo = mid + 1;
+		else
+			hi = mid;
+
+	}
+
+	if(lo > 0 && vobu[lo - 1].cell == cell)
+		lo--;
+
+	if(lo == dvd_vobu_index->vobus || vobu[lo].cell != cell)
+		return false;
+
+	*dvd_vobu = vobu[lo];
+
+	return true;
+
+}
+
+/**
+ * Find the VOBU that a time in a track falls in, using the cell elapsed
+ * times in the NAV packs.  Only the cell the time is in is read, so use
+ * dvd_vobu_index_find_msecs() instead when looking up more than a few times.
+ *
+ * @param msecs time from the start of the track
+ * @param dvd_vobu set to the VOBU
+ * @return false if the time is past the end of the track, or it can't be read
+ */
+bool dvd_vobu_find_msecs(struct dvd_session *dvd_session, const uint16_t track_number, const uint32_t msecs, struct dvd_vobu *dvd_vobu) {
+
+	struct dvd_vobu_index dvd_vobu_index;
+	uint8_t cell = 0;
+	uint32_t cell_msecs = 0;
+	bool found = false;
+
+	if(!dvd_vobu_msecs_cell(dvd_session, track_number, msecs, &cell, &cell_msecs))
+		return false;
+
+	if(!dvd_vobu_index_cells(dvd_session, track_number, cell, cell, &dvd_vobu_index))
+		return false;
+
+	found = dvd_vobu_index_search(&dvd_vobu_index, cell, cell_msecs, dvd_vobu);
+
+	dvd_vobu_index_free(&dvd_vobu_index);
+
+	return found;
+
+}
+
+/**
+ * Find the VOBU that a time falls in, in the index of a whole track
+ *
+ * @param msecs time from the start of the track
+ * @param dvd_vobu set to the VOBU
+ * @return false if the time is past the end of the track, or isn't indexed
+ */
+bool dvd_vobu_index_find_msecs(struct dvd_session *dvd_session, const struct dvd_vobu_index *dvd_vobu_index, const uint32_t msecs, struct dvd_vobu *dvd_vobu) {
+
+	uint8_t cell = 0;
+	uint32_t cell_msecs = 0;
+
+	if(!dvd_vobu_msecs_cell(dvd_session, dvd_vobu_index->track, msecs, &cell, &cell_msecs))
+		return false;
+
+	return dvd_vobu_index_search(dvd_vobu_index, cell, cell_msecs, dvd_vobu);
+
+}
+
+/**
+ * Read the first reference picture of the VOBU a time is in, and hand it to a
+ * demuxer, which is reset first.  This is all a thumbnail of that time needs:
+ * the decoder behind the demuxer only has to be flushed with a sequence end
+ * code to display the picture.
+ *
+ * @param dvdread_vts_file title VOBs of the track's VTS
+ * @param dvd_vobu set to the VOBU that was read
+ */
+bool dvd_vobu_index_sample(struct dvd_session *dvd_session, const struct dvd_vobu_index *dvd_vobu_index, dvd_file_t *dvdread_vts_file, const uint32_t msecs, struct dvd_vobu *dvd_vobu, struct dvd_demux *dvd_vobu_demux) {
+
+	unsigned char *buffer = NULL;
+	uint32_t blocks = 0;
+	bool demuxed = false;
+
+	if(!dvd_vobu_index_find_msecs(dvd_session, dvd_vobu_index, msecs, dvd_vobu)) {
+		fprintf(stderr, "* Could not find a VOBU at %u ms in track %u\n", msecs, dvd_vobu_index->track);
+		return false;
+	}
+
+	blocks = dvd_vobu_first_ref_blocks(dvd_vobu);
+
+	buffer = malloc((size_t)blocks * DVD_VIDEO_LB_LEN);
+	if(buffer == NULL) {
+		fprintf(stderr, "Couldn't allocate memory\n");
+		return false;
+	}
+
+	if(DVDReadBlocks(dvdread_vts_file, (int)dvd_vobu->sector, blocks, buffer) != (ssize_t)blocks) {
+		fprintf(stderr, "* Could not read sector %u\n", dvd_vobu->sector);
+		free(buffer);
+		return false;
+	}
+
+	// Only the output can stop the demuxer, and it says why
+	dvd_demux_reset(dvd_vobu_demux);
+	demuxed = dvd_demux(dvd_vobu_demux, buffer, buffer + blocks * DVD_VIDEO_LB_LEN, DVD_DEMUX_PAYLOAD_START) != DVD_DEMUX_ERROR;
+
+	free(buffer);
+
+	return demuxed;
+
+}
+
+static void dvd_vobu_write16(unsigned char *buf, const uint16_t value) {
+
+	buf[0] = value & 0xff;
+	buf[1] = (value >> 8) & 0xff;
+
+}
+
+static void dvd_vobu_write32(unsigned char *buf, const uint32_t value) {
+
+	buf[0] = value & 0xff;
+	buf[1] = (value >> 8) & 0xff;
+	buf[2] = (value >> 16) & 0xff;
+	buf[3] = (value >> 24) & 0xff;
+
+}
+
+static uint16_t dvd_vobu_read16(const unsigned char *buf) {
+
+	return (uint16_t)(buf[0] | (buf[1] << 8));
+
+}
+
+static uint32_t dvd_vobu_read32(const unsigned char *buf) {
+
+	return (uint32_t)buf[0] | ((uint32_t)buf[1] << 8) | ((uint32_t)buf[2] << 16) | ((uint32_t)buf[3] << 24);
+
+}
+
+/**
+ * Save the index to a binary file
+ */
+bool dvd_vobu_index_save(const struct dvd_vobu_index *dvd_vobu_index, const char *filename) {
+
+	FILE *vobu_file = NULL;
+	unsigned char header[DVD_VOBU_HEADER];
+	unsigned char record[DVD_VOBU_RECORD];
+	const struct dvd_vobu *dvd_vobu = NULL;
+	uint32_t ix = 0;
+	bool saved = true;
+
+	vobu_file = fopen(filename, "wb");
+	if(vobu_file == NULL)
+		return false;
+
+	memset(header, 0, sizeof(header));
+	memcpy(header, DVD_VOBU_MAGIC, 7);
+	header[7] = DVD_VOBU_VERSION;
+	dvd_vobu_write16(header + 8, dvd_vobu_index->track);
+	dvd_vobu_write16(header + 10, dvd_vobu_index->vts);
+	dvd_vobu_write32(header + 12, dvd_vobu_index->vobus);
+
+	if(fwrite(header, sizeof(header), 1, vobu_file) != 1)
+		saved = false;
+
+	for(ix = 0; ix < dvd_vobu_index->vobus && saved; ix++) {
+
+		dvd_vobu = &dvd_vobu_index->vobu[ix];
+
+		memset(record, 0, sizeof(record));
+		dvd_vobu_write32(record, dvd_vobu->sector);
+		dvd_vobu_write32(record + 4, dvd_vobu->offset);
+		dvd_vobu_write32(record + 8, dvd_vobu->blocks);
+		dvd_vobu_write32(record + 12, dvd_vobu->start_pts);
+		dvd_vobu_write32(record + 16, dvd_vobu->end_pts);
+		dvd_vobu_write32(record + 20, dvd_vobu->next_vobu);
+		dvd_vobu_write32(record + 24, dvd_vobu->first_ref);
+		dvd_vobu_write32(record + 28, dvd_vobu->cell_msecs);
+		dvd_vobu_write32(record + 32, dvd_vobu->ilvu_ea);
+		dvd_vobu_write32(record + 36, dvd_vobu->ilvu_sa);
+		dvd_vobu_write16(record + 40, dvd_vobu->vob_id);
+		dvd_vobu_write16(record + 42, dvd_vobu->category);
+		record[44] = dvd_vobu->cell;
+		record[45] = dvd_vobu->cell_id;
+		record[46] = dvd_vobu->angles;
+
+		if(fwrite(record, sizeof(record), 1, vobu_file) != 1)
+			saved = false;
+
+	}
+
+	if(fclose(vobu_file) != 0)
+		saved = false;
+
+	return saved;
+
+}
+
+/**
+ * Load an index saved with dvd_vobu_index_save()
+ *
+ * @return false if the file can't be read, or isn't a VOBU index
+ */
+bool dvd_vobu_index_load(struct dvd_vobu_index *dvd_vobu_index, const char *filename) {
+
+	FILE *vobu_file = NULL;
+	unsigned char header[DVD_VOBU_HEADER];
+	unsigned char record[DVD_VOBU_RECORD];
+	struct dvd_vobu dvd_vobu;
+	uint32_t vobus = 0;
+	uint32_t ix = 0;
+
+	memset(dvd_vobu_index, 0, sizeof(*dvd_vobu_index));
+
+	vobu_file = fopen(filename, "rb");
+	if(vobu_file == NULL)
+		return false;
+
+	if(fread(header, sizeof(header), 1, vobu_file) != 1 || memcmp(header, DVD_VOBU_MAGIC, 7) != 0 || header[7] != DVD_VOBU_VERSION) {
+		fclose(vobu_file);
+		return false;
+	}
+
+	dvd_vobu_index_init(dvd_vobu_index, dvd_vobu_read16(header + 8), dvd_vobu_read16(header + 10));
+	vobus = dvd_vobu_read32(header + 12);
+
+	for(ix = 0; ix < vobus; ix++) {
+
+		if(fread(record, sizeof(record), 1, vobu_file) != 1) {
+			dvd_vobu_index_free(dvd_vobu_index);
+			fclose(vobu_file);
+			return false;
+		}
+
+		memset(&dvd_vobu, 0, sizeof(dvd_vobu));
+		dvd_vobu.sector = dvd_vobu_read32(record);
+		dvd_vobu.offset = dvd_vobu_read32(record + 4);
+		dvd_vobu.blocks = dvd_vobu_read32(record + 8);
+		dvd_vobu.start_pts = dvd_vobu_read32(record + 12);
+		dvd_vobu.end_pts = dvd_vobu_read32(record + 16);
+		dvd_vobu.next_vobu = dvd_vobu_read32(record + 20);
+		dvd_vobu.first_ref = dvd_vobu_read32(record + 24);
+		dvd_vobu.cell_msecs = dvd_vobu_read32(record + 28);
+		dvd_vobu.ilvu_ea = dvd_vobu_read32(record + 32);
+		dvd_vobu.ilvu_sa = dvd_vobu_read32(record + 36);
+		dvd_vobu.vob_id = dvd_vobu_read16(record + 40);
+		dvd_vobu.category = dvd_vobu_read16(record + 42);
+		dvd_vobu.cell = record[44];
+		dvd_vobu.cell_id = record[45];
+		dvd_vobu.angles = record[46];
+
+		if(!dvd_vobu_index_add(dvd_vobu_index, &dvd_vobu)) {
+			dvd_vobu_index_free(dvd_vobu_index);
+			fclose(vobu_file);
+			return false;
+		}
+
+	}
+
+	fclose(vobu_file);
+
+	return true;
+
+}
+
+void dvd_vobu_index_free(struct dvd_vobu_index *dvd_vobu_index) {
+
+	free(dvd_vobu_index->vobu);
+
+	dvd_vobu_index->vobu = NULL;
+	dvd_vobu_index->vobus = 0;
+	dvd_vobu_index->size = 0;
+
+}
+
+static bool dvd_vobu_index_pipeline_write(void *data, const struct dvd_pipeline_blocks *dvd_pipeline_blocks) {
+
+	struct dvd_vobu_index *dvd_vobu_index = (struct dvd_vobu_index *)data;
+	struct dvd_vobu dvd_vobu;
+	const unsigned char *block = NULL;
+	ssize_t ix = 0;
+
+	dvd_vobu_index->track = dvd_pipeline_blocks->track;
+	dvd_vobu_index->vts = dvd_pipeline_blocks->vts;
+
+	for(ix = 0; ix < dvd_pipeline_blocks->blocks; ix++) {
+
+		block = dvd_pipeline_blocks->buffer + ix * DVD_VIDEO_LB_LEN;
+
+		if(!dvd_vobu_parse(&dvd_vobu, block))
+			continue;
+
+		dvd_vobu.sector = dvd_pipeline_blocks->sector + (uint32_t)ix;
+		dvd_vobu.offset = (uint32_t)(dvd_pipeline_blocks->blocks_read - dvd_pipeline_blocks->blocks + ix);
+		dvd_vobu.cell = dvd_pipeline_blocks->cell;
+
+		if(!dvd_vobu_index_add(dvd_vobu_index, &dvd_vobu)) {
+			fprintf(stderr, "Couldn't allocate memory\n");
+			return false;
+		}
+
+	}
+
+	return true;
+
+}
+
+/**
+ * Build an index from the NAV packs as a pipeline reads them, with no extra
+ * reads.  The offsets are from the start of the chapter range being read,
+ * and the track and VTS are set from the blocks.
+ */
+bool dvd_vobu_index_pipeline(struct dvd_pipeline *dvd_pipeline, struct dvd_vobu_index *dvd_vobu_index) {
+
+	dvd_vobu_index_init(dvd_vobu_index, 0, 0);
+
+	return dvd_pipeline_add(dvd_pipeline, "vobu", dvd_vobu_index_pipeline_write, NULL, dvd_vobu_index);
+
+}
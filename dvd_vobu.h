@@ -0,0 +1,123 @@
+#ifndef DVD_INFO_VOBU_H
+#define DVD_INFO_VOBU_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dvdread/dvd_reader.h>
+#include <dvdread/ifo_read.h>
+#include <dvdread/nav_read.h>
+#include "dvd_session.h"
+
+#ifndef DVD_VIDEO_LB_LEN
+#define DVD_VIDEO_LB_LEN 2048
+#endif
+
+// Where the PCI and DSI packets start in a NAV pack
+#ifndef PCI_START_BYTE
+#define PCI_START_BYTE 45
+#endif
+#ifndef DSI_START_BYTE
+#define DSI_START_BYTE 1031
+#endif
+
+#ifndef SRI_END_OF_CELL
+#define SRI_END_OF_CELL 0x3fffffff
+#endif
+
+/**
+ * VOBU index
+ *
+ * Every VOBU (about half a second of video) starts with a NAV pack, which has
+ * two packets in private stream 2 (0xbf): the PCI, with the presentation
+ * times, and the DSI, with the VOBU's length and where the next ones are.
+ * The index is one entry for each NAV pack of a track, so anything that needs
+ * to find a time or a sector (seeking, copying part of a track, bitrates)
+ * can look it up instead of scanning the stream.
+ *
+ * The index can be saved to a binary file (.vobu), which has a 16 byte
+ * header, "DVDVOBU", the version, then the track, VTS and number of entries,
+ * and a 48 byte record for each VOBU.  Everything is little-endian.
+ */
+
+#define DVD_VOBU_MAGIC "DVDVOBU"
+#define DVD_VOBU_VERSION 1
+#define DVD_VOBU_HEADER 16
+#define DVD_VOBU_RECORD 48
+
+/**
+ * sector: NAV pack, relative to the start of the VTS title VOBs
+ * offset: blocks into the track (or a copy of it) that the VOBU starts at
+ * blocks: length of the VOBU
+ * start_pts, end_pts: presentation times (90 kHz)
+ * next_vobu: next VOBU, as stored in the DSI (relative, with flags)
+ * first_ref: end of the first reference (I) frame, relative to the NAV pack
+ * cell_msecs: time elapsed in the cell
+ * category, ilvu_ea, ilvu_sa: seamless playback / interleaved unit info
+ * angles: number of angles with a seamless angle link
+ */
+struct dvd_vobu {
+	uint32_t sector;
+	uint32_t offset;
+	uint32_t blocks;
+	uint32_t start_pts;
+	uint32_t end_pts;
+	uint32_t next_vobu;
+	uint32_t first_ref;
+	uint32_t cell_msecs;
+	uint32_t ilvu_ea;
+	uint32_t ilvu_sa;
+	uint16_t vob_id;
+	uint16_t category;
+	uint8_t cell;
+	uint8_t cell_id;
+	uint8_t angles;
+};
+
+struct dvd_vobu_index {
+	uint16_t track;
+	uint16_t vts;
+	uint32_t vobus;
+	uint32_t size;
+	struct dvd_vobu *vobu;
+};
+
+bool dvd_vobu_nav_pack(const unsigned char *block);
+
+bool dvd_vobu_parse(struct dvd_vobu *dvd_vobu, const unsigned char *block);
+
+uint32_t dvd_vobu_first_ref_blocks(const struct dvd_vobu *dvd_vobu);
+
+uint32_t dvd_vobu_pts_msecs(const struct dvd_vobu *dvd_vobu, const uint64_t pts);
+
+void dvd_vobu_pts_base(const struct dvd_vobu *dvd_vobu, const uint32_t cell_start, bool *has_base, int64_t *base);
+
+void dvd_vobu_index_init(struct dvd_vobu_index *dvd_vobu_index, const uint16_t track_number, const uint16_t vts);
+
+bool dvd_vobu_index_add(struct dvd_vobu_index *dvd_vobu_index, const struct dvd_vobu *dvd_vobu);
+
+bool dvd_vobu_index_cells(struct dvd_session *dvd_session, const uint16_t track_number, const uint8_t first_cell, const uint8_t last_cell, struct dvd_vobu_index *dvd_vobu_index);
+
+bool dvd_vobu_index_track(struct dvd_session *dvd_session, const uint16_t track_number, struct dvd_vobu_index *dvd_vobu_index);
+
+bool dvd_vobu_find_msecs(struct dvd_session *dvd_session, const uint16_t track_number, const uint32_t msecs, struct dvd_vobu *dvd_vobu);
+
+bool dvd_vobu_index_find_msecs(struct dvd_session *dvd_session, const struct dvd_vobu_index *dvd_vobu_index, const uint32_t msecs, struct dvd_vobu *dvd_vobu);
+
+struct dvd_demux;
+
+bool dvd_vobu_index_sample(struct dvd_session *dvd_session, const struct dvd_vobu_index *dvd_vobu_index, dvd_file_t *dvdread_vts_file, const uint32_t msecs, struct dvd_vobu *dvd_vobu, struct dvd_demux *dvd_vobu_demux);
+
+bool dvd_vobu_index_save(const struct dvd_vobu_index *dvd_vobu_index, const char *filename);
+
+bool dvd_vobu_index_load(struct dvd_vobu_index *dvd_vobu_index, const char *filename);
+
+void dvd_vobu_index_free(struct dvd_vobu_index *dvd_vobu_index);
+
+struct dvd_pipeline;
+
+bool dvd_vobu_index_pipeline(struct dvd_pipeline *dvd_pipeline, struct dvd_vobu_index *dvd_vobu_index);
+
+#endif
@@ -0,0 +1,151 @@
+#include "dvd_workers.h"
+
+/**
+ * Functions to run jobs across a number of threads
+ */
+
+struct dvd_workers_queue {
+	const struct dvd_workers *dvd_workers;
+	pthread_mutex_t mutex;
+	uint32_t next;
+	bool failed;
+};
+
+struct dvd_workers_thread {
+	pthread_t thread;
+	struct dvd_workers_queue *queue;
+	struct dvd_session *dvd_session;
+	bool own_session;
+	void *worker;
+};
+
+static void dvd_workers_fail(struct dvd_workers_queue *queue) {
+
+	pthread_mutex_lock(&queue->mutex);
+	queue->failed = true;
+	pthread_mutex_unlock(&queue->mutex);
+
+}
+
+/**
+ * Take the next job until there are none left, or one of them has failed
+ */
+static void *dvd_workers_work(void *arg) {
+
+	struct dvd_workers_thread *dvd_workers_thread = (struct dvd_workers_thread *)arg;
+	struct dvd_workers_queue *queue = dvd_workers_thread->queue;
+	const struct dvd_workers *dvd_workers = queue->dvd_workers;
+	uint32_t job = 0;
+	bool done = false;
+
+	while(true) {
+
+		pthread_mutex_lock(&queue->mutex);
+		done = queue->failed || queue->next == dvd_workers->jobs;
+		if(!done)
+			job = queue->next++;
+		pthread_mutex_unlock(&queue->mutex);
+
+		if(done)
+			break;
+
+		if(!dvd_workers->job(dvd_workers->data, dvd_workers_thread->worker, job)) {
+			dvd_workers_fail(queue);
+			break;
+		}
+
+	}
+
+	return NULL;
+
+}
+
+/**
+ * Split the jobs across a number of workers, and wait for all of them
+ *
+ * @param workers number of threads, never more than there are jobs
+ * @return false if a worker couldn't be set up or started, or a job failed
+ */
+bool dvd_workers_run(struct dvd_session *dvd_session, const struct dvd_workers *dvd_workers, uint16_t workers) {
+
+	struct dvd_workers_queue queue;
+	struct dvd_workers_thread *dvd_workers_thread = NULL;
+	unsigned char *state = NULL;
+	int session_error = DVD_SESSION_OK;
+	uint16_t ix = 0;
+	uint16_t opened = 0;
+	uint16_t started = 0;
+	bool ok = true;
+
+	if(workers > dvd_workers->jobs)
+		workers = (uint16_t)dvd_workers->jobs;
+	if(workers < 1)
+		workers = 1;
+
+	dvd_workers_thread = calloc(workers, sizeof(*dvd_workers_thread));
+	state = calloc(workers, dvd_workers->size ? dvd_workers->size : 1);
+	if(dvd_workers_thread == NULL || state == NULL) {
+		fprintf(stderr, "Couldn't allocate memory\n");
+		free(dvd_workers_thread);
+		free(state);
+		return false;
+	}
+
+	memset(&queue, 0, sizeof(queue));
+	queue.dvd_workers = dvd_workers;
+	pthread_mutex_init(&queue.mutex, NULL);
+
+	for(ix = 0; ix < workers && ok; ix++) {
+
+		dvd_workers_thread[ix].queue = &queue;
+		dvd_workers_thread[ix].worker = state + ix * dvd_workers->size;
+
+		if(ix == 0) {
+			dvd_workers_thread[ix].dvd_session = dvd_session;
+		} else {
+			dvd_workers_thread[ix].dvd_session = dvd_session_open(dvd_session_device(dvd_session), &session_error);
+			dvd_workers_thread[ix].own_session = true;
+			if(dvd_workers_thread[ix].dvd_session == NULL) {
+				fprintf(stderr, "* Could not open %s for worker %u: %s\n", dvd_session_device(dvd_session), ix + 1, dvd_session_strerror(session_error));
+				ok = false;
+				break;
+			}
+		}
+
+		opened++;
+
+		if(dvd_workers->open != NULL && !dvd_workers->open(dvd_workers->data, dvd_workers_thread[ix].worker, ix, dvd_workers_thread[ix].dvd_session))
+			ok = false;
+
+	}
+
+	// With one worker, there is no need for a thread
+	if(ok && workers == 1) {
+		dvd_workers_work(&dvd_workers_thread[0]);
+	} else if(ok) {
+		for(started = 0; started < workers; started++) {
+			if(pthread_create(&dvd_workers_thread[started].thread, NULL, dvd_workers_work, &dvd_workers_thread[started]) != 0) {
+				fprintf(stderr, "* Could not start worker %u\n", started + 1);
+				dvd_workers_fail(&queue);
+				break;
+			}
+		}
+		for(ix = 0; ix < started; ix++)
+			pthread_join(dvd_workers_thread[ix].thread, NULL);
+	}
+
+	for(ix = 0; ix < workers; ix++) {
+		if(ix < opened && dvd_workers->close != NULL)
+			dvd_workers->close(dvd_workers->data, dvd_workers_thread[ix].worker, ix);
+		if(dvd_workers_thread[ix].own_session && dvd_workers_thread[ix].dvd_session != NULL)
+			dvd_session_close(dvd_workers_thread[ix].dvd_session);
+	}
+
+	pthread_mutex_destroy(&queue.mutex);
+
+	free(dvd_workers_thread);
+	free(state);
+
+	return ok && !queue.failed;
+
+}
@@ -0,0 +1,65 @@
+#ifndef DVD_INFO_WORKERS_H
+#define DVD_INFO_WORKERS_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "dvd_session.h"
+
+/**
+ * libdvdinfo worker pool
+ *
+ * Runs a number of jobs across a number of threads, each worker taking the
+ * next job in order until there are none left.  Every worker has its own
+ * session (and so its own dvd_reader_t), since libdvdread can't share one
+ * between threads.  The first worker borrows the session it's given.
+ *
+ * Each worker's own state (a decoder, a demuxer, an open VOB) is set up by
+ * open() on the calling thread before any worker starts, so opening the disc
+ * and libraries that detect the CPU the first time they're used never race.
+ * close() is called for each of them, also on the calling thread, once they
+ * have all finished.  A job that fails stops any more from being started.
+ *
+ * struct dvd_workers dvd_workers = { jobs, sizeof(struct worker), worker_open, worker_job, worker_close, &data };
+ * dvd_workers_run(dvd_session, &dvd_workers, 4);
+ */
+
+/**
+ * Set up a worker's state, which starts zeroed
+ *
+ * @param index worker number, 0 is the one with the borrowed session
+ * @return false to stop the run before any job is started
+ */
+typedef bool (*dvd_workers_open_t)(void *data, void *worker, const uint16_t index, struct dvd_session *dvd_session);
+
+/**
+ * Run one job, on the worker's thread.  Returning false fails the run.
+ */
+typedef bool (*dvd_workers_job_t)(void *data, void *worker, const uint32_t job);
+
+/**
+ * Free a worker's state.  Called for every worker open() was, even when it
+ * failed.  Can be NULL.
+ */
+typedef void (*dvd_workers_close_t)(void *data, void *worker, const uint16_t index);
+
+/**
+ * jobs: number of jobs
+ * size: size of each worker's state
+ * data: passed to every call, shared by all the workers
+ */
+struct dvd_workers {
+	uint32_t jobs;
+	size_t size;
+	dvd_workers_open_t open;
+	dvd_workers_job_t job;
+	dvd_workers_close_t close;
+	void *data;
+};
+
+bool dvd_workers_run(struct dvd_session *dvd_session, const struct dvd_workers *dvd_workers, uint16_t workers);
+
+#endif